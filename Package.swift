@@ -15,6 +15,18 @@ let package = Package(
             type: .static,
             targets: ["OpenMPTSwift", "LibOpenMPT"]
         ),
+        .executable(
+            name: "openmpt-indexer",
+            targets: ["OpenMPTIndexer"]
+        ),
+        .executable(
+            name: "openmpt-export",
+            targets: ["OpenMPTExport"]
+        ),
+        .executable(
+            name: "openmpt-bench",
+            targets: ["OpenMPTBench"]
+        ),
     ],
     dependencies: [],
     targets: [
@@ -30,7 +42,31 @@ let package = Package(
             name: "CLibOpenMPT",
             dependencies: ["LibOpenMPT"],
             path: "Sources/CLibOpenMPT",
-            sources: ["CLibOpenMPT.c"],
+            sources: [
+                "CLibOpenMPT.c",
+                "bridge_util.c",
+                "bridge_pcm.c",
+                "bridge_fft.c",
+                "bridge_pattern_store.c",
+                "openmpt_bridge_index.c",
+                "openmpt_bridge_catalog.c",
+                "openmpt_bridge_subsongs.c",
+                "openmpt_bridge_export.c",
+                "openmpt_bridge_module.c",
+                "openmpt_bridge_deadline.c",
+                "openmpt_bridge_quality.c",
+                "openmpt_bridge_commands.c",
+                "openmpt_bridge_snapshot.c",
+                "openmpt_bridge_resampler.c",
+                "openmpt_bridge_taps.c",
+                "openmpt_bridge_stems.c",
+                "openmpt_bridge_analyzer.c",
+                "openmpt_bridge_waveform.c",
+                "openmpt_bridge_loudness.c",
+                "openmpt_bridge_preview.c",
+                "openmpt_bridge_fingerprint.c",
+                "openmpt_bridge_interactive.c"
+            ],
             publicHeadersPath: "include",
             cSettings: [
                 .headerSearchPath("include"),
@@ -47,6 +83,27 @@ let package = Package(
             ]
         ),
         
+        // Corpus indexer command-line tool
+        .executableTarget(
+            name: "OpenMPTIndexer",
+            dependencies: ["CLibOpenMPT"],
+            path: "Sources/OpenMPTIndexer"
+        ),
+        
+        // Module export command-line tool
+        .executableTarget(
+            name: "OpenMPTExport",
+            dependencies: ["CLibOpenMPT"],
+            path: "Sources/OpenMPTExport"
+        ),
+        
+        // Corpus benchmark command-line tool
+        .executableTarget(
+            name: "OpenMPTBench",
+            dependencies: ["CLibOpenMPT"],
+            path: "Sources/OpenMPTBench"
+        ),
+        
         // XCFramework binary target
         .binaryTarget(
             name: "LibOpenMPT",
@@ -30,6 +30,7 @@ int clibopenmpt_test_linking(void) {
 static void* _openmpt_symbol_table[] = {
     (void*)openmpt_get_library_version,
     (void*)openmpt_module_create_from_memory2,
+    (void*)openmpt_module_create2,
     (void*)openmpt_module_destroy,
     (void*)openmpt_module_get_current_order,
     (void*)openmpt_module_get_current_pattern,
@@ -45,9 +46,12 @@ static void* _openmpt_symbol_table[] = {
     (void*)openmpt_module_get_num_samples,
     (void*)openmpt_module_get_position_seconds,
     (void*)openmpt_module_get_sample_name,
+    (void*)openmpt_module_get_current_playing_channels,
     (void*)openmpt_module_read_interleaved_float_stereo,
+    (void*)openmpt_module_read_float_stereo,
     (void*)openmpt_module_set_position_seconds,
     (void*)openmpt_module_set_repeat_count,
+    (void*)openmpt_module_get_repeat_count,
     // Only include functions that exist in the XCFramework
     (void*)openmpt_module_get_pattern_num_rows,
     (void*)openmpt_module_get_pattern_row_channel_command,
@@ -57,13 +61,24 @@ static void* _openmpt_symbol_table[] = {
     (void*)openmpt_module_get_num_orders,
     (void*)openmpt_module_get_order_pattern,
     (void*)openmpt_module_set_position_order_row,
+    (void*)openmpt_module_get_time_at_position,
     (void*)openmpt_module_get_num_subsongs,
     (void*)openmpt_module_get_selected_subsong,
     (void*)openmpt_module_select_subsong,
+    (void*)openmpt_module_get_restart_order,
+    (void*)openmpt_module_get_restart_row,
+    (void*)openmpt_module_get_subsong_name,
     (void*)openmpt_module_get_render_param,
     (void*)openmpt_module_set_render_param,
     (void*)openmpt_module_ctl_get,
     (void*)openmpt_module_ctl_set,
+    (void*)openmpt_module_ext_create_from_memory,
+    (void*)openmpt_module_ext_destroy,
+    (void*)openmpt_module_ext_get_module,
+    (void*)openmpt_module_ext_get_interface,
+    (void*)openmpt_log_func_silent,
+    (void*)openmpt_probe_file_header_get_recommended_size,
+    (void*)openmpt_probe_file_header,
     // Our custom bridge functions are implemented below, not in symbol table
     0
 };
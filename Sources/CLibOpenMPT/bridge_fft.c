@@ -0,0 +1,184 @@
+// bridge_fft.c
+// Real-input FFT: a half-size complex FFT with a radix-4 first pass and vectorized radix-2 stages
+
+#include "bridge_fft.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// size real samples are packed as size / 2 complex ones (even samples real,
+// odd samples imaginary), transformed, and split back into the real
+// spectrum. Data is kept as separate real and imaginary arrays so every
+// radix-2 stage past the first pass works on four butterflies at a time.
+struct bridge_fft {
+    size_t size;
+    size_t half;
+    uint32_t* bitrev;       // half entries
+    float* twiddle_re;      // stages with h >= 4 back to back, h entries each
+    float* twiddle_im;
+    float* split_re;        // e^(-2 pi i k / size) for k in [0, half]
+    float* split_im;
+    float* work_re;         // half entries
+    float* work_im;
+};
+
+// MARK: - Plan
+
+void bridge_fft_destroy(bridge_fft* fft) {
+    if (!fft) return;
+    free(fft->bitrev);
+    free(fft->twiddle_re);
+    free(fft->twiddle_im);
+    free(fft->split_re);
+    free(fft->split_im);
+    free(fft->work_re);
+    free(fft->work_im);
+    free(fft);
+}
+
+bridge_fft* bridge_fft_create(size_t size) {
+    if (size < 16 || size > 65536 || (size & (size - 1)) != 0) return NULL;
+    bridge_fft* fft = calloc(1, sizeof(*fft));
+    if (!fft) return NULL;
+    size_t half = size / 2;
+    fft->size = size;
+    fft->half = half;
+    fft->bitrev = malloc(half * sizeof(*fft->bitrev));
+    fft->twiddle_re = malloc(half * sizeof(float));
+    fft->twiddle_im = malloc(half * sizeof(float));
+    fft->split_re = malloc((half + 1) * sizeof(float));
+    fft->split_im = malloc((half + 1) * sizeof(float));
+    fft->work_re = malloc(half * sizeof(float));
+    fft->work_im = malloc(half * sizeof(float));
+    if (!fft->bitrev || !fft->twiddle_re || !fft->twiddle_im || !fft->split_re || !fft->split_im ||
+        !fft->work_re || !fft->work_im) {
+        bridge_fft_destroy(fft);
+        return NULL;
+    }
+
+    int bits = 0;
+    while (((size_t)1 << bits) < half) bits++;
+    for (size_t i = 0; i < half; i++) {
+        uint32_t reversed = 0;
+        for (int b = 0; b < bits; b++) reversed |= (uint32_t)((i >> b) & 1) << (bits - 1 - b);
+        fft->bitrev[i] = reversed;
+    }
+
+    size_t offset = 0;
+    for (size_t h = 4; h < half; h *= 2) {
+        for (size_t k = 0; k < h; k++) {
+            double angle = -M_PI * (double)k / (double)h;
+            fft->twiddle_re[offset + k] = (float)cos(angle);
+            fft->twiddle_im[offset + k] = (float)sin(angle);
+        }
+        offset += h;
+    }
+    for (size_t k = 0; k <= half; k++) {
+        double angle = -2.0 * M_PI * (double)k / (double)size;
+        fft->split_re[k] = (float)cos(angle);
+        fft->split_im[k] = (float)sin(angle);
+    }
+    return fft;
+}
+
+// MARK: - Butterflies
+
+// The first two radix-2 stages fused: every twiddle is 1 or -i
+static void bridge_fft_radix4(float* re, float* im, size_t count) {
+    for (size_t s = 0; s < count; s += 4) {
+        float r0 = re[s] + re[s + 1], i0 = im[s] + im[s + 1];
+        float r1 = re[s] - re[s + 1], i1 = im[s] - im[s + 1];
+        float r2 = re[s + 2] + re[s + 3], i2 = im[s + 2] + im[s + 3];
+        float r3 = re[s + 2] - re[s + 3], i3 = im[s + 2] - im[s + 3];
+        re[s] = r0 + r2;        im[s] = i0 + i2;
+        re[s + 2] = r0 - r2;    im[s + 2] = i0 - i2;
+        // -i * (r3 + i i3) = i3 - i r3
+        re[s + 1] = r1 + i3;    im[s + 1] = i1 - r3;
+        re[s + 3] = r1 - i3;    im[s + 3] = i1 + r3;
+    }
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+
+// Compiler vector extensions lower to SSE on x86 and NEON on ARM
+typedef float bridge_v4f __attribute__((vector_size(16)));
+
+static void bridge_fft_stage(float* re, float* im, size_t count, size_t h, const float* wr, const float* wi) {
+    for (size_t s = 0; s < count; s += 2 * h) {
+        for (size_t k = 0; k < h; k += 4) {
+            bridge_v4f ar, ai, br, bi, tw_r, tw_i;
+            memcpy(&ar, re + s + k, sizeof(ar));
+            memcpy(&ai, im + s + k, sizeof(ai));
+            memcpy(&br, re + s + h + k, sizeof(br));
+            memcpy(&bi, im + s + h + k, sizeof(bi));
+            memcpy(&tw_r, wr + k, sizeof(tw_r));
+            memcpy(&tw_i, wi + k, sizeof(tw_i));
+            bridge_v4f tr = br * tw_r - bi * tw_i;
+            bridge_v4f ti = br * tw_i + bi * tw_r;
+            bridge_v4f out_r = ar + tr, out_i = ai + ti;
+            memcpy(re + s + k, &out_r, sizeof(out_r));
+            memcpy(im + s + k, &out_i, sizeof(out_i));
+            out_r = ar - tr;
+            out_i = ai - ti;
+            memcpy(re + s + h + k, &out_r, sizeof(out_r));
+            memcpy(im + s + h + k, &out_i, sizeof(out_i));
+        }
+    }
+}
+
+#else
+
+static void bridge_fft_stage(float* re, float* im, size_t count, size_t h, const float* wr, const float* wi) {
+    for (size_t s = 0; s < count; s += 2 * h) {
+        for (size_t k = 0; k < h; k++) {
+            float br = re[s + h + k], bi = im[s + h + k];
+            float tr = br * wr[k] - bi * wi[k];
+            float ti = br * wi[k] + bi * wr[k];
+            re[s + h + k] = re[s + k] - tr;
+            im[s + h + k] = im[s + k] - ti;
+            re[s + k] += tr;
+            im[s + k] += ti;
+        }
+    }
+}
+
+#endif
+
+// MARK: - Transform
+
+void bridge_fft_real(bridge_fft* fft, const float* input, float* re, float* im) {
+    const size_t half = fft->half;
+    float* zr = fft->work_re;
+    float* zi = fft->work_im;
+    for (size_t i = 0; i < half; i++) {
+        size_t j = fft->bitrev[i];
+        zr[i] = input[2 * j];
+        zi[i] = input[2 * j + 1];
+    }
+
+    bridge_fft_radix4(zr, zi, half);
+    size_t offset = 0;
+    for (size_t h = 4; h < half; h *= 2) {
+        bridge_fft_stage(zr, zi, half, h, fft->twiddle_re + offset, fft->twiddle_im + offset);
+        offset += h;
+    }
+
+    // X[k] = E[k] + W^k O[k], with E and O the spectra of the even and odd
+    // samples recovered from Z[k] and conj(Z[half - k])
+    for (size_t k = 0; k <= half; k++) {
+        size_t a = k % half;
+        size_t b = (half - k) % half;
+        float er = 0.5f * (zr[a] + zr[b]);
+        float ei = 0.5f * (zi[a] - zi[b]);
+        float or_ = 0.5f * (zi[a] + zi[b]);
+        float oi = -0.5f * (zr[a] - zr[b]);
+        re[k] = er + fft->split_re[k] * or_ - fft->split_im[k] * oi;
+        im[k] = ei + fft->split_re[k] * oi + fft->split_im[k] * or_;
+    }
+}
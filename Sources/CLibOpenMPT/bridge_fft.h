@@ -0,0 +1,29 @@
+// bridge_fft.h
+// Private real-input FFT used by the spectrum analyzer.
+// Not part of the public module map.
+
+#ifndef CLIBOPENMPT_BRIDGE_FFT_H
+#define CLIBOPENMPT_BRIDGE_FFT_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct bridge_fft bridge_fft;
+
+// Plan a forward FFT of size real samples; size is a power of two from 16
+// to 65536. Returns NULL otherwise or when out of memory.
+bridge_fft* bridge_fft_create(size_t size);
+void bridge_fft_destroy(bridge_fft* fft);
+
+// Transform size real samples into size / 2 + 1 bins, unnormalized.
+// Not thread-safe per plan: the plan owns the work buffers.
+void bridge_fft_real(bridge_fft* fft, const float* input, float* re, float* im);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLIBOPENMPT_BRIDGE_FFT_H */
@@ -0,0 +1,102 @@
+// bridge_internal.h
+// Private helpers shared by the bridge translation units.
+// Not part of the public module map.
+
+#ifndef CLIBOPENMPT_BRIDGE_INTERNAL_H
+#define CLIBOPENMPT_BRIDGE_INTERNAL_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "libopenmpt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Modification time of a stat result in nanoseconds since the epoch
+#if defined(__APPLE__)
+#define BRIDGE_STAT_MTIME_NS(st) ((int64_t)(st).st_mtimespec.tv_sec * 1000000000 + (int64_t)(st).st_mtimespec.tv_nsec)
+#else
+#define BRIDGE_STAT_MTIME_NS(st) ((int64_t)(st).st_mtim.tv_sec * 1000000000 + (int64_t)(st).st_mtim.tv_nsec)
+#endif
+
+// Atomic loads for getters that take a const handle. C11 declares the
+// atomic_load functions on non-const objects only, so the cast lives here.
+static inline uint_fast64_t bridge_atomic_load_u64(const atomic_uint_fast64_t* object, memory_order order) {
+    return atomic_load_explicit((atomic_uint_fast64_t*)object, order);
+}
+
+static inline size_t bridge_atomic_load_size(const atomic_size_t* object, memory_order order) {
+    return atomic_load_explicit((atomic_size_t*)object, order);
+}
+
+static inline int bridge_atomic_load_int(const atomic_int* object, memory_order order) {
+    return atomic_load_explicit((atomic_int*)object, order);
+}
+
+static inline unsigned bridge_atomic_load_uint(const atomic_uint* object, memory_order order) {
+    return atomic_load_explicit((atomic_uint*)object, order);
+}
+
+// Doubles kept in atomic_uint_fast64_t as their bit pattern
+static inline uint64_t bridge_double_bits(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static inline double bridge_bits_double(uint64_t bits) {
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Monotonic clock
+uint64_t bridge_now_ns(void);
+double bridge_now_seconds(void);
+
+// Number of online CPUs, at least 1
+int bridge_cpu_count(void);
+
+// Run fn(ctx, index, worker) for every index in [0, count) on up to
+// thread_count threads (0 = one per CPU). Workers pull indices from a shared
+// atomic counter, so uneven job sizes balance out. Returns once all jobs ran.
+typedef void (*bridge_job_func)(void* ctx, size_t index, int worker);
+void bridge_parallel_for(size_t count, int thread_count, bridge_job_func fn, void* ctx);
+
+// Resolve a requested thread count (0 = one per CPU) against a job count
+int bridge_resolve_thread_count(int requested, size_t jobs);
+
+// Whole-file helpers. Return 1 on success, 0 on failure (libopenmpt style).
+int bridge_read_file(const char* path, void** data, size_t* size);
+int bridge_map_file(const char* path, const void** data, size_t* size);
+void bridge_unmap_file(const void* data, size_t size);
+
+// Write a buffer to path atomically (temporary file + rename)
+int bridge_write_file_atomic(const char* path, const void* data, size_t size);
+
+// XXH64 of a buffer
+uint64_t bridge_hash64(const void* data, size_t size, uint64_t seed);
+
+// Metadata string copied out of libopenmpt (never NULL, free() the result)
+char* bridge_copy_metadata(openmpt_module* mod, const char* key);
+
+// Render a loaded module from its current position to the end of the song
+// and measure its loudness (openmpt_bridge_loudness.c). Returns 1 on success.
+struct openmpt_bridge_loudness;
+int bridge_loudness_render(openmpt_module* mod, struct openmpt_bridge_loudness* loudness);
+
+// Render a loaded module from its current position at low quality and write
+// up to capacity fingerprint hashes (openmpt_bridge_fingerprint.c). Changes
+// the module's render parameters. Returns the number of hashes written.
+size_t bridge_fingerprint_render(openmpt_module* mod, uint32_t* hashes, size_t capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLIBOPENMPT_BRIDGE_INTERNAL_H */
@@ -0,0 +1,279 @@
+// bridge_module_internal.h
+// Layout of openmpt_bridge_module, shared by the translation units that
+// extend the handle. Not part of the public module map.
+
+#ifndef CLIBOPENMPT_BRIDGE_MODULE_INTERNAL_H
+#define CLIBOPENMPT_BRIDGE_MODULE_INTERNAL_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "openmpt_bridge_commands.h"
+#include "openmpt_bridge_deadline.h"
+#include "openmpt_bridge_interactive.h"
+#include "openmpt_bridge_module.h"
+#include "openmpt_bridge_quality.h"
+#include "openmpt_bridge_snapshot.h"
+#include "openmpt_bridge_taps.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct bridge_counters {
+    atomic_uint_fast64_t frames_rendered;
+    atomic_uint_fast64_t render_calls;
+    atomic_uint_fast64_t render_ns;
+    atomic_uint_fast64_t max_block_ns;
+    atomic_uint_fast64_t underruns;
+    atomic_uint_fast64_t seeks;
+    atomic_uint_fast64_t loads;
+    atomic_uint_fast64_t load_ns;
+} bridge_counters;
+
+// Capacity of the overrun event queue (power of two)
+#define BRIDGE_DEADLINE_QUEUE 64
+
+typedef struct bridge_deadline {
+    atomic_uint_fast64_t buckets[OPENMPT_BRIDGE_DEADLINE_BUCKETS];
+    atomic_uint_fast64_t blocks;
+    atomic_uint_fast64_t overruns;
+    atomic_uint_fast64_t missed;
+    atomic_uint_fast64_t dropped;
+    atomic_uint_fast64_t peak_ppm;      // peak utilization in millionths
+    atomic_uint_fast64_t budget_ppm;
+
+    // Single-producer (render thread), single-consumer ring
+    atomic_size_t head;
+    atomic_size_t tail;
+    openmpt_bridge_overrun_event events[BRIDGE_DEADLINE_QUEUE];
+} bridge_deadline;
+
+typedef struct bridge_quality {
+    // Written by control threads, read by the render thread
+    atomic_int enabled;
+    atomic_int max_level;
+    atomic_uint_fast32_t degrade_blocks;
+    atomic_uint_fast32_t restore_blocks;
+    atomic_uint_fast64_t restore_ppm;
+    atomic_int requested_interpolation;
+    atomic_int requested_ramping;
+
+    // Published by the render thread
+    atomic_int level;
+    atomic_int applied_interpolation;
+    atomic_int applied_ramping;
+    atomic_uint_fast64_t degrades;
+    atomic_uint_fast64_t restores;
+
+    // Render thread only
+    uint32_t pressure;
+    uint32_t calm;
+} bridge_quality;
+
+typedef enum bridge_command_kind {
+    BRIDGE_COMMAND_RENDER_PARAM,
+    BRIDGE_COMMAND_CTL,
+    BRIDGE_COMMAND_SEEK_SECONDS,
+    BRIDGE_COMMAND_SEEK_ORDER_ROW,      // param = order, value = row
+    BRIDGE_COMMAND_SELECT_SUBSONG,
+    BRIDGE_COMMAND_REPEAT_COUNT,
+    BRIDGE_COMMAND_PLAY_NOTE,           // param = voice, value = instrument
+    BRIDGE_COMMAND_STOP_NOTE,           // param = voice, -1 for all
+    BRIDGE_COMMAND_NOTE_OFF,            // param = voice, -1 for all
+    BRIDGE_COMMAND_CHANNEL_MUTE,        // param = channel, -1 for all; value = mute
+    BRIDGE_COMMAND_CHANNEL_SOLO,        // param = channel, -1 for all; value = solo
+    BRIDGE_COMMAND_CHANNEL_VOLUME,      // param = channel
+    BRIDGE_COMMAND_CHANNEL_PANNING,     // param = channel
+    BRIDGE_COMMAND_TEMPO_FACTOR,
+    BRIDGE_COMMAND_PITCH_FACTOR
+} bridge_command_kind;
+
+typedef struct bridge_command {
+    bridge_command_kind kind;
+    int param;
+    int32_t value;
+    double seconds;
+    int32_t note;
+    double volume;
+    double panning;
+    double factor;
+    char ctl[OPENMPT_BRIDGE_COMMAND_CTL_LENGTH];
+    char text[OPENMPT_BRIDGE_COMMAND_VALUE_LENGTH];
+} bridge_command;
+
+typedef struct bridge_command_slot {
+    atomic_size_t sequence;
+    bridge_command command;
+} bridge_command_slot;
+
+// A render parameter ramped by the render thread
+typedef struct bridge_smoothed_param {
+    int param;
+    int active;
+    int32_t target;
+    double current;
+    double step;                        // per frame
+} bridge_smoothed_param;
+
+typedef struct bridge_commands {
+    // Bounded multi-producer queue with per-slot sequence numbers; the
+    // render thread is the only consumer
+    atomic_size_t enqueue_pos;
+    atomic_size_t dequeue_pos;
+    bridge_command_slot slots[OPENMPT_BRIDGE_COMMAND_CAPACITY];
+    atomic_uint_fast64_t dropped;
+
+    atomic_int realtime;
+    atomic_uint_fast64_t smoothing_us;
+
+    // Render thread only
+    bridge_smoothed_param gain;
+    bridge_smoothed_param separation;
+} bridge_commands;
+
+// Seqlock: odd sequence while the single writer updates the fields
+typedef struct bridge_position {
+    atomic_uint sequence;
+    atomic_int valid;
+    atomic_uint_fast64_t seconds;       // double bits
+    atomic_uint_fast64_t tempo;         // double bits
+    atomic_int order;
+    atomic_int pattern;
+    atomic_int row;
+    atomic_int speed;
+    atomic_int subsong;
+    atomic_int playing_channels;
+    atomic_int at_end;
+} bridge_position;
+
+// Frames converted per pass when feeding taps
+#define BRIDGE_TAP_CHUNK 512
+
+typedef struct bridge_taps {
+    // Attached taps; written by control threads, walked by the render thread
+    _Atomic(openmpt_bridge_tap*) slots[OPENMPT_BRIDGE_MAX_TAPS];
+    atomic_int attached;
+    // Odd while the render thread is feeding taps, so detach can wait it out
+    atomic_uint epoch;
+
+    // Render thread only: planar blocks interleaved for the taps
+    float scratch[BRIDGE_TAP_CHUNK * 2];
+} bridge_taps;
+
+// bridge_channel.flags
+#define BRIDGE_CHANNEL_MUTE 1
+#define BRIDGE_CHANNEL_SOLO 2
+
+typedef struct bridge_channel {
+    // Requested by control threads, stored once the request is accepted
+    atomic_uint flags;
+    atomic_uint_fast64_t volume;        // double bits
+    atomic_uint_fast64_t panning;       // double bits
+
+    // Render thread only: flags as of the last applied command, and the
+    // mute status last given to libopenmpt
+    unsigned applied_flags;
+    int muted;
+} bridge_channel;
+
+typedef struct bridge_interactive {
+    // Set on load, while no render thread runs
+    int available;
+    int available2;
+    int32_t instruments;                // instruments, or samples without instruments
+    int32_t channels;                   // pattern channels, at most OPENMPT_BRIDGE_MAX_CHANNELS
+    openmpt_module_ext_interface_interactive interactive;
+    openmpt_module_ext_interface_interactive2 interactive2;
+
+    // Voice ids handed out by play_note
+    atomic_uint next_voice;
+
+    // Render thread only: channel of each voice's note, -1 if none
+    int32_t voices[OPENMPT_BRIDGE_JAM_VOICES];
+
+    bridge_channel mix[OPENMPT_BRIDGE_MAX_CHANNELS];
+
+    // Requested by control threads, stored once the request is accepted
+    atomic_uint_fast64_t tempo_factor;  // double bits
+    atomic_uint_fast64_t pitch_factor;  // double bits
+} bridge_interactive;
+
+typedef struct bridge_snapshot bridge_snapshot;
+
+struct openmpt_bridge_module {
+    openmpt_module_ext* mod_ext;
+    openmpt_module* mod;        // owned by mod_ext
+    bridge_counters counters;
+    bridge_deadline deadline;
+    bridge_quality quality;
+    bridge_commands commands;
+    bridge_position position;
+    bridge_taps taps;
+    bridge_interactive interactive;
+    int at_end;                 // owned by whichever thread renders
+
+    // Guards the snapshot pointer against concurrent loads and acquires;
+    // control threads only
+    pthread_mutex_t snapshot_lock;
+    bridge_snapshot* snapshot;
+};
+
+void bridge_deadline_init(bridge_deadline* deadline);
+// Called by the render path after every block. Returns the block's
+// utilization in millionths, or 0 if it could not be measured.
+uint64_t bridge_deadline_record(bridge_deadline* deadline, size_t frames, int32_t sample_rate,
+                                uint64_t end_ns, uint64_t elapsed_ns, uint64_t block_index);
+
+void bridge_quality_init(bridge_quality* quality);
+// Called after a module is loaded: read its render params as the requested quality
+void bridge_quality_reset(openmpt_bridge_module* handle);
+// Called by the render path after every block, between bridge_deadline_record
+// and the next render call
+void bridge_quality_update(openmpt_bridge_module* handle, uint64_t utilization_ppm);
+// Apply a render param from the thread that owns the module, tracking the
+// requested interpolation and ramping. Returns 1 on success.
+int bridge_quality_set_render_param(openmpt_bridge_module* handle, int param, int32_t value);
+
+void bridge_commands_init(bridge_commands* commands);
+// Queue a command for the render thread. Returns 0 if the queue is full.
+int bridge_commands_submit(openmpt_bridge_module* handle, const bridge_command* command);
+// Called after a module is loaded: drop queued changes and stop any ramps
+void bridge_commands_reset(openmpt_bridge_module* handle);
+// Called by the render path at the start of every block
+void bridge_commands_drain(openmpt_bridge_module* handle, int32_t samplerate);
+// Frames that may be rendered before the next smoothing step; count when
+// nothing is ramping. Advances the ramps by the returned number of frames.
+size_t bridge_commands_smooth(openmpt_bridge_module* handle, size_t count);
+
+// Snapshot of a freshly loaded module with one reference, or NULL. The
+// module data is parsed again for the snapshot's pattern store.
+bridge_snapshot* bridge_snapshot_create(openmpt_module* mod, const void* data, size_t size);
+void bridge_snapshot_retain(bridge_snapshot* snapshot);
+void bridge_snapshot_release(bridge_snapshot* snapshot);
+
+void bridge_taps_init(bridge_taps* taps);
+// Free every attached tap; only when no thread renders
+void bridge_taps_destroy(bridge_taps* taps);
+// Called by the render path after every block with the rendered frames.
+// Exactly one of interleaved or left/right is set.
+void bridge_taps_feed(openmpt_bridge_module* handle, int32_t samplerate, const float* interleaved,
+                      const float* left, const float* right, size_t frames);
+
+void bridge_interactive_init(bridge_interactive* interactive);
+// Called after a module is loaded or unloaded: fetch its interfaces and forget all voices
+void bridge_interactive_reset(openmpt_bridge_module* handle);
+// Apply a note, channel mix or factor command from the thread that owns the module
+void bridge_interactive_apply(openmpt_bridge_module* handle, const bridge_command* command);
+
+void bridge_position_init(bridge_position* position);
+// Read the module's position and publish it to readers
+void bridge_position_publish(openmpt_bridge_module* handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLIBOPENMPT_BRIDGE_MODULE_INTERNAL_H */
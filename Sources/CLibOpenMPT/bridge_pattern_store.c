@@ -0,0 +1,345 @@
+// bridge_pattern_store.c
+// Lazily decoded pattern pages with a byte budget and LRU eviction
+
+#include "bridge_pattern_store.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// A page holds up to this many rows of one pattern, every channel
+#define BRIDGE_PATTERN_PAGE_ROWS 16
+
+// libopenmpt answers -1 for orders that are never played
+#define BRIDGE_ORDER_TIME_UNKNOWN -2.0
+
+// Packed page: for each row a bitmap of channels with a non-empty cell,
+// and only those cells, row by row. Most tracker patterns are largely
+// empty, so this is several times smaller than the plain cell grid.
+typedef struct bridge_pattern_page {
+    struct bridge_pattern_page* newer;
+    struct bridge_pattern_page* older;
+    size_t slot;                        // index into store->slots
+    size_t bytes;
+    int32_t rows;
+    uint64_t* occupied;                 // rows * store->words_per_row
+    uint16_t* row_start;                // rows + 1 offsets into cells
+    openmpt_pattern_cell* cells;
+} bridge_pattern_page;
+
+struct bridge_pattern_store {
+    pthread_mutex_t lock;
+    openmpt_module* mod;                // pattern-only instance, guarded by lock
+    void* data;                         // module file until the first access parses it
+    size_t size;
+    int unreadable;                     // the parse failed; never retried
+    int32_t channels;
+    int32_t orders;
+    int32_t patterns;
+    size_t words_per_row;
+    int32_t* rows;                      // per pattern
+    size_t* first_slot;                 // per pattern, into slots
+    bridge_pattern_page** slots;        // one per page of every pattern, NULL until decoded
+    openmpt_pattern_cell* scratch;      // one page of plain cells
+    double* order_times;                // per order, BRIDGE_ORDER_TIME_UNKNOWN until asked for
+
+    // LRU list, newest first
+    bridge_pattern_page* newest;
+    bridge_pattern_page* oldest;
+    size_t budget;
+    size_t bytes;
+    int32_t pages;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t prefetched;
+};
+
+// MARK: - Lifecycle
+
+bridge_pattern_store* bridge_pattern_store_create(const void* data, size_t size, int32_t channels, int32_t orders,
+                                                  int32_t patterns, const int32_t* rows, size_t budget) {
+    if (!data || channels < 0 || orders < 0 || patterns < 0 || (patterns > 0 && !rows)) return NULL;
+    bridge_pattern_store* store = calloc(1, sizeof(*store));
+    if (!store) return NULL;
+    if (pthread_mutex_init(&store->lock, NULL) != 0) {
+        free(store);
+        return NULL;
+    }
+    store->channels = channels;
+    store->orders = orders;
+    store->patterns = patterns;
+    store->words_per_row = ((size_t)channels + 63) / 64;
+    store->budget = budget;
+
+    // Parsing waits for the first access, so loads that never look at the
+    // patterns pay only for this copy
+    store->data = malloc(size > 0 ? size : 1);
+    if (store->data) memcpy(store->data, data, size);
+    store->size = size;
+    store->rows = calloc(patterns > 0 ? (size_t)patterns : 1, sizeof(*store->rows));
+    store->first_slot = calloc((size_t)patterns + 1, sizeof(*store->first_slot));
+    store->scratch = calloc((size_t)BRIDGE_PATTERN_PAGE_ROWS * (channels > 0 ? (size_t)channels : 1), sizeof(*store->scratch));
+    store->order_times = malloc((orders > 0 ? (size_t)orders : 1) * sizeof(*store->order_times));
+    if (!store->data || !store->rows || !store->first_slot || !store->scratch || !store->order_times) goto fail;
+    for (int32_t i = 0; i < orders; i++) store->order_times[i] = BRIDGE_ORDER_TIME_UNKNOWN;
+
+    size_t slots = 0;
+    for (int32_t i = 0; i < patterns; i++) {
+        store->rows[i] = rows[i] > 0 ? rows[i] : 0;
+        store->first_slot[i] = slots;
+        slots += ((size_t)store->rows[i] + BRIDGE_PATTERN_PAGE_ROWS - 1) / BRIDGE_PATTERN_PAGE_ROWS;
+    }
+    store->first_slot[patterns] = slots;
+    store->slots = calloc(slots > 0 ? slots : 1, sizeof(*store->slots));
+    if (!store->slots) goto fail;
+    return store;
+
+fail:
+    bridge_pattern_store_destroy(store);
+    return NULL;
+}
+
+void bridge_pattern_store_destroy(bridge_pattern_store* store) {
+    if (!store) return;
+    bridge_pattern_page* page = store->newest;
+    while (page) {
+        bridge_pattern_page* older = page->older;
+        free(page);
+        page = older;
+    }
+    if (store->mod) openmpt_module_destroy(store->mod);
+    free(store->data);
+    free(store->rows);
+    free(store->first_slot);
+    free(store->slots);
+    free(store->scratch);
+    free(store->order_times);
+    pthread_mutex_destroy(&store->lock);
+    free(store);
+}
+
+// Pattern-only instance, parsed from the copied file the first time it is
+// needed. Call with the lock held. Returns NULL if the file cannot be loaded.
+static openmpt_module* bridge_pattern_store_module(bridge_pattern_store* store) {
+    if (store->mod || store->unreadable) return store->mod;
+
+    // Samples, plugins and the subsong scan are what make loading slow;
+    // the cells need none of them
+    const openmpt_module_initial_ctl ctls[] = {
+        { "load.skip_samples", "1" },
+        { "load.skip_plugins", "1" },
+        { "load.skip_subsongs_init", "1" },
+        { NULL, NULL }
+    };
+    int error = 0;
+    store->mod = openmpt_module_create_from_memory2(store->data, store->size, (void*)openmpt_log_func_silent, NULL,
+                                                    NULL, NULL, &error, NULL, ctls);
+    store->unreadable = store->mod == NULL;
+    free(store->data);
+    store->data = NULL;
+    return store->mod;
+}
+
+// MARK: - Pages
+
+static size_t bridge_align(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+static int bridge_cell_empty(const openmpt_pattern_cell* cell) {
+    return !cell->note && !cell->instrument && !cell->volume && !cell->effect && !cell->effect_param;
+}
+
+static void bridge_page_unlink(bridge_pattern_store* store, bridge_pattern_page* page) {
+    if (page->newer) page->newer->older = page->older; else store->newest = page->older;
+    if (page->older) page->older->newer = page->newer; else store->oldest = page->newer;
+    page->newer = page->older = NULL;
+}
+
+static void bridge_page_push(bridge_pattern_store* store, bridge_pattern_page* page) {
+    page->newer = NULL;
+    page->older = store->newest;
+    if (store->newest) store->newest->newer = page; else store->oldest = page;
+    store->newest = page;
+}
+
+// Drop the least recently used pages until the cache fits its budget, but
+// never the page just used
+static void bridge_pattern_store_trim(bridge_pattern_store* store) {
+    while (store->bytes > store->budget && store->oldest && store->oldest != store->newest) {
+        bridge_pattern_page* page = store->oldest;
+        bridge_page_unlink(store, page);
+        store->slots[page->slot] = NULL;
+        store->bytes -= page->bytes;
+        store->pages--;
+        store->evictions++;
+        free(page);
+    }
+}
+
+static bridge_pattern_page* bridge_page_decode(bridge_pattern_store* store, int32_t pattern, int32_t index) {
+    openmpt_module* mod = bridge_pattern_store_module(store);
+    if (!mod) return NULL;
+    int32_t first_row = index * BRIDGE_PATTERN_PAGE_ROWS;
+    int32_t rows = store->rows[pattern] - first_row;
+    if (rows > BRIDGE_PATTERN_PAGE_ROWS) rows = BRIDGE_PATTERN_PAGE_ROWS;
+
+    size_t used = 0;
+    openmpt_pattern_cell* cell = store->scratch;
+    for (int32_t row = first_row; row < first_row + rows; row++) {
+        for (int32_t channel = 0; channel < store->channels; channel++, cell++) {
+            cell->note = openmpt_module_get_pattern_row_channel_command(mod, pattern, row, channel, OPENMPT_MODULE_COMMAND_NOTE);
+            cell->instrument = openmpt_module_get_pattern_row_channel_command(mod, pattern, row, channel, OPENMPT_MODULE_COMMAND_INSTRUMENT);
+            cell->volume = openmpt_module_get_pattern_row_channel_command(mod, pattern, row, channel, OPENMPT_MODULE_COMMAND_VOLUME);
+            cell->effect = openmpt_module_get_pattern_row_channel_command(mod, pattern, row, channel, OPENMPT_MODULE_COMMAND_EFFECT);
+            cell->effect_param = openmpt_module_get_pattern_row_channel_command(mod, pattern, row, channel, OPENMPT_MODULE_COMMAND_PARAMETER);
+            if (!bridge_cell_empty(cell)) used++;
+        }
+    }
+
+    // One allocation: header, bitmaps, row offsets, packed cells
+    size_t words = (size_t)rows * store->words_per_row;
+    size_t occupied_offset = bridge_align(sizeof(bridge_pattern_page), sizeof(uint64_t));
+    size_t row_start_offset = occupied_offset + words * sizeof(uint64_t);
+    size_t cells_offset = row_start_offset + ((size_t)rows + 1) * sizeof(uint16_t);
+    size_t bytes = cells_offset + used * sizeof(openmpt_pattern_cell);
+    bridge_pattern_page* page = calloc(1, bytes);
+    if (!page) return NULL;
+    page->bytes = bytes;
+    page->rows = rows;
+    page->occupied = (uint64_t*)((char*)page + occupied_offset);
+    page->row_start = (uint16_t*)((char*)page + row_start_offset);
+    page->cells = (openmpt_pattern_cell*)((char*)page + cells_offset);
+
+    // At most 16 rows of 256 channels, so offsets fit in 16 bits
+    uint16_t packed = 0;
+    cell = store->scratch;
+    for (int32_t row = 0; row < rows; row++) {
+        page->row_start[row] = packed;
+        uint64_t* bits = page->occupied + (size_t)row * store->words_per_row;
+        for (int32_t channel = 0; channel < store->channels; channel++, cell++) {
+            if (bridge_cell_empty(cell)) continue;
+            bits[channel / 64] |= UINT64_C(1) << (channel % 64);
+            page->cells[packed++] = *cell;
+        }
+    }
+    page->row_start[rows] = packed;
+    return page;
+}
+
+// Page holding a row, decoded if needed and marked most recently used.
+// Call with the lock held.
+static bridge_pattern_page* bridge_pattern_store_page(bridge_pattern_store* store, int32_t pattern, int32_t row, int prefetch) {
+    int32_t index = row / BRIDGE_PATTERN_PAGE_ROWS;
+    size_t slot = store->first_slot[pattern] + (size_t)index;
+    bridge_pattern_page* page = store->slots[slot];
+    if (page) {
+        if (!prefetch) store->hits++;
+        if (page != store->newest) {
+            bridge_page_unlink(store, page);
+            bridge_page_push(store, page);
+        }
+        return page;
+    }
+
+    page = bridge_page_decode(store, pattern, index);
+    if (!page) return NULL;
+    page->slot = slot;
+    store->slots[slot] = page;
+    bridge_page_push(store, page);
+    store->bytes += page->bytes;
+    store->pages++;
+    if (prefetch) store->prefetched++; else store->misses++;
+    bridge_pattern_store_trim(store);
+    return page;
+}
+
+static openmpt_pattern_cell bridge_page_cell(const bridge_pattern_store* store, const bridge_pattern_page* page,
+                                             int32_t row, int32_t channel) {
+    openmpt_pattern_cell cell = { 0, 0, 0, 0, 0 };
+    const uint64_t* bits = page->occupied + (size_t)row * store->words_per_row;
+    uint64_t bit = UINT64_C(1) << (channel % 64);
+    if (!(bits[channel / 64] & bit)) return cell;
+    size_t index = page->row_start[row];
+    for (int32_t word = 0; word < channel / 64; word++) index += (size_t)__builtin_popcountll(bits[word]);
+    index += (size_t)__builtin_popcountll(bits[channel / 64] & (bit - 1));
+    return page->cells[index];
+}
+
+// MARK: - Access
+
+static int bridge_pattern_store_valid(const bridge_pattern_store* store, int32_t pattern, int32_t row) {
+    return store && pattern >= 0 && pattern < store->patterns && row >= 0 && row < store->rows[pattern];
+}
+
+int bridge_pattern_store_get_cell(bridge_pattern_store* store, int32_t pattern, int32_t row, int32_t channel,
+                                  openmpt_pattern_cell* cell) {
+    if (!bridge_pattern_store_valid(store, pattern, row) || channel < 0 || channel >= store->channels) return 0;
+    pthread_mutex_lock(&store->lock);
+    bridge_pattern_page* page = bridge_pattern_store_page(store, pattern, row, 0);
+    if (page) *cell = bridge_page_cell(store, page, row % BRIDGE_PATTERN_PAGE_ROWS, channel);
+    pthread_mutex_unlock(&store->lock);
+    return page != NULL;
+}
+
+int bridge_pattern_store_get_row(bridge_pattern_store* store, int32_t pattern, int32_t row, openmpt_pattern_cell* cells) {
+    if (!bridge_pattern_store_valid(store, pattern, row)) return 0;
+    pthread_mutex_lock(&store->lock);
+    bridge_pattern_page* page = bridge_pattern_store_page(store, pattern, row, 0);
+    if (page) {
+        int32_t page_row = row % BRIDGE_PATTERN_PAGE_ROWS;
+        const uint64_t* bits = page->occupied + (size_t)page_row * store->words_per_row;
+        const openmpt_pattern_cell* packed = page->cells + page->row_start[page_row];
+        memset(cells, 0, (size_t)store->channels * sizeof(*cells));
+        for (int32_t channel = 0; channel < store->channels; channel++) {
+            if (bits[channel / 64] & (UINT64_C(1) << (channel % 64))) cells[channel] = *packed++;
+        }
+    }
+    pthread_mutex_unlock(&store->lock);
+    return page != NULL;
+}
+
+void bridge_pattern_store_prefetch(bridge_pattern_store* store, int32_t pattern) {
+    if (!store || pattern < 0 || pattern >= store->patterns) return;
+    pthread_mutex_lock(&store->lock);
+    for (int32_t row = 0; row < store->rows[pattern]; row += BRIDGE_PATTERN_PAGE_ROWS) {
+        if (!bridge_pattern_store_page(store, pattern, row, 1)) break;
+    }
+    pthread_mutex_unlock(&store->lock);
+}
+
+void bridge_pattern_store_get_stats(bridge_pattern_store* store, openmpt_bridge_pattern_cache_stats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (!store) return;
+    pthread_mutex_lock(&store->lock);
+    stats->hits = store->hits;
+    stats->misses = store->misses;
+    stats->evictions = store->evictions;
+    stats->prefetched = store->prefetched;
+    stats->bytes = store->bytes;
+    stats->budget = store->budget;
+    stats->pages = store->pages;
+    pthread_mutex_unlock(&store->lock);
+}
+
+void bridge_pattern_store_set_budget(bridge_pattern_store* store, size_t budget) {
+    if (!store) return;
+    pthread_mutex_lock(&store->lock);
+    store->budget = budget;
+    bridge_pattern_store_trim(store);
+    pthread_mutex_unlock(&store->lock);
+}
+
+double bridge_pattern_store_get_order_time(bridge_pattern_store* store, int32_t order) {
+    if (!store || order < 0 || order >= store->orders) return -1.0;
+    pthread_mutex_lock(&store->lock);
+    double seconds = store->order_times[order];
+    if (seconds == BRIDGE_ORDER_TIME_UNKNOWN) {
+        openmpt_module* mod = bridge_pattern_store_module(store);
+        seconds = mod ? openmpt_module_get_time_at_position(mod, order, 0) : -1.0;
+        store->order_times[order] = seconds;
+    }
+    pthread_mutex_unlock(&store->lock);
+    return seconds;
+}
@@ -0,0 +1,49 @@
+// bridge_pattern_store.h
+// Private pattern cells for module snapshots, decoded on first access into
+// a fixed-budget LRU of packed pages, and order start times worked out on
+// first request. Not part of the public module map.
+
+#ifndef CLIBOPENMPT_BRIDGE_PATTERN_STORE_H
+#define CLIBOPENMPT_BRIDGE_PATTERN_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libopenmpt.h"
+#include "openmpt_bridge_snapshot.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct bridge_pattern_store bridge_pattern_store;
+
+// Store for module data that decodes from its own pattern-only instance, so
+// it never touches the module a render thread owns. The data is copied and
+// parsed on first access. rows holds the row count of each of the patterns.
+// Returns NULL when out of memory.
+bridge_pattern_store* bridge_pattern_store_create(const void* data, size_t size, int32_t channels, int32_t orders,
+                                                  int32_t patterns, const int32_t* rows, size_t budget);
+void bridge_pattern_store_destroy(bridge_pattern_store* store);
+
+// Copy one cell, or the channels cells of a row. Thread-safe. Returns 0 if
+// out of range or the page cannot be decoded.
+int bridge_pattern_store_get_cell(bridge_pattern_store* store, int32_t pattern, int32_t row, int32_t channel,
+                                  openmpt_pattern_cell* cell);
+int bridge_pattern_store_get_row(bridge_pattern_store* store, int32_t pattern, int32_t row, openmpt_pattern_cell* cells);
+
+// Decode every page of a pattern that is not cached yet
+void bridge_pattern_store_prefetch(bridge_pattern_store* store, int32_t pattern);
+
+void bridge_pattern_store_get_stats(bridge_pattern_store* store, openmpt_bridge_pattern_cache_stats* stats);
+void bridge_pattern_store_set_budget(bridge_pattern_store* store, size_t budget);
+
+// Start of an order in seconds, -1 if it is never played. Each order costs
+// one scan of the song the first time it is asked for. Thread-safe.
+double bridge_pattern_store_get_order_time(bridge_pattern_store* store, int32_t order);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLIBOPENMPT_BRIDGE_PATTERN_STORE_H */
@@ -0,0 +1,420 @@
+// bridge_pcm.c
+// PCM conversion kernels, WAV headers and the double-buffered async writer
+
+#include "bridge_pcm.h"
+#include "bridge_internal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define BRIDGE_PCM_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define BRIDGE_PCM_SSE2 1
+#endif
+
+size_t bridge_sample_bytes(int32_t format) {
+    switch (format) {
+    case OPENMPT_BRIDGE_SAMPLE_FORMAT_S16: return 2;
+    case OPENMPT_BRIDGE_SAMPLE_FORMAT_S24: return 3;
+    case OPENMPT_BRIDGE_SAMPLE_FORMAT_F32: return 4;
+    default: return 0;
+    }
+}
+
+// MARK: - Conversion kernels
+
+static inline int32_t bridge_round_clamp(float value, float scale, int32_t low, int32_t high) {
+    float scaled = value * scale;
+    if (scaled <= (float)low) return low;
+    if (scaled >= (float)high) return high;
+    return (int32_t)lrintf(scaled);
+}
+
+void bridge_convert_f32_to_s16(const float* in, int16_t* out, size_t count) {
+    size_t i = 0;
+#if defined(BRIDGE_PCM_NEON)
+    const float32x4_t scale = vdupq_n_f32(32768.0f);
+    for (; i + 8 <= count; i += 8) {
+        int32x4_t a = vcvtnq_s32_f32(vmulq_f32(vld1q_f32(in + i), scale));
+        int32x4_t b = vcvtnq_s32_f32(vmulq_f32(vld1q_f32(in + i + 4), scale));
+        // Saturating narrow clips to [-32768, 32767]
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+    }
+#elif defined(BRIDGE_PCM_SSE2)
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    const __m128 high = _mm_set1_ps(32767.0f);
+    for (; i + 8 <= count; i += 8) {
+        // Out-of-range floats convert to INT32_MIN, which the saturating
+        // pack maps to -32768; clamp the positive side before converting
+        __m128i a = _mm_cvtps_epi32(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(in + i), scale), high));
+        __m128i b = _mm_cvtps_epi32(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(in + i + 4), scale), high));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(a, b));
+    }
+#endif
+    for (; i < count; i++) {
+        out[i] = (int16_t)bridge_round_clamp(in[i], 32768.0f, -32768, 32767);
+    }
+}
+
+void bridge_convert_f32_to_s24(const float* in, uint8_t* out, size_t count) {
+    size_t i = 0;
+    int32_t converted[8];
+#if defined(BRIDGE_PCM_NEON)
+    const float32x4_t scale = vdupq_n_f32(8388608.0f);
+    const float32x4_t low = vdupq_n_f32(-8388608.0f);
+    const float32x4_t high = vdupq_n_f32(8388607.0f);
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t a = vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(in + i), scale), low), high);
+        float32x4_t b = vminq_f32(vmaxq_f32(vmulq_f32(vld1q_f32(in + i + 4), scale), low), high);
+        vst1q_s32(converted, vcvtnq_s32_f32(a));
+        vst1q_s32(converted + 4, vcvtnq_s32_f32(b));
+        for (int k = 0; k < 8; k++) {
+            uint8_t* p = out + (i + (size_t)k) * 3;
+            p[0] = (uint8_t)converted[k];
+            p[1] = (uint8_t)(converted[k] >> 8);
+            p[2] = (uint8_t)(converted[k] >> 16);
+        }
+    }
+#elif defined(BRIDGE_PCM_SSE2)
+    const __m128 scale = _mm_set1_ps(8388608.0f);
+    const __m128 low = _mm_set1_ps(-8388608.0f);
+    const __m128 high = _mm_set1_ps(8388607.0f);
+    for (; i + 8 <= count; i += 8) {
+        __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i), scale), low), high);
+        __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i + 4), scale), low), high);
+        _mm_storeu_si128((__m128i*)converted, _mm_cvtps_epi32(a));
+        _mm_storeu_si128((__m128i*)(converted + 4), _mm_cvtps_epi32(b));
+        for (int k = 0; k < 8; k++) {
+            uint8_t* p = out + (i + (size_t)k) * 3;
+            p[0] = (uint8_t)converted[k];
+            p[1] = (uint8_t)(converted[k] >> 8);
+            p[2] = (uint8_t)(converted[k] >> 16);
+        }
+    }
+#else
+    (void)converted;
+#endif
+    for (; i < count; i++) {
+        int32_t value = bridge_round_clamp(in[i], 8388608.0f, -8388608, 8388607);
+        uint8_t* p = out + i * 3;
+        p[0] = (uint8_t)value;
+        p[1] = (uint8_t)(value >> 8);
+        p[2] = (uint8_t)(value >> 16);
+    }
+}
+
+void bridge_convert_samples(const float* in, void* out, size_t count, int32_t format) {
+    switch (format) {
+    case OPENMPT_BRIDGE_SAMPLE_FORMAT_S16:
+        bridge_convert_f32_to_s16(in, (int16_t*)out, count);
+        break;
+    case OPENMPT_BRIDGE_SAMPLE_FORMAT_S24:
+        bridge_convert_f32_to_s24(in, (uint8_t*)out, count);
+        break;
+    case OPENMPT_BRIDGE_SAMPLE_FORMAT_F32:
+        memcpy(out, in, count * sizeof(float));
+        break;
+    default:
+        break;
+    }
+}
+
+// MARK: - Silence detection
+
+size_t bridge_audible_frames(const float* interleaved, size_t frames, int32_t channels, float threshold) {
+    size_t count = frames * (size_t)channels;
+    // Scan backwards; the odd samples past the last full vector go first
+    size_t i = count;
+    while (i % 8) {
+        i--;
+        if (fabsf(interleaved[i]) > threshold) return i / (size_t)channels + 1;
+    }
+#if defined(BRIDGE_PCM_NEON)
+    const float32x4_t limit = vdupq_n_f32(threshold);
+    for (; i; i -= 8) {
+        uint32x4_t loud = vorrq_u32(vcagtq_f32(vld1q_f32(interleaved + i - 8), limit),
+                                    vcagtq_f32(vld1q_f32(interleaved + i - 4), limit));
+        if (vmaxvq_u32(loud)) break;
+    }
+#elif defined(BRIDGE_PCM_SSE2)
+    const __m128 limit = _mm_set1_ps(threshold);
+    const __m128 magnitude = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    for (; i; i -= 8) {
+        __m128 a = _mm_cmpgt_ps(_mm_and_ps(_mm_loadu_ps(interleaved + i - 8), magnitude), limit);
+        __m128 b = _mm_cmpgt_ps(_mm_and_ps(_mm_loadu_ps(interleaved + i - 4), magnitude), limit);
+        if (_mm_movemask_ps(_mm_or_ps(a, b))) break;
+    }
+#endif
+    // Locate the loud sample within the vector that stopped the scan
+    while (i) {
+        i--;
+        if (fabsf(interleaved[i]) > threshold) return i / (size_t)channels + 1;
+    }
+    return 0;
+}
+
+// MARK: - WAV header
+
+static uint8_t* bridge_put32(uint8_t* p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+    return p + 4;
+}
+
+static uint8_t* bridge_put16(uint8_t* p, uint16_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    return p + 2;
+}
+
+size_t bridge_wav_header(uint8_t* out, int32_t format, int32_t sample_rate, int32_t channels, uint64_t data_bytes) {
+    int is_float = format == OPENMPT_BRIDGE_SAMPLE_FORMAT_F32;
+    uint32_t sample_bytes = (uint32_t)bridge_sample_bytes(format);
+    uint32_t block_align = sample_bytes * (uint32_t)channels;
+    // RIFF sizes are 32-bit; longer renders keep playing in most readers
+    uint32_t data_size = data_bytes > 0xFFFFFF00ull ? 0xFFFFFF00u : (uint32_t)data_bytes;
+    // Float data uses the 18-byte fmt chunk plus a fact chunk
+    uint32_t fmt_size = is_float ? 18 : 16;
+    uint32_t fact_size = is_float ? 12 : 0;
+    uint32_t header_size = 12 + 8 + fmt_size + fact_size + 8;
+
+    uint8_t* p = out;
+    memcpy(p, "RIFF", 4);
+    p = bridge_put32(p + 4, header_size - 8 + data_size);
+    memcpy(p, "WAVEfmt ", 8);
+    p = bridge_put32(p + 8, fmt_size);
+    p = bridge_put16(p, is_float ? 3 : 1);
+    p = bridge_put16(p, (uint16_t)channels);
+    p = bridge_put32(p, (uint32_t)sample_rate);
+    p = bridge_put32(p, (uint32_t)sample_rate * block_align);
+    p = bridge_put16(p, (uint16_t)block_align);
+    p = bridge_put16(p, (uint16_t)(sample_bytes * 8));
+    if (is_float) {
+        p = bridge_put16(p, 0);
+        memcpy(p, "fact", 4);
+        p = bridge_put32(p + 4, 4);
+        p = bridge_put32(p, block_align ? data_size / block_align : 0);
+    }
+    memcpy(p, "data", 4);
+    p = bridge_put32(p + 4, data_size);
+    return (size_t)(p - out);
+}
+
+// MARK: - Async writer
+
+enum {
+    BRIDGE_BLOCK_FREE = 0,
+    BRIDGE_BLOCK_FILLING = 1,
+    BRIDGE_BLOCK_QUEUED = 2
+};
+
+struct bridge_writer {
+    int fd;
+    int32_t container;
+    int32_t format;
+    int32_t sample_rate;
+    int32_t channels;
+    size_t block_frames;
+    size_t header_size;
+
+    float* blocks[2];
+    size_t frames[2];
+    int state[2];
+    int fill_index;
+    int write_index;
+    void* converted;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int closing;
+    int failed;
+
+    uint64_t data_bytes;
+    double wait_seconds;
+};
+
+static int bridge_write_all(int fd, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    while (size) {
+        ssize_t wrote = write(fd, bytes, size);
+        if (wrote < 0 && errno == EINTR) continue;
+        if (wrote <= 0) return 0;
+        bytes += wrote;
+        size -= (size_t)wrote;
+    }
+    return 1;
+}
+
+int bridge_pwrite_all(int fd, const void* data, size_t size, uint64_t offset) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    while (size) {
+        ssize_t wrote = pwrite(fd, bytes, size, (off_t)offset);
+        if (wrote < 0 && errno == EINTR) continue;
+        if (wrote <= 0) return 0;
+        bytes += wrote;
+        size -= (size_t)wrote;
+        offset += (uint64_t)wrote;
+    }
+    return 1;
+}
+
+static void* bridge_writer_main(void* arg) {
+    bridge_writer* writer = (bridge_writer*)arg;
+    size_t sample_bytes = bridge_sample_bytes(writer->format);
+
+    pthread_mutex_lock(&writer->lock);
+    for (;;) {
+        int index = writer->write_index;
+        while (writer->state[index] != BRIDGE_BLOCK_QUEUED && !writer->closing) {
+            pthread_cond_wait(&writer->cond, &writer->lock);
+        }
+        if (writer->state[index] != BRIDGE_BLOCK_QUEUED) break; // closing and drained
+        size_t frames = writer->frames[index];
+        pthread_mutex_unlock(&writer->lock);
+
+        // Conversion runs here so the producer thread only renders
+        size_t samples = frames * (size_t)writer->channels;
+        bridge_convert_samples(writer->blocks[index], writer->converted, samples, writer->format);
+        int ok = bridge_write_all(writer->fd, writer->converted, samples * sample_bytes);
+
+        pthread_mutex_lock(&writer->lock);
+        if (!ok) writer->failed = 1;
+        writer->data_bytes += samples * sample_bytes;
+        writer->state[index] = BRIDGE_BLOCK_FREE;
+        writer->write_index ^= 1;
+        pthread_cond_broadcast(&writer->cond);
+    }
+    pthread_mutex_unlock(&writer->lock);
+    return NULL;
+}
+
+bridge_writer* bridge_writer_open(const char* path, int32_t container, int32_t format,
+                                  int32_t sample_rate, int32_t channels, size_t block_frames) {
+    size_t sample_bytes = bridge_sample_bytes(format);
+    if (!path || !sample_bytes || channels <= 0 || sample_rate <= 0 || block_frames == 0) return NULL;
+    if (container != OPENMPT_BRIDGE_CONTAINER_WAV && container != OPENMPT_BRIDGE_CONTAINER_RAW) return NULL;
+
+    bridge_writer* writer = calloc(1, sizeof(*writer));
+    if (!writer) return NULL;
+    writer->container = container;
+    writer->format = format;
+    writer->sample_rate = sample_rate;
+    writer->channels = channels;
+    writer->block_frames = block_frames;
+
+    size_t samples = block_frames * (size_t)channels;
+    writer->blocks[0] = malloc(samples * sizeof(float));
+    writer->blocks[1] = malloc(samples * sizeof(float));
+    writer->converted = malloc(samples * sample_bytes);
+    writer->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (!writer->blocks[0] || !writer->blocks[1] || !writer->converted || writer->fd < 0) goto fail;
+
+    if (container == OPENMPT_BRIDGE_CONTAINER_WAV) {
+        // Placeholder sizes, rewritten on close
+        uint8_t header[BRIDGE_WAV_HEADER_MAX];
+        writer->header_size = bridge_wav_header(header, format, sample_rate, channels, 0);
+        if (!bridge_write_all(writer->fd, header, writer->header_size)) goto fail;
+    }
+
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->cond, NULL);
+    if (pthread_create(&writer->thread, NULL, bridge_writer_main, writer) != 0) {
+        pthread_mutex_destroy(&writer->lock);
+        pthread_cond_destroy(&writer->cond);
+        goto fail;
+    }
+    return writer;
+
+fail:
+    if (writer->fd >= 0) {
+        close(writer->fd);
+        unlink(path);
+    }
+    free(writer->blocks[0]);
+    free(writer->blocks[1]);
+    free(writer->converted);
+    free(writer);
+    return NULL;
+}
+
+float* bridge_writer_acquire(bridge_writer* writer) {
+    pthread_mutex_lock(&writer->lock);
+    int index = writer->fill_index;
+    if (writer->state[index] != BRIDGE_BLOCK_FREE) {
+        uint64_t start = bridge_now_ns();
+        while (writer->state[index] != BRIDGE_BLOCK_FREE) {
+            pthread_cond_wait(&writer->cond, &writer->lock);
+        }
+        writer->wait_seconds += (double)(bridge_now_ns() - start) * 1e-9;
+    }
+    writer->state[index] = BRIDGE_BLOCK_FILLING;
+    pthread_mutex_unlock(&writer->lock);
+    return writer->blocks[index];
+}
+
+int bridge_writer_submit(bridge_writer* writer, size_t frames) {
+    pthread_mutex_lock(&writer->lock);
+    int index = writer->fill_index;
+    if (frames > writer->block_frames) frames = writer->block_frames;
+    writer->frames[index] = frames;
+    writer->state[index] = BRIDGE_BLOCK_QUEUED;
+    writer->fill_index ^= 1;
+    int ok = !writer->failed;
+    pthread_cond_broadcast(&writer->cond);
+    pthread_mutex_unlock(&writer->lock);
+    return ok;
+}
+
+int bridge_writer_close(bridge_writer* writer) {
+    return bridge_writer_close_trimmed(writer, UINT64_MAX);
+}
+
+int bridge_writer_close_trimmed(bridge_writer* writer, uint64_t keep_frames) {
+    if (!writer) return 0;
+
+    pthread_mutex_lock(&writer->lock);
+    writer->closing = 1;
+    pthread_cond_broadcast(&writer->cond);
+    pthread_mutex_unlock(&writer->lock);
+    pthread_join(writer->thread, NULL);
+
+    int ok = !writer->failed;
+    uint64_t frame_bytes = bridge_sample_bytes(writer->format) * (uint64_t)writer->channels;
+    if (ok && keep_frames < writer->data_bytes / frame_bytes) {
+        writer->data_bytes = keep_frames * frame_bytes;
+        ok = ftruncate(writer->fd, (off_t)(writer->header_size + writer->data_bytes)) == 0;
+    }
+    if (ok && writer->container == OPENMPT_BRIDGE_CONTAINER_WAV) {
+        uint8_t header[BRIDGE_WAV_HEADER_MAX];
+        size_t size = bridge_wav_header(header, writer->format, writer->sample_rate, writer->channels, writer->data_bytes);
+        ok = pwrite(writer->fd, header, size, 0) == (ssize_t)size;
+    }
+    if (close(writer->fd) != 0) ok = 0;
+
+    pthread_mutex_destroy(&writer->lock);
+    pthread_cond_destroy(&writer->cond);
+    free(writer->blocks[0]);
+    free(writer->blocks[1]);
+    free(writer->converted);
+    free(writer);
+    return ok;
+}
+
+double bridge_writer_wait_seconds(const bridge_writer* writer) {
+    return writer ? writer->wait_seconds : 0.0;
+}
+
+uint64_t bridge_writer_bytes_written(const bridge_writer* writer) {
+    return writer ? writer->data_bytes : 0;
+}
@@ -0,0 +1,62 @@
+// bridge_pcm.h
+// Private PCM conversion kernels and the double-buffered file writer.
+// Not part of the public module map.
+
+#ifndef CLIBOPENMPT_BRIDGE_PCM_H
+#define CLIBOPENMPT_BRIDGE_PCM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "openmpt_bridge_export.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bytes per sample of an openmpt_bridge_sample_format, 0 if unknown
+size_t bridge_sample_bytes(int32_t format);
+
+// Conversion kernels. Input is float in [-1, 1]; out-of-range values clip.
+void bridge_convert_f32_to_s16(const float* in, int16_t* out, size_t count);
+void bridge_convert_f32_to_s24(const float* in, uint8_t* out, size_t count);
+void bridge_convert_samples(const float* in, void* out, size_t count, int32_t format);
+
+// Frames up to and including the last one holding a sample whose magnitude
+// exceeds threshold; 0 if the whole buffer is silent
+size_t bridge_audible_frames(const float* interleaved, size_t frames, int32_t channels, float threshold);
+
+// Serialize a WAV header for data_bytes of audio. Returns the header size
+// (at most BRIDGE_WAV_HEADER_MAX), which depends only on the format.
+#define BRIDGE_WAV_HEADER_MAX 64
+size_t bridge_wav_header(uint8_t* out, int32_t format, int32_t sample_rate, int32_t channels, uint64_t data_bytes);
+
+// Positional write of the whole buffer, retrying short writes. Returns 1 on success.
+int bridge_pwrite_all(int fd, const void* data, size_t size, uint64_t offset);
+
+// Double-buffered asynchronous writer.
+//
+// The producer fills one float block while a writer thread converts and
+// writes the other, so rendering and disk I/O overlap. acquire() blocks only
+// when both blocks are still queued.
+typedef struct bridge_writer bridge_writer;
+
+bridge_writer* bridge_writer_open(const char* path, int32_t container, int32_t format,
+                                  int32_t sample_rate, int32_t channels, size_t block_frames);
+// Next block to fill with up to block_frames interleaved frames
+float* bridge_writer_acquire(bridge_writer* writer);
+// Queue the acquired block holding frames frames. Returns 0 after an I/O error.
+int bridge_writer_submit(bridge_writer* writer, size_t frames);
+// Drain, finalize the header and close. Returns 1 if every write succeeded.
+int bridge_writer_close(bridge_writer* writer);
+// Same, but cut the file after keep_frames frames if more were written
+int bridge_writer_close_trimmed(bridge_writer* writer, uint64_t keep_frames);
+// Seconds the producer spent blocked in acquire()
+double bridge_writer_wait_seconds(const bridge_writer* writer);
+uint64_t bridge_writer_bytes_written(const bridge_writer* writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLIBOPENMPT_BRIDGE_PCM_H */
@@ -0,0 +1,299 @@
+// bridge_util.c
+// Threading, timing, file and hashing helpers used across the bridge
+
+#include "bridge_internal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+// MARK: - Time
+
+uint64_t bridge_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+double bridge_now_seconds(void) {
+    return (double)bridge_now_ns() * 1e-9;
+}
+
+// MARK: - Threads
+
+int bridge_cpu_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+int bridge_resolve_thread_count(int requested, size_t jobs) {
+    int threads = requested > 0 ? requested : bridge_cpu_count();
+    if (jobs < (size_t)threads) threads = (int)jobs;
+    return threads > 0 ? threads : 1;
+}
+
+typedef struct bridge_parallel_ctx {
+    atomic_size_t next;
+    size_t count;
+    bridge_job_func fn;
+    void* user;
+} bridge_parallel_ctx;
+
+typedef struct bridge_parallel_worker {
+    bridge_parallel_ctx* shared;
+    int index;
+} bridge_parallel_worker;
+
+static void* bridge_parallel_main(void* arg) {
+    bridge_parallel_worker* worker = (bridge_parallel_worker*)arg;
+    bridge_parallel_ctx* shared = worker->shared;
+    for (;;) {
+        size_t index = atomic_fetch_add_explicit(&shared->next, 1, memory_order_relaxed);
+        if (index >= shared->count) break;
+        shared->fn(shared->user, index, worker->index);
+    }
+    return NULL;
+}
+
+void bridge_parallel_for(size_t count, int thread_count, bridge_job_func fn, void* ctx) {
+    if (count == 0 || !fn) return;
+    int threads = bridge_resolve_thread_count(thread_count, count);
+
+    bridge_parallel_ctx shared;
+    atomic_init(&shared.next, 0);
+    shared.count = count;
+    shared.fn = fn;
+    shared.user = ctx;
+
+    bridge_parallel_worker* workers = calloc((size_t)threads, sizeof(*workers));
+    pthread_t* handles = calloc((size_t)threads, sizeof(*handles));
+    if (!workers || !handles) {
+        // Fall back to running everything on the calling thread
+        free(workers);
+        free(handles);
+        for (size_t i = 0; i < count; i++) fn(ctx, i, 0);
+        return;
+    }
+
+    // The calling thread acts as worker 0
+    int started = 1;
+    for (int i = 1; i < threads; i++) {
+        workers[i].shared = &shared;
+        workers[i].index = i;
+        if (pthread_create(&handles[i], NULL, bridge_parallel_main, &workers[i]) != 0) break;
+        started++;
+    }
+    workers[0].shared = &shared;
+    workers[0].index = 0;
+    bridge_parallel_main(&workers[0]);
+
+    for (int i = 1; i < started; i++) {
+        pthread_join(handles[i], NULL);
+    }
+    free(workers);
+    free(handles);
+}
+
+// MARK: - Files
+
+int bridge_read_file(const char* path, void** data, size_t* size) {
+    if (!path || !data || !size) return 0;
+    *data = NULL;
+    *size = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 0) {
+        close(fd);
+        return 0;
+    }
+
+    size_t length = (size_t)st.st_size;
+    unsigned char* buffer = malloc(length ? length : 1);
+    if (!buffer) {
+        close(fd);
+        return 0;
+    }
+
+    size_t done = 0;
+    while (done < length) {
+        ssize_t got = read(fd, buffer + done, length - done);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        done += (size_t)got;
+    }
+    close(fd);
+
+    if (done != length) {
+        free(buffer);
+        return 0;
+    }
+    *data = buffer;
+    *size = length;
+    return 1;
+}
+
+int bridge_map_file(const char* path, const void** data, size_t* size) {
+    if (!path || !data || !size) return 0;
+    *data = NULL;
+    *size = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return 0;
+    }
+
+    void* mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return 0;
+
+    *data = mapping;
+    *size = (size_t)st.st_size;
+    return 1;
+}
+
+void bridge_unmap_file(const void* data, size_t size) {
+    if (data && size) munmap((void*)data, size);
+}
+
+int bridge_write_file_atomic(const char* path, const void* data, size_t size) {
+    if (!path) return 0;
+
+    size_t path_length = strlen(path);
+    char* temp_path = malloc(path_length + 32);
+    if (!temp_path) return 0;
+    snprintf(temp_path, path_length + 32, "%s.tmp.%ld", path, (long)getpid());
+
+    int fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        free(temp_path);
+        return 0;
+    }
+
+    const unsigned char* bytes = (const unsigned char*)data;
+    size_t done = 0;
+    while (done < size) {
+        ssize_t wrote = write(fd, bytes + done, size - done);
+        if (wrote < 0 && errno == EINTR) continue;
+        if (wrote <= 0) break;
+        done += (size_t)wrote;
+    }
+
+    // Close even after a failed write so the descriptor is never leaked
+    int closed = close(fd) == 0;
+    int ok = done == size && closed;
+    if (ok) ok = rename(temp_path, path) == 0;
+    if (!ok) unlink(temp_path);
+    free(temp_path);
+    return ok;
+}
+
+// MARK: - Hashing (XXH64)
+
+#define BRIDGE_XXH_PRIME1 0x9E3779B185EBCA87ull
+#define BRIDGE_XXH_PRIME2 0xC2B2AE3D27D4EB4Full
+#define BRIDGE_XXH_PRIME3 0x165667B19E3779F9ull
+#define BRIDGE_XXH_PRIME4 0x85EBCA77C2B2AE63ull
+#define BRIDGE_XXH_PRIME5 0x27D4EB2F165667C5ull
+
+static inline uint64_t bridge_rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t bridge_read64(const unsigned char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t bridge_read32(const unsigned char* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t bridge_xxh_round(uint64_t acc, uint64_t input) {
+    acc += input * BRIDGE_XXH_PRIME2;
+    acc = bridge_rotl64(acc, 31);
+    return acc * BRIDGE_XXH_PRIME1;
+}
+
+static inline uint64_t bridge_xxh_merge(uint64_t acc, uint64_t value) {
+    acc ^= bridge_xxh_round(0, value);
+    return acc * BRIDGE_XXH_PRIME1 + BRIDGE_XXH_PRIME4;
+}
+
+uint64_t bridge_hash64(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* p = (const unsigned char*)data;
+    const unsigned char* end = p + size;
+    uint64_t h;
+
+    if (size >= 32) {
+        uint64_t v1 = seed + BRIDGE_XXH_PRIME1 + BRIDGE_XXH_PRIME2;
+        uint64_t v2 = seed + BRIDGE_XXH_PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - BRIDGE_XXH_PRIME1;
+        const unsigned char* limit = end - 32;
+        do {
+            v1 = bridge_xxh_round(v1, bridge_read64(p));
+            v2 = bridge_xxh_round(v2, bridge_read64(p + 8));
+            v3 = bridge_xxh_round(v3, bridge_read64(p + 16));
+            v4 = bridge_xxh_round(v4, bridge_read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = bridge_rotl64(v1, 1) + bridge_rotl64(v2, 7) + bridge_rotl64(v3, 12) + bridge_rotl64(v4, 18);
+        h = bridge_xxh_merge(h, v1);
+        h = bridge_xxh_merge(h, v2);
+        h = bridge_xxh_merge(h, v3);
+        h = bridge_xxh_merge(h, v4);
+    } else {
+        h = seed + BRIDGE_XXH_PRIME5;
+    }
+
+    h += (uint64_t)size;
+
+    while (p + 8 <= end) {
+        h ^= bridge_xxh_round(0, bridge_read64(p));
+        h = bridge_rotl64(h, 27) * BRIDGE_XXH_PRIME1 + BRIDGE_XXH_PRIME4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)bridge_read32(p) * BRIDGE_XXH_PRIME1;
+        h = bridge_rotl64(h, 23) * BRIDGE_XXH_PRIME2 + BRIDGE_XXH_PRIME3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= (uint64_t)(*p) * BRIDGE_XXH_PRIME5;
+        h = bridge_rotl64(h, 11) * BRIDGE_XXH_PRIME1;
+        p++;
+    }
+
+    h ^= h >> 33;
+    h *= BRIDGE_XXH_PRIME2;
+    h ^= h >> 29;
+    h *= BRIDGE_XXH_PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+// MARK: - libopenmpt helpers
+
+char* bridge_copy_metadata(openmpt_module* mod, const char* key) {
+    const char* value = mod ? openmpt_module_get_metadata(mod, key) : NULL;
+    char* copy = strdup(value ? value : "");
+    if (value) openmpt_free_string(value);
+    return copy;
+}
@@ -34,24 +34,56 @@ typedef struct openmpt_pattern_cell {
 } openmpt_pattern_cell;
 #endif
 
+// Initial control passed to module creation, terminated by { NULL, NULL }
+typedef struct openmpt_module_initial_ctl {
+    const char * ctl;
+    const char * value;
+} openmpt_module_initial_ctl;
+
 // Essential function declarations for the module lifecycle
 extern uint32_t openmpt_get_library_version(void);
 extern uint32_t openmpt_get_core_version(void);
 extern const char * openmpt_get_string( const char * key );
 extern void openmpt_free_string( const char * str );
+extern void openmpt_log_func_silent( const char * message, void * user );
+
+// Format probing
+#define OPENMPT_PROBE_FILE_HEADER_FLAGS_MODULES    0x1ull
+#define OPENMPT_PROBE_FILE_HEADER_FLAGS_CONTAINERS 0x2ull
+#define OPENMPT_PROBE_FILE_HEADER_FLAGS_DEFAULT    ( OPENMPT_PROBE_FILE_HEADER_FLAGS_MODULES | OPENMPT_PROBE_FILE_HEADER_FLAGS_CONTAINERS )
+#define OPENMPT_PROBE_FILE_HEADER_RESULT_SUCCESS      1
+#define OPENMPT_PROBE_FILE_HEADER_RESULT_FAILURE      0
+#define OPENMPT_PROBE_FILE_HEADER_RESULT_WANTMOREDATA (-1)
+#define OPENMPT_PROBE_FILE_HEADER_RESULT_ERROR        (-255)
+extern size_t openmpt_probe_file_header_get_recommended_size( void );
+extern int openmpt_probe_file_header( uint64_t flags, const void * data, size_t size, uint64_t filesize, void * logfunc, void * loguser, void * errfunc, void * erruser, int * error, const char * * error_message );
 
 // Module creation and destruction
+#define OPENMPT_STREAM_SEEK_SET 0
+#define OPENMPT_STREAM_SEEK_CUR 1
+#define OPENMPT_STREAM_SEEK_END 2
+typedef size_t (*openmpt_stream_read_func)( void * stream, void * dst, size_t bytes );
+typedef int (*openmpt_stream_seek_func)( void * stream, int64_t offset, int whence );
+typedef int64_t (*openmpt_stream_tell_func)( void * stream );
+typedef struct openmpt_stream_callbacks {
+    openmpt_stream_read_func read;
+    openmpt_stream_seek_func seek;
+    openmpt_stream_tell_func tell;
+} openmpt_stream_callbacks;
+extern openmpt_module * openmpt_module_create2( openmpt_stream_callbacks stream_callbacks, void * stream, void * logfunc, void * loguser, void * errfunc, void * erruser, int * error, const char * * error_message, const void * ctls );
 __attribute__((visibility("default"))) extern openmpt_module * openmpt_module_create_from_memory2( const void * filedata, size_t filesize, void * logfunc, void * loguser, void * errfunc, void * erruser, int * error, const char * * error_message, const void * ctls );
 __attribute__((visibility("default"))) extern void openmpt_module_destroy( openmpt_module * mod );
 
 // Playback control
 extern int openmpt_module_set_repeat_count( openmpt_module * mod, int32_t repeat_count );
+extern int32_t openmpt_module_get_repeat_count( openmpt_module * mod );
 extern double openmpt_module_get_duration_seconds( openmpt_module * mod );
 extern double openmpt_module_set_position_seconds( openmpt_module * mod, double seconds );
 extern double openmpt_module_get_position_seconds( openmpt_module * mod );
 
 // Audio rendering
 extern size_t openmpt_module_read_interleaved_float_stereo( openmpt_module * mod, int32_t samplerate, size_t count, float * interleaved_stereo );
+extern size_t openmpt_module_read_float_stereo( openmpt_module * mod, int32_t samplerate, size_t count, float * left, float * right );
 
 // Module information
 extern const char * openmpt_module_get_metadata( openmpt_module * mod, const char * key );
@@ -61,6 +93,7 @@ extern int32_t openmpt_module_get_num_patterns( openmpt_module * mod );
 extern int32_t openmpt_module_get_num_channels( openmpt_module * mod );
 extern const char * openmpt_module_get_instrument_name( openmpt_module * mod, int32_t index );
 extern const char * openmpt_module_get_sample_name( openmpt_module * mod, int32_t index );
+extern int32_t openmpt_module_get_current_playing_channels( openmpt_module * mod );
 
 // Current position info
 extern int32_t openmpt_module_get_current_order( openmpt_module * mod );
@@ -71,6 +104,12 @@ extern double openmpt_module_get_current_tempo2( openmpt_module * mod );
 
 // Standard libopenmpt functions that exist in the XCFramework
 extern int32_t openmpt_module_get_pattern_num_rows( openmpt_module * mod, int32_t pattern );
+#define OPENMPT_MODULE_COMMAND_NOTE         0
+#define OPENMPT_MODULE_COMMAND_INSTRUMENT   1
+#define OPENMPT_MODULE_COMMAND_VOLUMEEFFECT 2
+#define OPENMPT_MODULE_COMMAND_EFFECT       3
+#define OPENMPT_MODULE_COMMAND_VOLUME       4
+#define OPENMPT_MODULE_COMMAND_PARAMETER    5
 extern uint8_t openmpt_module_get_pattern_row_channel_command( openmpt_module * mod, int32_t pattern, int32_t row, int32_t channel, int command );
 extern const char * openmpt_module_get_pattern_name( openmpt_module * mod, int32_t index );
 extern int32_t openmpt_module_get_pattern_rows_per_beat( openmpt_module * mod, int32_t pattern );
@@ -78,14 +117,60 @@ extern int32_t openmpt_module_get_pattern_rows_per_measure( openmpt_module * mod
 extern int32_t openmpt_module_get_num_orders( openmpt_module * mod );
 extern int32_t openmpt_module_get_order_pattern( openmpt_module * mod, int32_t order );
 extern double openmpt_module_set_position_order_row( openmpt_module * mod, int32_t order, int32_t row );
+extern double openmpt_module_get_time_at_position( openmpt_module * mod, int32_t order, int32_t row );
 extern int32_t openmpt_module_get_num_subsongs( openmpt_module * mod );
 extern int32_t openmpt_module_get_selected_subsong( openmpt_module * mod );
 extern int openmpt_module_select_subsong( openmpt_module * mod, int32_t subsong );
-extern int32_t openmpt_module_get_render_param( openmpt_module * mod, int param );
+extern int32_t openmpt_module_get_restart_order( openmpt_module * mod, int32_t subsong );
+extern int32_t openmpt_module_get_restart_row( openmpt_module * mod, int32_t subsong );
+extern const char * openmpt_module_get_subsong_name( openmpt_module * mod, int32_t index );
+#define OPENMPT_MODULE_RENDER_MASTERGAIN_MILLIBEL        1
+#define OPENMPT_MODULE_RENDER_STEREOSEPARATION_PERCENT   2
+#define OPENMPT_MODULE_RENDER_INTERPOLATIONFILTER_LENGTH 3
+#define OPENMPT_MODULE_RENDER_VOLUMERAMPING_STRENGTH     4
+extern int openmpt_module_get_render_param( openmpt_module * mod, int param, int32_t * value );
 extern int openmpt_module_set_render_param( openmpt_module * mod, int param, int32_t value );
 extern const char * openmpt_module_ctl_get( openmpt_module * mod, const char * ctl );
 extern int openmpt_module_ctl_set( openmpt_module * mod, const char * ctl, const char * value );
 
+// Extended module interface (libopenmpt_ext.h)
+typedef struct openmpt_module_ext openmpt_module_ext;
+extern openmpt_module_ext * openmpt_module_ext_create_from_memory( const void * filedata, size_t filesize, void * logfunc, void * loguser, void * errfunc, void * erruser, int * error, const char * * error_message, const openmpt_module_initial_ctl * ctls );
+extern void openmpt_module_ext_destroy( openmpt_module_ext * mod_ext );
+// The module is owned by mod_ext and must not be destroyed separately
+extern openmpt_module * openmpt_module_ext_get_module( openmpt_module_ext * mod_ext );
+extern int openmpt_module_ext_get_interface( openmpt_module_ext * mod_ext, const char * interface_id, void * interface, size_t interface_size );
+
+#define LIBOPENMPT_EXT_C_INTERFACE_INTERACTIVE "interactive"
+typedef struct openmpt_module_ext_interface_interactive {
+    int ( * set_current_speed )( openmpt_module_ext * mod_ext, int32_t speed );
+    int ( * set_current_tempo )( openmpt_module_ext * mod_ext, int32_t tempo );
+    int ( * set_tempo_factor )( openmpt_module_ext * mod_ext, double factor );
+    double ( * get_tempo_factor )( openmpt_module_ext * mod_ext );
+    int ( * set_pitch_factor )( openmpt_module_ext * mod_ext, double factor );
+    double ( * get_pitch_factor )( openmpt_module_ext * mod_ext );
+    int ( * set_global_volume )( openmpt_module_ext * mod_ext, double volume );
+    double ( * get_global_volume )( openmpt_module_ext * mod_ext );
+    int ( * set_channel_volume )( openmpt_module_ext * mod_ext, int32_t channel, double volume );
+    double ( * get_channel_volume )( openmpt_module_ext * mod_ext, int32_t channel );
+    int ( * set_channel_mute_status )( openmpt_module_ext * mod_ext, int32_t channel, int mute );
+    int ( * get_channel_mute_status )( openmpt_module_ext * mod_ext, int32_t channel );
+    int ( * set_instrument_mute_status )( openmpt_module_ext * mod_ext, int32_t instrument, int mute );
+    int ( * get_instrument_mute_status )( openmpt_module_ext * mod_ext, int32_t instrument );
+    int32_t ( * play_note )( openmpt_module_ext * mod_ext, int32_t instrument, int32_t note, double volume, double panning );
+    int ( * stop_note )( openmpt_module_ext * mod_ext, int32_t channel );
+} openmpt_module_ext_interface_interactive;
+
+#define LIBOPENMPT_EXT_C_INTERFACE_INTERACTIVE2 "interactive2"
+typedef struct openmpt_module_ext_interface_interactive2 {
+    int ( * note_off )( openmpt_module_ext * mod_ext, int32_t channel );
+    int ( * note_fade )( openmpt_module_ext * mod_ext, int32_t channel );
+    int ( * set_channel_panning )( openmpt_module_ext * mod_ext, int32_t channel, double panning );
+    double ( * get_channel_panning )( openmpt_module_ext * mod_ext, int32_t channel );
+    int ( * set_note_finetune )( openmpt_module_ext * mod_ext, int32_t channel, double finetune );
+    double ( * get_note_finetune )( openmpt_module_ext * mod_ext, int32_t channel );
+} openmpt_module_ext_interface_interactive2;
+
 // Custom bridge functions implemented in CLibOpenMPT.c
 // Note: These are wrappers/stubs since libopenmpt is read-only
 extern int32_t openmpt_module_get_pattern_rows( openmpt_module * mod, int32_t pattern );
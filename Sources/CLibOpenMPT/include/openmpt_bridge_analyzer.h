@@ -0,0 +1,74 @@
+/*
+ * openmpt_bridge_analyzer.h
+ * -------------------------
+ * Purpose: Spectrum analyzer computed off the audio thread
+ *
+ * The analyzer attaches a float stereo tap at the render rate, so the only
+ * work the render thread does for it is a copy into the tap's ring. A
+ * worker thread drains the ring, downmixes to mono, and computes windowed
+ * FFT magnitude spectra every hop. The newest spectrum is published through
+ * a triple buffer: the worker never waits for the reader and the reader
+ * never sees a half-written frame, however fast or slow either side runs.
+ *
+ * Spectra describe the most recent audio rendered, not what is audible
+ * right now; readers that want them in sync with the speaker delay them by
+ * the output latency.
+ */
+
+#ifndef OPENMPT_BRIDGE_ANALYZER_H
+#define OPENMPT_BRIDGE_ANALYZER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "openmpt_bridge_module.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OPENMPT_BRIDGE_ANALYZER_WINDOW_HANN             0
+#define OPENMPT_BRIDGE_ANALYZER_WINDOW_BLACKMAN_HARRIS  1
+
+typedef struct openmpt_bridge_analyzer openmpt_bridge_analyzer;
+
+typedef struct openmpt_bridge_analyzer_options {
+    int32_t sample_rate;        // rate the handle renders at, for bin frequencies
+    int32_t fft_size;           // power of two from 64 to 16384
+    int32_t hop_frames;         // frames between spectra, 0 = fft_size / 4
+    int32_t window;             // OPENMPT_BRIDGE_ANALYZER_WINDOW_*
+    float smoothing;            // 0 = none, towards 1 = slower decay between spectra
+    float floor_db;             // magnitudes are clamped to at least this
+} openmpt_bridge_analyzer_options;
+
+typedef struct openmpt_bridge_spectrum {
+    uint64_t sequence;          // increases by one per spectrum computed
+    uint64_t frame;             // rendered frames seen by the analyzer when the window ended
+    int32_t bins;               // fft_size / 2 + 1, DC to Nyquist
+    const float * magnitudes;   // dBFS; a full-scale sine peaks at about 0
+} openmpt_bridge_spectrum;
+
+// Defaults: 48000 Hz, 2048-point FFT, hop 512, Hann window, smoothing 0.5, -120 dB floor
+extern void openmpt_bridge_analyzer_options_init( openmpt_bridge_analyzer_options * options );
+
+// Attach an analyzer to the handle and start its worker thread. Uses one of
+// the handle's OPENMPT_BRIDGE_MAX_TAPS taps. Returns NULL if the options
+// are invalid or no tap is free. options may be NULL for the defaults.
+extern openmpt_bridge_analyzer * openmpt_bridge_analyzer_create( openmpt_bridge_module * handle, const openmpt_bridge_analyzer_options * options );
+
+// Stop the worker, detach the tap and free the analyzer. handle must be the
+// one passed to create.
+extern void openmpt_bridge_analyzer_destroy( openmpt_bridge_module * handle, openmpt_bridge_analyzer * analyzer );
+
+// Single reader thread. Returns the newest spectrum, or NULL before the
+// first one. The frame stays valid and unchanged until the next call.
+extern const openmpt_bridge_spectrum * openmpt_bridge_analyzer_acquire( openmpt_bridge_analyzer * analyzer );
+
+// Centre frequency of a bin in Hz
+extern double openmpt_bridge_analyzer_bin_frequency( const openmpt_bridge_analyzer * analyzer, int32_t bin );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPENMPT_BRIDGE_ANALYZER_H */
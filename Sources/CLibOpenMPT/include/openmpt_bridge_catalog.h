@@ -0,0 +1,129 @@
+/*
+ * openmpt_bridge_catalog.h
+ * ------------------------
+ * Purpose: Read-only, memory-mapped module catalog for instant startup
+ *
+ * A catalog is written once by the bridge and then mmap()ed and queried in
+ * place; opening it validates offsets but never parses or copies records.
+ *
+ * File layout (little-endian, every section 8-byte aligned):
+ *   openmpt_bridge_catalog_header
+ *   openmpt_bridge_catalog_record[record_count]   fixed-width records
+ *   uint32_t path_order[record_count]              record indices sorted by path
+ *   uint32_t title_order[record_count]             ... by title (ASCII case-folded)
+ *   uint32_t artist_order[record_count]            ... by artist (ASCII case-folded)
+ *   char     strings[strings_size]                 deduplicated NUL-terminated UTF-8
+ *
+ * String fields of a record are byte offsets into the string pool.
+ */
+
+#ifndef OPENMPT_BRIDGE_CATALOG_H
+#define OPENMPT_BRIDGE_CATALOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libopenmpt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OPENMPT_BRIDGE_CATALOG_VERSION 2
+
+// Record flags
+#define OPENMPT_BRIDGE_CATALOG_FLAG_LOUDNESS 1u   // loudness and true_peak hold a measurement
+
+typedef struct openmpt_bridge_catalog_header {
+    char magic[8];              // "OMPTCAT\0"
+    uint32_t version;
+    uint32_t record_size;       // sizeof(openmpt_bridge_catalog_record)
+    uint64_t record_count;
+    uint64_t records_offset;
+    uint64_t path_order_offset;
+    uint64_t title_order_offset;
+    uint64_t artist_order_offset;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+} openmpt_bridge_catalog_header;
+
+// One module, 72 bytes
+typedef struct openmpt_bridge_catalog_record {
+    uint32_t path;              // string pool offsets
+    uint32_t title;
+    uint32_t artist;
+    uint32_t type;
+    uint32_t tracker;
+    uint32_t channels;
+    uint32_t patterns;
+    uint32_t instruments;
+    uint32_t samples;
+    uint32_t flags;             // OPENMPT_BRIDGE_CATALOG_FLAG_*
+    double duration;            // seconds
+    uint64_t file_size;
+    uint64_t content_hash;
+    float loudness;             // integrated LUFS
+    float true_peak;            // dBTP
+} openmpt_bridge_catalog_record;
+
+// Entry handed to the builder. Strings are copied; NULL means "".
+typedef struct openmpt_bridge_catalog_entry {
+    const char * path;
+    const char * title;
+    const char * artist;
+    const char * type;
+    const char * tracker;
+    double duration;
+    uint32_t channels;
+    uint32_t patterns;
+    uint32_t instruments;
+    uint32_t samples;
+    uint64_t file_size;
+    uint64_t content_hash;
+    uint32_t loudness_measured; // non-zero if loudness and true_peak are set
+    double loudness;            // integrated LUFS (openmpt_bridge_loudness.h)
+    double true_peak;           // dBTP
+} openmpt_bridge_catalog_entry;
+
+typedef enum openmpt_bridge_catalog_order {
+    OPENMPT_BRIDGE_CATALOG_ORDER_PATH = 0,
+    OPENMPT_BRIDGE_CATALOG_ORDER_TITLE = 1,
+    OPENMPT_BRIDGE_CATALOG_ORDER_ARTIST = 2
+} openmpt_bridge_catalog_order;
+
+typedef struct openmpt_bridge_catalog openmpt_bridge_catalog;
+typedef struct openmpt_bridge_catalog_builder openmpt_bridge_catalog_builder;
+
+// MARK: Writing
+
+extern openmpt_bridge_catalog_builder * openmpt_bridge_catalog_builder_create( void );
+extern void openmpt_bridge_catalog_builder_destroy( openmpt_bridge_catalog_builder * builder );
+extern int openmpt_bridge_catalog_builder_add( openmpt_bridge_catalog_builder * builder, const openmpt_bridge_catalog_entry * entry );
+// Add a loaded module, reading metadata and counts from libopenmpt
+extern int openmpt_bridge_catalog_builder_add_module( openmpt_bridge_catalog_builder * builder, const char * path, openmpt_module * mod, uint64_t file_size, uint64_t content_hash );
+// Write the catalog atomically. Returns 1 on success, 0 on failure.
+extern int openmpt_bridge_catalog_builder_write( openmpt_bridge_catalog_builder * builder, const char * catalog_path );
+
+// Convert the successfully loaded rows of an indexer database (openmpt_bridge_index.h)
+extern int openmpt_bridge_catalog_write_from_index( const char * database_path, const char * catalog_path );
+
+// MARK: Reading
+
+// Map a catalog. Returns NULL if missing or malformed.
+extern openmpt_bridge_catalog * openmpt_bridge_catalog_open( const char * catalog_path );
+extern void openmpt_bridge_catalog_close( openmpt_bridge_catalog * catalog );
+extern uint64_t openmpt_bridge_catalog_get_count( const openmpt_bridge_catalog * catalog );
+// Pointer into the mapping, valid until the catalog is closed
+extern const openmpt_bridge_catalog_record * openmpt_bridge_catalog_get_record( const openmpt_bridge_catalog * catalog, uint64_t index );
+// Pool string for an offset taken from a record; "" when out of range
+extern const char * openmpt_bridge_catalog_get_string( const openmpt_bridge_catalog * catalog, uint32_t offset );
+// Record index at a position of one of the sort orders, or UINT32_MAX
+extern uint32_t openmpt_bridge_catalog_get_ordered( const openmpt_bridge_catalog * catalog, int32_t order, uint64_t position );
+// Binary search by exact path. Returns the record index or -1.
+extern int64_t openmpt_bridge_catalog_find_path( const openmpt_bridge_catalog * catalog, const char * path );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPENMPT_BRIDGE_CATALOG_H */
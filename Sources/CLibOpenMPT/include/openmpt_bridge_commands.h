@@ -0,0 +1,64 @@
+/*
+ * openmpt_bridge_commands.h
+ * -------------------------
+ * Purpose: Render parameter and ctl changes delivered to the render thread
+ *
+ * libopenmpt modules are not thread safe, so while a handle is in real-time
+ * mode, parameter changes from other threads are pushed into a bounded
+ * lock-free queue instead of touching the module. The render path drains
+ * the queue at the start of every block. Outside real-time mode changes are
+ * applied immediately by the calling thread.
+ *
+ * Master gain and stereo separation can optionally be smoothed: the render
+ * path then ramps towards the new value in short sub-blocks instead of
+ * jumping, which avoids zipper noise.
+ */
+
+#ifndef OPENMPT_BRIDGE_COMMANDS_H
+#define OPENMPT_BRIDGE_COMMANDS_H
+
+#include <stdint.h>
+
+#include "openmpt_bridge_module.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Queued commands per handle; further changes fail until the renderer catches up
+#define OPENMPT_BRIDGE_COMMAND_CAPACITY 256
+// Longest ctl name and value (including the terminator) that can be queued
+#define OPENMPT_BRIDGE_COMMAND_CTL_LENGTH 64
+#define OPENMPT_BRIDGE_COMMAND_VALUE_LENGTH 64
+
+// Enter real-time mode before a render thread starts using the handle, and
+// leave it after that thread has stopped. Leaving applies any queued changes
+// on the calling thread.
+extern void openmpt_bridge_module_set_realtime( openmpt_bridge_module * handle, int realtime );
+extern int openmpt_bridge_module_is_realtime( const openmpt_bridge_module * handle );
+
+// Set a render parameter (OPENMPT_MODULE_RENDER_*). Interpolation and volume
+// ramping values are remembered as the requested quality for adaptive
+// quality. In real-time mode the change is queued and takes effect at the
+// next block. Returns 1 if applied or queued, 0 if the parameter is unknown,
+// no module is loaded, or the queue is full.
+extern int openmpt_bridge_module_set_render_param( openmpt_bridge_module * handle, int param, int32_t value );
+
+// Set a ctl, like openmpt_module_ctl_set. In real-time mode the change is
+// queued; the return value then only says whether it was queued, not
+// whether libopenmpt accepted it.
+extern int openmpt_bridge_module_ctl_set( openmpt_bridge_module * handle, const char * ctl, const char * value );
+
+// Ramp time for master gain and stereo separation changes made in real-time
+// mode. 0 (the default) applies them at the next block boundary.
+extern void openmpt_bridge_module_set_smoothing( openmpt_bridge_module * handle, double seconds );
+extern double openmpt_bridge_module_get_smoothing( const openmpt_bridge_module * handle );
+
+// Changes that could not be queued because the queue was full
+extern uint64_t openmpt_bridge_module_get_dropped_commands( const openmpt_bridge_module * handle );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPENMPT_BRIDGE_COMMANDS_H */
@@ -0,0 +1,68 @@
+/*
+ * openmpt_bridge_deadline.h
+ * -------------------------
+ * Purpose: Real-time deadline monitoring for the bridge render path
+ *
+ * Every render call through an openmpt_bridge_module is measured against
+ * its deadline, the audio duration it produced (frames / sample rate). The
+ * ratio goes into a utilization histogram, and calls above a configurable
+ * budget push an overrun event into a lock-free queue that a control thread
+ * drains. Nothing on the render side blocks or allocates.
+ */
+
+#ifndef OPENMPT_BRIDGE_DEADLINE_H
+#define OPENMPT_BRIDGE_DEADLINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "openmpt_bridge_module.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Utilization buckets of 5% each; the last bucket holds everything >= 200%
+#define OPENMPT_BRIDGE_DEADLINE_BUCKETS 41
+#define OPENMPT_BRIDGE_DEADLINE_BUCKET_WIDTH 0.05
+
+// Default budget: a block may use up to 75% of its deadline
+#define OPENMPT_BRIDGE_DEADLINE_DEFAULT_BUDGET 0.75
+
+typedef struct openmpt_bridge_deadline_histogram {
+    uint64_t buckets[OPENMPT_BRIDGE_DEADLINE_BUCKETS];
+    uint64_t blocks;            // render calls measured
+    uint64_t overruns;          // calls above the budget
+    uint64_t missed;            // calls that took longer than their deadline
+    uint64_t dropped_events;    // overruns not queued because the queue was full
+    double peak_utilization;    // highest elapsed / deadline seen
+} openmpt_bridge_deadline_histogram;
+
+typedef struct openmpt_bridge_overrun_event {
+    uint64_t timestamp_ns;      // monotonic clock when the block finished
+    uint64_t elapsed_ns;
+    uint64_t deadline_ns;
+    uint64_t block_index;       // render call number since the last reset
+    uint32_t frames;
+    int32_t sample_rate;
+} openmpt_bridge_overrun_event;
+
+// Budget as a fraction of the deadline (e.g. 0.75). Values <= 0 restore the default.
+extern void openmpt_bridge_deadline_set_budget( openmpt_bridge_module * handle, double budget );
+extern double openmpt_bridge_deadline_get_budget( const openmpt_bridge_module * handle );
+
+// Copy the histogram. Returns 1 on success, 0 if handle or histogram is NULL.
+extern int openmpt_bridge_deadline_get_histogram( const openmpt_bridge_module * handle, openmpt_bridge_deadline_histogram * histogram );
+
+// Pop the oldest queued overrun event. Returns 1 if one was copied, 0 if the
+// queue is empty. Call from a single consumer thread.
+extern int openmpt_bridge_deadline_pop_event( openmpt_bridge_module * handle, openmpt_bridge_overrun_event * event );
+
+// Clear the histogram. Queued events are kept.
+extern void openmpt_bridge_deadline_reset( openmpt_bridge_module * handle );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPENMPT_BRIDGE_DEADLINE_H */
@@ -0,0 +1,112 @@
+/*
+ * openmpt_bridge_export.h
+ * -----------------------
+ * Purpose: Faster-than-realtime export of modules to WAV or raw PCM
+ *
+ * The exporter renders large blocks on the calling thread while a writer
+ * thread converts the previous block and writes it, so disk I/O is hidden
+ * behind rendering.
+ *
+ * The parallel exporter splits one song at order boundaries and renders the
+ * segments on separate module instances. Each instance seeks to an earlier
+ * boundary and pre-rolls to rebuild channel state, and neighbouring segments
+ * render a short overlap that is compared and, if it differs, crossfaded.
+ *
+ * Both exporters scan every rendered block for silence. With trim_silence
+ * set, the song is rendered with play.at_end "stop" instead of fading out,
+ * and frames after the last one above silence_threshold_db are cut from
+ * the file. max_silence_seconds ends a render early once that much
+ * continuous silence has been rendered, so modules with long silent tails
+ * cost no more than their audible part.
+ */
+
+#ifndef OPENMPT_BRIDGE_EXPORT_H
+#define OPENMPT_BRIDGE_EXPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libopenmpt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum openmpt_bridge_sample_format {
+    OPENMPT_BRIDGE_SAMPLE_FORMAT_S16 = 0,   // 16-bit signed integer
+    OPENMPT_BRIDGE_SAMPLE_FORMAT_S24 = 1,   // 24-bit signed integer, packed
+    OPENMPT_BRIDGE_SAMPLE_FORMAT_F32 = 2    // 32-bit IEEE float
+} openmpt_bridge_sample_format;
+
+typedef enum openmpt_bridge_container {
+    OPENMPT_BRIDGE_CONTAINER_WAV = 0,
+    OPENMPT_BRIDGE_CONTAINER_RAW = 1        // headerless interleaved little-endian PCM
+} openmpt_bridge_container;
+
+typedef struct openmpt_bridge_export_options {
+    int32_t sample_rate;    // 0 = 48000
+    int32_t format;         // openmpt_bridge_sample_format
+    int32_t container;      // openmpt_bridge_container
+    int32_t block_frames;   // frames per render block, 0 = 32768
+    double max_seconds;     // stop after this much audio, 0 = end of song
+    int32_t trim_silence;   // non-zero stops at the song end and drops the silent tail
+    double silence_threshold_db;    // peak level still counted as silence, 0 = -90 dBFS
+    double max_silence_seconds;     // end the render after this much silence, 0 = never
+} openmpt_bridge_export_options;
+
+typedef struct openmpt_bridge_export_result {
+    uint64_t frames;            // stereo frames written
+    double audio_seconds;       // frames / sample_rate
+    double wall_seconds;        // total elapsed time
+    double render_seconds;      // time spent inside libopenmpt
+    double write_wait_seconds;  // time the renderer waited for the writer
+    double realtime_factor;     // audio_seconds / wall_seconds
+    uint64_t trimmed_frames;    // silent frames rendered but cut from the end
+} openmpt_bridge_export_result;
+
+// Fill options with defaults (48 kHz, 16-bit WAV, whole song, no trimming)
+extern void openmpt_bridge_export_options_init( openmpt_bridge_export_options * options );
+
+// Render mod from the start of its selected subsong to a file. The repeat
+// count is set to 0 for the export and restored afterwards; the playback
+// position is left at the end. options and result may be NULL.
+// Returns 1 on success, 0 on failure.
+extern int openmpt_bridge_export_module( openmpt_module * mod, const char * output_path, const openmpt_bridge_export_options * options, openmpt_bridge_export_result * result );
+
+// Load a module file and export it
+extern int openmpt_bridge_export_file( const char * module_path, const char * output_path, const openmpt_bridge_export_options * options, openmpt_bridge_export_result * result );
+
+typedef struct openmpt_bridge_parallel_export_options {
+    int32_t thread_count;       // 0 = one per CPU
+    int32_t segment_count;      // 0 = one per thread
+    int32_t overlap_frames;     // frames rendered by both sides of a seam, at least 1
+    int32_t subsong;            // -1 = default subsong
+    double preroll_seconds;     // audio rendered and discarded before each segment
+    double min_segment_seconds; // segments are never planned shorter than this
+} openmpt_bridge_parallel_export_options;
+
+typedef struct openmpt_bridge_parallel_export_result {
+    openmpt_bridge_export_result totals;    // render_seconds is summed over all workers
+    int32_t segments;           // segments actually rendered
+    int32_t exact_seams;        // overlaps that matched bit for bit
+    int32_t crossfaded_seams;   // overlaps that differed and were crossfaded
+    float max_seam_error;       // largest sample difference seen in any overlap
+} openmpt_bridge_parallel_export_result;
+
+// Fill parallel options with defaults (one segment per CPU, 2 s pre-roll,
+// 256-frame overlap, segments of at least 10 s)
+extern void openmpt_bridge_parallel_export_options_init( openmpt_bridge_parallel_export_options * parallel );
+
+// Render module data to a file using several module instances in parallel.
+// Songs too short to split are rendered as a single segment. options,
+// parallel and result may be NULL. Returns 1 on success, 0 on failure.
+extern int openmpt_bridge_export_parallel( const void * data, size_t size, const char * output_path, const openmpt_bridge_export_options * options, const openmpt_bridge_parallel_export_options * parallel, openmpt_bridge_parallel_export_result * result );
+
+// Read a module file and export it in parallel
+extern int openmpt_bridge_export_parallel_file( const char * module_path, const char * output_path, const openmpt_bridge_export_options * options, const openmpt_bridge_parallel_export_options * parallel, openmpt_bridge_parallel_export_result * result );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPENMPT_BRIDGE_EXPORT_H */
@@ -0,0 +1,85 @@
+/*
+ * openmpt_bridge_fingerprint.h
+ * ----------------------------
+ * Purpose: Audio fingerprints for finding the same song in different files
+ *
+ * A song is rendered once at 8000 Hz in mono with nearest-neighbour
+ * interpolation and cut into 256 ms frames every 128 ms. Each frame becomes
+ * one 32-bit hash. The low 12 bits mark the pitch classes (chroma) above
+ * the frame's average. The high 20 bits give the sign of the change, from
+ * the previous frame, in the energy difference between neighbouring bands
+ * on a log-spaced scale. These features survive format conversion, sample
+ * rate and interpolation differences, so a MOD and its XM conversion give
+ * nearly identical hashes. Silent frames hash to 0.
+ *
+ * The fingerprint index is an inverted index from hash to (song, frame).
+ * A query looks up each of its hashes, and every hit votes for a song at
+ * the time offset between the two frames. The best offsets are then
+ * checked by comparing the aligned fingerprints bit by bit. Similarity is
+ * the fraction of equal bits, about 0.5 for unrelated songs.
+ *
+ * The indexer stores fingerprints in OPENMPT_BRIDGE_INDEX_COLUMN_FINGERPRINT
+ * as arrays of uint32_t, and an index can be built straight from that column.
+ */
+
+#ifndef OPENMPT_BRIDGE_FINGERPRINT_H
+#define OPENMPT_BRIDGE_FINGERPRINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OPENMPT_BRIDGE_FINGERPRINT_SAMPLE_RATE 8000
+#define OPENMPT_BRIDGE_FINGERPRINT_HOP_FRAMES 1024      // 128 ms between hashes
+#define OPENMPT_BRIDGE_FINGERPRINT_MAX_HASHES 960       // about the first two minutes
+#define OPENMPT_BRIDGE_FINGERPRINT_DUPLICATE 0.9        // similarity above which songs are the same
+
+typedef struct openmpt_bridge_fingerprint_index openmpt_bridge_fingerprint_index;
+
+typedef struct openmpt_bridge_fingerprint_match {
+    uint64_t id;                    // as passed to openmpt_bridge_fingerprint_index_add
+    double similarity;              // fraction of equal bits where both songs are audible
+    int32_t offset;                 // query hash i lines up with hash i + offset of the match
+    uint32_t compared;              // aligned hashes compared
+} openmpt_bridge_fingerprint_match;
+
+// Render module data (subsong -1 for the default) and write up to capacity
+// hashes. Returns the number of hashes written, or 0 if the data cannot be
+// loaded or the song is shorter than one frame.
+extern size_t openmpt_bridge_fingerprint_compute( const void * data, size_t size, int32_t subsong, uint32_t * hashes, size_t capacity );
+
+// Similarity of two fingerprints at the best alignment within max_offset
+// hashes, where a[i] lines up with b[i + offset]. offset, if not NULL,
+// receives that alignment. Returns 0 when fewer than 8 audible hashes overlap.
+extern double openmpt_bridge_fingerprint_similarity( const uint32_t * a, size_t a_count, const uint32_t * b, size_t b_count, int32_t max_offset, int32_t * offset );
+
+extern openmpt_bridge_fingerprint_index * openmpt_bridge_fingerprint_index_create( void );
+extern void openmpt_bridge_fingerprint_index_destroy( openmpt_bridge_fingerprint_index * index );
+
+// Index built from the fingerprint column of an indexer database, with row
+// numbers as ids. Returns NULL if the database cannot be opened.
+extern openmpt_bridge_fingerprint_index * openmpt_bridge_fingerprint_index_open_database( const char * database_path );
+
+// Add a song. The hashes are copied. Returns 0 if out of memory.
+extern int openmpt_bridge_fingerprint_index_add( openmpt_bridge_fingerprint_index * index, uint64_t id, const uint32_t * hashes, size_t count );
+
+extern size_t openmpt_bridge_fingerprint_index_get_count( const openmpt_bridge_fingerprint_index * index );
+
+// Songs resembling hashes with at least min_similarity, best first. Only
+// songs sharing at least two hashes at a consistent offset are checked.
+// Queries first sort songs added since the last query, so an index must
+// not be used from several threads at once. Up to capacity matches are
+// written. Returns the number written.
+extern size_t openmpt_bridge_fingerprint_index_query( openmpt_bridge_fingerprint_index * index, const uint32_t * hashes, size_t count, double min_similarity, openmpt_bridge_fingerprint_match * matches, size_t capacity );
+
+// Songs in the index resembling the song added as id, excluding itself
+extern size_t openmpt_bridge_fingerprint_index_query_id( openmpt_bridge_fingerprint_index * index, uint64_t id, double min_similarity, openmpt_bridge_fingerprint_match * matches, size_t capacity );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPENMPT_BRIDGE_FINGERPRINT_H */
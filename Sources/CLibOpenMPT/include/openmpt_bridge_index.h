@@ -0,0 +1,149 @@
+/*
+ * openmpt_bridge_index.h
+ * ----------------------
+ * Purpose: Parallel corpus indexer writing a columnar metadata database
+ *
+ * The indexer walks a directory tree, probes every regular file with
+ * openmpt_probe_file_header(), metadata-loads the accepted ones on a thread
+ * pool (samples and plugins are skipped) and writes one column per field.
+ * Re-runs reuse rows whose (path, size, mtime) are unchanged.
+ *
+ * With measure_loudness set, every module is also loaded in full and
+ * rendered once through the loudness meter (openmpt_bridge_loudness.h), and
+ * the results are stored in the loudness columns. Reused rows that were
+ * indexed without a measurement are measured on the next such run.
+ *
+ * With fingerprint set, every module is rendered again at 8000 Hz with
+ * nearest-neighbour interpolation and its audio fingerprint
+ * (openmpt_bridge_fingerprint.h) is stored in the fingerprint column. Rows
+ * with no fingerprint are fingerprinted on the next such run.
+ *
+ * A row loaded again for a missing analysis keeps the results of the other
+ * one, so runs with either option may alternate. An analysis that fails is
+ * recorded in analysis_failed and not retried until the file changes.
+ *
+ * Database layout (little-endian, every section 8-byte aligned):
+ *   char     magic[8]      "OMPTIDX\0"
+ *   uint32_t version       OPENMPT_BRIDGE_INDEX_VERSION
+ *   uint32_t column_count
+ *   uint64_t row_count
+ *   column_count x { uint32_t id; uint32_t kind; uint64_t offset; uint64_t size; }
+ *   column data
+ *
+ * Fixed-width columns are plain arrays of row_count values. String columns
+ * are uint32_t offsets[row_count] into a pool of NUL-terminated UTF-8. Blob
+ * columns are { uint32_t offset; uint32_t size; }[row_count] into a pool
+ * whose entries start 4-byte aligned.
+ * Rows are sorted by path, which is stored relative to the indexed root.
+ */
+
+#ifndef OPENMPT_BRIDGE_INDEX_H
+#define OPENMPT_BRIDGE_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OPENMPT_BRIDGE_INDEX_VERSION 1
+
+// Column identifiers, in on-disk order
+typedef enum openmpt_bridge_index_column {
+    OPENMPT_BRIDGE_INDEX_COLUMN_PATH = 0,        // string
+    OPENMPT_BRIDGE_INDEX_COLUMN_SIZE,            // uint64, file size in bytes
+    OPENMPT_BRIDGE_INDEX_COLUMN_MTIME,           // int64, nanoseconds since the epoch
+    OPENMPT_BRIDGE_INDEX_COLUMN_STATUS,          // uint32, openmpt_bridge_index_status
+    OPENMPT_BRIDGE_INDEX_COLUMN_CONTENT_HASH,    // uint64, XXH64 of the file
+    OPENMPT_BRIDGE_INDEX_COLUMN_TITLE,           // string
+    OPENMPT_BRIDGE_INDEX_COLUMN_ARTIST,          // string
+    OPENMPT_BRIDGE_INDEX_COLUMN_TYPE,            // string, e.g. "it"
+    OPENMPT_BRIDGE_INDEX_COLUMN_TRACKER,         // string
+    OPENMPT_BRIDGE_INDEX_COLUMN_DURATION,        // double, seconds of the default subsong
+    OPENMPT_BRIDGE_INDEX_COLUMN_CHANNELS,        // uint32
+    OPENMPT_BRIDGE_INDEX_COLUMN_PATTERNS,        // uint32
+    OPENMPT_BRIDGE_INDEX_COLUMN_INSTRUMENTS,     // uint32
+    OPENMPT_BRIDGE_INDEX_COLUMN_SAMPLES,         // uint32
+    OPENMPT_BRIDGE_INDEX_COLUMN_LOUDNESS_MEASURED, // uint32, 1 if the loudness columns hold a measurement
+    OPENMPT_BRIDGE_INDEX_COLUMN_LOUDNESS,        // double, integrated LUFS of the default subsong
+    OPENMPT_BRIDGE_INDEX_COLUMN_LOUDNESS_RANGE,  // double, LU
+    OPENMPT_BRIDGE_INDEX_COLUMN_TRUE_PEAK,       // double, dBTP
+    OPENMPT_BRIDGE_INDEX_COLUMN_FINGERPRINT,     // blob, uint32_t fingerprint hashes, empty if not fingerprinted
+    OPENMPT_BRIDGE_INDEX_COLUMN_ANALYSIS_FAILED, // uint32, openmpt_bridge_index_analysis bits that failed
+    OPENMPT_BRIDGE_INDEX_COLUMN_COUNT
+} openmpt_bridge_index_column;
+
+// Storage kind of a column
+typedef enum openmpt_bridge_index_kind {
+    OPENMPT_BRIDGE_INDEX_KIND_UINT32 = 1,
+    OPENMPT_BRIDGE_INDEX_KIND_UINT64 = 2,
+    OPENMPT_BRIDGE_INDEX_KIND_INT64 = 3,
+    OPENMPT_BRIDGE_INDEX_KIND_DOUBLE = 4,
+    OPENMPT_BRIDGE_INDEX_KIND_STRING = 5,
+    OPENMPT_BRIDGE_INDEX_KIND_BLOB = 6
+} openmpt_bridge_index_kind;
+
+// Per-row outcome. Rejected and failed files are kept so that incremental
+// runs do not retry them until they change on disk.
+typedef enum openmpt_bridge_index_status {
+    OPENMPT_BRIDGE_INDEX_STATUS_OK = 0,
+    OPENMPT_BRIDGE_INDEX_STATUS_REJECTED = 1,    // probe says not a module
+    OPENMPT_BRIDGE_INDEX_STATUS_FAILED = 2       // unreadable or failed to load
+} openmpt_bridge_index_status;
+
+// Analyses run on top of the metadata load
+typedef enum openmpt_bridge_index_analysis {
+    OPENMPT_BRIDGE_INDEX_ANALYSIS_LOUDNESS = 1,
+    OPENMPT_BRIDGE_INDEX_ANALYSIS_FINGERPRINT = 2
+} openmpt_bridge_index_analysis;
+
+typedef struct openmpt_bridge_index_options {
+    int32_t thread_count;   // 0 = one thread per CPU
+    int full_rebuild;       // non-zero ignores an existing database
+    int measure_loudness;   // non-zero renders every module to measure its loudness
+    int fingerprint;        // non-zero renders every module at low quality to fingerprint it
+    // Optional progress callback, invoked from worker threads
+    void ( * progress )( void * user, uint64_t done, uint64_t total );
+    void * progress_user;
+} openmpt_bridge_index_options;
+
+typedef struct openmpt_bridge_index_summary {
+    uint64_t files_scanned;
+    uint64_t files_reused;
+    uint64_t files_indexed;
+    uint64_t files_rejected;
+    uint64_t files_failed;
+    double seconds;
+} openmpt_bridge_index_summary;
+
+// Opaque read-only view of a database
+typedef struct openmpt_bridge_index openmpt_bridge_index;
+
+// Build or update the database at database_path from the tree under root.
+// options and summary may be NULL. Returns 1 on success, 0 on failure.
+extern int openmpt_bridge_index_build( const char * root, const char * database_path, const openmpt_bridge_index_options * options, openmpt_bridge_index_summary * summary );
+
+// Open a database for reading. Returns NULL if missing or malformed.
+extern openmpt_bridge_index * openmpt_bridge_index_open( const char * database_path );
+extern void openmpt_bridge_index_close( openmpt_bridge_index * index );
+extern uint64_t openmpt_bridge_index_get_row_count( const openmpt_bridge_index * index );
+
+// Typed column accessors. Integer accessors work on any integer column;
+// out-of-range rows and mismatched kinds return 0, 0.0 or "".
+extern const char * openmpt_bridge_index_get_string( const openmpt_bridge_index * index, int32_t column, uint64_t row );
+extern uint64_t openmpt_bridge_index_get_uint( const openmpt_bridge_index * index, int32_t column, uint64_t row );
+extern double openmpt_bridge_index_get_double( const openmpt_bridge_index * index, int32_t column, uint64_t row );
+
+// Blob column accessor. Returns a pointer into the mapping, valid until the
+// index is closed, and its size in bytes; NULL and 0 for empty blobs.
+extern const void * openmpt_bridge_index_get_blob( const openmpt_bridge_index * index, int32_t column, uint64_t row, size_t * size );
+
+// Name of a column for display ("title", "duration", ...)
+extern const char * openmpt_bridge_index_column_name( int32_t column );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPENMPT_BRIDGE_INDEX_H */
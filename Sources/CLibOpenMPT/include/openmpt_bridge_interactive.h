@@ -0,0 +1,112 @@
+/*
+ * openmpt_bridge_interactive.h
+ * ----------------------------
+ * Purpose: Live control of a playing module through libopenmpt's ext interactive interface
+ *
+ * The handle loads every module through openmpt_module_ext and keeps its
+ * interactive interfaces. Like render parameters, interactive changes made
+ * in real-time mode travel through the handle's lock-free command queue
+ * (openmpt_bridge_commands.h) and take effect at the start of the next
+ * block, so the audio thread never waits for a lock. Outside real-time mode
+ * they are applied immediately by the calling thread.
+ *
+ * Note preview ("jam"): play_note triggers an instrument, or a sample in
+ * modules without instruments, on one of libopenmpt's background channels.
+ * Those channels come after the pattern channels, so previews never cut
+ * notes the song is playing. Because the channel is only known once the
+ * render thread has started the note, play_note returns a voice id instead.
+ * The render thread maps voices to channels, and stop_note and note_off
+ * take the voice id. Voices are reused round-robin; when a voice id comes
+ * round again, its previous note is cut first.
+ *
+ * Channel mix: mute, solo, volume and panning per pattern channel. The
+ * requested state is kept on the handle, so getters never touch the module
+ * and answer with the latest request that was applied or queued; a request
+ * refused because the queue is full changes nothing. The render thread
+ * brings the module in line at the next block boundary. A channel is muted
+ * if it is muted itself, or if any channel is soloed and it is not.
+ * libopenmpt's mixer skips muted channels entirely, so a render or export
+ * with channels muted costs only the channels that remain. Pattern effects
+ * may still change a channel's volume or panning as the song plays.
+ *
+ * Tempo and pitch factors scale playback speed and pitch independently, for
+ * practice loops or matching another track. They are requested and applied
+ * like the channel mix and persist across seeks and subsong changes. Times
+ * in the snapshot and the published position stay in song time at a factor
+ * of 1.
+ */
+
+#ifndef OPENMPT_BRIDGE_INTERACTIVE_H
+#define OPENMPT_BRIDGE_INTERACTIVE_H
+
+#include <stdint.h>
+
+#include "openmpt_bridge_module.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Preview notes that can sound at once
+#define OPENMPT_BRIDGE_JAM_VOICES 32
+// Pattern channels the channel mix can control
+#define OPENMPT_BRIDGE_MAX_CHANNELS 256
+// Largest tempo and pitch factor libopenmpt accepts
+#define OPENMPT_BRIDGE_MAX_FACTOR 4.0
+
+// Non-zero if the loaded module exposes the interactive interface
+extern int openmpt_bridge_module_is_interactive( const openmpt_bridge_module * handle );
+
+// Start a preview note. instrument is 0-based (a sample index in modules
+// without instruments), note is 0-119 with 60 for middle C, volume is 0-1
+// and panning -1 (left) to 1 (right). Returns the voice id, or -1 if no
+// module is loaded, the module is not interactive, an argument is out of
+// range, or the command queue is full.
+extern int32_t openmpt_bridge_module_play_note( openmpt_bridge_module * handle, int32_t instrument, int32_t note, double volume, double panning );
+
+// Cut a preview note immediately, or all of them for voice -1.
+// Returns 1 if applied or queued.
+extern int openmpt_bridge_module_stop_note( openmpt_bridge_module * handle, int32_t voice );
+
+// Release a preview note as a key-up would, letting its envelope fade, or
+// all of them for voice -1. Cuts the note when libopenmpt has no note-off.
+// Returns 1 if applied or queued.
+extern int openmpt_bridge_module_note_off( openmpt_bridge_module * handle, int32_t voice );
+
+// Mute or unmute a channel, or every channel for channel -1. Returns 1 if
+// applied or queued, 0 if the channel does not exist or the queue is full.
+extern int openmpt_bridge_module_set_channel_mute( openmpt_bridge_module * handle, int32_t channel, int mute );
+extern int openmpt_bridge_module_get_channel_mute( const openmpt_bridge_module * handle, int32_t channel );
+
+// Solo or unsolo a channel, or every channel for channel -1. Several
+// channels may be soloed at once.
+extern int openmpt_bridge_module_set_channel_solo( openmpt_bridge_module * handle, int32_t channel, int solo );
+extern int openmpt_bridge_module_get_channel_solo( const openmpt_bridge_module * handle, int32_t channel );
+
+// Channel volume, 0 (silent) to 1 (as written). Starts at the module's
+// initial channel volume.
+extern int openmpt_bridge_module_set_channel_volume( openmpt_bridge_module * handle, int32_t channel, double volume );
+extern double openmpt_bridge_module_get_channel_volume( const openmpt_bridge_module * handle, int32_t channel );
+
+// Channel panning, -1 (left) to 1 (right). Starts at the module's initial
+// channel panning. Fails if libopenmpt lacks the interactive2 interface.
+extern int openmpt_bridge_module_set_channel_panning( openmpt_bridge_module * handle, int32_t channel, double panning );
+extern double openmpt_bridge_module_get_channel_panning( const openmpt_bridge_module * handle, int32_t channel );
+
+// Playback speed factor in (0, 4], 1 as written; 2 plays twice as fast
+// without changing pitch. Returns 1 if applied or queued, 0 if out of
+// range, no module is loaded, or the queue is full.
+extern int openmpt_bridge_module_set_tempo_factor( openmpt_bridge_module * handle, double factor );
+// The requested tempo factor, 1 when no module is loaded
+extern double openmpt_bridge_module_get_tempo_factor( const openmpt_bridge_module * handle );
+
+// Pitch factor in (0, 4], 1 as written; 2 plays an octave higher without
+// changing tempo
+extern int openmpt_bridge_module_set_pitch_factor( openmpt_bridge_module * handle, double factor );
+extern double openmpt_bridge_module_get_pitch_factor( const openmpt_bridge_module * handle );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPENMPT_BRIDGE_INTERACTIVE_H */
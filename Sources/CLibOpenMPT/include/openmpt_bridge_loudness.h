@@ -0,0 +1,72 @@
+/*
+ * openmpt_bridge_loudness.h
+ * -------------------------
+ * Purpose: EBU R128 / ITU-R BS.1770-4 loudness meter for rendered audio
+ *
+ * The meter K-weights the stereo stream with the two BS.1770 biquads and
+ * keeps the energy of every 100 ms step. Momentary (400 ms) and short-term
+ * (3 s) loudness come from the most recent steps. Integrated loudness and
+ * loudness range (EBU Tech 3342) are computed from the stored steps with
+ * the absolute and relative gates. True peak is measured on a 4x
+ * oversampled signal, or 2x at 96 kHz and above.
+ *
+ * The meter allocates as the song grows, so it belongs in batch renders
+ * such as the indexer, not on a real-time audio thread. Its results are
+ * stored in the index and catalog, and the gain they imply can be applied
+ * through OPENMPT_MODULE_RENDER_MASTERGAIN_MILLIBEL at load time.
+ */
+
+#ifndef OPENMPT_BRIDGE_LOUDNESS_H
+#define OPENMPT_BRIDGE_LOUDNESS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ReplayGain 2.0 reference level
+#define OPENMPT_BRIDGE_LOUDNESS_REPLAYGAIN_REFERENCE -18.0
+
+typedef struct openmpt_bridge_loudness_meter openmpt_bridge_loudness_meter;
+
+// Loudness values are -INFINITY when nothing passed the gates
+typedef struct openmpt_bridge_loudness {
+    double integrated_lufs;
+    double momentary_lufs;          // last 400 ms
+    double short_term_lufs;         // last 3 s
+    double max_momentary_lufs;
+    double max_short_term_lufs;
+    double loudness_range_lu;
+    double true_peak_dbtp;
+    double sample_peak_dbfs;
+    double replaygain_db;           // gain to OPENMPT_BRIDGE_LOUDNESS_REPLAYGAIN_REFERENCE
+    uint64_t frames;
+} openmpt_bridge_loudness;
+
+// Meter for interleaved stereo float at sample_rate. Returns NULL if the rate is not positive.
+extern openmpt_bridge_loudness_meter * openmpt_bridge_loudness_meter_create( int32_t sample_rate );
+extern void openmpt_bridge_loudness_meter_destroy( openmpt_bridge_loudness_meter * meter );
+extern void openmpt_bridge_loudness_meter_reset( openmpt_bridge_loudness_meter * meter );
+
+// Feed frames of interleaved stereo. Returns 0 if out of memory.
+extern int openmpt_bridge_loudness_meter_add( openmpt_bridge_loudness_meter * meter, const float * interleaved_stereo, size_t frames );
+
+// Everything measured so far. Returns 1 on success, 0 if meter or loudness is NULL.
+extern int openmpt_bridge_loudness_meter_get( const openmpt_bridge_loudness_meter * meter, openmpt_bridge_loudness * loudness );
+
+// Render module data once at 48 kHz, from the start of subsong (-1 for the
+// default) to its end, and measure it. Returns 1 on success, 0 on failure.
+extern int openmpt_bridge_loudness_measure( const void * data, size_t size, int32_t subsong, openmpt_bridge_loudness * loudness );
+
+// Master gain, in millibel, that brings integrated_lufs to target_lufs
+// without lifting true_peak_dbtp above peak_ceiling_dbtp. Returns 0 when the
+// loudness is not finite. Negative gains are never limited by the ceiling.
+extern int32_t openmpt_bridge_loudness_gain_millibel( double integrated_lufs, double true_peak_dbtp, double target_lufs, double peak_ceiling_dbtp );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPENMPT_BRIDGE_LOUDNESS_H */
@@ -0,0 +1,77 @@
+/*
+ * openmpt_bridge_module.h
+ * -----------------------
+ * Purpose: Bridge-owned module handle with built-in instrumentation
+ *
+ * The handle owns an openmpt_module and routes loading, rendering and
+ * seeking through the bridge, so every call is counted and timed. Counters
+ * are per handle, updated with relaxed atomics, and can be read from any
+ * thread while another thread renders.
+ */
+
+#ifndef OPENMPT_BRIDGE_MODULE_H
+#define OPENMPT_BRIDGE_MODULE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libopenmpt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct openmpt_bridge_module openmpt_bridge_module;
+
+typedef struct openmpt_bridge_stats {
+    uint64_t frames_rendered;   // stereo frames produced by libopenmpt
+    uint64_t render_calls;
+    uint64_t render_ns;         // total time spent rendering
+    uint64_t max_block_ns;      // slowest single render call
+    uint64_t underruns;         // render calls that returned fewer frames than requested
+    uint64_t seeks;
+    uint64_t loads;             // successful loads
+    uint64_t load_ns;           // total time spent in successful loads
+} openmpt_bridge_stats;
+
+// Create an empty handle
+extern openmpt_bridge_module * openmpt_bridge_module_create( void );
+extern void openmpt_bridge_module_destroy( openmpt_bridge_module * handle );
+
+// Load module data, replacing any loaded module. The previous module is
+// released first, so the handle is empty if loading fails. ctls may be NULL.
+// Fails in real-time mode. Returns 1 on success, 0 on failure.
+extern int openmpt_bridge_module_load( openmpt_bridge_module * handle, const void * data, size_t size, const openmpt_module_initial_ctl * ctls, int * error );
+// Release the loaded module, if any. Fails in real-time mode, where the
+// render thread may be using it. Returns 1 on success, 0 on failure.
+extern int openmpt_bridge_module_unload( openmpt_bridge_module * handle );
+
+// Loaded module, or NULL. Owned by the handle.
+extern openmpt_module * openmpt_bridge_module_get_module( const openmpt_bridge_module * handle );
+
+// Render interleaved or planar stereo float. Returns frames rendered.
+extern size_t openmpt_bridge_module_read_interleaved_float_stereo( openmpt_bridge_module * handle, int32_t samplerate, size_t count, float * interleaved_stereo );
+extern size_t openmpt_bridge_module_read_float_stereo( openmpt_bridge_module * handle, int32_t samplerate, size_t count, float * left, float * right );
+
+// Seek. Returns the position actually set, in seconds. In real-time mode
+// the seek is queued for the next block and the return value is the
+// expected position: the clamped target, or the start of the order.
+extern double openmpt_bridge_module_set_position_seconds( openmpt_bridge_module * handle, double seconds );
+extern double openmpt_bridge_module_set_position_order_row( openmpt_bridge_module * handle, int32_t order, int32_t row );
+
+// Select a subsong (-1 for all) or set the repeat count, queued in real-time
+// mode. Returns 1 on success or when queued, 0 on failure.
+extern int openmpt_bridge_module_select_subsong( openmpt_bridge_module * handle, int32_t subsong );
+extern int openmpt_bridge_module_set_repeat_count( openmpt_bridge_module * handle, int32_t repeat_count );
+
+// Copy the current counters. Each field is read atomically; fields updated
+// by a concurrent render call may be one block apart.
+// Returns 1 on success, 0 if handle or stats is NULL.
+extern int openmpt_bridge_get_stats( const openmpt_bridge_module * handle, openmpt_bridge_stats * stats );
+extern void openmpt_bridge_reset_stats( openmpt_bridge_module * handle );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPENMPT_BRIDGE_MODULE_H */
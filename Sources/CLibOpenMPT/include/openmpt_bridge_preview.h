@@ -0,0 +1,71 @@
+/*
+ * openmpt_bridge_preview.h
+ * ------------------------
+ * Purpose: Short preview clips starting at the most energetic part of a song
+ *
+ * Picking the start never renders the whole song. The order start times
+ * (the same seek index the parallel exporter splits on) give the candidate
+ * starts. A scan instance seeks to each order and renders a short probe at
+ * a low sample rate with nearest-neighbour interpolation, and a clip-length
+ * window over those probes picks the loudest stretch. A second instance
+ * then seeks straight to the chosen order and renders only the clip, at
+ * full quality. The clip is faded in and out and written atomically, so a
+ * catalog never sees a partial file.
+ *
+ * Batches run one module per job on a thread pool.
+ */
+
+#ifndef OPENMPT_BRIDGE_PREVIEW_H
+#define OPENMPT_BRIDGE_PREVIEW_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "openmpt_bridge_export.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct openmpt_bridge_preview_options {
+    double clip_seconds;            // clip length
+    double fade_in_seconds;         // clips start mid-song, so a short fade avoids a click
+    double fade_out_seconds;
+    double probe_seconds;           // audio rendered per order while scanning
+    int32_t scan_sample_rate;       // rate of the probes
+    int32_t subsong;                // -1 = default subsong
+    int32_t thread_count;           // batch workers, 0 = one per CPU
+} openmpt_bridge_preview_options;
+
+typedef struct openmpt_bridge_preview_result {
+    int32_t ok;                     // 1 if the clip was written
+    int32_t order;                  // order the clip starts at, -1 for the start of the song
+    double start_seconds;           // song time the clip starts at
+    uint64_t frames;                // frames written; shorter than the clip for short songs
+    double scan_seconds;            // time spent choosing the start
+    double render_seconds;          // time spent rendering the clip
+} openmpt_bridge_preview_result;
+
+// Defaults: 20 s clips, 10 ms fade in, 1.5 s fade out, 1 s probes at 8000 Hz,
+// default subsong, one thread per CPU
+extern void openmpt_bridge_preview_options_init( openmpt_bridge_preview_options * preview );
+
+// Choose where a preview of module data should start without writing it.
+// preview may be NULL. Returns 1 on success, 0 if the data cannot be loaded.
+extern int openmpt_bridge_preview_find_start( const void * data, size_t size, const openmpt_bridge_preview_options * preview, int32_t * order, double * start_seconds );
+
+// Write a preview of module data to output_path. options sets the sample
+// rate, format and container; its length and trimming fields are ignored.
+// options, preview and result may be NULL. Returns 1 on success, 0 on failure.
+extern int openmpt_bridge_preview_render( const void * data, size_t size, const char * output_path, const openmpt_bridge_export_options * options, const openmpt_bridge_preview_options * preview, openmpt_bridge_preview_result * result );
+
+// Write a preview for each of count module files, module_paths[i] to
+// output_paths[i], on preview->thread_count threads. results, if not NULL,
+// receives one entry per module. Returns the number of previews written.
+extern size_t openmpt_bridge_preview_batch( const char * const * module_paths, const char * const * output_paths, size_t count, const openmpt_bridge_export_options * options, const openmpt_bridge_preview_options * preview, openmpt_bridge_preview_result * results );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPENMPT_BRIDGE_PREVIEW_H */
@@ -0,0 +1,63 @@
+/*
+ * openmpt_bridge_quality.h
+ * ------------------------
+ * Purpose: Adaptive render quality driven by the deadline monitor
+ *
+ * When enabled, the render thread watches each block's utilization. Sustained
+ * overruns step the quality level down: level 1 disables volume ramping and
+ * caps the interpolation filter at 4 taps, level 2 at 2 taps, level 3 at 1
+ * tap (nearest neighbour). Once utilization has stayed well below the budget
+ * for long enough, quality steps back up one level at a time. Changes are
+ * applied on the render thread between blocks.
+ *
+ * Interpolation and ramping set through openmpt_bridge_module_set_render_param
+ * are the requested quality that restores return to.
+ */
+
+#ifndef OPENMPT_BRIDGE_QUALITY_H
+#define OPENMPT_BRIDGE_QUALITY_H
+
+#include <stdint.h>
+
+#include "openmpt_bridge_module.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Level 0 is the requested quality, level 3 the cheapest
+#define OPENMPT_BRIDGE_QUALITY_MAX_LEVEL 3
+
+typedef struct openmpt_bridge_quality_options {
+    double restore_utilization; // headroom needed to step back up, as a fraction of the deadline (default 0.4)
+    uint32_t degrade_blocks;    // net overrun blocks before stepping down (default 4)
+    uint32_t restore_blocks;    // consecutive blocks below restore_utilization before stepping up (default 256)
+    int32_t max_level;          // lowest quality allowed, 1...OPENMPT_BRIDGE_QUALITY_MAX_LEVEL (default 3)
+} openmpt_bridge_quality_options;
+
+typedef struct openmpt_bridge_quality_state {
+    int32_t enabled;
+    int32_t level;
+    int32_t interpolation_filter_length;   // value currently applied to the module
+    int32_t volume_ramping_strength;
+    uint64_t degrades;          // steps down since the module was loaded
+    uint64_t restores;          // steps up since the module was loaded
+} openmpt_bridge_quality_state;
+
+extern void openmpt_bridge_quality_options_init( openmpt_bridge_quality_options * options );
+
+// Start adapting. options may be NULL for the defaults; calling again
+// replaces the options. Returns 1 on success, 0 if handle is NULL.
+extern int openmpt_bridge_quality_enable( openmpt_bridge_module * handle, const openmpt_bridge_quality_options * options );
+
+// Stop adapting. The requested quality is restored before the next block.
+extern void openmpt_bridge_quality_disable( openmpt_bridge_module * handle );
+
+// Returns 1 on success, 0 if handle or state is NULL.
+extern int openmpt_bridge_quality_get_state( const openmpt_bridge_module * handle, openmpt_bridge_quality_state * state );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPENMPT_BRIDGE_QUALITY_H */
@@ -0,0 +1,71 @@
+/*
+ * openmpt_bridge_resampler.h
+ * --------------------------
+ * Purpose: Polyphase sample-rate conversion of rendered audio
+ *
+ * Rendering a module once at a base rate and resampling the result is much
+ * cheaper than running libopenmpt's mixer again for every output rate. The
+ * resampler converts interleaved float audio between any two rates with a
+ * Kaiser-windowed sinc filter bank, evaluated with SIMD dot products.
+ *
+ * The rate ratio is reduced to L/M and tracked exactly. When L is at most
+ * OPENMPT_BRIDGE_RESAMPLER_MAX_PHASES the filter bank has one phase per
+ * output position (e.g. 48000 -> 44100 uses 147 phases); otherwise the
+ * nearest of that many phases is used.
+ *
+ * Output frame n corresponds to input time n * input_rate / output_rate;
+ * the filter's look-ahead is held back until more input (or a flush)
+ * arrives. A resampler is not thread safe, but processing never allocates.
+ */
+
+#ifndef OPENMPT_BRIDGE_RESAMPLER_H
+#define OPENMPT_BRIDGE_RESAMPLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OPENMPT_BRIDGE_RESAMPLER_MAX_CHANNELS 8
+#define OPENMPT_BRIDGE_RESAMPLER_MAX_PHASES 1024
+
+typedef enum openmpt_bridge_resampler_quality {
+    OPENMPT_BRIDGE_RESAMPLER_FAST = 0,      // 16 taps, ~90% passband
+    OPENMPT_BRIDGE_RESAMPLER_BALANCED = 1,  // 32 taps, ~94% passband
+    OPENMPT_BRIDGE_RESAMPLER_BEST = 2       // 64 taps, ~96% passband
+} openmpt_bridge_resampler_quality;
+
+typedef struct openmpt_bridge_resampler openmpt_bridge_resampler;
+
+// Returns NULL for rates <= 0, a downsampling factor above 16, a channel
+// count outside 1...OPENMPT_BRIDGE_RESAMPLER_MAX_CHANNELS, or an unknown quality.
+extern openmpt_bridge_resampler * openmpt_bridge_resampler_create( int32_t input_rate, int32_t output_rate, int channels, int quality );
+extern void openmpt_bridge_resampler_destroy( openmpt_bridge_resampler * resampler );
+
+// Convert interleaved frames. On entry *input_frames is the number of
+// frames available; on return it is the number consumed. Returns the
+// number of frames written to output. Input is consumed completely when
+// output_frames >= openmpt_bridge_resampler_max_output(input_frames).
+extern size_t openmpt_bridge_resampler_process( openmpt_bridge_resampler * resampler, const float * input, size_t * input_frames, float * output, size_t output_frames );
+
+// Emit the frames still held back by the filter's look-ahead, as if the
+// input were followed by silence. Returns frames written.
+extern size_t openmpt_bridge_resampler_flush( openmpt_bridge_resampler * resampler, float * output, size_t output_frames );
+
+// Largest number of frames process() or flush() can produce for this many input frames
+extern size_t openmpt_bridge_resampler_max_output( const openmpt_bridge_resampler * resampler, size_t input_frames );
+
+// Input frames held back before output catches up
+extern int openmpt_bridge_resampler_get_latency( const openmpt_bridge_resampler * resampler );
+extern int openmpt_bridge_resampler_get_taps( const openmpt_bridge_resampler * resampler );
+
+// Forget all buffered input
+extern void openmpt_bridge_resampler_reset( openmpt_bridge_resampler * resampler );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPENMPT_BRIDGE_RESAMPLER_H */
@@ -0,0 +1,141 @@
+/*
+ * openmpt_bridge_snapshot.h
+ * -------------------------
+ * Purpose: Immutable module snapshots and published playback position
+ *
+ * The render thread owns the libopenmpt module while a handle is in
+ * real-time mode. Everything else reads from two places that never touch
+ * the module:
+ *
+ * - a snapshot of metadata, order list and pattern layout taken when the
+ *   module is loaded. Snapshots are reference counted and never change, so
+ *   any thread may read them without synchronization.
+ *
+ *   Pattern cells are not copied at load. Each snapshot owns a pattern
+ *   store with a copy of the module file, parsed into its own pattern-only
+ *   libopenmpt instance, without samples, the first time a cell or order
+ *   time is asked for. Cells are decoded from it on first access, in pages
+ *   of 16 rows. Pages are packed: each row keeps a bitmap of its non-empty
+ *   channels and only those cells. The store caches pages in an LRU list
+ *   capped at OPENMPT_BRIDGE_PATTERN_CACHE_BYTES unless
+ *   openmpt_bridge_snapshot_set_cache_budget changes it. Cell reads take a short
+ *   per-snapshot lock, which only control threads ever contend for. A
+ *   viewer that follows playback calls openmpt_bridge_module_prefetch_patterns
+ *   so the next orders are decoded before they are drawn.
+ * - the playback position, published by whichever thread renders or seeks
+ *   through a sequence counter. Readers retry if they overlap a write; the
+ *   writer never waits.
+ *
+ * Seeks and subsong changes are queued like other commands in real-time
+ * mode (see openmpt_bridge_commands.h).
+ */
+
+#ifndef OPENMPT_BRIDGE_SNAPSHOT_H
+#define OPENMPT_BRIDGE_SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "openmpt_bridge_module.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Decoded pattern pages kept per snapshot
+#define OPENMPT_BRIDGE_PATTERN_CACHE_BYTES ( 1024 * 1024 )
+
+typedef struct openmpt_bridge_snapshot_pattern {
+    int32_t rows;
+    int32_t rows_per_beat;
+    int32_t rows_per_measure;
+    const char * name;
+} openmpt_bridge_snapshot_pattern;
+
+typedef struct openmpt_bridge_snapshot {
+    const char * title;
+    const char * artist;
+    const char * type;
+    const char * type_long;
+    const char * tracker;
+    const char * message;
+    double duration;
+
+    int32_t num_channels;
+    int32_t num_orders;
+    int32_t num_patterns;
+    int32_t num_instruments;
+    int32_t num_samples;
+    int32_t num_subsongs;
+
+    const int32_t * orders;                 // pattern index per order
+    const openmpt_bridge_snapshot_pattern * patterns;
+    const char * const * instrument_names;  // num_instruments entries
+    const char * const * sample_names;      // num_samples entries
+} openmpt_bridge_snapshot;
+
+typedef struct openmpt_bridge_pattern_cache_stats {
+    uint64_t hits;                  // reads served from a cached page
+    uint64_t misses;                // pages decoded for a read
+    uint64_t evictions;             // pages dropped to stay within budget
+    uint64_t prefetched;            // pages decoded ahead by a prefetch
+    size_t bytes;                   // cached page bytes
+    size_t budget;
+    int32_t pages;                  // cached pages
+} openmpt_bridge_pattern_cache_stats;
+
+typedef struct openmpt_bridge_position {
+    double seconds;
+    int32_t order;
+    int32_t pattern;
+    int32_t row;
+    int32_t speed;
+    double tempo;
+    int32_t subsong;
+    int32_t playing_channels;
+    int32_t at_end;                 // the last render stopped at the end of the song
+} openmpt_bridge_position;
+
+// Snapshot of the loaded module with an added reference, or NULL if no
+// module is loaded. Release it with openmpt_bridge_snapshot_release; it
+// stays valid after the handle loads another module or is destroyed.
+extern const openmpt_bridge_snapshot * openmpt_bridge_module_acquire_snapshot( openmpt_bridge_module * handle );
+extern void openmpt_bridge_snapshot_release( const openmpt_bridge_snapshot * snapshot );
+
+// Copy one pattern cell, decoding its page if needed. Returns 1 on
+// success, 0 if out of range or out of memory.
+extern int openmpt_bridge_snapshot_get_cell( const openmpt_bridge_snapshot * snapshot, int32_t pattern, int32_t channel, int32_t row, openmpt_pattern_cell * cell );
+
+// Copy the num_channels cells of a pattern row, cheaper than one call per cell
+extern int openmpt_bridge_snapshot_get_row( const openmpt_bridge_snapshot * snapshot, int32_t pattern, int32_t row, openmpt_pattern_cell * cells );
+
+// Decode the patterns of count orders starting at order, skipping ones
+// already cached. Orders past the end and order list markers are ignored.
+extern void openmpt_bridge_snapshot_prefetch( const openmpt_bridge_snapshot * snapshot, int32_t order, int32_t count );
+
+// Start of an order in seconds, or -1 if the order is never played or out
+// of range. Each order is looked up once, on first request, which costs a
+// scan of the song.
+extern double openmpt_bridge_snapshot_get_order_time( const openmpt_bridge_snapshot * snapshot, int32_t order );
+
+extern int openmpt_bridge_snapshot_get_cache_stats( const openmpt_bridge_snapshot * snapshot, openmpt_bridge_pattern_cache_stats * stats );
+
+// Change the byte budget of the decoded page cache, dropping the least
+// recently used pages at once if they no longer fit. The most recently used
+// page is always kept. Returns 1 on success, 0 without a snapshot.
+extern int openmpt_bridge_snapshot_set_cache_budget( const openmpt_bridge_snapshot * snapshot, size_t bytes );
+
+// Latest published position. Safe from any thread while another renders.
+// Returns 1 on success, 0 if no module is loaded.
+extern int openmpt_bridge_module_get_position( const openmpt_bridge_module * handle, openmpt_bridge_position * position );
+
+// Prefetch the patterns of the current order and the count orders after it,
+// as last published by the renderer. Call from a control thread that follows
+// playback, such as a pattern view's position timer.
+extern void openmpt_bridge_module_prefetch_patterns( openmpt_bridge_module * handle, int32_t count );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPENMPT_BRIDGE_SNAPSHOT_H */
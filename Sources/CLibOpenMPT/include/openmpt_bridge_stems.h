@@ -0,0 +1,65 @@
+/*
+ * openmpt_bridge_stems.h
+ * ----------------------
+ * Purpose: Parallel export of one file per tracker channel
+ *
+ * libopenmpt mixes every channel into a single stereo stream, so a stem has
+ * to come from an instance with all other channels muted. The stem
+ * exporter runs those instances on a thread pool, one job per channel.
+ * Muted channels are skipped by the mixer, so each job pays for sequencing
+ * the song plus mixing one channel, not for a full render. Workers hand
+ * converted blocks to one shared writer thread that serves every stem file,
+ * so disk I/O neither blocks rendering nor needs a thread per file.
+ *
+ * Channels whose patterns never trigger a note or instrument can be skipped
+ * without rendering.
+ */
+
+#ifndef OPENMPT_BRIDGE_STEMS_H
+#define OPENMPT_BRIDGE_STEMS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "openmpt_bridge_export.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct openmpt_bridge_stem_options {
+    int32_t thread_count;           // 0 = one per CPU
+    int32_t subsong;                // -1 = default subsong
+    int32_t skip_empty_channels;    // no file for channels without notes or instruments
+} openmpt_bridge_stem_options;
+
+typedef struct openmpt_bridge_stem_result {
+    // frames and audio_seconds are per stem, render_seconds is summed over
+    // all workers, write_wait_seconds is time workers waited for the writer,
+    // and realtime_factor counts the audio of every stem written
+    openmpt_bridge_export_result totals;
+    int32_t channels;               // channels in the module
+    int32_t stems_written;
+    int32_t empty_channels;         // channels skipped as empty
+} openmpt_bridge_stem_result;
+
+// Defaults: one thread per CPU, default subsong, empty channels skipped
+extern void openmpt_bridge_stem_options_init( openmpt_bridge_stem_options * stems );
+
+// Path of the stem for channel (0-based): "<prefix>_ch01.wav", or ".raw"
+// for the raw container. Returns the length snprintf would have written.
+extern int openmpt_bridge_stem_path( char * buffer, size_t size, const char * output_prefix, int32_t channel, int32_t container );
+
+// Render every channel of module data to its own file named by
+// openmpt_bridge_stem_path. options, stems and result may be NULL.
+// Returns 1 on success, 0 on failure; partial stems are removed on failure.
+extern int openmpt_bridge_export_stems( const void * data, size_t size, const char * output_prefix, const openmpt_bridge_export_options * options, const openmpt_bridge_stem_options * stems, openmpt_bridge_stem_result * result );
+
+// Read a module file and export its stems
+extern int openmpt_bridge_export_stems_file( const char * module_path, const char * output_prefix, const openmpt_bridge_export_options * options, const openmpt_bridge_stem_options * stems, openmpt_bridge_stem_result * result );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPENMPT_BRIDGE_STEMS_H */
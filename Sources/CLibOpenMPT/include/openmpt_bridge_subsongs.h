@@ -0,0 +1,43 @@
+/*
+ * openmpt_bridge_subsongs.h
+ * -------------------------
+ * Purpose: Durations, restart positions and names of all subsongs in one call
+ */
+
+#ifndef OPENMPT_BRIDGE_SUBSONGS_H
+#define OPENMPT_BRIDGE_SUBSONGS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libopenmpt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct openmpt_bridge_subsong {
+    double duration;            // seconds
+    int32_t restart_order;
+    int32_t restart_row;
+    const char * name;          // owned by the table, never NULL
+} openmpt_bridge_subsong;
+
+typedef struct openmpt_bridge_subsong_table {
+    int32_t count;
+    openmpt_bridge_subsong * subsongs;
+} openmpt_bridge_subsong_table;
+
+// Collect every subsong of a module into a single allocation.
+// libopenmpt measures all subsongs when the module is loaded, so this only
+// walks the cached results; the selected subsong and playback position are
+// restored afterwards. Do not call while another thread renders the module.
+// Returns NULL on failure; release with openmpt_bridge_subsongs_destroy().
+extern openmpt_bridge_subsong_table * openmpt_bridge_subsongs_create( openmpt_module * mod );
+extern void openmpt_bridge_subsongs_destroy( openmpt_bridge_subsong_table * table );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPENMPT_BRIDGE_SUBSONGS_H */
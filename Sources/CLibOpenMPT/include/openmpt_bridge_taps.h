@@ -0,0 +1,81 @@
+/*
+ * openmpt_bridge_taps.h
+ * ---------------------
+ * Purpose: Fan-out of one render to several consumers
+ *
+ * A tap receives a copy of every block the handle renders, converted to
+ * its own sample rate, channel count and sample format, and buffers it in
+ * a lock-free ring. Speaker output, a recorder, an analyzer and a network
+ * encoder can each attach a tap and read at their own pace instead of
+ * rendering the module again.
+ *
+ * The render thread writes each tap's ring after every block and never
+ * waits: when a reader falls behind, frames that do not fit are dropped and
+ * counted. Each tap has exactly one reader thread. Attaching and detaching
+ * happen on control threads; detach waits for a block in progress to finish
+ * with the tap before freeing it.
+ */
+
+#ifndef OPENMPT_BRIDGE_TAPS_H
+#define OPENMPT_BRIDGE_TAPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "openmpt_bridge_module.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Taps attached to one handle at a time
+#define OPENMPT_BRIDGE_MAX_TAPS 8
+
+typedef struct openmpt_bridge_tap openmpt_bridge_tap;
+
+typedef struct openmpt_bridge_tap_options {
+    int32_t sample_rate;        // output rate, or 0 to pass the render rate through
+    int32_t source_rate;        // rate the handle renders at; required when sample_rate is set
+    int32_t channels;           // 1 (downmixed) or 2
+    int32_t format;             // openmpt_bridge_sample_format
+    int32_t quality;            // openmpt_bridge_resampler_quality, used when the rates differ
+    size_t capacity_frames;     // ring size in output frames
+} openmpt_bridge_tap_options;
+
+typedef struct openmpt_bridge_tap_stats {
+    uint64_t frames_written;    // frames placed in the ring
+    uint64_t frames_read;
+    uint64_t frames_dropped;    // frames that did not fit because the reader fell behind
+    uint64_t blocks_skipped;    // blocks rendered at a rate other than source_rate
+} openmpt_bridge_tap_stats;
+
+// Defaults: render rate, stereo, F32, balanced quality, 16384 frames
+extern void openmpt_bridge_tap_options_init( openmpt_bridge_tap_options * options );
+
+// Attach a tap; it receives every block rendered from the next one on.
+// Returns NULL if the options are invalid or OPENMPT_BRIDGE_MAX_TAPS taps
+// are attached. options may be NULL for the defaults.
+extern openmpt_bridge_tap * openmpt_bridge_tap_attach( openmpt_bridge_module * handle, const openmpt_bridge_tap_options * options );
+
+// Detach and free a tap. Must not race with openmpt_bridge_tap_read.
+// Taps still attached are freed with the handle.
+extern void openmpt_bridge_tap_detach( openmpt_bridge_module * handle, openmpt_bridge_tap * tap );
+
+// Reader thread only. Copy up to frames buffered frames into output, in
+// the tap's format with interleaved channels. Returns frames copied.
+extern size_t openmpt_bridge_tap_read( openmpt_bridge_tap * tap, void * output, size_t frames );
+
+// Frames buffered and not yet read
+extern size_t openmpt_bridge_tap_available( const openmpt_bridge_tap * tap );
+
+// Bytes per output frame
+extern size_t openmpt_bridge_tap_frame_bytes( const openmpt_bridge_tap * tap );
+
+// Returns 1 on success, 0 if tap or stats is NULL
+extern int openmpt_bridge_tap_get_stats( const openmpt_bridge_tap * tap, openmpt_bridge_tap_stats * stats );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPENMPT_BRIDGE_TAPS_H */
@@ -0,0 +1,105 @@
+/*
+ * openmpt_bridge_waveform.h
+ * -------------------------
+ * Purpose: Min/max/RMS waveform overviews, cached on disk
+ *
+ * An overview is built by rendering the song once, faster than realtime, at
+ * a low sample rate with nearest-neighbour interpolation. Level 0 holds one
+ * point per frames_per_point rendered frames. Each further level halves the
+ * resolution, so a view of any width can pick the level closest to one
+ * point per pixel. Points cover both stereo channels.
+ *
+ * The overview is written once and then mmap()ed and read in place, like a
+ * catalog. The header records the hash of the module data and the build
+ * settings, so a cached file can be checked against the module it claims
+ * to describe.
+ *
+ * File layout (little-endian, every section 8-byte aligned):
+ *   openmpt_bridge_waveform_header
+ *   openmpt_bridge_waveform_point[levels[0].count]     level 0
+ *   openmpt_bridge_waveform_point[levels[1].count]     level 1, and so on
+ */
+
+#ifndef OPENMPT_BRIDGE_WAVEFORM_H
+#define OPENMPT_BRIDGE_WAVEFORM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OPENMPT_BRIDGE_WAVEFORM_VERSION 1
+#define OPENMPT_BRIDGE_WAVEFORM_MAX_LEVELS 16
+
+typedef struct openmpt_bridge_waveform_options {
+    int32_t sample_rate;            // render rate; lower is faster
+    int32_t frames_per_point;       // rendered frames per level 0 point
+    int32_t subsong;                // -1 = default subsong
+    int32_t interpolation_filter;   // OPENMPT_MODULE_RENDER_INTERPOLATIONFILTER_LENGTH value
+    double max_seconds;             // 0 = whole song
+} openmpt_bridge_waveform_options;
+
+// Peaks and RMS of one span, scaled so full scale is 32767, 6 bytes
+typedef struct openmpt_bridge_waveform_point {
+    int16_t min;
+    int16_t max;
+    uint16_t rms;
+} openmpt_bridge_waveform_point;
+
+typedef struct openmpt_bridge_waveform_level {
+    uint64_t offset;                // of the first point, from the start of the file
+    uint64_t count;
+    uint64_t frames_per_point;
+} openmpt_bridge_waveform_level;
+
+typedef struct openmpt_bridge_waveform_header {
+    char magic[8];                  // "OMPTWAV\0"
+    uint32_t version;
+    uint32_t point_size;            // sizeof(openmpt_bridge_waveform_point)
+    uint64_t content_hash;          // of the module data
+    int32_t sample_rate;
+    int32_t frames_per_point;
+    int32_t subsong;
+    int32_t interpolation_filter;
+    double max_seconds;
+    uint64_t total_frames;          // frames rendered
+    uint32_t level_count;
+    uint32_t reserved;
+    openmpt_bridge_waveform_level levels[OPENMPT_BRIDGE_WAVEFORM_MAX_LEVELS];
+} openmpt_bridge_waveform_header;
+
+typedef struct openmpt_bridge_waveform openmpt_bridge_waveform;
+
+// Defaults: 11025 Hz, 128 frames per point, default subsong, nearest neighbour, whole song
+extern void openmpt_bridge_waveform_options_init( openmpt_bridge_waveform_options * options );
+
+// Render module data and write its overview atomically to path. options
+// may be NULL. Returns 1 on success, 0 on failure.
+extern int openmpt_bridge_waveform_build( const void * data, size_t size, const openmpt_bridge_waveform_options * options, const char * path );
+
+// Map an overview. Returns NULL if missing or malformed.
+extern openmpt_bridge_waveform * openmpt_bridge_waveform_open( const char * path );
+
+// Map the overview cached at path if it was built from this data with these
+// options; otherwise build it first, replacing any stale file. Returns NULL
+// if the module cannot be rendered or the cache cannot be written.
+extern openmpt_bridge_waveform * openmpt_bridge_waveform_load( const void * data, size_t size, const openmpt_bridge_waveform_options * options, const char * path );
+
+extern void openmpt_bridge_waveform_close( openmpt_bridge_waveform * waveform );
+
+// Pointer into the mapping, valid until the overview is closed
+extern const openmpt_bridge_waveform_header * openmpt_bridge_waveform_get_header( const openmpt_bridge_waveform * waveform );
+
+// Points of one level, or NULL if level is out of range
+extern const openmpt_bridge_waveform_point * openmpt_bridge_waveform_get_level( const openmpt_bridge_waveform * waveform, uint32_t level, uint64_t * count );
+
+// Coarsest level with at most frames_per_point frames per point, or 0
+extern uint32_t openmpt_bridge_waveform_find_level( const openmpt_bridge_waveform * waveform, double frames_per_point );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPENMPT_BRIDGE_WAVEFORM_H */
@@ -0,0 +1,252 @@
+// openmpt_bridge_analyzer.c
+// Spectrum analyzer: tap ring in, worker-thread FFT, triple-buffered spectra out
+
+#include "openmpt_bridge_analyzer.h"
+#include "openmpt_bridge_taps.h"
+#include "bridge_fft.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BRIDGE_ANALYZER_READ_FRAMES 1024
+#define BRIDGE_ANALYZER_MIN_TAP_FRAMES 16384
+// Bit set in the triple buffer state while the middle frame is unread
+#define BRIDGE_ANALYZER_FRESH 4u
+
+struct openmpt_bridge_analyzer {
+    openmpt_bridge_analyzer_options options;
+    openmpt_bridge_tap* tap;
+    bridge_fft* fft;
+    pthread_t thread;
+    atomic_int running;
+
+    // Worker state
+    float* window;
+    float* history;             // latest fft_size mono frames, oldest first
+    float* block;               // one tap read, stereo
+    float* windowed;
+    float* re;
+    float* im;
+    float* smoothed;            // linear magnitudes carried between spectra
+    size_t since_hop;
+    uint64_t frames_seen;
+    uint64_t sequence;
+    float gain;                 // scales a full-scale sine to magnitude 1
+
+    // Triple buffer: the worker owns back, the reader owns front, and the
+    // middle index plus the fresh bit live in state
+    openmpt_bridge_spectrum frames[3];
+    float* magnitudes[3];
+    atomic_uint state;
+    unsigned back;
+    unsigned front;
+    int has_front;
+};
+
+void openmpt_bridge_analyzer_options_init(openmpt_bridge_analyzer_options* options) {
+    if (!options) return;
+    options->sample_rate = 48000;
+    options->fft_size = 2048;
+    options->hop_frames = 0;
+    options->window = OPENMPT_BRIDGE_ANALYZER_WINDOW_HANN;
+    options->smoothing = 0.5f;
+    options->floor_db = -120.0f;
+}
+
+// MARK: - Worker
+
+static void bridge_analyzer_publish(openmpt_bridge_analyzer* analyzer) {
+    const size_t size = (size_t)analyzer->options.fft_size;
+    const size_t bins = size / 2 + 1;
+    for (size_t i = 0; i < size; i++) analyzer->windowed[i] = analyzer->history[i] * analyzer->window[i];
+    bridge_fft_real(analyzer->fft, analyzer->windowed, analyzer->re, analyzer->im);
+
+    // Peaks show at once and fall back at the smoothing rate
+    const float smoothing = analyzer->options.smoothing;
+    const float floor_db = analyzer->options.floor_db;
+    float* out = analyzer->magnitudes[analyzer->back];
+    for (size_t k = 0; k < bins; k++) {
+        // DC and Nyquist have no mirrored negative-frequency half
+        float gain = k == 0 || k == bins - 1 ? 0.5f * analyzer->gain : analyzer->gain;
+        float magnitude = gain * sqrtf(analyzer->re[k] * analyzer->re[k] + analyzer->im[k] * analyzer->im[k]);
+        float previous = analyzer->smoothed[k];
+        if (magnitude < previous) magnitude = smoothing * previous + (1.0f - smoothing) * magnitude;
+        analyzer->smoothed[k] = magnitude;
+        float db = magnitude > 1e-12f ? 20.0f * log10f(magnitude) : floor_db;
+        out[k] = db > floor_db ? db : floor_db;
+    }
+
+    openmpt_bridge_spectrum* frame = &analyzer->frames[analyzer->back];
+    frame->sequence = ++analyzer->sequence;
+    frame->frame = analyzer->frames_seen;
+    unsigned previous = atomic_exchange_explicit(&analyzer->state, analyzer->back | BRIDGE_ANALYZER_FRESH, memory_order_acq_rel);
+    analyzer->back = previous & 3u;
+}
+
+// Append mono frames to the history window
+static void bridge_analyzer_push(openmpt_bridge_analyzer* analyzer, const float* stereo, size_t frames) {
+    const size_t size = (size_t)analyzer->options.fft_size;
+    memmove(analyzer->history, analyzer->history + frames, (size - frames) * sizeof(float));
+    float* tail = analyzer->history + size - frames;
+    for (size_t i = 0; i < frames; i++) tail[i] = 0.5f * (stereo[i * 2] + stereo[i * 2 + 1]);
+    analyzer->frames_seen += frames;
+    analyzer->since_hop += frames;
+}
+
+static void* bridge_analyzer_main(void* arg) {
+    openmpt_bridge_analyzer* analyzer = (openmpt_bridge_analyzer*)arg;
+    const size_t hop = (size_t)analyzer->options.hop_frames;
+    // Poll at about twice the hop rate, between 1 and 10 ms
+    long idle_ns = (long)(5e8 * (double)hop / analyzer->options.sample_rate);
+    if (idle_ns < 1000000) idle_ns = 1000000;
+    if (idle_ns > 10000000) idle_ns = 10000000;
+    const struct timespec idle = { 0, idle_ns };
+
+    while (atomic_load_explicit(&analyzer->running, memory_order_acquire)) {
+        size_t available = openmpt_bridge_tap_available(analyzer->tap);
+        if (available == 0) {
+            nanosleep(&idle, NULL);
+            continue;
+        }
+        while (available > 0) {
+            size_t wanted = hop - analyzer->since_hop;
+            if (wanted > available) wanted = available;
+            if (wanted > BRIDGE_ANALYZER_READ_FRAMES) wanted = BRIDGE_ANALYZER_READ_FRAMES;
+            size_t frames = openmpt_bridge_tap_read(analyzer->tap, analyzer->block, wanted);
+            if (frames == 0) break;
+            bridge_analyzer_push(analyzer, analyzer->block, frames);
+            available -= frames;
+            if (analyzer->since_hop < hop) continue;
+            analyzer->since_hop = 0;
+            // When behind, spectra that a later hop already supersedes are skipped
+            if (available < hop) bridge_analyzer_publish(analyzer);
+        }
+    }
+    return NULL;
+}
+
+// MARK: - Lifecycle
+
+static void bridge_analyzer_free(openmpt_bridge_analyzer* analyzer) {
+    bridge_fft_destroy(analyzer->fft);
+    free(analyzer->window);
+    free(analyzer->history);
+    free(analyzer->block);
+    free(analyzer->windowed);
+    free(analyzer->re);
+    free(analyzer->im);
+    free(analyzer->smoothed);
+    for (int i = 0; i < 3; i++) free(analyzer->magnitudes[i]);
+    free(analyzer);
+}
+
+static void bridge_analyzer_window(float* window, size_t size, int32_t kind) {
+    for (size_t i = 0; i < size; i++) {
+        double phase = 2.0 * M_PI * (double)i / (double)size;
+        if (kind == OPENMPT_BRIDGE_ANALYZER_WINDOW_BLACKMAN_HARRIS) {
+            window[i] = (float)(0.35875 - 0.48829 * cos(phase) + 0.14128 * cos(2.0 * phase) - 0.01168 * cos(3.0 * phase));
+        } else {
+            window[i] = (float)(0.5 - 0.5 * cos(phase));
+        }
+    }
+}
+
+openmpt_bridge_analyzer* openmpt_bridge_analyzer_create(openmpt_bridge_module* handle, const openmpt_bridge_analyzer_options* options) {
+    if (!handle) return NULL;
+    openmpt_bridge_analyzer_options settings;
+    openmpt_bridge_analyzer_options_init(&settings);
+    if (options) settings = *options;
+    if (settings.hop_frames == 0) settings.hop_frames = settings.fft_size / 4;
+    if (settings.sample_rate <= 0 || settings.fft_size < 64 || settings.fft_size > 16384 ||
+        (settings.fft_size & (settings.fft_size - 1)) != 0 || settings.hop_frames < 1 ||
+        settings.hop_frames > settings.fft_size || !(settings.smoothing >= 0.0f && settings.smoothing < 1.0f) ||
+        (settings.window != OPENMPT_BRIDGE_ANALYZER_WINDOW_HANN &&
+         settings.window != OPENMPT_BRIDGE_ANALYZER_WINDOW_BLACKMAN_HARRIS)) {
+        return NULL;
+    }
+
+    openmpt_bridge_analyzer* analyzer = calloc(1, sizeof(*analyzer));
+    if (!analyzer) return NULL;
+    analyzer->options = settings;
+    const size_t size = (size_t)settings.fft_size;
+    const size_t bins = size / 2 + 1;
+    analyzer->fft = bridge_fft_create(size);
+    analyzer->window = malloc(size * sizeof(float));
+    analyzer->history = calloc(size, sizeof(float));
+    analyzer->block = malloc(BRIDGE_ANALYZER_READ_FRAMES * 2 * sizeof(float));
+    analyzer->windowed = malloc(size * sizeof(float));
+    analyzer->re = malloc(bins * sizeof(float));
+    analyzer->im = malloc(bins * sizeof(float));
+    analyzer->smoothed = calloc(bins, sizeof(float));
+    int ok = analyzer->fft && analyzer->window && analyzer->history && analyzer->block && analyzer->windowed &&
+             analyzer->re && analyzer->im && analyzer->smoothed;
+    for (int i = 0; ok && i < 3; i++) {
+        analyzer->magnitudes[i] = malloc(bins * sizeof(float));
+        ok = analyzer->magnitudes[i] != NULL;
+        if (!ok) break;
+        analyzer->frames[i].bins = (int32_t)bins;
+        analyzer->frames[i].magnitudes = analyzer->magnitudes[i];
+    }
+    if (!ok) {
+        bridge_analyzer_free(analyzer);
+        return NULL;
+    }
+
+    bridge_analyzer_window(analyzer->window, size, settings.window);
+    double sum = 0.0;
+    for (size_t i = 0; i < size; i++) sum += analyzer->window[i];
+    analyzer->gain = (float)(2.0 / sum);
+    analyzer->back = 0;
+    analyzer->front = 2;
+    atomic_init(&analyzer->state, 1u);
+
+    openmpt_bridge_tap_options tap_options;
+    openmpt_bridge_tap_options_init(&tap_options);
+    tap_options.capacity_frames = size * 4 > BRIDGE_ANALYZER_MIN_TAP_FRAMES ? size * 4 : BRIDGE_ANALYZER_MIN_TAP_FRAMES;
+    analyzer->tap = openmpt_bridge_tap_attach(handle, &tap_options);
+    if (!analyzer->tap) {
+        bridge_analyzer_free(analyzer);
+        return NULL;
+    }
+
+    atomic_init(&analyzer->running, 1);
+    if (pthread_create(&analyzer->thread, NULL, bridge_analyzer_main, analyzer) != 0) {
+        openmpt_bridge_tap_detach(handle, analyzer->tap);
+        bridge_analyzer_free(analyzer);
+        return NULL;
+    }
+    return analyzer;
+}
+
+void openmpt_bridge_analyzer_destroy(openmpt_bridge_module* handle, openmpt_bridge_analyzer* analyzer) {
+    if (!analyzer) return;
+    atomic_store_explicit(&analyzer->running, 0, memory_order_release);
+    pthread_join(analyzer->thread, NULL);
+    openmpt_bridge_tap_detach(handle, analyzer->tap);
+    bridge_analyzer_free(analyzer);
+}
+
+// MARK: - Reader
+
+const openmpt_bridge_spectrum* openmpt_bridge_analyzer_acquire(openmpt_bridge_analyzer* analyzer) {
+    if (!analyzer) return NULL;
+    if (atomic_load_explicit(&analyzer->state, memory_order_relaxed) & BRIDGE_ANALYZER_FRESH) {
+        unsigned previous = atomic_exchange_explicit(&analyzer->state, analyzer->front, memory_order_acq_rel);
+        analyzer->front = previous & 3u;
+        analyzer->has_front = 1;
+    }
+    return analyzer->has_front ? &analyzer->frames[analyzer->front] : NULL;
+}
+
+double openmpt_bridge_analyzer_bin_frequency(const openmpt_bridge_analyzer* analyzer, int32_t bin) {
+    if (!analyzer) return 0.0;
+    return (double)bin * analyzer->options.sample_rate / analyzer->options.fft_size;
+}
@@ -0,0 +1,395 @@
+// openmpt_bridge_catalog.c
+// Memory-mapped module catalog writer and zero-copy reader
+
+#include "openmpt_bridge_catalog.h"
+#include "openmpt_bridge_index.h"
+#include "bridge_internal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const char openmpt_bridge_catalog_magic[8] = { 'O', 'M', 'P', 'T', 'C', 'A', 'T', 0 };
+
+static size_t catalog_align8(size_t value) {
+    return (value + 7) & ~(size_t)7;
+}
+
+// MARK: - Builder
+
+struct openmpt_bridge_catalog_builder {
+    openmpt_bridge_catalog_record* records;
+    size_t count;
+    size_t capacity;
+
+    char* strings;
+    size_t strings_size;
+    size_t strings_capacity;
+
+    // Open-addressing table of pool offsets + 1 for string deduplication
+    uint32_t* slots;
+    size_t slot_mask;
+    size_t slot_used;
+};
+
+openmpt_bridge_catalog_builder* openmpt_bridge_catalog_builder_create(void) {
+    openmpt_bridge_catalog_builder* builder = calloc(1, sizeof(*builder));
+    if (!builder) return NULL;
+    builder->slot_mask = 1023;
+    builder->slots = calloc(builder->slot_mask + 1, sizeof(*builder->slots));
+    if (!builder->slots) {
+        free(builder);
+        return NULL;
+    }
+    return builder;
+}
+
+void openmpt_bridge_catalog_builder_destroy(openmpt_bridge_catalog_builder* builder) {
+    if (!builder) return;
+    free(builder->records);
+    free(builder->strings);
+    free(builder->slots);
+    free(builder);
+}
+
+static int catalog_grow_slots(openmpt_bridge_catalog_builder* builder) {
+    size_t capacity = (builder->slot_mask + 1) * 2;
+    uint32_t* slots = calloc(capacity, sizeof(*slots));
+    if (!slots) return 0;
+    for (size_t i = 0; i <= builder->slot_mask; i++) {
+        uint32_t entry = builder->slots[i];
+        if (!entry) continue;
+        const char* value = builder->strings + entry - 1;
+        size_t slot = (size_t)bridge_hash64(value, strlen(value), 0) & (capacity - 1);
+        while (slots[slot]) slot = (slot + 1) & (capacity - 1);
+        slots[slot] = entry;
+    }
+    free(builder->slots);
+    builder->slots = slots;
+    builder->slot_mask = capacity - 1;
+    return 1;
+}
+
+// Intern a string and return its pool offset, or UINT32_MAX on failure
+static uint32_t catalog_intern(openmpt_bridge_catalog_builder* builder, const char* value) {
+    if (!value) value = "";
+    size_t length = strlen(value);
+    size_t slot = (size_t)bridge_hash64(value, length, 0) & builder->slot_mask;
+    while (builder->slots[slot]) {
+        const char* existing = builder->strings + builder->slots[slot] - 1;
+        if (strcmp(existing, value) == 0) return builder->slots[slot] - 1;
+        slot = (slot + 1) & builder->slot_mask;
+    }
+
+    if (builder->strings_size + length + 1 >= UINT32_MAX) return UINT32_MAX;
+    if (builder->strings_size + length + 1 > builder->strings_capacity) {
+        size_t capacity = builder->strings_capacity ? builder->strings_capacity : 64 * 1024;
+        while (capacity < builder->strings_size + length + 1) capacity *= 2;
+        char* strings = realloc(builder->strings, capacity);
+        if (!strings) return UINT32_MAX;
+        builder->strings = strings;
+        builder->strings_capacity = capacity;
+    }
+
+    uint32_t offset = (uint32_t)builder->strings_size;
+    memcpy(builder->strings + offset, value, length + 1);
+    builder->strings_size += length + 1;
+    builder->slots[slot] = offset + 1;
+
+    // Keep the load factor at or below one half
+    if (++builder->slot_used * 2 > builder->slot_mask + 1 && !catalog_grow_slots(builder)) return UINT32_MAX;
+    return offset;
+}
+
+int openmpt_bridge_catalog_builder_add(openmpt_bridge_catalog_builder* builder, const openmpt_bridge_catalog_entry* entry) {
+    if (!builder || !entry) return 0;
+    if (builder->count >= UINT32_MAX - 1) return 0;
+    if (builder->count == builder->capacity) {
+        size_t capacity = builder->capacity ? builder->capacity * 2 : 1024;
+        openmpt_bridge_catalog_record* records = realloc(builder->records, capacity * sizeof(*records));
+        if (!records) return 0;
+        builder->records = records;
+        builder->capacity = capacity;
+    }
+
+    openmpt_bridge_catalog_record record;
+    memset(&record, 0, sizeof(record));
+    record.path = catalog_intern(builder, entry->path);
+    record.title = catalog_intern(builder, entry->title);
+    record.artist = catalog_intern(builder, entry->artist);
+    record.type = catalog_intern(builder, entry->type);
+    record.tracker = catalog_intern(builder, entry->tracker);
+    if (record.path == UINT32_MAX || record.title == UINT32_MAX || record.artist == UINT32_MAX ||
+        record.type == UINT32_MAX || record.tracker == UINT32_MAX) {
+        return 0;
+    }
+    record.channels = entry->channels;
+    record.patterns = entry->patterns;
+    record.instruments = entry->instruments;
+    record.samples = entry->samples;
+    record.duration = entry->duration;
+    record.file_size = entry->file_size;
+    record.content_hash = entry->content_hash;
+    if (entry->loudness_measured) {
+        record.flags |= OPENMPT_BRIDGE_CATALOG_FLAG_LOUDNESS;
+        record.loudness = (float)entry->loudness;
+        record.true_peak = (float)entry->true_peak;
+    }
+
+    builder->records[builder->count++] = record;
+    return 1;
+}
+
+int openmpt_bridge_catalog_builder_add_module(openmpt_bridge_catalog_builder* builder, const char* path, openmpt_module* mod, uint64_t file_size, uint64_t content_hash) {
+    if (!builder || !mod) return 0;
+
+    openmpt_bridge_catalog_entry entry;
+    char* title = bridge_copy_metadata(mod, "title");
+    char* artist = bridge_copy_metadata(mod, "artist");
+    char* type = bridge_copy_metadata(mod, "type");
+    char* tracker = bridge_copy_metadata(mod, "tracker");
+    entry.path = path;
+    entry.title = title;
+    entry.artist = artist;
+    entry.type = type;
+    entry.tracker = tracker;
+    entry.duration = openmpt_module_get_duration_seconds(mod);
+    entry.channels = (uint32_t)openmpt_module_get_num_channels(mod);
+    entry.patterns = (uint32_t)openmpt_module_get_num_patterns(mod);
+    entry.instruments = (uint32_t)openmpt_module_get_num_instruments(mod);
+    entry.samples = (uint32_t)openmpt_module_get_num_samples(mod);
+    entry.file_size = file_size;
+    entry.content_hash = content_hash;
+    entry.loudness_measured = 0;
+    entry.loudness = 0.0;
+    entry.true_peak = 0.0;
+
+    int ok = openmpt_bridge_catalog_builder_add(builder, &entry);
+    free(title);
+    free(artist);
+    free(type);
+    free(tracker);
+    return ok;
+}
+
+typedef struct catalog_sort_key {
+    const char* key;
+    uint32_t index;
+} catalog_sort_key;
+
+static int catalog_compare_exact(const void* a, const void* b) {
+    const catalog_sort_key* ka = (const catalog_sort_key*)a;
+    const catalog_sort_key* kb = (const catalog_sort_key*)b;
+    int result = strcmp(ka->key, kb->key);
+    if (result) return result;
+    return ka->index < kb->index ? -1 : ka->index > kb->index;
+}
+
+static int catalog_fold(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+static int catalog_compare_folded(const void* a, const void* b) {
+    const catalog_sort_key* ka = (const catalog_sort_key*)a;
+    const catalog_sort_key* kb = (const catalog_sort_key*)b;
+    const unsigned char* pa = (const unsigned char*)ka->key;
+    const unsigned char* pb = (const unsigned char*)kb->key;
+    while (*pa && catalog_fold(*pa) == catalog_fold(*pb)) {
+        pa++;
+        pb++;
+    }
+    int result = catalog_fold(*pa) - catalog_fold(*pb);
+    if (result) return result;
+    return ka->index < kb->index ? -1 : ka->index > kb->index;
+}
+
+static int catalog_write_order(const openmpt_bridge_catalog_builder* builder, size_t field_offset,
+                               int (*compare)(const void*, const void*), unsigned char* out) {
+    size_t count = builder->count;
+    catalog_sort_key* keys = malloc((count ? count : 1) * sizeof(*keys));
+    if (!keys) return 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t offset;
+        memcpy(&offset, (const unsigned char*)&builder->records[i] + field_offset, sizeof(offset));
+        keys[i].key = builder->strings + offset;
+        keys[i].index = (uint32_t)i;
+    }
+    qsort(keys, count, sizeof(*keys), compare);
+    for (size_t i = 0; i < count; i++) memcpy(out + i * 4, &keys[i].index, 4);
+    free(keys);
+    return 1;
+}
+
+int openmpt_bridge_catalog_builder_write(openmpt_bridge_catalog_builder* builder, const char* catalog_path) {
+    if (!builder || !catalog_path) return 0;
+
+    size_t count = builder->count;
+    openmpt_bridge_catalog_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, openmpt_bridge_catalog_magic, sizeof(header.magic));
+    header.version = OPENMPT_BRIDGE_CATALOG_VERSION;
+    header.record_size = sizeof(openmpt_bridge_catalog_record);
+    header.record_count = count;
+    header.records_offset = catalog_align8(sizeof(header));
+    header.path_order_offset = catalog_align8(header.records_offset + count * sizeof(openmpt_bridge_catalog_record));
+    header.title_order_offset = catalog_align8(header.path_order_offset + count * 4);
+    header.artist_order_offset = catalog_align8(header.title_order_offset + count * 4);
+    header.strings_offset = catalog_align8(header.artist_order_offset + count * 4);
+    header.strings_size = builder->strings_size;
+    size_t total = (size_t)(header.strings_offset + header.strings_size);
+
+    unsigned char* buffer = calloc(1, total);
+    if (!buffer) return 0;
+    memcpy(buffer, &header, sizeof(header));
+    if (count) memcpy(buffer + header.records_offset, builder->records, count * sizeof(openmpt_bridge_catalog_record));
+    if (builder->strings_size) memcpy(buffer + header.strings_offset, builder->strings, builder->strings_size);
+
+    int ok = catalog_write_order(builder, offsetof(openmpt_bridge_catalog_record, path), catalog_compare_exact, buffer + header.path_order_offset)
+        && catalog_write_order(builder, offsetof(openmpt_bridge_catalog_record, title), catalog_compare_folded, buffer + header.title_order_offset)
+        && catalog_write_order(builder, offsetof(openmpt_bridge_catalog_record, artist), catalog_compare_folded, buffer + header.artist_order_offset)
+        && bridge_write_file_atomic(catalog_path, buffer, total);
+    free(buffer);
+    return ok;
+}
+
+int openmpt_bridge_catalog_write_from_index(const char* database_path, const char* catalog_path) {
+    openmpt_bridge_index* index = openmpt_bridge_index_open(database_path);
+    if (!index) return 0;
+    openmpt_bridge_catalog_builder* builder = openmpt_bridge_catalog_builder_create();
+    if (!builder) {
+        openmpt_bridge_index_close(index);
+        return 0;
+    }
+
+    int ok = 1;
+    uint64_t rows = openmpt_bridge_index_get_row_count(index);
+    for (uint64_t row = 0; ok && row < rows; row++) {
+        if (openmpt_bridge_index_get_uint(index, OPENMPT_BRIDGE_INDEX_COLUMN_STATUS, row) != OPENMPT_BRIDGE_INDEX_STATUS_OK) continue;
+        openmpt_bridge_catalog_entry entry;
+        entry.path = openmpt_bridge_index_get_string(index, OPENMPT_BRIDGE_INDEX_COLUMN_PATH, row);
+        entry.title = openmpt_bridge_index_get_string(index, OPENMPT_BRIDGE_INDEX_COLUMN_TITLE, row);
+        entry.artist = openmpt_bridge_index_get_string(index, OPENMPT_BRIDGE_INDEX_COLUMN_ARTIST, row);
+        entry.type = openmpt_bridge_index_get_string(index, OPENMPT_BRIDGE_INDEX_COLUMN_TYPE, row);
+        entry.tracker = openmpt_bridge_index_get_string(index, OPENMPT_BRIDGE_INDEX_COLUMN_TRACKER, row);
+        entry.duration = openmpt_bridge_index_get_double(index, OPENMPT_BRIDGE_INDEX_COLUMN_DURATION, row);
+        entry.channels = (uint32_t)openmpt_bridge_index_get_uint(index, OPENMPT_BRIDGE_INDEX_COLUMN_CHANNELS, row);
+        entry.patterns = (uint32_t)openmpt_bridge_index_get_uint(index, OPENMPT_BRIDGE_INDEX_COLUMN_PATTERNS, row);
+        entry.instruments = (uint32_t)openmpt_bridge_index_get_uint(index, OPENMPT_BRIDGE_INDEX_COLUMN_INSTRUMENTS, row);
+        entry.samples = (uint32_t)openmpt_bridge_index_get_uint(index, OPENMPT_BRIDGE_INDEX_COLUMN_SAMPLES, row);
+        entry.file_size = openmpt_bridge_index_get_uint(index, OPENMPT_BRIDGE_INDEX_COLUMN_SIZE, row);
+        entry.content_hash = openmpt_bridge_index_get_uint(index, OPENMPT_BRIDGE_INDEX_COLUMN_CONTENT_HASH, row);
+        entry.loudness_measured = (uint32_t)openmpt_bridge_index_get_uint(index, OPENMPT_BRIDGE_INDEX_COLUMN_LOUDNESS_MEASURED, row);
+        entry.loudness = openmpt_bridge_index_get_double(index, OPENMPT_BRIDGE_INDEX_COLUMN_LOUDNESS, row);
+        entry.true_peak = openmpt_bridge_index_get_double(index, OPENMPT_BRIDGE_INDEX_COLUMN_TRUE_PEAK, row);
+        ok = openmpt_bridge_catalog_builder_add(builder, &entry);
+    }
+
+    if (ok) ok = openmpt_bridge_catalog_builder_write(builder, catalog_path);
+    openmpt_bridge_catalog_builder_destroy(builder);
+    openmpt_bridge_index_close(index);
+    return ok;
+}
+
+// MARK: - Reader
+
+struct openmpt_bridge_catalog {
+    const unsigned char* mapping;
+    size_t mapping_size;
+    uint64_t count;
+    const openmpt_bridge_catalog_record* records;
+    const uint32_t* orders[3];
+    const char* strings;
+    uint64_t strings_size;
+};
+
+static int catalog_section_valid(uint64_t offset, uint64_t size, size_t mapping_size) {
+    return (offset & 7) == 0 && offset <= mapping_size && size <= mapping_size - offset;
+}
+
+openmpt_bridge_catalog* openmpt_bridge_catalog_open(const char* catalog_path) {
+    const void* data = NULL;
+    size_t size = 0;
+    if (!bridge_map_file(catalog_path, &data, &size)) return NULL;
+
+    openmpt_bridge_catalog* catalog = calloc(1, sizeof(*catalog));
+    if (!catalog) {
+        bridge_unmap_file(data, size);
+        return NULL;
+    }
+    catalog->mapping = (const unsigned char*)data;
+    catalog->mapping_size = size;
+
+    // The mapping is page aligned and every section is 8-byte aligned, so
+    // records and order tables are addressed in place
+    const openmpt_bridge_catalog_header* header = (const openmpt_bridge_catalog_header*)data;
+    if (size < sizeof(*header)) goto invalid;
+    if (memcmp(header->magic, openmpt_bridge_catalog_magic, sizeof(header->magic)) != 0) goto invalid;
+    if (header->version != OPENMPT_BRIDGE_CATALOG_VERSION) goto invalid;
+    if (header->record_size != sizeof(openmpt_bridge_catalog_record)) goto invalid;
+    if (header->record_count > UINT32_MAX) goto invalid;
+
+    uint64_t count = header->record_count;
+    if (!catalog_section_valid(header->records_offset, count * sizeof(openmpt_bridge_catalog_record), size)) goto invalid;
+    if (!catalog_section_valid(header->path_order_offset, count * 4, size)) goto invalid;
+    if (!catalog_section_valid(header->title_order_offset, count * 4, size)) goto invalid;
+    if (!catalog_section_valid(header->artist_order_offset, count * 4, size)) goto invalid;
+    if (header->strings_offset > size || header->strings_size > size - header->strings_offset) goto invalid;
+
+    catalog->count = count;
+    catalog->records = (const openmpt_bridge_catalog_record*)(catalog->mapping + header->records_offset);
+    catalog->orders[OPENMPT_BRIDGE_CATALOG_ORDER_PATH] = (const uint32_t*)(catalog->mapping + header->path_order_offset);
+    catalog->orders[OPENMPT_BRIDGE_CATALOG_ORDER_TITLE] = (const uint32_t*)(catalog->mapping + header->title_order_offset);
+    catalog->orders[OPENMPT_BRIDGE_CATALOG_ORDER_ARTIST] = (const uint32_t*)(catalog->mapping + header->artist_order_offset);
+    catalog->strings = (const char*)(catalog->mapping + header->strings_offset);
+    catalog->strings_size = header->strings_size;
+
+    if (catalog->strings_size && catalog->strings[catalog->strings_size - 1] != '\0') goto invalid;
+    return catalog;
+
+invalid:
+    openmpt_bridge_catalog_close(catalog);
+    return NULL;
+}
+
+void openmpt_bridge_catalog_close(openmpt_bridge_catalog* catalog) {
+    if (!catalog) return;
+    bridge_unmap_file(catalog->mapping, catalog->mapping_size);
+    free(catalog);
+}
+
+uint64_t openmpt_bridge_catalog_get_count(const openmpt_bridge_catalog* catalog) {
+    return catalog ? catalog->count : 0;
+}
+
+const openmpt_bridge_catalog_record* openmpt_bridge_catalog_get_record(const openmpt_bridge_catalog* catalog, uint64_t index) {
+    if (!catalog || index >= catalog->count) return NULL;
+    return &catalog->records[index];
+}
+
+const char* openmpt_bridge_catalog_get_string(const openmpt_bridge_catalog* catalog, uint32_t offset) {
+    // Offsets are checked per access rather than per record at open time
+    if (!catalog || offset >= catalog->strings_size) return "";
+    return catalog->strings + offset;
+}
+
+uint32_t openmpt_bridge_catalog_get_ordered(const openmpt_bridge_catalog* catalog, int32_t order, uint64_t position) {
+    if (!catalog || order < 0 || order > OPENMPT_BRIDGE_CATALOG_ORDER_ARTIST || position >= catalog->count) return UINT32_MAX;
+    uint32_t index = catalog->orders[order][position];
+    return index < catalog->count ? index : UINT32_MAX;
+}
+
+int64_t openmpt_bridge_catalog_find_path(const openmpt_bridge_catalog* catalog, const char* path) {
+    if (!catalog || !path) return -1;
+    const uint32_t* order = catalog->orders[OPENMPT_BRIDGE_CATALOG_ORDER_PATH];
+    uint64_t low = 0;
+    uint64_t high = catalog->count;
+    while (low < high) {
+        uint64_t mid = low + (high - low) / 2;
+        uint32_t index = order[mid];
+        if (index >= catalog->count) return -1;
+        int result = strcmp(openmpt_bridge_catalog_get_string(catalog, catalog->records[index].path), path);
+        if (result == 0) return index;
+        if (result < 0) low = mid + 1;
+        else high = mid;
+    }
+    return -1;
+}
@@ -0,0 +1,234 @@
+// openmpt_bridge_commands.c
+// Lock-free delivery of render param and ctl changes to the render thread
+
+#include "openmpt_bridge_commands.h"
+#include "bridge_internal.h"
+#include "bridge_module_internal.h"
+
+#include <math.h>
+#include <string.h>
+
+// Frames rendered between smoothing steps while a ramp is active
+#define BRIDGE_SMOOTHING_CHUNK 64
+
+// MARK: - Queue
+
+void bridge_commands_init(bridge_commands* commands) {
+    atomic_init(&commands->enqueue_pos, 0);
+    atomic_init(&commands->dequeue_pos, 0);
+    for (size_t i = 0; i < OPENMPT_BRIDGE_COMMAND_CAPACITY; i++) atomic_init(&commands->slots[i].sequence, i);
+    atomic_init(&commands->dropped, 0);
+    atomic_init(&commands->realtime, 0);
+    atomic_init(&commands->smoothing_us, 0);
+    commands->gain.param = OPENMPT_MODULE_RENDER_MASTERGAIN_MILLIBEL;
+    commands->separation.param = OPENMPT_MODULE_RENDER_STEREOSEPARATION_PERCENT;
+}
+
+// Any thread. Each slot's sequence says whether it is free for position pos
+// (== pos) or still holds an unconsumed command from the previous lap (< pos).
+static int bridge_commands_push(bridge_commands* commands, const bridge_command* command) {
+    size_t pos = atomic_load_explicit(&commands->enqueue_pos, memory_order_relaxed);
+    bridge_command_slot* slot;
+    for (;;) {
+        slot = &commands->slots[pos & (OPENMPT_BRIDGE_COMMAND_CAPACITY - 1)];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&commands->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&commands->dropped, 1, memory_order_relaxed);
+            return 0;
+        } else {
+            pos = atomic_load_explicit(&commands->enqueue_pos, memory_order_relaxed);
+        }
+    }
+    slot->command = *command;
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+    return 1;
+}
+
+// Single consumer: the render thread, or the owner of the handle when no
+// render thread is running
+static int bridge_commands_pop(bridge_commands* commands, bridge_command* command) {
+    size_t pos = atomic_load_explicit(&commands->dequeue_pos, memory_order_relaxed);
+    bridge_command_slot* slot = &commands->slots[pos & (OPENMPT_BRIDGE_COMMAND_CAPACITY - 1)];
+    if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != pos + 1) return 0;
+    *command = slot->command;
+    atomic_store_explicit(&commands->dequeue_pos, pos + 1, memory_order_relaxed);
+    atomic_store_explicit(&slot->sequence, pos + OPENMPT_BRIDGE_COMMAND_CAPACITY, memory_order_release);
+    return 1;
+}
+
+int bridge_commands_submit(openmpt_bridge_module* handle, const bridge_command* command) {
+    return bridge_commands_push(&handle->commands, command);
+}
+
+// MARK: - Applying
+
+static bridge_smoothed_param* bridge_commands_smoothed(bridge_commands* commands, int param) {
+    if (param == OPENMPT_MODULE_RENDER_MASTERGAIN_MILLIBEL) return &commands->gain;
+    if (param == OPENMPT_MODULE_RENDER_STEREOSEPARATION_PERCENT) return &commands->separation;
+    return NULL;
+}
+
+static int bridge_commands_apply_param(openmpt_bridge_module* handle, int param, int32_t value, int32_t samplerate) {
+    bridge_commands* commands = &handle->commands;
+    bridge_smoothed_param* smoothed = bridge_commands_smoothed(commands, param);
+    if (smoothed && samplerate > 0) {
+        uint64_t smoothing_us = atomic_load_explicit(&commands->smoothing_us, memory_order_relaxed);
+        double frames = (double)smoothing_us * (double)samplerate * 1e-6;
+        if (frames >= 1.0 && (double)value != smoothed->current) {
+            smoothed->target = value;
+            smoothed->step = ((double)value - smoothed->current) / frames;
+            smoothed->active = 1;
+            return 1;
+        }
+    }
+    if (smoothed) {
+        smoothed->current = value;
+        smoothed->active = 0;
+    }
+    return bridge_quality_set_render_param(handle, param, value);
+}
+
+static void bridge_commands_apply(openmpt_bridge_module* handle, const bridge_command* command, int32_t samplerate) {
+    switch (command->kind) {
+    case BRIDGE_COMMAND_RENDER_PARAM:
+        bridge_commands_apply_param(handle, command->param, command->value, samplerate);
+        break;
+    case BRIDGE_COMMAND_CTL:
+        openmpt_module_ctl_set(handle->mod, command->ctl, command->text);
+        break;
+    case BRIDGE_COMMAND_SEEK_SECONDS:
+        openmpt_module_set_position_seconds(handle->mod, command->seconds);
+        break;
+    case BRIDGE_COMMAND_SEEK_ORDER_ROW:
+        openmpt_module_set_position_order_row(handle->mod, command->param, command->value);
+        break;
+    case BRIDGE_COMMAND_SELECT_SUBSONG:
+        openmpt_module_select_subsong(handle->mod, command->value);
+        break;
+    case BRIDGE_COMMAND_REPEAT_COUNT:
+        openmpt_module_set_repeat_count(handle->mod, command->value);
+        break;
+    case BRIDGE_COMMAND_PLAY_NOTE:
+    case BRIDGE_COMMAND_STOP_NOTE:
+    case BRIDGE_COMMAND_NOTE_OFF:
+    case BRIDGE_COMMAND_CHANNEL_MUTE:
+    case BRIDGE_COMMAND_CHANNEL_SOLO:
+    case BRIDGE_COMMAND_CHANNEL_VOLUME:
+    case BRIDGE_COMMAND_CHANNEL_PANNING:
+    case BRIDGE_COMMAND_TEMPO_FACTOR:
+    case BRIDGE_COMMAND_PITCH_FACTOR:
+        bridge_interactive_apply(handle, command);
+        break;
+    }
+}
+
+void bridge_commands_drain(openmpt_bridge_module* handle, int32_t samplerate) {
+    bridge_command command;
+    while (bridge_commands_pop(&handle->commands, &command)) {
+        if (handle->mod) bridge_commands_apply(handle, &command, samplerate);
+    }
+}
+
+static void bridge_commands_finish_ramp(openmpt_bridge_module* handle, bridge_smoothed_param* smoothed) {
+    if (!smoothed->active) return;
+    smoothed->current = smoothed->target;
+    smoothed->active = 0;
+    if (handle->mod) openmpt_module_set_render_param(handle->mod, smoothed->param, smoothed->target);
+}
+
+static void bridge_commands_step(openmpt_bridge_module* handle, bridge_smoothed_param* smoothed, size_t frames) {
+    if (!smoothed->active) return;
+    smoothed->current += smoothed->step * (double)frames;
+    if ((smoothed->step > 0.0 && smoothed->current >= smoothed->target) ||
+        (smoothed->step < 0.0 && smoothed->current <= smoothed->target) || smoothed->step == 0.0) {
+        bridge_commands_finish_ramp(handle, smoothed);
+        return;
+    }
+    openmpt_module_set_render_param(handle->mod, smoothed->param, (int32_t)lround(smoothed->current));
+}
+
+size_t bridge_commands_smooth(openmpt_bridge_module* handle, size_t count) {
+    bridge_commands* commands = &handle->commands;
+    if (!commands->gain.active && !commands->separation.active) return count;
+    size_t frames = count < BRIDGE_SMOOTHING_CHUNK ? count : BRIDGE_SMOOTHING_CHUNK;
+    bridge_commands_step(handle, &commands->gain, frames);
+    bridge_commands_step(handle, &commands->separation, frames);
+    return frames;
+}
+
+void bridge_commands_reset(openmpt_bridge_module* handle) {
+    bridge_commands* commands = &handle->commands;
+    bridge_command discarded;
+    while (bridge_commands_pop(commands, &discarded)) {}
+
+    int32_t gain = 0;
+    int32_t separation = 100;
+    if (handle->mod) {
+        openmpt_module_get_render_param(handle->mod, OPENMPT_MODULE_RENDER_MASTERGAIN_MILLIBEL, &gain);
+        openmpt_module_get_render_param(handle->mod, OPENMPT_MODULE_RENDER_STEREOSEPARATION_PERCENT, &separation);
+    }
+    commands->gain.current = gain;
+    commands->gain.active = 0;
+    commands->separation.current = separation;
+    commands->separation.active = 0;
+}
+
+// MARK: - Public API
+
+void openmpt_bridge_module_set_realtime(openmpt_bridge_module* handle, int realtime) {
+    if (!handle) return;
+    atomic_store_explicit(&handle->commands.realtime, realtime ? 1 : 0, memory_order_release);
+    if (realtime) return;
+    // The render thread has stopped, so this thread may consume the queue
+    bridge_commands_drain(handle, 0);
+    bridge_commands_finish_ramp(handle, &handle->commands.gain);
+    bridge_commands_finish_ramp(handle, &handle->commands.separation);
+    if (handle->mod) bridge_position_publish(handle);
+}
+
+int openmpt_bridge_module_is_realtime(const openmpt_bridge_module* handle) {
+    if (!handle) return 0;
+    return bridge_atomic_load_int(&handle->commands.realtime, memory_order_acquire);
+}
+
+int openmpt_bridge_module_set_render_param(openmpt_bridge_module* handle, int param, int32_t value) {
+    if (!handle || !handle->mod) return 0;
+    if (param < OPENMPT_MODULE_RENDER_MASTERGAIN_MILLIBEL || param > OPENMPT_MODULE_RENDER_VOLUMERAMPING_STRENGTH) return 0;
+    if (!openmpt_bridge_module_is_realtime(handle)) return bridge_commands_apply_param(handle, param, value, 0);
+
+    bridge_command command = { .kind = BRIDGE_COMMAND_RENDER_PARAM, .param = param, .value = value };
+    return bridge_commands_submit(handle, &command);
+}
+
+int openmpt_bridge_module_ctl_set(openmpt_bridge_module* handle, const char* ctl, const char* value) {
+    if (!handle || !handle->mod || !ctl || !value) return 0;
+    if (!openmpt_bridge_module_is_realtime(handle)) return openmpt_module_ctl_set(handle->mod, ctl, value);
+
+    size_t ctl_length = strlen(ctl);
+    size_t value_length = strlen(value);
+    if (ctl_length >= OPENMPT_BRIDGE_COMMAND_CTL_LENGTH || value_length >= OPENMPT_BRIDGE_COMMAND_VALUE_LENGTH) return 0;
+    bridge_command command = { .kind = BRIDGE_COMMAND_CTL };
+    memcpy(command.ctl, ctl, ctl_length + 1);
+    memcpy(command.text, value, value_length + 1);
+    return bridge_commands_submit(handle, &command);
+}
+
+void openmpt_bridge_module_set_smoothing(openmpt_bridge_module* handle, double seconds) {
+    if (!handle) return;
+    if (seconds < 0.0) seconds = 0.0;
+    atomic_store_explicit(&handle->commands.smoothing_us, (uint_fast64_t)(seconds * 1e6), memory_order_relaxed);
+}
+
+double openmpt_bridge_module_get_smoothing(const openmpt_bridge_module* handle) {
+    if (!handle) return 0.0;
+    return (double)bridge_atomic_load_u64(&handle->commands.smoothing_us, memory_order_relaxed) * 1e-6;
+}
+
+uint64_t openmpt_bridge_module_get_dropped_commands(const openmpt_bridge_module* handle) {
+    if (!handle) return 0;
+    return bridge_atomic_load_u64(&handle->commands.dropped, memory_order_relaxed);
+}
@@ -0,0 +1,104 @@
+// openmpt_bridge_deadline.c
+// Per-block deadline measurement, utilization histogram and overrun queue
+
+#include "openmpt_bridge_deadline.h"
+#include "bridge_internal.h"
+#include "bridge_module_internal.h"
+
+void bridge_deadline_init(bridge_deadline* deadline) {
+    for (size_t i = 0; i < OPENMPT_BRIDGE_DEADLINE_BUCKETS; i++) atomic_init(&deadline->buckets[i], 0);
+    atomic_init(&deadline->blocks, 0);
+    atomic_init(&deadline->overruns, 0);
+    atomic_init(&deadline->missed, 0);
+    atomic_init(&deadline->dropped, 0);
+    atomic_init(&deadline->peak_ppm, 0);
+    atomic_init(&deadline->budget_ppm, (uint_fast64_t)(OPENMPT_BRIDGE_DEADLINE_DEFAULT_BUDGET * 1e6));
+    atomic_init(&deadline->head, 0);
+    atomic_init(&deadline->tail, 0);
+}
+
+// Render thread only: no locks, no allocation
+uint64_t bridge_deadline_record(bridge_deadline* deadline, size_t frames, int32_t sample_rate,
+                                uint64_t end_ns, uint64_t elapsed_ns, uint64_t block_index) {
+    if (frames == 0 || sample_rate <= 0) return 0;
+    uint64_t deadline_ns = (uint64_t)frames * 1000000000ull / (uint64_t)sample_rate;
+    if (deadline_ns == 0) return 0;
+
+    uint64_t ppm = elapsed_ns * 1000000ull / deadline_ns;
+    size_t bucket = (size_t)(ppm / (uint64_t)(OPENMPT_BRIDGE_DEADLINE_BUCKET_WIDTH * 1e6));
+    if (bucket >= OPENMPT_BRIDGE_DEADLINE_BUCKETS) bucket = OPENMPT_BRIDGE_DEADLINE_BUCKETS - 1;
+    atomic_fetch_add_explicit(&deadline->buckets[bucket], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&deadline->blocks, 1, memory_order_relaxed);
+    if (ppm > atomic_load_explicit(&deadline->peak_ppm, memory_order_relaxed)) {
+        atomic_store_explicit(&deadline->peak_ppm, ppm, memory_order_relaxed);
+    }
+    if (elapsed_ns > deadline_ns) atomic_fetch_add_explicit(&deadline->missed, 1, memory_order_relaxed);
+
+    if (ppm <= atomic_load_explicit(&deadline->budget_ppm, memory_order_relaxed)) return ppm;
+    atomic_fetch_add_explicit(&deadline->overruns, 1, memory_order_relaxed);
+
+    size_t head = atomic_load_explicit(&deadline->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&deadline->tail, memory_order_acquire);
+    if (head - tail >= BRIDGE_DEADLINE_QUEUE) {
+        atomic_fetch_add_explicit(&deadline->dropped, 1, memory_order_relaxed);
+        return ppm;
+    }
+    openmpt_bridge_overrun_event* event = &deadline->events[head & (BRIDGE_DEADLINE_QUEUE - 1)];
+    event->timestamp_ns = end_ns;
+    event->elapsed_ns = elapsed_ns;
+    event->deadline_ns = deadline_ns;
+    event->block_index = block_index;
+    event->frames = (uint32_t)frames;
+    event->sample_rate = sample_rate;
+    atomic_store_explicit(&deadline->head, head + 1, memory_order_release);
+    return ppm;
+}
+
+void openmpt_bridge_deadline_set_budget(openmpt_bridge_module* handle, double budget) {
+    if (!handle) return;
+    if (budget <= 0.0) budget = OPENMPT_BRIDGE_DEADLINE_DEFAULT_BUDGET;
+    atomic_store_explicit(&handle->deadline.budget_ppm, (uint_fast64_t)(budget * 1e6), memory_order_relaxed);
+}
+
+double openmpt_bridge_deadline_get_budget(const openmpt_bridge_module* handle) {
+    if (!handle) return 0.0;
+    return (double)bridge_atomic_load_u64(&handle->deadline.budget_ppm, memory_order_relaxed) * 1e-6;
+}
+
+int openmpt_bridge_deadline_get_histogram(const openmpt_bridge_module* handle, openmpt_bridge_deadline_histogram* histogram) {
+    if (!handle || !histogram) return 0;
+    const bridge_deadline* deadline = &handle->deadline;
+    for (size_t i = 0; i < OPENMPT_BRIDGE_DEADLINE_BUCKETS; i++) {
+        histogram->buckets[i] = bridge_atomic_load_u64(&deadline->buckets[i], memory_order_relaxed);
+    }
+    histogram->blocks = bridge_atomic_load_u64(&deadline->blocks, memory_order_relaxed);
+    histogram->overruns = bridge_atomic_load_u64(&deadline->overruns, memory_order_relaxed);
+    histogram->missed = bridge_atomic_load_u64(&deadline->missed, memory_order_relaxed);
+    histogram->dropped_events = bridge_atomic_load_u64(&deadline->dropped, memory_order_relaxed);
+    histogram->peak_utilization = (double)bridge_atomic_load_u64(&deadline->peak_ppm, memory_order_relaxed) * 1e-6;
+    return 1;
+}
+
+int openmpt_bridge_deadline_pop_event(openmpt_bridge_module* handle, openmpt_bridge_overrun_event* event) {
+    if (!handle || !event) return 0;
+    bridge_deadline* deadline = &handle->deadline;
+    size_t tail = atomic_load_explicit(&deadline->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&deadline->head, memory_order_acquire);
+    if (tail == head) return 0;
+    *event = deadline->events[tail & (BRIDGE_DEADLINE_QUEUE - 1)];
+    atomic_store_explicit(&deadline->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+void openmpt_bridge_deadline_reset(openmpt_bridge_module* handle) {
+    if (!handle) return;
+    bridge_deadline* deadline = &handle->deadline;
+    for (size_t i = 0; i < OPENMPT_BRIDGE_DEADLINE_BUCKETS; i++) {
+        atomic_store_explicit(&deadline->buckets[i], 0, memory_order_relaxed);
+    }
+    atomic_store_explicit(&deadline->blocks, 0, memory_order_relaxed);
+    atomic_store_explicit(&deadline->overruns, 0, memory_order_relaxed);
+    atomic_store_explicit(&deadline->missed, 0, memory_order_relaxed);
+    atomic_store_explicit(&deadline->dropped, 0, memory_order_relaxed);
+    atomic_store_explicit(&deadline->peak_ppm, 0, memory_order_relaxed);
+}
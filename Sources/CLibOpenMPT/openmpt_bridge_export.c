@@ -0,0 +1,509 @@
+// openmpt_bridge_export.c
+// Block renderer feeding the double-buffered PCM writer, and the segmented
+// parallel exporter
+
+#include "openmpt_bridge_export.h"
+#include "bridge_internal.h"
+#include "bridge_pcm.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BRIDGE_EXPORT_DEFAULT_RATE 48000
+#define BRIDGE_EXPORT_DEFAULT_BLOCK 32768
+#define BRIDGE_EXPORT_DEFAULT_OVERLAP 256
+#define BRIDGE_EXPORT_DEFAULT_PREROLL 2.0
+#define BRIDGE_EXPORT_DEFAULT_MIN_SEGMENT 10.0
+#define BRIDGE_EXPORT_DEFAULT_SILENCE_DB -90.0
+
+void openmpt_bridge_export_options_init(openmpt_bridge_export_options* options) {
+    if (!options) return;
+    memset(options, 0, sizeof(*options));
+    options->sample_rate = BRIDGE_EXPORT_DEFAULT_RATE;
+    options->format = OPENMPT_BRIDGE_SAMPLE_FORMAT_S16;
+    options->container = OPENMPT_BRIDGE_CONTAINER_WAV;
+    options->block_frames = BRIDGE_EXPORT_DEFAULT_BLOCK;
+}
+
+// Linear peak at or below which audio counts as silence
+static float bridge_export_silence_threshold(const openmpt_bridge_export_options* settings) {
+    double db = settings->silence_threshold_db < 0.0 ? settings->silence_threshold_db : BRIDGE_EXPORT_DEFAULT_SILENCE_DB;
+    return (float)pow(10.0, db / 20.0);
+}
+
+// Frames of continuous silence after which a render ends early
+static uint64_t bridge_export_silence_limit(const openmpt_bridge_export_options* settings) {
+    if (settings->max_silence_seconds <= 0.0) return UINT64_MAX;
+    return (uint64_t)(settings->max_silence_seconds * settings->sample_rate);
+}
+
+int openmpt_bridge_export_module(openmpt_module* mod, const char* output_path, const openmpt_bridge_export_options* options, openmpt_bridge_export_result* result) {
+    if (!mod || !output_path) return 0;
+
+    openmpt_bridge_export_options settings;
+    openmpt_bridge_export_options_init(&settings);
+    if (options) settings = *options;
+    if (settings.sample_rate <= 0) settings.sample_rate = BRIDGE_EXPORT_DEFAULT_RATE;
+    if (settings.block_frames <= 0) settings.block_frames = BRIDGE_EXPORT_DEFAULT_BLOCK;
+
+    uint64_t frame_limit = UINT64_MAX;
+    if (settings.max_seconds > 0.0) frame_limit = (uint64_t)(settings.max_seconds * settings.sample_rate);
+
+    bridge_writer* writer = bridge_writer_open(output_path, settings.container, settings.format,
+                                               settings.sample_rate, 2, (size_t)settings.block_frames);
+    if (!writer) return 0;
+
+    // Render the song once from the top; restore looping afterwards
+    int32_t repeat_count = openmpt_module_get_repeat_count(mod);
+    openmpt_module_set_repeat_count(mod, 0);
+    const char* at_end = NULL;
+    if (settings.trim_silence) {
+        at_end = openmpt_module_ctl_get(mod, "play.at_end");
+        openmpt_module_ctl_set(mod, "play.at_end", "stop");
+    }
+    openmpt_module_set_position_seconds(mod, 0.0);
+
+    const float threshold = bridge_export_silence_threshold(&settings);
+    const uint64_t silence_limit = bridge_export_silence_limit(&settings);
+    uint64_t start = bridge_now_ns();
+    uint64_t render_ns = 0;
+    uint64_t frames = 0;
+    uint64_t audible = 0; // frames up to the last one above the threshold
+    int ok = 1;
+
+    while (ok && frames < frame_limit) {
+        size_t wanted = (size_t)settings.block_frames;
+        if (frame_limit - frames < wanted) wanted = (size_t)(frame_limit - frames);
+
+        float* block = bridge_writer_acquire(writer);
+        uint64_t render_start = bridge_now_ns();
+        size_t rendered = openmpt_module_read_interleaved_float_stereo(mod, settings.sample_rate, wanted, block);
+        render_ns += bridge_now_ns() - render_start;
+
+        // The writer owns the block once it is submitted
+        size_t loud = bridge_audible_frames(block, rendered, 2, threshold);
+        if (loud) audible = frames + loud;
+        ok = bridge_writer_submit(writer, rendered);
+        frames += rendered;
+        if (rendered < wanted) break; // end of song
+        if (frames - audible >= silence_limit) break;
+    }
+
+    double wait_seconds = bridge_writer_wait_seconds(writer);
+    uint64_t kept = settings.trim_silence ? audible : frames;
+    ok = bridge_writer_close_trimmed(writer, kept) && ok;
+    openmpt_module_set_repeat_count(mod, repeat_count);
+    if (at_end) {
+        openmpt_module_ctl_set(mod, "play.at_end", at_end);
+        openmpt_free_string(at_end);
+    }
+
+    if (result) {
+        memset(result, 0, sizeof(*result));
+        result->frames = kept;
+        result->trimmed_frames = frames - kept;
+        result->audio_seconds = (double)kept / settings.sample_rate;
+        result->wall_seconds = (double)(bridge_now_ns() - start) * 1e-9;
+        result->render_seconds = (double)render_ns * 1e-9;
+        result->write_wait_seconds = wait_seconds;
+        result->realtime_factor = result->wall_seconds > 0.0 ? result->audio_seconds / result->wall_seconds : 0.0;
+    }
+    return ok;
+}
+
+int openmpt_bridge_export_file(const char* module_path, const char* output_path, const openmpt_bridge_export_options* options, openmpt_bridge_export_result* result) {
+    void* data = NULL;
+    size_t size = 0;
+    if (!bridge_read_file(module_path, &data, &size)) return 0;
+
+    int error = 0;
+    openmpt_module* mod = openmpt_module_create_from_memory2(data, size, (void*)openmpt_log_func_silent, NULL,
+                                                             NULL, NULL, &error, NULL, NULL);
+    free(data);
+    if (!mod) return 0;
+
+    int ok = openmpt_bridge_export_module(mod, output_path, options, result);
+    openmpt_module_destroy(mod);
+    return ok;
+}
+
+// MARK: - Parallel export
+
+// Seeking with sample sync restores sample positions as well as global
+// state, so pre-roll only has to settle ramping, filters and effects
+static const openmpt_module_initial_ctl export_load_ctls[] = {
+    { "seek.sync_samples", "1" },
+    { NULL, NULL }
+};
+
+typedef struct bridge_checkpoint {
+    int32_t order;
+    double seconds;
+} bridge_checkpoint;
+
+typedef struct bridge_segment {
+    int32_t preroll_order;      // -1 = render from the start of the subsong
+    uint64_t preroll_frames;    // frames rendered and discarded before start
+    uint64_t start;             // first output frame
+    uint64_t end;               // next segment's start, or the frame limit
+    float* head;                // overlap rendered from start (not for segment 0)
+    float* tail;                // overlap rendered past end (not for the last segment)
+    size_t head_frames;
+    size_t tail_frames;
+    uint64_t frames;            // frames rendered from start, excluding the tail
+    uint64_t audible;           // one past the last audible frame before end, 0 if none
+    uint64_t render_ns;
+    int ok;
+} bridge_segment;
+
+typedef struct bridge_parallel_export {
+    const void* data;
+    size_t size;
+    openmpt_bridge_export_options settings;
+    int32_t subsong;
+    size_t overlap;
+    float silence_threshold;
+    uint64_t silence_limit;
+    int fd;
+    size_t header_size;
+    size_t frame_bytes;
+    bridge_segment* segments;
+    size_t segment_count;
+} bridge_parallel_export;
+
+void openmpt_bridge_parallel_export_options_init(openmpt_bridge_parallel_export_options* parallel) {
+    if (!parallel) return;
+    memset(parallel, 0, sizeof(*parallel));
+    parallel->overlap_frames = BRIDGE_EXPORT_DEFAULT_OVERLAP;
+    parallel->subsong = -1;
+    parallel->preroll_seconds = BRIDGE_EXPORT_DEFAULT_PREROLL;
+    parallel->min_segment_seconds = BRIDGE_EXPORT_DEFAULT_MIN_SEGMENT;
+}
+
+static openmpt_module* bridge_export_instance(const void* data, size_t size, int32_t subsong) {
+    int error = 0;
+    openmpt_module* mod = openmpt_module_create_from_memory2(data, size, (void*)openmpt_log_func_silent, NULL,
+                                                             NULL, NULL, &error, NULL, export_load_ctls);
+    if (!mod) return NULL;
+    if (subsong >= 0 && !openmpt_module_select_subsong(mod, subsong)) {
+        openmpt_module_destroy(mod);
+        return NULL;
+    }
+    openmpt_module_set_repeat_count(mod, 0);
+    return mod;
+}
+
+static int bridge_checkpoint_compare(const void* a, const void* b) {
+    double lhs = ((const bridge_checkpoint*)a)->seconds;
+    double rhs = ((const bridge_checkpoint*)b)->seconds;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+// Start time of every order that is played, sorted by time
+static bridge_checkpoint* bridge_export_checkpoints(openmpt_module* mod, size_t* count) {
+    int32_t orders = openmpt_module_get_num_orders(mod);
+    *count = 0;
+    if (orders <= 0) return NULL;
+
+    bridge_checkpoint* checkpoints = malloc((size_t)orders * sizeof(*checkpoints));
+    if (!checkpoints) return NULL;
+    for (int32_t order = 0; order < orders; order++) {
+        double seconds = openmpt_module_get_time_at_position(mod, order, 0);
+        if (seconds < 0.0) continue;
+        checkpoints[*count].order = order;
+        checkpoints[*count].seconds = seconds;
+        (*count)++;
+    }
+    qsort(checkpoints, *count, sizeof(*checkpoints), bridge_checkpoint_compare);
+    return checkpoints;
+}
+
+// Pick segment starts near even divisions of the song, each at an order
+// boundary, and the boundary each segment pre-rolls from
+static size_t bridge_export_plan(bridge_parallel_export* job, const bridge_checkpoint* checkpoints,
+                                 size_t checkpoint_count, size_t wanted, double song_seconds,
+                                 double preroll_seconds, uint64_t frame_limit) {
+    const double rate = job->settings.sample_rate;
+    bridge_segment* segments = job->segments;
+    size_t count = 1;
+    segments[0].preroll_order = -1;
+    double previous = 0.0;
+
+    for (size_t k = 1; k < wanted; k++) {
+        double target = song_seconds * (double)k / (double)wanted;
+        const bridge_checkpoint* best = NULL;
+        for (size_t i = 0; i < checkpoint_count; i++) {
+            const bridge_checkpoint* candidate = &checkpoints[i];
+            if (candidate->seconds <= previous) continue;
+            uint64_t start = (uint64_t)llround(candidate->seconds * rate);
+            if (start - segments[count - 1].start <= 2 * job->overlap) continue;
+            if (start + job->overlap >= frame_limit) continue;
+            if (!best || fabs(candidate->seconds - target) < fabs(best->seconds - target)) best = candidate;
+        }
+        if (!best) break;
+
+        bridge_segment* segment = &segments[count++];
+        segment->start = (uint64_t)llround(best->seconds * rate);
+        segment->preroll_order = -1;
+        segment->preroll_frames = segment->start;
+        for (const bridge_checkpoint* cp = checkpoints; cp <= best; cp++) {
+            if (cp->seconds > best->seconds - preroll_seconds) break;
+            if (cp->seconds <= 0.0) continue;
+            // Latest boundary at least preroll_seconds before the start
+            segment->preroll_order = cp->order;
+            segment->preroll_frames = segment->start - (uint64_t)llround(cp->seconds * rate);
+        }
+        previous = best->seconds;
+    }
+
+    for (size_t k = 0; k < count; k++) {
+        segments[k].end = k + 1 < count ? segments[k + 1].start : frame_limit;
+    }
+    return count;
+}
+
+static void bridge_export_segment(void* ctx, size_t index, int worker) {
+    (void)worker;
+    bridge_parallel_export* job = (bridge_parallel_export*)ctx;
+    bridge_segment* segment = &job->segments[index];
+    const size_t block_frames = (size_t)job->settings.block_frames;
+    const int32_t rate = job->settings.sample_rate;
+
+    openmpt_module* mod = bridge_export_instance(job->data, job->size, job->subsong);
+    float* block = malloc(block_frames * 2 * sizeof(float));
+    void* converted = malloc(block_frames * job->frame_bytes);
+    if (!mod || !block || !converted) goto done;
+    if (job->settings.trim_silence) openmpt_module_ctl_set(mod, "play.at_end", "stop");
+
+    uint64_t render_start = bridge_now_ns();
+    if (segment->preroll_order >= 0) openmpt_module_set_position_order_row(mod, segment->preroll_order, 0);
+    for (uint64_t remaining = segment->preroll_frames; remaining; ) {
+        size_t wanted = remaining < block_frames ? (size_t)remaining : block_frames;
+        size_t rendered = openmpt_module_read_interleaved_float_stereo(mod, rate, wanted, block);
+        if (rendered < wanted) goto done;
+        remaining -= rendered;
+    }
+
+    const uint64_t body = segment->start + (segment->head ? job->overlap : 0);
+    const uint64_t stop = segment->tail ? segment->end + job->overlap : segment->end;
+    uint64_t position = segment->start;
+    int write_ok = 1;
+
+    while (write_ok && position < stop) {
+        size_t wanted = stop - position < block_frames ? (size_t)(stop - position) : block_frames;
+        size_t rendered = openmpt_module_read_interleaved_float_stereo(mod, rate, wanted, block);
+
+        // Route each part of the block: head overlap, body, tail overlap
+        for (size_t i = 0; i < rendered; ) {
+            uint64_t frame = position + i;
+            size_t run;
+            if (frame < body) {
+                run = (size_t)(body - frame) < rendered - i ? (size_t)(body - frame) : rendered - i;
+                memcpy(segment->head + (frame - segment->start) * 2, block + i * 2, run * 2 * sizeof(float));
+                segment->head_frames += run;
+            } else if (frame < segment->end) {
+                run = (size_t)(segment->end - frame) < rendered - i ? (size_t)(segment->end - frame) : rendered - i;
+                bridge_convert_samples(block + i * 2, converted, run * 2, job->settings.format);
+                write_ok = bridge_pwrite_all(job->fd, converted, run * job->frame_bytes,
+                                             job->header_size + frame * job->frame_bytes);
+            } else {
+                run = rendered - i;
+                memcpy(segment->tail + (frame - segment->end) * 2, block + i * 2, run * 2 * sizeof(float));
+                segment->tail_frames += run;
+            }
+            // The tail is the next segment's head and is counted there
+            if (frame < segment->end) {
+                size_t loud = bridge_audible_frames(block + i * 2, run, 2, job->silence_threshold);
+                if (loud) segment->audible = frame + loud;
+            }
+            i += run;
+        }
+        position += rendered;
+        if (rendered < wanted) break; // end of song
+        // Only the last segment decides where the song ends
+        uint64_t quiet_from = segment->audible > segment->start ? segment->audible : segment->start;
+        if (!segment->tail && position - quiet_from >= job->silence_limit) break;
+    }
+    segment->render_ns = bridge_now_ns() - render_start;
+    segment->frames = (position < segment->end ? position : segment->end) - segment->start;
+
+    // Only the final segment may end before its planned end
+    segment->ok = write_ok && (!segment->tail || position == stop);
+
+done:
+    free(converted);
+    free(block);
+    if (mod) openmpt_module_destroy(mod);
+}
+
+// Write the overlap between two segments. Identical overlaps are copied;
+// otherwise the previous segment fades out while the next fades in.
+static int bridge_export_seam(bridge_parallel_export* job, const bridge_segment* previous,
+                              const bridge_segment* next, float* mixed, void* converted,
+                              openmpt_bridge_parallel_export_result* result) {
+    size_t frames = next->head_frames < previous->tail_frames ? next->head_frames : previous->tail_frames;
+    size_t samples = frames * 2;
+    float error = 0.0f;
+    for (size_t i = 0; i < samples; i++) {
+        float difference = fabsf(previous->tail[i] - next->head[i]);
+        if (difference > error) error = difference;
+    }
+
+    if (error == 0.0f) {
+        memcpy(mixed, next->head, samples * sizeof(float));
+        result->exact_seams++;
+    } else {
+        for (size_t i = 0; i < frames; i++) {
+            float weight = (float)(i + 1) / (float)(frames + 1);
+            mixed[i * 2] = previous->tail[i * 2] + (next->head[i * 2] - previous->tail[i * 2]) * weight;
+            mixed[i * 2 + 1] = previous->tail[i * 2 + 1] + (next->head[i * 2 + 1] - previous->tail[i * 2 + 1]) * weight;
+        }
+        result->crossfaded_seams++;
+    }
+    if (error > result->max_seam_error) result->max_seam_error = error;
+
+    bridge_convert_samples(mixed, converted, samples, job->settings.format);
+    return bridge_pwrite_all(job->fd, converted, frames * job->frame_bytes,
+                             job->header_size + next->start * job->frame_bytes);
+}
+
+int openmpt_bridge_export_parallel(const void* data, size_t size, const char* output_path, const openmpt_bridge_export_options* options, const openmpt_bridge_parallel_export_options* parallel, openmpt_bridge_parallel_export_result* result) {
+    if (!data || !size || !output_path) return 0;
+
+    bridge_parallel_export job;
+    memset(&job, 0, sizeof(job));
+    job.data = data;
+    job.size = size;
+    job.fd = -1;
+    openmpt_bridge_export_options_init(&job.settings);
+    if (options) job.settings = *options;
+    if (job.settings.sample_rate <= 0) job.settings.sample_rate = BRIDGE_EXPORT_DEFAULT_RATE;
+    if (job.settings.block_frames <= 0) job.settings.block_frames = BRIDGE_EXPORT_DEFAULT_BLOCK;
+    job.frame_bytes = bridge_sample_bytes(job.settings.format) * 2;
+    if (!job.frame_bytes) return 0;
+    if (job.settings.container != OPENMPT_BRIDGE_CONTAINER_WAV && job.settings.container != OPENMPT_BRIDGE_CONTAINER_RAW) return 0;
+
+    openmpt_bridge_parallel_export_options split;
+    openmpt_bridge_parallel_export_options_init(&split);
+    if (parallel) split = *parallel;
+    job.subsong = split.subsong;
+    job.overlap = split.overlap_frames > 0 ? (size_t)split.overlap_frames : 1;
+    job.silence_threshold = bridge_export_silence_threshold(&job.settings);
+    job.silence_limit = bridge_export_silence_limit(&job.settings);
+
+    openmpt_bridge_parallel_export_result summary;
+    memset(&summary, 0, sizeof(summary));
+    uint64_t start = bridge_now_ns();
+
+    // Plan on a throwaway instance
+    openmpt_module* planner = bridge_export_instance(data, size, job.subsong);
+    if (!planner) return 0;
+    double song_seconds = openmpt_module_get_duration_seconds(planner);
+    uint64_t frame_limit = UINT64_MAX;
+    if (job.settings.max_seconds > 0.0) {
+        frame_limit = (uint64_t)(job.settings.max_seconds * job.settings.sample_rate);
+        if (job.settings.max_seconds < song_seconds) song_seconds = job.settings.max_seconds;
+    }
+    size_t checkpoint_count = 0;
+    bridge_checkpoint* checkpoints = bridge_export_checkpoints(planner, &checkpoint_count);
+    openmpt_module_destroy(planner);
+
+    double min_segment = split.min_segment_seconds > 0.0 ? split.min_segment_seconds : 0.0;
+    size_t longest = min_segment > 0.0 ? (size_t)(song_seconds / min_segment) : checkpoint_count + 1;
+    if (longest < 1) longest = 1;
+    size_t wanted = split.segment_count > 0 ? (size_t)split.segment_count
+                                            : (size_t)bridge_resolve_thread_count(split.thread_count, longest);
+    if (wanted > longest) wanted = longest;
+
+    int ok = 0;
+    float* mixed = NULL;
+    void* converted = NULL;
+    job.segments = calloc(wanted, sizeof(*job.segments));
+    if (!job.segments) goto cleanup;
+    job.segment_count = bridge_export_plan(&job, checkpoints, checkpoint_count, wanted, song_seconds,
+                                           split.preroll_seconds > 0.0 ? split.preroll_seconds : 0.0, frame_limit);
+    for (size_t k = 0; k < job.segment_count; k++) {
+        if (k > 0 && !(job.segments[k].head = malloc(job.overlap * 2 * sizeof(float)))) goto cleanup;
+        if (k + 1 < job.segment_count && !(job.segments[k].tail = malloc(job.overlap * 2 * sizeof(float)))) goto cleanup;
+    }
+    mixed = malloc(job.overlap * 2 * sizeof(float));
+    converted = malloc(job.overlap * job.frame_bytes);
+    if (!mixed || !converted) goto cleanup;
+
+    job.fd = open(output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (job.fd < 0) goto cleanup;
+    uint8_t header[BRIDGE_WAV_HEADER_MAX];
+    if (job.settings.container == OPENMPT_BRIDGE_CONTAINER_WAV) {
+        job.header_size = bridge_wav_header(header, job.settings.format, job.settings.sample_rate, 2, 0);
+    }
+
+    bridge_parallel_for(job.segment_count, split.thread_count, bridge_export_segment, &job);
+
+    ok = 1;
+    uint64_t render_ns = 0;
+    for (size_t k = 0; k < job.segment_count; k++) {
+        ok = ok && job.segments[k].ok;
+        render_ns += job.segments[k].render_ns;
+    }
+    for (size_t k = 1; ok && k < job.segment_count; k++) {
+        ok = bridge_export_seam(&job, &job.segments[k - 1], &job.segments[k], mixed, converted, &summary);
+    }
+
+    const bridge_segment* last = &job.segments[job.segment_count - 1];
+    uint64_t rendered_frames = last->start + last->frames;
+    uint64_t frames = rendered_frames;
+    if (ok && job.settings.trim_silence) {
+        frames = 0;
+        for (size_t k = 0; k < job.segment_count; k++) {
+            if (job.segments[k].audible > frames) frames = job.segments[k].audible;
+        }
+        if (frames < rendered_frames) ok = ftruncate(job.fd, (off_t)(job.header_size + frames * job.frame_bytes)) == 0;
+    }
+    if (ok && job.header_size) {
+        bridge_wav_header(header, job.settings.format, job.settings.sample_rate, 2, frames * job.frame_bytes);
+        ok = bridge_pwrite_all(job.fd, header, job.header_size, 0);
+    }
+
+    summary.segments = (int32_t)job.segment_count;
+    summary.totals.frames = frames;
+    summary.totals.trimmed_frames = rendered_frames - frames;
+    summary.totals.audio_seconds = (double)frames / job.settings.sample_rate;
+    summary.totals.render_seconds = (double)render_ns * 1e-9;
+
+cleanup:
+    if (job.fd >= 0) {
+        if (close(job.fd) != 0) ok = 0;
+        if (!ok) unlink(output_path);
+    }
+    if (job.segments) {
+        for (size_t k = 0; k < job.segment_count; k++) {
+            free(job.segments[k].head);
+            free(job.segments[k].tail);
+        }
+    }
+    free(job.segments);
+    free(checkpoints);
+    free(mixed);
+    free(converted);
+
+    if (result) {
+        summary.totals.wall_seconds = (double)(bridge_now_ns() - start) * 1e-9;
+        summary.totals.realtime_factor = summary.totals.wall_seconds > 0.0
+            ? summary.totals.audio_seconds / summary.totals.wall_seconds : 0.0;
+        *result = summary;
+    }
+    return ok;
+}
+
+int openmpt_bridge_export_parallel_file(const char* module_path, const char* output_path, const openmpt_bridge_export_options* options, const openmpt_bridge_parallel_export_options* parallel, openmpt_bridge_parallel_export_result* result) {
+    void* data = NULL;
+    size_t size = 0;
+    if (!bridge_read_file(module_path, &data, &size)) return 0;
+
+    int ok = openmpt_bridge_export_parallel(data, size, output_path, options, parallel, result);
+    free(data);
+    return ok;
+}
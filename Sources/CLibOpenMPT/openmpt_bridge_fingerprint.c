@@ -0,0 +1,436 @@
+// openmpt_bridge_fingerprint.c
+// Chroma and band-energy fingerprints with an inverted index for duplicate lookups
+
+#include "openmpt_bridge_fingerprint.h"
+#include "openmpt_bridge_index.h"
+#include "bridge_internal.h"
+#include "bridge_fft.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BRIDGE_FINGERPRINT_FRAME 2048           // 256 ms
+#define BRIDGE_FINGERPRINT_BANDS 21             // 20 difference bits
+#define BRIDGE_FINGERPRINT_BAND_LOW 150.0
+#define BRIDGE_FINGERPRINT_BAND_HIGH 3800.0
+#define BRIDGE_FINGERPRINT_CHROMA_LOW 110.0
+#define BRIDGE_FINGERPRINT_CHROMA_HIGH 2000.0
+#define BRIDGE_FINGERPRINT_SILENCE 1e-7         // mean square, about -70 dBFS
+#define BRIDGE_FINGERPRINT_BLOCK 2048
+#define BRIDGE_FINGERPRINT_MIN_COMPARED 8
+#define BRIDGE_FINGERPRINT_VERIFY_RADIUS 1      // offsets around the best vote that are compared
+
+// Index entries pack hash, song and frame into one sortable word, so the
+// frame must fit below 1 << BRIDGE_FINGERPRINT_POSITION_BITS
+#define BRIDGE_FINGERPRINT_POSITION_BITS 10
+#define BRIDGE_FINGERPRINT_SONG_BITS 22
+#define BRIDGE_FINGERPRINT_OFFSET_BIAS (1 << BRIDGE_FINGERPRINT_POSITION_BITS)
+
+_Static_assert(OPENMPT_BRIDGE_FINGERPRINT_MAX_HASHES <= (1 << BRIDGE_FINGERPRINT_POSITION_BITS),
+               "fingerprint frames must fit the index entry");
+
+// MARK: - Hashing
+
+typedef struct bridge_fingerprinter {
+    bridge_fft* fft;
+    float window[BRIDGE_FINGERPRINT_FRAME];
+    float frame[BRIDGE_FINGERPRINT_FRAME];
+    float windowed[BRIDGE_FINGERPRINT_FRAME];
+    float re[BRIDGE_FINGERPRINT_FRAME / 2 + 1];
+    float im[BRIDGE_FINGERPRINT_FRAME / 2 + 1];
+    int8_t chroma_class[BRIDGE_FINGERPRINT_FRAME / 2 + 1];  // pitch class of a bin, -1 outside the range
+    int8_t band[BRIDGE_FINGERPRINT_FRAME / 2 + 1];          // band of a bin, -1 outside the range
+    double previous[BRIDGE_FINGERPRINT_BANDS];
+    size_t filled;
+} bridge_fingerprinter;
+
+static int bridge_fingerprinter_init(bridge_fingerprinter* fp) {
+    memset(fp, 0, sizeof(*fp));
+    fp->fft = bridge_fft_create(BRIDGE_FINGERPRINT_FRAME);
+    if (!fp->fft) return 0;
+
+    for (size_t i = 0; i < BRIDGE_FINGERPRINT_FRAME; i++) {
+        fp->window[i] = (float)(0.5 - 0.5 * cos(2.0 * M_PI * (double)i / BRIDGE_FINGERPRINT_FRAME));
+    }
+    const double bin_hz = (double)OPENMPT_BRIDGE_FINGERPRINT_SAMPLE_RATE / BRIDGE_FINGERPRINT_FRAME;
+    const double octaves = log2(BRIDGE_FINGERPRINT_BAND_HIGH / BRIDGE_FINGERPRINT_BAND_LOW);
+    for (size_t bin = 0; bin <= BRIDGE_FINGERPRINT_FRAME / 2; bin++) {
+        double hz = (double)bin * bin_hz;
+        fp->chroma_class[bin] = -1;
+        fp->band[bin] = -1;
+        if (hz >= BRIDGE_FINGERPRINT_CHROMA_LOW && hz < BRIDGE_FINGERPRINT_CHROMA_HIGH) {
+            // Semitones from A, folded into one octave
+            long semitone = lround(12.0 * log2(hz / 440.0));
+            fp->chroma_class[bin] = (int8_t)(((semitone % 12) + 12) % 12);
+        }
+        if (hz >= BRIDGE_FINGERPRINT_BAND_LOW && hz < BRIDGE_FINGERPRINT_BAND_HIGH) {
+            int band = (int)(log2(hz / BRIDGE_FINGERPRINT_BAND_LOW) / octaves * BRIDGE_FINGERPRINT_BANDS);
+            fp->band[bin] = (int8_t)(band < BRIDGE_FINGERPRINT_BANDS ? band : BRIDGE_FINGERPRINT_BANDS - 1);
+        }
+    }
+    return 1;
+}
+
+static void bridge_fingerprinter_free(bridge_fingerprinter* fp) {
+    bridge_fft_destroy(fp->fft);
+}
+
+// Hash of the full frame buffer
+static uint32_t bridge_fingerprinter_hash(bridge_fingerprinter* fp) {
+    double power = 0.0;
+    for (size_t i = 0; i < BRIDGE_FINGERPRINT_FRAME; i++) {
+        power += (double)fp->frame[i] * fp->frame[i];
+        fp->windowed[i] = fp->frame[i] * fp->window[i];
+    }
+    bridge_fft_real(fp->fft, fp->windowed, fp->re, fp->im);
+
+    double chroma[12] = { 0 };
+    double bands[BRIDGE_FINGERPRINT_BANDS] = { 0 };
+    for (size_t bin = 1; bin <= BRIDGE_FINGERPRINT_FRAME / 2; bin++) {
+        double energy = (double)fp->re[bin] * fp->re[bin] + (double)fp->im[bin] * fp->im[bin];
+        if (fp->chroma_class[bin] >= 0) chroma[fp->chroma_class[bin]] += energy;
+        if (fp->band[bin] >= 0) bands[fp->band[bin]] += energy;
+    }
+
+    uint32_t hash = 0;
+    if (power / BRIDGE_FINGERPRINT_FRAME >= BRIDGE_FINGERPRINT_SILENCE) {
+        double mean = 0.0;
+        for (int c = 0; c < 12; c++) mean += chroma[c];
+        mean /= 12.0;
+        for (int c = 0; c < 12; c++) {
+            if (chroma[c] > mean) hash |= 1u << c;
+        }
+        for (int m = 0; m + 1 < BRIDGE_FINGERPRINT_BANDS; m++) {
+            double change = (bands[m] - bands[m + 1]) - (fp->previous[m] - fp->previous[m + 1]);
+            if (change > 0.0) hash |= 1u << (12 + m);
+        }
+        // A frame that is audible but hashes to 0 must not read as silence
+        if (!hash) hash = 1;
+    }
+    memcpy(fp->previous, bands, sizeof(bands));
+    return hash;
+}
+
+size_t bridge_fingerprint_render(openmpt_module* mod, uint32_t* hashes, size_t capacity) {
+    if (!hashes || !capacity) return 0;
+    bridge_fingerprinter* fp = calloc(1, sizeof(*fp));
+    float* block = malloc(BRIDGE_FINGERPRINT_BLOCK * 2 * sizeof(float));
+    if (!fp || !block || !bridge_fingerprinter_init(fp)) {
+        if (fp) bridge_fingerprinter_free(fp);
+        free(fp);
+        free(block);
+        return 0;
+    }
+
+    // Timbre detail does not survive hashing, so the cheapest render will do
+    openmpt_module_set_render_param(mod, OPENMPT_MODULE_RENDER_INTERPOLATIONFILTER_LENGTH, 1);
+    openmpt_module_set_render_param(mod, OPENMPT_MODULE_RENDER_VOLUMERAMPING_STRENGTH, 0);
+    openmpt_module_set_repeat_count(mod, 0);
+
+    size_t count = 0;
+    while (count < capacity) {
+        size_t rendered = openmpt_module_read_interleaved_float_stereo(mod, OPENMPT_BRIDGE_FINGERPRINT_SAMPLE_RATE,
+                                                                       BRIDGE_FINGERPRINT_BLOCK, block);
+        for (size_t i = 0; i < rendered && count < capacity; i++) {
+            fp->frame[fp->filled++] = 0.5f * (block[i * 2] + block[i * 2 + 1]);
+            if (fp->filled < BRIDGE_FINGERPRINT_FRAME) continue;
+            hashes[count++] = bridge_fingerprinter_hash(fp);
+            memmove(fp->frame, fp->frame + OPENMPT_BRIDGE_FINGERPRINT_HOP_FRAMES,
+                    (BRIDGE_FINGERPRINT_FRAME - OPENMPT_BRIDGE_FINGERPRINT_HOP_FRAMES) * sizeof(float));
+            fp->filled = BRIDGE_FINGERPRINT_FRAME - OPENMPT_BRIDGE_FINGERPRINT_HOP_FRAMES;
+        }
+        if (rendered < BRIDGE_FINGERPRINT_BLOCK) break; // end of song
+    }
+
+    bridge_fingerprinter_free(fp);
+    free(fp);
+    free(block);
+    return count;
+}
+
+size_t openmpt_bridge_fingerprint_compute(const void* data, size_t size, int32_t subsong, uint32_t* hashes, size_t capacity) {
+    if (!data || !size || !hashes || !capacity) return 0;
+    int error = 0;
+    openmpt_module* mod = openmpt_module_create_from_memory2(data, size, (void*)openmpt_log_func_silent, NULL,
+                                                             NULL, NULL, &error, NULL, NULL);
+    if (!mod) return 0;
+    size_t count = 0;
+    if (subsong < 0 || openmpt_module_select_subsong(mod, subsong)) {
+        count = bridge_fingerprint_render(mod, hashes, capacity);
+    }
+    openmpt_module_destroy(mod);
+    return count;
+}
+
+// MARK: - Comparison
+
+// Differing bits where both a[i] and b[i + offset] are audible
+static double bridge_fingerprint_compare(const uint32_t* a, size_t a_count, const uint32_t* b, size_t b_count,
+                                         int32_t offset, uint32_t* compared) {
+    size_t first = offset < 0 ? (size_t)-(int64_t)offset : 0;
+    int64_t last = (int64_t)b_count - offset;
+    if (last > (int64_t)a_count) last = (int64_t)a_count;
+    uint64_t bits = 0;
+    uint32_t pairs = 0;
+    for (int64_t i = (int64_t)first; i < last; i++) {
+        uint32_t x = a[i];
+        uint32_t y = b[i + offset];
+        if (!x || !y) continue;
+        bits += (uint64_t)__builtin_popcount(x ^ y);
+        pairs++;
+    }
+    *compared = pairs;
+    if (pairs < BRIDGE_FINGERPRINT_MIN_COMPARED) return 0.0;
+    return 1.0 - (double)bits / (32.0 * pairs);
+}
+
+double openmpt_bridge_fingerprint_similarity(const uint32_t* a, size_t a_count, const uint32_t* b, size_t b_count, int32_t max_offset, int32_t* offset) {
+    if (offset) *offset = 0;
+    if (!a || !b || !a_count || !b_count) return 0.0;
+    if (max_offset < 0) max_offset = 0;
+    double best = 0.0;
+    for (int32_t shift = -max_offset; shift <= max_offset; shift++) {
+        uint32_t compared = 0;
+        double similarity = bridge_fingerprint_compare(a, a_count, b, b_count, shift, &compared);
+        if (similarity > best) {
+            best = similarity;
+            if (offset) *offset = shift;
+        }
+    }
+    return best;
+}
+
+// MARK: - Inverted index
+
+typedef struct bridge_fingerprint_song {
+    uint64_t id;
+    uint32_t* hashes;
+    uint32_t count;
+} bridge_fingerprint_song;
+
+struct openmpt_bridge_fingerprint_index {
+    bridge_fingerprint_song* songs;
+    size_t song_count;
+    size_t song_capacity;
+    // hash << 32 | song << 10 | frame, sorted up to sorted_count
+    uint64_t* entries;
+    size_t entry_count;
+    size_t entry_capacity;
+    size_t sorted_count;
+    uint64_t* votes;                // query scratch
+    size_t vote_capacity;
+};
+
+static inline uint32_t bridge_entry_hash(uint64_t entry) { return (uint32_t)(entry >> 32); }
+static inline uint32_t bridge_entry_song(uint64_t entry) { return (uint32_t)(entry >> BRIDGE_FINGERPRINT_POSITION_BITS) & ((1u << BRIDGE_FINGERPRINT_SONG_BITS) - 1); }
+static inline uint32_t bridge_entry_position(uint64_t entry) { return (uint32_t)entry & ((1u << BRIDGE_FINGERPRINT_POSITION_BITS) - 1); }
+
+static int bridge_u64_compare(const void* a, const void* b) {
+    uint64_t lhs = *(const uint64_t*)a;
+    uint64_t rhs = *(const uint64_t*)b;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+openmpt_bridge_fingerprint_index* openmpt_bridge_fingerprint_index_create(void) {
+    return calloc(1, sizeof(openmpt_bridge_fingerprint_index));
+}
+
+void openmpt_bridge_fingerprint_index_destroy(openmpt_bridge_fingerprint_index* index) {
+    if (!index) return;
+    for (size_t i = 0; i < index->song_count; i++) free(index->songs[i].hashes);
+    free(index->songs);
+    free(index->entries);
+    free(index->votes);
+    free(index);
+}
+
+size_t openmpt_bridge_fingerprint_index_get_count(const openmpt_bridge_fingerprint_index* index) {
+    return index ? index->song_count : 0;
+}
+
+static int bridge_reserve(void** items, size_t* capacity, size_t needed, size_t item_size) {
+    if (needed <= *capacity) return 1;
+    size_t grown = *capacity ? *capacity : 256;
+    while (grown < needed) grown *= 2;
+    void* resized = realloc(*items, grown * item_size);
+    if (!resized) return 0;
+    *items = resized;
+    *capacity = grown;
+    return 1;
+}
+
+int openmpt_bridge_fingerprint_index_add(openmpt_bridge_fingerprint_index* index, uint64_t id, const uint32_t* hashes, size_t count) {
+    if (!index || (count && !hashes)) return 0;
+    if (index->song_count >= ((size_t)1 << BRIDGE_FINGERPRINT_SONG_BITS)) return 0;
+    // Frames past the packed range stay comparable but are not looked up
+    if (count > OPENMPT_BRIDGE_FINGERPRINT_MAX_HASHES) count = OPENMPT_BRIDGE_FINGERPRINT_MAX_HASHES;
+
+    if (!bridge_reserve((void**)&index->songs, &index->song_capacity, index->song_count + 1, sizeof(*index->songs))) return 0;
+    if (!bridge_reserve((void**)&index->entries, &index->entry_capacity, index->entry_count + count, sizeof(*index->entries))) return 0;
+    uint32_t* copy = malloc((count ? count : 1) * sizeof(*copy));
+    if (!copy) return 0;
+    if (count) memcpy(copy, hashes, count * sizeof(*copy));
+
+    uint64_t song = index->song_count;
+    for (size_t i = 0; i < count; i++) {
+        if (!copy[i]) continue; // silence matches everything
+        index->entries[index->entry_count++] = (uint64_t)copy[i] << 32 | song << BRIDGE_FINGERPRINT_POSITION_BITS | i;
+    }
+    index->songs[index->song_count].id = id;
+    index->songs[index->song_count].hashes = copy;
+    index->songs[index->song_count].count = (uint32_t)count;
+    index->song_count++;
+    return 1;
+}
+
+openmpt_bridge_fingerprint_index* openmpt_bridge_fingerprint_index_open_database(const char* database_path) {
+    openmpt_bridge_index* database = openmpt_bridge_index_open(database_path);
+    if (!database) return NULL;
+    openmpt_bridge_fingerprint_index* index = openmpt_bridge_fingerprint_index_create();
+    // Blobs in the mapped file carry no alignment guarantee, so hashes are
+    // copied out before they are read as uint32_t
+    uint32_t* hashes = malloc(OPENMPT_BRIDGE_FINGERPRINT_MAX_HASHES * sizeof(*hashes));
+    if (!hashes) {
+        openmpt_bridge_fingerprint_index_destroy(index);
+        index = NULL;
+    }
+    uint64_t rows = openmpt_bridge_index_get_row_count(database);
+    for (uint64_t row = 0; index && row < rows; row++) {
+        size_t size = 0;
+        const void* blob = openmpt_bridge_index_get_blob(database, OPENMPT_BRIDGE_INDEX_COLUMN_FINGERPRINT, row, &size);
+        size_t count = blob ? size / sizeof(uint32_t) : 0;
+        if (count > OPENMPT_BRIDGE_FINGERPRINT_MAX_HASHES) count = OPENMPT_BRIDGE_FINGERPRINT_MAX_HASHES;
+        if (count) memcpy(hashes, blob, count * sizeof(*hashes));
+        // Rows stay aligned with ids even when a module has no fingerprint
+        if (!openmpt_bridge_fingerprint_index_add(index, row, hashes, count)) {
+            openmpt_bridge_fingerprint_index_destroy(index);
+            index = NULL;
+        }
+    }
+    free(hashes);
+    openmpt_bridge_index_close(database);
+    return index;
+}
+
+static void bridge_fingerprint_index_sort(openmpt_bridge_fingerprint_index* index) {
+    if (index->sorted_count == index->entry_count) return;
+    qsort(index->entries, index->entry_count, sizeof(*index->entries), bridge_u64_compare);
+    index->sorted_count = index->entry_count;
+}
+
+// First entry with a hash of at least hash
+static size_t bridge_fingerprint_index_lower_bound(const openmpt_bridge_fingerprint_index* index, uint32_t hash) {
+    size_t low = 0;
+    size_t high = index->sorted_count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (bridge_entry_hash(index->entries[mid]) < hash) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+static int bridge_match_compare(const void* a, const void* b) {
+    double lhs = ((const openmpt_bridge_fingerprint_match*)a)->similarity;
+    double rhs = ((const openmpt_bridge_fingerprint_match*)b)->similarity;
+    return (lhs < rhs) - (lhs > rhs);
+}
+
+static size_t bridge_fingerprint_index_search(openmpt_bridge_fingerprint_index* index, const uint32_t* hashes, size_t count,
+                                              int64_t exclude, double min_similarity,
+                                              openmpt_bridge_fingerprint_match* matches, size_t capacity) {
+    if (!index || !hashes || !count || !matches || !capacity) return 0;
+    if (count > OPENMPT_BRIDGE_FINGERPRINT_MAX_HASHES) count = OPENMPT_BRIDGE_FINGERPRINT_MAX_HASHES;
+    bridge_fingerprint_index_sort(index);
+
+    // Hashes shared by many songs (steady tones, drum loops) carry little
+    // information and would dominate the votes, so they are skipped
+    size_t common = index->song_count / 20;
+    if (common < 64) common = 64;
+
+    // One vote per shared hash for (song, offset)
+    size_t vote_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!hashes[i]) continue;
+        size_t first = bridge_fingerprint_index_lower_bound(index, hashes[i]);
+        size_t last = first;
+        while (last < index->sorted_count && bridge_entry_hash(index->entries[last]) == hashes[i]) last++;
+        if (last == first || last - first > common) continue;
+        if (!bridge_reserve((void**)&index->votes, &index->vote_capacity, vote_count + (last - first), sizeof(*index->votes))) return 0;
+        for (size_t e = first; e < last; e++) {
+            uint32_t song = bridge_entry_song(index->entries[e]);
+            if ((int64_t)song == exclude) continue;
+            int64_t offset = (int64_t)bridge_entry_position(index->entries[e]) - (int64_t)i;
+            index->votes[vote_count++] = (uint64_t)song << (BRIDGE_FINGERPRINT_POSITION_BITS + 1) |
+                                         (uint64_t)(offset + BRIDGE_FINGERPRINT_OFFSET_BIAS);
+        }
+    }
+    qsort(index->votes, vote_count, sizeof(*index->votes), bridge_u64_compare);
+
+    // Each song's most voted offset, checked bit by bit around that offset
+    size_t written = 0;
+    size_t v = 0;
+    while (v < vote_count) {
+        uint64_t song = index->votes[v] >> (BRIDGE_FINGERPRINT_POSITION_BITS + 1);
+        uint64_t best_vote = 0;
+        size_t best_run = 0;
+        while (v < vote_count && index->votes[v] >> (BRIDGE_FINGERPRINT_POSITION_BITS + 1) == song) {
+            size_t run = 1;
+            while (v + run < vote_count && index->votes[v + run] == index->votes[v]) run++;
+            if (run > best_run) {
+                best_run = run;
+                best_vote = index->votes[v];
+            }
+            v += run;
+        }
+        if (best_run < 2) continue;
+
+        const bridge_fingerprint_song* candidate = &index->songs[song];
+        int32_t voted = (int32_t)(best_vote & ((1u << (BRIDGE_FINGERPRINT_POSITION_BITS + 1)) - 1)) - BRIDGE_FINGERPRINT_OFFSET_BIAS;
+        openmpt_bridge_fingerprint_match match = { candidate->id, 0.0, voted, 0 };
+        for (int32_t shift = voted - BRIDGE_FINGERPRINT_VERIFY_RADIUS; shift <= voted + BRIDGE_FINGERPRINT_VERIFY_RADIUS; shift++) {
+            uint32_t compared = 0;
+            double similarity = bridge_fingerprint_compare(hashes, count, candidate->hashes, candidate->count, shift, &compared);
+            if (similarity > match.similarity) {
+                match.similarity = similarity;
+                match.offset = shift;
+                match.compared = compared;
+            }
+        }
+        if (match.similarity < min_similarity || match.compared == 0) continue;
+
+        // Keep the best capacity matches; the list is sorted once at the end
+        if (written < capacity) {
+            matches[written++] = match;
+        } else {
+            size_t worst = 0;
+            for (size_t m = 1; m < written; m++) {
+                if (matches[m].similarity < matches[worst].similarity) worst = m;
+            }
+            if (match.similarity > matches[worst].similarity) matches[worst] = match;
+        }
+    }
+    qsort(matches, written, sizeof(*matches), bridge_match_compare);
+    return written;
+}
+
+size_t openmpt_bridge_fingerprint_index_query(openmpt_bridge_fingerprint_index* index, const uint32_t* hashes, size_t count, double min_similarity, openmpt_bridge_fingerprint_match* matches, size_t capacity) {
+    return bridge_fingerprint_index_search(index, hashes, count, -1, min_similarity, matches, capacity);
+}
+
+size_t openmpt_bridge_fingerprint_index_query_id(openmpt_bridge_fingerprint_index* index, uint64_t id, double min_similarity, openmpt_bridge_fingerprint_match* matches, size_t capacity) {
+    if (!index) return 0;
+    // Indexes built from a database use row numbers, so the id is usually the slot
+    size_t song = id < index->song_count && index->songs[id].id == id ? (size_t)id : index->song_count;
+    for (size_t i = 0; song == index->song_count && i < index->song_count; i++) {
+        if (index->songs[i].id == id) song = i;
+    }
+    if (song == index->song_count) return 0;
+    return bridge_fingerprint_index_search(index, index->songs[song].hashes, index->songs[song].count,
+                                           (int64_t)song, min_similarity, matches, capacity);
+}
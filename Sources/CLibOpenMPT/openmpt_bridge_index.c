@@ -0,0 +1,760 @@
+// openmpt_bridge_index.c
+// Parallel corpus indexer and columnar database reader
+
+#include "openmpt_bridge_index.h"
+#include "openmpt_bridge_loudness.h"
+#include "openmpt_bridge_fingerprint.h"
+#include "bridge_internal.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char openmpt_bridge_index_magic[8] = { 'O', 'M', 'P', 'T', 'I', 'D', 'X', 0 };
+
+typedef struct index_column_info {
+    const char* name;
+    uint32_t kind;
+} index_column_info;
+
+static const index_column_info index_columns[OPENMPT_BRIDGE_INDEX_COLUMN_COUNT] = {
+    { "path", OPENMPT_BRIDGE_INDEX_KIND_STRING },
+    { "size", OPENMPT_BRIDGE_INDEX_KIND_UINT64 },
+    { "mtime", OPENMPT_BRIDGE_INDEX_KIND_INT64 },
+    { "status", OPENMPT_BRIDGE_INDEX_KIND_UINT32 },
+    { "content_hash", OPENMPT_BRIDGE_INDEX_KIND_UINT64 },
+    { "title", OPENMPT_BRIDGE_INDEX_KIND_STRING },
+    { "artist", OPENMPT_BRIDGE_INDEX_KIND_STRING },
+    { "type", OPENMPT_BRIDGE_INDEX_KIND_STRING },
+    { "tracker", OPENMPT_BRIDGE_INDEX_KIND_STRING },
+    { "duration", OPENMPT_BRIDGE_INDEX_KIND_DOUBLE },
+    { "channels", OPENMPT_BRIDGE_INDEX_KIND_UINT32 },
+    { "patterns", OPENMPT_BRIDGE_INDEX_KIND_UINT32 },
+    { "instruments", OPENMPT_BRIDGE_INDEX_KIND_UINT32 },
+    { "samples", OPENMPT_BRIDGE_INDEX_KIND_UINT32 },
+    { "loudness_measured", OPENMPT_BRIDGE_INDEX_KIND_UINT32 },
+    { "loudness", OPENMPT_BRIDGE_INDEX_KIND_DOUBLE },
+    { "loudness_range", OPENMPT_BRIDGE_INDEX_KIND_DOUBLE },
+    { "true_peak", OPENMPT_BRIDGE_INDEX_KIND_DOUBLE },
+    { "fingerprint", OPENMPT_BRIDGE_INDEX_KIND_BLOB },
+    { "analysis_failed", OPENMPT_BRIDGE_INDEX_KIND_UINT32 },
+};
+
+static size_t index_kind_width(uint32_t kind) {
+    switch (kind) {
+    case OPENMPT_BRIDGE_INDEX_KIND_UINT32: return 4;
+    case OPENMPT_BRIDGE_INDEX_KIND_STRING: return 4;
+    case OPENMPT_BRIDGE_INDEX_KIND_UINT64: return 8;
+    case OPENMPT_BRIDGE_INDEX_KIND_INT64: return 8;
+    case OPENMPT_BRIDGE_INDEX_KIND_DOUBLE: return 8;
+    case OPENMPT_BRIDGE_INDEX_KIND_BLOB: return 8;
+    default: return 0;
+    }
+}
+
+static size_t index_align8(size_t value) {
+    return (value + 7) & ~(size_t)7;
+}
+
+static size_t index_align4(size_t value) {
+    return (value + 3) & ~(size_t)3;
+}
+
+const char* openmpt_bridge_index_column_name(int32_t column) {
+    if (column < 0 || column >= OPENMPT_BRIDGE_INDEX_COLUMN_COUNT) return "";
+    return index_columns[column].name;
+}
+
+// MARK: - Reader
+
+typedef struct index_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t column_count;
+    uint64_t row_count;
+} index_header;
+
+typedef struct index_directory_entry {
+    uint32_t id;
+    uint32_t kind;
+    uint64_t offset;
+    uint64_t size;
+} index_directory_entry;
+
+struct openmpt_bridge_index {
+    const void* mapping;
+    size_t mapping_size;
+    uint64_t row_count;
+    const unsigned char* columns[OPENMPT_BRIDGE_INDEX_COLUMN_COUNT];
+    const char* pools[OPENMPT_BRIDGE_INDEX_COLUMN_COUNT];
+    uint64_t pool_sizes[OPENMPT_BRIDGE_INDEX_COLUMN_COUNT];
+};
+
+openmpt_bridge_index* openmpt_bridge_index_open(const char* database_path) {
+    const void* data = NULL;
+    size_t size = 0;
+    if (!bridge_map_file(database_path, &data, &size)) return NULL;
+
+    openmpt_bridge_index* index = calloc(1, sizeof(*index));
+    if (!index) {
+        bridge_unmap_file(data, size);
+        return NULL;
+    }
+    index->mapping = data;
+    index->mapping_size = size;
+
+    const unsigned char* bytes = (const unsigned char*)data;
+    index_header header;
+    if (size < sizeof(header)) goto invalid;
+    memcpy(&header, bytes, sizeof(header));
+    if (memcmp(header.magic, openmpt_bridge_index_magic, sizeof(header.magic)) != 0) goto invalid;
+    if (header.version != OPENMPT_BRIDGE_INDEX_VERSION) goto invalid;
+    if (header.column_count > (size - sizeof(header)) / sizeof(index_directory_entry)) goto invalid;
+    index->row_count = header.row_count;
+
+    for (uint32_t i = 0; i < header.column_count; i++) {
+        index_directory_entry entry;
+        memcpy(&entry, bytes + sizeof(header) + i * sizeof(entry), sizeof(entry));
+        if (entry.offset > size || entry.size > size - entry.offset) goto invalid;
+        // Unknown columns from newer writers are ignored
+        if (entry.id >= OPENMPT_BRIDGE_INDEX_COLUMN_COUNT) continue;
+        if (entry.kind != index_columns[entry.id].kind) goto invalid;
+
+        uint64_t fixed = header.row_count * index_kind_width(entry.kind);
+        if (header.row_count && fixed / header.row_count != index_kind_width(entry.kind)) goto invalid;
+        if (entry.size < fixed) goto invalid;
+
+        index->columns[entry.id] = bytes + entry.offset;
+        if (entry.kind == OPENMPT_BRIDGE_INDEX_KIND_STRING) {
+            uint64_t pool_size = entry.size - fixed;
+            const char* pool = (const char*)(bytes + entry.offset + fixed);
+            // Every offset must land inside a pool that ends with a terminator
+            if (header.row_count && (pool_size == 0 || pool[pool_size - 1] != '\0')) goto invalid;
+            for (uint64_t row = 0; row < header.row_count; row++) {
+                uint32_t offset;
+                memcpy(&offset, bytes + entry.offset + row * 4, sizeof(offset));
+                if (offset >= pool_size) goto invalid;
+            }
+            index->pools[entry.id] = pool;
+            index->pool_sizes[entry.id] = pool_size;
+        } else if (entry.kind == OPENMPT_BRIDGE_INDEX_KIND_BLOB) {
+            uint64_t pool_size = entry.size - fixed;
+            for (uint64_t row = 0; row < header.row_count; row++) {
+                uint32_t span[2];
+                memcpy(span, bytes + entry.offset + row * 8, sizeof(span));
+                if (span[0] > pool_size || span[1] > pool_size - span[0]) goto invalid;
+            }
+            index->pools[entry.id] = (const char*)(bytes + entry.offset + fixed);
+            index->pool_sizes[entry.id] = pool_size;
+        }
+    }
+    return index;
+
+invalid:
+    openmpt_bridge_index_close(index);
+    return NULL;
+}
+
+void openmpt_bridge_index_close(openmpt_bridge_index* index) {
+    if (!index) return;
+    bridge_unmap_file(index->mapping, index->mapping_size);
+    free(index);
+}
+
+uint64_t openmpt_bridge_index_get_row_count(const openmpt_bridge_index* index) {
+    return index ? index->row_count : 0;
+}
+
+const char* openmpt_bridge_index_get_string(const openmpt_bridge_index* index, int32_t column, uint64_t row) {
+    if (!index || column < 0 || column >= OPENMPT_BRIDGE_INDEX_COLUMN_COUNT) return "";
+    if (row >= index->row_count || !index->pools[column]) return "";
+    uint32_t offset;
+    memcpy(&offset, index->columns[column] + row * 4, sizeof(offset));
+    return index->pools[column] + offset;
+}
+
+uint64_t openmpt_bridge_index_get_uint(const openmpt_bridge_index* index, int32_t column, uint64_t row) {
+    if (!index || column < 0 || column >= OPENMPT_BRIDGE_INDEX_COLUMN_COUNT) return 0;
+    if (row >= index->row_count || !index->columns[column]) return 0;
+    const unsigned char* cell = index->columns[column];
+    switch (index_columns[column].kind) {
+    case OPENMPT_BRIDGE_INDEX_KIND_UINT32: {
+        uint32_t value;
+        memcpy(&value, cell + row * 4, sizeof(value));
+        return value;
+    }
+    case OPENMPT_BRIDGE_INDEX_KIND_UINT64:
+    case OPENMPT_BRIDGE_INDEX_KIND_INT64: {
+        uint64_t value;
+        memcpy(&value, cell + row * 8, sizeof(value));
+        return value;
+    }
+    default:
+        return 0;
+    }
+}
+
+double openmpt_bridge_index_get_double(const openmpt_bridge_index* index, int32_t column, uint64_t row) {
+    if (!index || column < 0 || column >= OPENMPT_BRIDGE_INDEX_COLUMN_COUNT) return 0.0;
+    if (row >= index->row_count || !index->columns[column]) return 0.0;
+    if (index_columns[column].kind != OPENMPT_BRIDGE_INDEX_KIND_DOUBLE) return 0.0;
+    double value;
+    memcpy(&value, index->columns[column] + row * 8, sizeof(value));
+    return value;
+}
+
+const void* openmpt_bridge_index_get_blob(const openmpt_bridge_index* index, int32_t column, uint64_t row, size_t* size) {
+    if (size) *size = 0;
+    if (!index || column < 0 || column >= OPENMPT_BRIDGE_INDEX_COLUMN_COUNT) return NULL;
+    if (row >= index->row_count || !index->columns[column]) return NULL;
+    if (index_columns[column].kind != OPENMPT_BRIDGE_INDEX_KIND_BLOB) return NULL;
+    uint32_t span[2];
+    memcpy(span, index->columns[column] + row * 8, sizeof(span));
+    if (!span[1]) return NULL;
+    if (size) *size = span[1];
+    return index->pools[column] + span[0];
+}
+
+// MARK: - Records
+
+typedef struct index_record {
+    char* path; // relative to the root
+    uint64_t size;
+    int64_t mtime;
+    uint32_t status;
+    uint64_t content_hash;
+    char* title;
+    char* artist;
+    char* type;
+    char* tracker;
+    double duration;
+    uint32_t channels;
+    uint32_t patterns;
+    uint32_t instruments;
+    uint32_t samples;
+    uint32_t loudness_measured;
+    double loudness;
+    double loudness_range;
+    double true_peak;
+    uint32_t* fingerprint;
+    uint32_t fingerprint_count;
+    uint32_t analysis_failed;
+    int reused;
+} index_record;
+
+typedef struct index_record_list {
+    index_record* items;
+    size_t count;
+    size_t capacity;
+} index_record_list;
+
+static index_record* index_record_append(index_record_list* list) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 1024;
+        index_record* items = realloc(list->items, capacity * sizeof(*items));
+        if (!items) return NULL;
+        list->items = items;
+        list->capacity = capacity;
+    }
+    index_record* record = &list->items[list->count++];
+    memset(record, 0, sizeof(*record));
+    return record;
+}
+
+static void index_record_free(index_record* record) {
+    free(record->path);
+    free(record->title);
+    free(record->artist);
+    free(record->type);
+    free(record->tracker);
+    free(record->fingerprint);
+}
+
+static int index_record_compare(const void* a, const void* b) {
+    return strcmp(((const index_record*)a)->path, ((const index_record*)b)->path);
+}
+
+// MARK: - Directory walk
+
+static char* index_join_path(const char* a, const char* b) {
+    size_t la = strlen(a);
+    size_t lb = strlen(b);
+    char* joined = malloc(la + lb + 2);
+    if (!joined) return NULL;
+    memcpy(joined, a, la);
+    size_t pos = la;
+    if (la && a[la - 1] != '/') joined[pos++] = '/';
+    memcpy(joined + pos, b, lb + 1);
+    return joined;
+}
+
+static int index_walk(const char* root, const char* relative, index_record_list* list) {
+    char* directory = relative[0] ? index_join_path(root, relative) : strdup(root);
+    if (!directory) return 0;
+    DIR* dir = opendir(directory);
+    if (!dir) {
+        free(directory);
+        return relative[0] != 0; // an unreadable subdirectory is not fatal
+    }
+
+    int ok = 1;
+    struct dirent* entry;
+    while (ok && (entry = readdir(dir)) != NULL) {
+        // Skip ".", ".." and hidden files
+        if (entry->d_name[0] == '.') continue;
+
+        char* child_relative = relative[0] ? index_join_path(relative, entry->d_name) : strdup(entry->d_name);
+        char* child_full = child_relative ? index_join_path(root, child_relative) : NULL;
+        struct stat st;
+        if (!child_relative || !child_full) {
+            ok = 0;
+        } else if (lstat(child_full, &st) == 0) {
+            if (S_ISDIR(st.st_mode)) {
+                ok = index_walk(root, child_relative, list);
+            } else if (S_ISREG(st.st_mode) || (S_ISLNK(st.st_mode) && stat(child_full, &st) == 0 && S_ISREG(st.st_mode))) {
+                index_record* record = index_record_append(list);
+                if (record) {
+                    record->path = child_relative;
+                    record->size = (uint64_t)st.st_size;
+                    record->mtime = BRIDGE_STAT_MTIME_NS(st);
+                    child_relative = NULL;
+                } else {
+                    ok = 0;
+                }
+            }
+        }
+        free(child_relative);
+        free(child_full);
+    }
+    closedir(dir);
+    free(directory);
+    return ok;
+}
+
+// MARK: - Incremental reuse
+
+typedef struct index_previous {
+    openmpt_bridge_index* index;
+    uint64_t* slots; // row + 1, 0 = empty
+    size_t mask;
+} index_previous;
+
+static int index_previous_load(index_previous* previous, const char* database_path) {
+    memset(previous, 0, sizeof(*previous));
+    previous->index = openmpt_bridge_index_open(database_path);
+    if (!previous->index) return 0;
+
+    uint64_t rows = previous->index->row_count;
+    size_t capacity = 16;
+    while (capacity < rows * 2) capacity <<= 1;
+    previous->slots = calloc(capacity, sizeof(*previous->slots));
+    if (!previous->slots) {
+        openmpt_bridge_index_close(previous->index);
+        previous->index = NULL;
+        return 0;
+    }
+    previous->mask = capacity - 1;
+
+    for (uint64_t row = 0; row < rows; row++) {
+        const char* path = openmpt_bridge_index_get_string(previous->index, OPENMPT_BRIDGE_INDEX_COLUMN_PATH, row);
+        size_t slot = (size_t)bridge_hash64(path, strlen(path), 0) & previous->mask;
+        while (previous->slots[slot]) slot = (slot + 1) & previous->mask;
+        previous->slots[slot] = row + 1;
+    }
+    return 1;
+}
+
+static int64_t index_previous_find(const index_previous* previous, const char* path) {
+    if (!previous->index) return -1;
+    size_t slot = (size_t)bridge_hash64(path, strlen(path), 0) & previous->mask;
+    while (previous->slots[slot]) {
+        uint64_t row = previous->slots[slot] - 1;
+        if (strcmp(openmpt_bridge_index_get_string(previous->index, OPENMPT_BRIDGE_INDEX_COLUMN_PATH, row), path) == 0) {
+            return (int64_t)row;
+        }
+        slot = (slot + 1) & previous->mask;
+    }
+    return -1;
+}
+
+static void index_previous_free(index_previous* previous) {
+    openmpt_bridge_index_close(previous->index);
+    free(previous->slots);
+}
+
+static int index_needs_loudness(const index_record* record) {
+    return !record->loudness_measured && !(record->analysis_failed & OPENMPT_BRIDGE_INDEX_ANALYSIS_LOUDNESS);
+}
+
+static int index_needs_fingerprint(const index_record* record) {
+    return !record->fingerprint && !(record->analysis_failed & OPENMPT_BRIDGE_INDEX_ANALYSIS_FINGERPRINT);
+}
+
+static int index_reuse(index_record* record, const openmpt_bridge_index* db, uint64_t row, const openmpt_bridge_index_options* options) {
+    if (openmpt_bridge_index_get_uint(db, OPENMPT_BRIDGE_INDEX_COLUMN_SIZE, row) != record->size) return 0;
+    if ((int64_t)openmpt_bridge_index_get_uint(db, OPENMPT_BRIDGE_INDEX_COLUMN_MTIME, row) != record->mtime) return 0;
+
+    // The file is unchanged, so stored analyses carry over even if the row is
+    // loaded again for one that is missing
+    size_t fingerprint_size = 0;
+    const void* fingerprint = openmpt_bridge_index_get_blob(db, OPENMPT_BRIDGE_INDEX_COLUMN_FINGERPRINT, row, &fingerprint_size);
+    if (fingerprint) {
+        record->fingerprint = malloc(fingerprint_size);
+        if (!record->fingerprint) return 0;
+        memcpy(record->fingerprint, fingerprint, fingerprint_size);
+        record->fingerprint_count = (uint32_t)(fingerprint_size / sizeof(uint32_t));
+    }
+    record->loudness_measured = (uint32_t)openmpt_bridge_index_get_uint(db, OPENMPT_BRIDGE_INDEX_COLUMN_LOUDNESS_MEASURED, row);
+    record->loudness = openmpt_bridge_index_get_double(db, OPENMPT_BRIDGE_INDEX_COLUMN_LOUDNESS, row);
+    record->loudness_range = openmpt_bridge_index_get_double(db, OPENMPT_BRIDGE_INDEX_COLUMN_LOUDNESS_RANGE, row);
+    record->true_peak = openmpt_bridge_index_get_double(db, OPENMPT_BRIDGE_INDEX_COLUMN_TRUE_PEAK, row);
+    record->analysis_failed = (uint32_t)openmpt_bridge_index_get_uint(db, OPENMPT_BRIDGE_INDEX_COLUMN_ANALYSIS_FAILED, row);
+
+    // Modules indexed before loudness or fingerprints were asked for are loaded again
+    if (openmpt_bridge_index_get_uint(db, OPENMPT_BRIDGE_INDEX_COLUMN_STATUS, row) == OPENMPT_BRIDGE_INDEX_STATUS_OK && options) {
+        if (options->measure_loudness && index_needs_loudness(record)) return 0;
+        if (options->fingerprint && index_needs_fingerprint(record)) return 0;
+    }
+
+    record->status = (uint32_t)openmpt_bridge_index_get_uint(db, OPENMPT_BRIDGE_INDEX_COLUMN_STATUS, row);
+    record->content_hash = openmpt_bridge_index_get_uint(db, OPENMPT_BRIDGE_INDEX_COLUMN_CONTENT_HASH, row);
+    record->title = strdup(openmpt_bridge_index_get_string(db, OPENMPT_BRIDGE_INDEX_COLUMN_TITLE, row));
+    record->artist = strdup(openmpt_bridge_index_get_string(db, OPENMPT_BRIDGE_INDEX_COLUMN_ARTIST, row));
+    record->type = strdup(openmpt_bridge_index_get_string(db, OPENMPT_BRIDGE_INDEX_COLUMN_TYPE, row));
+    record->tracker = strdup(openmpt_bridge_index_get_string(db, OPENMPT_BRIDGE_INDEX_COLUMN_TRACKER, row));
+    record->duration = openmpt_bridge_index_get_double(db, OPENMPT_BRIDGE_INDEX_COLUMN_DURATION, row);
+    record->channels = (uint32_t)openmpt_bridge_index_get_uint(db, OPENMPT_BRIDGE_INDEX_COLUMN_CHANNELS, row);
+    record->patterns = (uint32_t)openmpt_bridge_index_get_uint(db, OPENMPT_BRIDGE_INDEX_COLUMN_PATTERNS, row);
+    record->instruments = (uint32_t)openmpt_bridge_index_get_uint(db, OPENMPT_BRIDGE_INDEX_COLUMN_INSTRUMENTS, row);
+    record->samples = (uint32_t)openmpt_bridge_index_get_uint(db, OPENMPT_BRIDGE_INDEX_COLUMN_SAMPLES, row);
+    record->reused = 1;
+    return 1;
+}
+
+// MARK: - Processing
+
+typedef struct index_job {
+    const char* root;
+    index_record* records;
+    size_t* pending;
+    size_t pending_count;
+    uint64_t total;
+    atomic_uint_fast64_t done;
+    const openmpt_bridge_index_options* options;
+} index_job;
+
+static const openmpt_module_initial_ctl index_load_ctls[] = {
+    { "load.skip_samples", "1" },
+    { "load.skip_plugins", "1" },
+    { NULL, NULL }
+};
+
+static void index_measure_loudness(openmpt_module* mod, index_record* record) {
+    openmpt_bridge_loudness loudness;
+    if (!bridge_loudness_render(mod, &loudness)) {
+        record->analysis_failed |= OPENMPT_BRIDGE_INDEX_ANALYSIS_LOUDNESS;
+        return;
+    }
+    record->loudness_measured = 1;
+    record->loudness = loudness.integrated_lufs;
+    record->loudness_range = loudness.loudness_range_lu;
+    record->true_peak = loudness.true_peak_dbtp;
+}
+
+static void index_fingerprint(openmpt_module* mod, index_record* record) {
+    uint32_t* hashes = malloc(OPENMPT_BRIDGE_FINGERPRINT_MAX_HASHES * sizeof(*hashes));
+    if (!hashes) return;
+    size_t count = bridge_fingerprint_render(mod, hashes, OPENMPT_BRIDGE_FINGERPRINT_MAX_HASHES);
+    if (!count) {
+        record->analysis_failed |= OPENMPT_BRIDGE_INDEX_ANALYSIS_FINGERPRINT;
+        free(hashes);
+        return;
+    }
+    record->fingerprint = hashes;
+    record->fingerprint_count = (uint32_t)count;
+}
+
+static void index_probe_and_load(const char* path, index_record* record, const openmpt_bridge_index_options* options) {
+    // Analyses carried over from the previous run are not repeated
+    int measure_loudness = options && options->measure_loudness && index_needs_loudness(record);
+    int fingerprint = options && options->fingerprint && index_needs_fingerprint(record);
+    record->status = OPENMPT_BRIDGE_INDEX_STATUS_FAILED;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+
+    // Read just the probe window first so non-modules cost one small read
+    size_t length = (size_t)record->size;
+    unsigned char* data = malloc(length ? length : 1);
+    if (!data) {
+        close(fd);
+        return;
+    }
+    size_t header = openmpt_probe_file_header_get_recommended_size();
+    if (header > length) header = length;
+    size_t got = 0;
+    while (got < header) {
+        ssize_t n = read(fd, data + got, header - got);
+        if (n <= 0) break;
+        got += (size_t)n;
+    }
+
+    int probe = got == header
+        ? openmpt_probe_file_header(OPENMPT_PROBE_FILE_HEADER_FLAGS_DEFAULT, data, header, record->size,
+                                    (void*)openmpt_log_func_silent, NULL, NULL, NULL, NULL, NULL)
+        : OPENMPT_PROBE_FILE_HEADER_RESULT_ERROR;
+    if (probe == OPENMPT_PROBE_FILE_HEADER_RESULT_FAILURE) {
+        record->status = OPENMPT_BRIDGE_INDEX_STATUS_REJECTED;
+    }
+    if (probe != OPENMPT_PROBE_FILE_HEADER_RESULT_SUCCESS && probe != OPENMPT_PROBE_FILE_HEADER_RESULT_WANTMOREDATA) {
+        close(fd);
+        free(data);
+        return;
+    }
+
+    while (got < length) {
+        ssize_t n = read(fd, data + got, length - got);
+        if (n <= 0) break;
+        got += (size_t)n;
+    }
+    close(fd);
+    if (got != length) {
+        free(data);
+        return;
+    }
+
+    record->content_hash = bridge_hash64(data, length, 0);
+
+    int error = 0;
+    // Rendering needs the samples, so those modules load in full
+    int render = measure_loudness || fingerprint;
+    openmpt_module* mod = openmpt_module_create_from_memory2(data, length, (void*)openmpt_log_func_silent, NULL,
+                                                             NULL, NULL, &error, NULL, render ? NULL : index_load_ctls);
+    free(data);
+    if (!mod) return;
+
+    record->title = bridge_copy_metadata(mod, "title");
+    record->artist = bridge_copy_metadata(mod, "artist");
+    record->type = bridge_copy_metadata(mod, "type");
+    record->tracker = bridge_copy_metadata(mod, "tracker");
+    record->duration = openmpt_module_get_duration_seconds(mod);
+    record->channels = (uint32_t)openmpt_module_get_num_channels(mod);
+    record->patterns = (uint32_t)openmpt_module_get_num_patterns(mod);
+    record->instruments = (uint32_t)openmpt_module_get_num_instruments(mod);
+    record->samples = (uint32_t)openmpt_module_get_num_samples(mod);
+    record->status = OPENMPT_BRIDGE_INDEX_STATUS_OK;
+    if (measure_loudness) index_measure_loudness(mod, record);
+    if (fingerprint) {
+        // Fingerprinting drops to low-quality rendering, so it goes last
+        if (measure_loudness) openmpt_module_set_position_seconds(mod, 0.0);
+        index_fingerprint(mod, record);
+    }
+    openmpt_module_destroy(mod);
+}
+
+static void index_process(void* ctx, size_t index, int worker) {
+    (void)worker;
+    index_job* job = (index_job*)ctx;
+    index_record* record = &job->records[job->pending[index]];
+
+    char* full_path = index_join_path(job->root, record->path);
+    if (full_path) {
+        index_probe_and_load(full_path, record, job->options);
+        free(full_path);
+    } else {
+        record->status = OPENMPT_BRIDGE_INDEX_STATUS_FAILED;
+    }
+
+    uint64_t done = atomic_fetch_add_explicit(&job->done, 1, memory_order_relaxed) + 1;
+    if (job->options && job->options->progress) {
+        job->options->progress(job->options->progress_user, done, job->total);
+    }
+}
+
+// MARK: - Writer
+
+static const char* index_record_string(const index_record* record, int column) {
+    const char* value = NULL;
+    switch (column) {
+    case OPENMPT_BRIDGE_INDEX_COLUMN_PATH: value = record->path; break;
+    case OPENMPT_BRIDGE_INDEX_COLUMN_TITLE: value = record->title; break;
+    case OPENMPT_BRIDGE_INDEX_COLUMN_ARTIST: value = record->artist; break;
+    case OPENMPT_BRIDGE_INDEX_COLUMN_TYPE: value = record->type; break;
+    case OPENMPT_BRIDGE_INDEX_COLUMN_TRACKER: value = record->tracker; break;
+    default: break;
+    }
+    return value ? value : "";
+}
+
+static const void* index_record_blob(const index_record* record, int column, size_t* size) {
+    switch (column) {
+    case OPENMPT_BRIDGE_INDEX_COLUMN_FINGERPRINT:
+        *size = (size_t)record->fingerprint_count * sizeof(uint32_t);
+        return record->fingerprint;
+    default:
+        *size = 0;
+        return NULL;
+    }
+}
+
+static void index_record_fixed(const index_record* record, int column, unsigned char* out) {
+    switch (column) {
+    case OPENMPT_BRIDGE_INDEX_COLUMN_SIZE: memcpy(out, &record->size, 8); break;
+    case OPENMPT_BRIDGE_INDEX_COLUMN_MTIME: memcpy(out, &record->mtime, 8); break;
+    case OPENMPT_BRIDGE_INDEX_COLUMN_STATUS: memcpy(out, &record->status, 4); break;
+    case OPENMPT_BRIDGE_INDEX_COLUMN_CONTENT_HASH: memcpy(out, &record->content_hash, 8); break;
+    case OPENMPT_BRIDGE_INDEX_COLUMN_DURATION: memcpy(out, &record->duration, 8); break;
+    case OPENMPT_BRIDGE_INDEX_COLUMN_CHANNELS: memcpy(out, &record->channels, 4); break;
+    case OPENMPT_BRIDGE_INDEX_COLUMN_PATTERNS: memcpy(out, &record->patterns, 4); break;
+    case OPENMPT_BRIDGE_INDEX_COLUMN_INSTRUMENTS: memcpy(out, &record->instruments, 4); break;
+    case OPENMPT_BRIDGE_INDEX_COLUMN_SAMPLES: memcpy(out, &record->samples, 4); break;
+    case OPENMPT_BRIDGE_INDEX_COLUMN_LOUDNESS_MEASURED: memcpy(out, &record->loudness_measured, 4); break;
+    case OPENMPT_BRIDGE_INDEX_COLUMN_LOUDNESS: memcpy(out, &record->loudness, 8); break;
+    case OPENMPT_BRIDGE_INDEX_COLUMN_LOUDNESS_RANGE: memcpy(out, &record->loudness_range, 8); break;
+    case OPENMPT_BRIDGE_INDEX_COLUMN_TRUE_PEAK: memcpy(out, &record->true_peak, 8); break;
+    case OPENMPT_BRIDGE_INDEX_COLUMN_ANALYSIS_FAILED: memcpy(out, &record->analysis_failed, 4); break;
+    default: break;
+    }
+}
+
+static int index_write(const char* database_path, const index_record* records, size_t count) {
+    index_directory_entry directory[OPENMPT_BRIDGE_INDEX_COLUMN_COUNT];
+    size_t offset = index_align8(sizeof(index_header) + sizeof(directory));
+
+    // Lay out columns first so the whole file is written with one allocation
+    for (int column = 0; column < OPENMPT_BRIDGE_INDEX_COLUMN_COUNT; column++) {
+        uint32_t kind = index_columns[column].kind;
+        size_t size = count * index_kind_width(kind);
+        if (kind == OPENMPT_BRIDGE_INDEX_KIND_STRING) {
+            for (size_t i = 0; i < count; i++) size += strlen(index_record_string(&records[i], column)) + 1;
+            if (size - count * 4 > UINT32_MAX) return 0;
+        } else if (kind == OPENMPT_BRIDGE_INDEX_KIND_BLOB) {
+            for (size_t i = 0; i < count; i++) {
+                size_t blob_size = 0;
+                index_record_blob(&records[i], column, &blob_size);
+                size = index_align4(size + blob_size);
+            }
+            if (size - count * 8 > UINT32_MAX) return 0;
+        }
+        directory[column].id = (uint32_t)column;
+        directory[column].kind = kind;
+        directory[column].offset = offset;
+        directory[column].size = size;
+        offset = index_align8(offset + size);
+    }
+
+    unsigned char* buffer = calloc(1, offset);
+    if (!buffer) return 0;
+
+    index_header header;
+    memcpy(header.magic, openmpt_bridge_index_magic, sizeof(header.magic));
+    header.version = OPENMPT_BRIDGE_INDEX_VERSION;
+    header.column_count = OPENMPT_BRIDGE_INDEX_COLUMN_COUNT;
+    header.row_count = count;
+    memcpy(buffer, &header, sizeof(header));
+    memcpy(buffer + sizeof(header), directory, sizeof(directory));
+
+    for (int column = 0; column < OPENMPT_BRIDGE_INDEX_COLUMN_COUNT; column++) {
+        unsigned char* base = buffer + directory[column].offset;
+        if (directory[column].kind == OPENMPT_BRIDGE_INDEX_KIND_STRING) {
+            char* pool = (char*)base + count * 4;
+            uint32_t pool_offset = 0;
+            for (size_t i = 0; i < count; i++) {
+                const char* value = index_record_string(&records[i], column);
+                size_t length = strlen(value) + 1;
+                memcpy(base + i * 4, &pool_offset, 4);
+                memcpy(pool + pool_offset, value, length);
+                pool_offset += (uint32_t)length;
+            }
+        } else if (directory[column].kind == OPENMPT_BRIDGE_INDEX_KIND_BLOB) {
+            unsigned char* pool = base + count * 8;
+            uint32_t span[2] = { 0, 0 };
+            for (size_t i = 0; i < count; i++) {
+                size_t blob_size = 0;
+                const void* blob = index_record_blob(&records[i], column, &blob_size);
+                span[1] = (uint32_t)blob_size;
+                memcpy(base + i * 8, span, sizeof(span));
+                if (blob_size) memcpy(pool + span[0], blob, blob_size);
+                span[0] = (uint32_t)index_align4(span[0] + blob_size);
+            }
+        } else {
+            size_t width = index_kind_width(directory[column].kind);
+            for (size_t i = 0; i < count; i++) index_record_fixed(&records[i], column, base + i * width);
+        }
+    }
+
+    int ok = bridge_write_file_atomic(database_path, buffer, offset);
+    free(buffer);
+    return ok;
+}
+
+// MARK: - Build
+
+int openmpt_bridge_index_build(const char* root, const char* database_path, const openmpt_bridge_index_options* options, openmpt_bridge_index_summary* summary) {
+    if (!root || !database_path) return 0;
+    double start = bridge_now_seconds();
+
+    index_record_list list = { 0 };
+    if (!index_walk(root, "", &list)) {
+        for (size_t i = 0; i < list.count; i++) index_record_free(&list.items[i]);
+        free(list.items);
+        return 0;
+    }
+
+    index_previous previous;
+    memset(&previous, 0, sizeof(previous));
+    if (!options || !options->full_rebuild) index_previous_load(&previous, database_path);
+
+    size_t* pending = malloc((list.count ? list.count : 1) * sizeof(*pending));
+    if (!pending) {
+        index_previous_free(&previous);
+        for (size_t i = 0; i < list.count; i++) index_record_free(&list.items[i]);
+        free(list.items);
+        return 0;
+    }
+
+    size_t pending_count = 0;
+    for (size_t i = 0; i < list.count; i++) {
+        int64_t row = index_previous_find(&previous, list.items[i].path);
+        if (row < 0 || !index_reuse(&list.items[i], previous.index, (uint64_t)row, options)) {
+            pending[pending_count++] = i;
+        }
+    }
+    // Reused strings were copied, so the old mapping can go before rewriting
+    index_previous_free(&previous);
+
+    index_job job;
+    job.root = root;
+    job.records = list.items;
+    job.pending = pending;
+    job.pending_count = pending_count;
+    job.total = pending_count;
+    atomic_init(&job.done, 0);
+    job.options = options;
+    bridge_parallel_for(pending_count, options ? options->thread_count : 0, index_process, &job);
+    free(pending);
+
+    if (list.count > 1) qsort(list.items, list.count, sizeof(*list.items), index_record_compare);
+    int ok = index_write(database_path, list.items, list.count);
+
+    if (summary) {
+        memset(summary, 0, sizeof(*summary));
+        summary->files_scanned = list.count;
+        for (size_t i = 0; i < list.count; i++) {
+            const index_record* record = &list.items[i];
+            if (record->reused) summary->files_reused++;
+            else if (record->status == OPENMPT_BRIDGE_INDEX_STATUS_OK) summary->files_indexed++;
+            else if (record->status == OPENMPT_BRIDGE_INDEX_STATUS_REJECTED) summary->files_rejected++;
+            else summary->files_failed++;
+        }
+        summary->seconds = bridge_now_seconds() - start;
+    }
+
+    for (size_t i = 0; i < list.count; i++) index_record_free(&list.items[i]);
+    free(list.items);
+    return ok;
+}
@@ -0,0 +1,335 @@
+// openmpt_bridge_interactive.c
+// Preview notes, channel mix and tempo/pitch through libopenmpt's ext interactive interface
+
+#include "openmpt_bridge_interactive.h"
+#include "bridge_internal.h"
+#include "bridge_module_internal.h"
+
+// Highest note play_note accepts (B-9)
+#define BRIDGE_NOTE_MAX 119
+
+// MARK: - Render thread
+
+static void bridge_channel_init(bridge_channel* channel, unsigned flags, double volume, double panning) {
+    atomic_store_explicit(&channel->flags, flags, memory_order_relaxed);
+    atomic_store_explicit(&channel->volume, bridge_double_bits(volume), memory_order_relaxed);
+    atomic_store_explicit(&channel->panning, bridge_double_bits(panning), memory_order_relaxed);
+    channel->applied_flags = flags;
+    channel->muted = (flags & BRIDGE_CHANNEL_MUTE) != 0;
+}
+
+void bridge_interactive_init(bridge_interactive* interactive) {
+    interactive->available = 0;
+    interactive->available2 = 0;
+    interactive->instruments = 0;
+    interactive->channels = 0;
+    atomic_init(&interactive->next_voice, 0);
+    for (int i = 0; i < OPENMPT_BRIDGE_JAM_VOICES; i++) interactive->voices[i] = -1;
+    for (int i = 0; i < OPENMPT_BRIDGE_MAX_CHANNELS; i++) {
+        atomic_init(&interactive->mix[i].flags, 0);
+        atomic_init(&interactive->mix[i].volume, bridge_double_bits(1.0));
+        atomic_init(&interactive->mix[i].panning, bridge_double_bits(0.0));
+        interactive->mix[i].applied_flags = 0;
+        interactive->mix[i].muted = 0;
+    }
+    atomic_init(&interactive->tempo_factor, bridge_double_bits(1.0));
+    atomic_init(&interactive->pitch_factor, bridge_double_bits(1.0));
+}
+
+void bridge_interactive_reset(openmpt_bridge_module* handle) {
+    bridge_interactive* interactive = &handle->interactive;
+    interactive->available = 0;
+    interactive->available2 = 0;
+    interactive->instruments = 0;
+    interactive->channels = 0;
+    for (int i = 0; i < OPENMPT_BRIDGE_JAM_VOICES; i++) interactive->voices[i] = -1;
+    atomic_store_explicit(&interactive->tempo_factor, bridge_double_bits(1.0), memory_order_relaxed);
+    atomic_store_explicit(&interactive->pitch_factor, bridge_double_bits(1.0), memory_order_relaxed);
+    if (!handle->mod_ext) return;
+
+    interactive->available = openmpt_module_ext_get_interface(handle->mod_ext, LIBOPENMPT_EXT_C_INTERFACE_INTERACTIVE,
+                                                              &interactive->interactive, sizeof(interactive->interactive));
+    interactive->available2 = openmpt_module_ext_get_interface(handle->mod_ext, LIBOPENMPT_EXT_C_INTERFACE_INTERACTIVE2,
+                                                               &interactive->interactive2, sizeof(interactive->interactive2));
+    int32_t instruments = openmpt_module_get_num_instruments(handle->mod);
+    interactive->instruments = instruments > 0 ? instruments : openmpt_module_get_num_samples(handle->mod);
+    if (!interactive->available) return;
+
+    // Initial ctls may have set play.tempo_factor or play.pitch_factor
+    double tempo_factor = interactive->interactive.get_tempo_factor(handle->mod_ext);
+    double pitch_factor = interactive->interactive.get_pitch_factor(handle->mod_ext);
+    atomic_store_explicit(&interactive->tempo_factor, bridge_double_bits(tempo_factor), memory_order_relaxed);
+    atomic_store_explicit(&interactive->pitch_factor, bridge_double_bits(pitch_factor), memory_order_relaxed);
+
+    // Start from the mix the module was saved with
+    int32_t channels = openmpt_module_get_num_channels(handle->mod);
+    if (channels > OPENMPT_BRIDGE_MAX_CHANNELS) channels = OPENMPT_BRIDGE_MAX_CHANNELS;
+    interactive->channels = channels > 0 ? channels : 0;
+    for (int32_t c = 0; c < interactive->channels; c++) {
+        int mute = interactive->interactive.get_channel_mute_status(handle->mod_ext, c) == 1;
+        double volume = interactive->interactive.get_channel_volume(handle->mod_ext, c);
+        double panning = interactive->available2 ? interactive->interactive2.get_channel_panning(handle->mod_ext, c) : 0.0;
+        bridge_channel_init(&interactive->mix[c], mute ? BRIDGE_CHANNEL_MUTE : 0, volume, panning);
+    }
+}
+
+static void bridge_interactive_stop(openmpt_bridge_module* handle, int voice, int release) {
+    bridge_interactive* interactive = &handle->interactive;
+    int32_t channel = interactive->voices[voice];
+    if (channel < 0) return;
+    interactive->voices[voice] = -1;
+    if (release && interactive->available2) {
+        interactive->interactive2.note_off(handle->mod_ext, channel);
+    } else {
+        interactive->interactive.stop_note(handle->mod_ext, channel);
+    }
+}
+
+static void bridge_interactive_play(openmpt_bridge_module* handle, const bridge_command* command) {
+    bridge_interactive* interactive = &handle->interactive;
+    int voice = command->param;
+    // The voice id came round again: its previous note is stolen
+    bridge_interactive_stop(handle, voice, 0);
+    int32_t channel = interactive->interactive.play_note(handle->mod_ext, command->value, command->note,
+                                                         command->volume, command->panning);
+    if (channel < 0) return;
+    // libopenmpt reuses background channels once a note has died away, so
+    // an older voice may still point at this channel
+    for (int i = 0; i < OPENMPT_BRIDGE_JAM_VOICES; i++) {
+        if (interactive->voices[i] == channel) interactive->voices[i] = -1;
+    }
+    interactive->voices[voice] = channel;
+}
+
+// Set or clear a mute or solo flag, then bring libopenmpt's mute status in
+// line with every channel's flags, touching only channels that change
+static void bridge_interactive_apply_mutes(openmpt_bridge_module* handle, int32_t channel_index, unsigned flag, int set) {
+    bridge_interactive* interactive = &handle->interactive;
+    int32_t first = channel_index < 0 ? 0 : channel_index;
+    int32_t last = channel_index < 0 ? interactive->channels : channel_index + 1;
+    for (int32_t c = first; c < last && c < interactive->channels; c++) {
+        if (set) interactive->mix[c].applied_flags |= flag;
+        else interactive->mix[c].applied_flags &= ~flag;
+    }
+
+    int soloing = 0;
+    for (int32_t c = 0; c < interactive->channels; c++) {
+        if (interactive->mix[c].applied_flags & BRIDGE_CHANNEL_SOLO) soloing = 1;
+    }
+    for (int32_t c = 0; c < interactive->channels; c++) {
+        bridge_channel* channel = &interactive->mix[c];
+        unsigned flags = channel->applied_flags;
+        int muted = (flags & BRIDGE_CHANNEL_MUTE) || (soloing && !(flags & BRIDGE_CHANNEL_SOLO));
+        if (muted == channel->muted) continue;
+        if (interactive->interactive.set_channel_mute_status(handle->mod_ext, c, muted)) channel->muted = muted;
+    }
+}
+
+void bridge_interactive_apply(openmpt_bridge_module* handle, const bridge_command* command) {
+    bridge_interactive* interactive = &handle->interactive;
+    if (!handle->mod_ext || !interactive->available) return;
+    switch (command->kind) {
+    case BRIDGE_COMMAND_PLAY_NOTE:
+        bridge_interactive_play(handle, command);
+        break;
+    case BRIDGE_COMMAND_STOP_NOTE:
+    case BRIDGE_COMMAND_NOTE_OFF: {
+        int release = command->kind == BRIDGE_COMMAND_NOTE_OFF;
+        if (command->param >= 0) {
+            bridge_interactive_stop(handle, command->param, release);
+        } else {
+            for (int i = 0; i < OPENMPT_BRIDGE_JAM_VOICES; i++) bridge_interactive_stop(handle, i, release);
+        }
+        break;
+    }
+    case BRIDGE_COMMAND_CHANNEL_MUTE:
+        bridge_interactive_apply_mutes(handle, command->param, BRIDGE_CHANNEL_MUTE, command->value);
+        break;
+    case BRIDGE_COMMAND_CHANNEL_SOLO:
+        bridge_interactive_apply_mutes(handle, command->param, BRIDGE_CHANNEL_SOLO, command->value);
+        break;
+    case BRIDGE_COMMAND_CHANNEL_VOLUME:
+        interactive->interactive.set_channel_volume(handle->mod_ext, command->param, command->volume);
+        break;
+    case BRIDGE_COMMAND_CHANNEL_PANNING:
+        if (interactive->available2) {
+            interactive->interactive2.set_channel_panning(handle->mod_ext, command->param, command->panning);
+        }
+        break;
+    case BRIDGE_COMMAND_TEMPO_FACTOR:
+        interactive->interactive.set_tempo_factor(handle->mod_ext, command->factor);
+        break;
+    case BRIDGE_COMMAND_PITCH_FACTOR:
+        interactive->interactive.set_pitch_factor(handle->mod_ext, command->factor);
+        break;
+    default:
+        break;
+    }
+}
+
+// MARK: - Public API
+
+// Apply now, or queue for the render thread in real-time mode
+static int bridge_interactive_submit(openmpt_bridge_module* handle, const bridge_command* command) {
+    if (openmpt_bridge_module_is_realtime(handle)) return bridge_commands_submit(handle, command);
+    bridge_interactive_apply(handle, command);
+    return 1;
+}
+
+static double bridge_clamp(double value, double low, double high) {
+    if (!(value >= low)) return low;
+    return value > high ? high : value;
+}
+
+int openmpt_bridge_module_is_interactive(const openmpt_bridge_module* handle) {
+    return handle && handle->mod && handle->interactive.available;
+}
+
+int32_t openmpt_bridge_module_play_note(openmpt_bridge_module* handle, int32_t instrument, int32_t note, double volume, double panning) {
+    if (!openmpt_bridge_module_is_interactive(handle)) return -1;
+    if (instrument < 0 || instrument >= handle->interactive.instruments) return -1;
+    if (note < 0 || note > BRIDGE_NOTE_MAX) return -1;
+
+    unsigned ticket = atomic_fetch_add_explicit(&handle->interactive.next_voice, 1, memory_order_relaxed);
+    int32_t voice = (int32_t)(ticket % OPENMPT_BRIDGE_JAM_VOICES);
+    bridge_command command = {
+        .kind = BRIDGE_COMMAND_PLAY_NOTE,
+        .param = voice,
+        .value = instrument,
+        .note = note,
+        .volume = bridge_clamp(volume, 0.0, 1.0),
+        .panning = bridge_clamp(panning, -1.0, 1.0),
+    };
+    return bridge_interactive_submit(handle, &command) ? voice : -1;
+}
+
+int openmpt_bridge_module_stop_note(openmpt_bridge_module* handle, int32_t voice) {
+    if (!openmpt_bridge_module_is_interactive(handle)) return 0;
+    if (voice < -1 || voice >= OPENMPT_BRIDGE_JAM_VOICES) return 0;
+    bridge_command command = { .kind = BRIDGE_COMMAND_STOP_NOTE, .param = voice };
+    return bridge_interactive_submit(handle, &command);
+}
+
+int openmpt_bridge_module_note_off(openmpt_bridge_module* handle, int32_t voice) {
+    if (!openmpt_bridge_module_is_interactive(handle)) return 0;
+    if (voice < -1 || voice >= OPENMPT_BRIDGE_JAM_VOICES) return 0;
+    bridge_command command = { .kind = BRIDGE_COMMAND_NOTE_OFF, .param = voice };
+    return bridge_interactive_submit(handle, &command);
+}
+
+// MARK: - Channel mix
+
+static int bridge_channel_valid(const openmpt_bridge_module* handle, int32_t channel) {
+    return openmpt_bridge_module_is_interactive(handle) && channel >= 0 && channel < handle->interactive.channels;
+}
+
+static int bridge_channel_set_flag(openmpt_bridge_module* handle, int32_t channel, unsigned flag, int set) {
+    if (!openmpt_bridge_module_is_interactive(handle)) return 0;
+    if (channel < -1 || channel >= handle->interactive.channels) return 0;
+    // The command carries the change, so the render thread never sees flags
+    // of a request the queue turned down
+    bridge_command command = {
+        .kind = flag == BRIDGE_CHANNEL_SOLO ? BRIDGE_COMMAND_CHANNEL_SOLO : BRIDGE_COMMAND_CHANNEL_MUTE,
+        .param = channel,
+        .value = set != 0,
+    };
+    if (!bridge_interactive_submit(handle, &command)) return 0;
+
+    int32_t first = channel < 0 ? 0 : channel;
+    int32_t last = channel < 0 ? handle->interactive.channels : channel + 1;
+    for (int32_t c = first; c < last; c++) {
+        atomic_uint* flags = &handle->interactive.mix[c].flags;
+        if (set) {
+            atomic_fetch_or_explicit(flags, flag, memory_order_relaxed);
+        } else {
+            atomic_fetch_and_explicit(flags, ~flag, memory_order_relaxed);
+        }
+    }
+    return 1;
+}
+
+static int bridge_channel_get_flag(const openmpt_bridge_module* handle, int32_t channel, unsigned flag) {
+    if (!bridge_channel_valid(handle, channel)) return 0;
+    return (bridge_atomic_load_uint(&handle->interactive.mix[channel].flags, memory_order_relaxed) & flag) != 0;
+}
+
+int openmpt_bridge_module_set_channel_mute(openmpt_bridge_module* handle, int32_t channel, int mute) {
+    return bridge_channel_set_flag(handle, channel, BRIDGE_CHANNEL_MUTE, mute);
+}
+
+int openmpt_bridge_module_get_channel_mute(const openmpt_bridge_module* handle, int32_t channel) {
+    return bridge_channel_get_flag(handle, channel, BRIDGE_CHANNEL_MUTE);
+}
+
+int openmpt_bridge_module_set_channel_solo(openmpt_bridge_module* handle, int32_t channel, int solo) {
+    return bridge_channel_set_flag(handle, channel, BRIDGE_CHANNEL_SOLO, solo);
+}
+
+int openmpt_bridge_module_get_channel_solo(const openmpt_bridge_module* handle, int32_t channel) {
+    return bridge_channel_get_flag(handle, channel, BRIDGE_CHANNEL_SOLO);
+}
+
+int openmpt_bridge_module_set_channel_volume(openmpt_bridge_module* handle, int32_t channel, double volume) {
+    if (!bridge_channel_valid(handle, channel)) return 0;
+    volume = bridge_clamp(volume, 0.0, 1.0);
+    bridge_command command = { .kind = BRIDGE_COMMAND_CHANNEL_VOLUME, .param = channel, .volume = volume };
+    if (!bridge_interactive_submit(handle, &command)) return 0;
+    atomic_store_explicit(&handle->interactive.mix[channel].volume, bridge_double_bits(volume), memory_order_relaxed);
+    return 1;
+}
+
+double openmpt_bridge_module_get_channel_volume(const openmpt_bridge_module* handle, int32_t channel) {
+    if (!bridge_channel_valid(handle, channel)) return 0.0;
+    return bridge_bits_double(bridge_atomic_load_u64(&handle->interactive.mix[channel].volume, memory_order_relaxed));
+}
+
+int openmpt_bridge_module_set_channel_panning(openmpt_bridge_module* handle, int32_t channel, double panning) {
+    if (!bridge_channel_valid(handle, channel) || !handle->interactive.available2) return 0;
+    panning = bridge_clamp(panning, -1.0, 1.0);
+    bridge_command command = { .kind = BRIDGE_COMMAND_CHANNEL_PANNING, .param = channel, .panning = panning };
+    if (!bridge_interactive_submit(handle, &command)) return 0;
+    atomic_store_explicit(&handle->interactive.mix[channel].panning, bridge_double_bits(panning), memory_order_relaxed);
+    return 1;
+}
+
+double openmpt_bridge_module_get_channel_panning(const openmpt_bridge_module* handle, int32_t channel) {
+    if (!bridge_channel_valid(handle, channel)) return 0.0;
+    return bridge_bits_double(bridge_atomic_load_u64(&handle->interactive.mix[channel].panning, memory_order_relaxed));
+}
+
+// MARK: - Tempo and pitch
+
+static int bridge_factor_set(openmpt_bridge_module* handle, atomic_uint_fast64_t* requested,
+                             bridge_command_kind kind, double factor) {
+    if (!openmpt_bridge_module_is_interactive(handle)) return 0;
+    if (!(factor > 0.0 && factor <= OPENMPT_BRIDGE_MAX_FACTOR)) return 0;
+    bridge_command command = { .kind = kind, .factor = factor };
+    if (!bridge_interactive_submit(handle, &command)) return 0;
+    atomic_store_explicit(requested, bridge_double_bits(factor), memory_order_relaxed);
+    return 1;
+}
+
+static double bridge_factor_get(const openmpt_bridge_module* handle, const atomic_uint_fast64_t* requested) {
+    if (!openmpt_bridge_module_is_interactive(handle)) return 1.0;
+    return bridge_bits_double(bridge_atomic_load_u64(requested, memory_order_relaxed));
+}
+
+int openmpt_bridge_module_set_tempo_factor(openmpt_bridge_module* handle, double factor) {
+    if (!handle) return 0;
+    return bridge_factor_set(handle, &handle->interactive.tempo_factor, BRIDGE_COMMAND_TEMPO_FACTOR, factor);
+}
+
+double openmpt_bridge_module_get_tempo_factor(const openmpt_bridge_module* handle) {
+    if (!handle) return 1.0;
+    return bridge_factor_get(handle, &handle->interactive.tempo_factor);
+}
+
+int openmpt_bridge_module_set_pitch_factor(openmpt_bridge_module* handle, double factor) {
+    if (!handle) return 0;
+    return bridge_factor_set(handle, &handle->interactive.pitch_factor, BRIDGE_COMMAND_PITCH_FACTOR, factor);
+}
+
+double openmpt_bridge_module_get_pitch_factor(const openmpt_bridge_module* handle) {
+    if (!handle) return 1.0;
+    return bridge_factor_get(handle, &handle->interactive.pitch_factor);
+}
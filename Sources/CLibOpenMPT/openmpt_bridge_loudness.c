@@ -0,0 +1,355 @@
+// openmpt_bridge_loudness.c
+// BS.1770-4 K-weighting, gated integrated loudness, loudness range and oversampled true peak
+
+#include "openmpt_bridge_loudness.h"
+#include "bridge_internal.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BRIDGE_LOUDNESS_MOMENTARY_STEPS 4       // 400 ms
+#define BRIDGE_LOUDNESS_SHORT_TERM_STEPS 30     // 3 s
+#define BRIDGE_LOUDNESS_ABSOLUTE_GATE -70.0
+#define BRIDGE_LOUDNESS_RELATIVE_GATE -10.0
+#define BRIDGE_LOUDNESS_RANGE_GATE -20.0
+#define BRIDGE_LOUDNESS_PEAK_TAPS 12            // per oversampling phase
+#define BRIDGE_LOUDNESS_MAX_FACTOR 4
+#define BRIDGE_LOUDNESS_MEASURE_RATE 48000
+#define BRIDGE_LOUDNESS_MEASURE_BLOCK 4096
+
+typedef struct bridge_biquad {
+    double b0, b1, b2, a1, a2;
+} bridge_biquad;
+
+typedef struct bridge_energy_list {
+    double* values;
+    size_t count;
+    size_t capacity;
+} bridge_energy_list;
+
+struct openmpt_bridge_loudness_meter {
+    int32_t sample_rate;
+    size_t step_frames;                 // frames per 100 ms step
+    bridge_biquad shelf;
+    bridge_biquad highpass;
+    double state[2][4];                 // per channel: shelf z1, z2, highpass z1, z2
+
+    double step_energy;                 // K-weighted sum of squares of the current step
+    size_t step_filled;
+    double recent[BRIDGE_LOUDNESS_SHORT_TERM_STEPS]; // energies of the last steps, newest at recent_next - 1
+    size_t recent_next;
+    uint64_t steps;
+
+    bridge_energy_list momentary;       // mean square of every 400 ms block, one per step
+    bridge_energy_list short_term;      // mean square of every 3 s window, one per step
+
+    int factor;                         // true peak oversampling
+    float peak_filter[BRIDGE_LOUDNESS_MAX_FACTOR][BRIDGE_LOUDNESS_PEAK_TAPS];
+    float history[2][BRIDGE_LOUDNESS_PEAK_TAPS * 2]; // doubled so a window is always contiguous
+    size_t history_next;
+    float true_peak;
+    float sample_peak;
+    uint64_t frames;
+};
+
+// MARK: - Filters
+
+// K-weighting as a high shelf followed by the RLB high-pass, with the
+// BS.1770 analogue prototypes mapped to the meter's rate
+static void bridge_loudness_design(openmpt_bridge_loudness_meter* meter) {
+    double rate = meter->sample_rate;
+
+    double f0 = 1681.974450955533, gain_db = 3.999843853973347, q = 0.7071752369554196;
+    double k = tan(M_PI * f0 / rate);
+    double vh = pow(10.0, gain_db / 20.0);
+    double vb = pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    meter->shelf.b0 = (vh + vb * k / q + k * k) / a0;
+    meter->shelf.b1 = 2.0 * (k * k - vh) / a0;
+    meter->shelf.b2 = (vh - vb * k / q + k * k) / a0;
+    meter->shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+    meter->shelf.a2 = (1.0 - k / q + k * k) / a0;
+
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = tan(M_PI * f0 / rate);
+    a0 = 1.0 + k / q + k * k;
+    meter->highpass.b0 = 1.0;
+    meter->highpass.b1 = -2.0;
+    meter->highpass.b2 = 1.0;
+    meter->highpass.a1 = 2.0 * (k * k - 1.0) / a0;
+    meter->highpass.a2 = (1.0 - k / q + k * k) / a0;
+
+    // Windowed-sinc interpolator, split into one short filter per phase
+    meter->factor = meter->sample_rate >= 192000 ? 1 : meter->sample_rate >= 96000 ? 2 : BRIDGE_LOUDNESS_MAX_FACTOR;
+    int length = BRIDGE_LOUDNESS_PEAK_TAPS * meter->factor;
+    double center = (length - 1) / 2.0;
+    for (int n = 0; n < length; n++) {
+        double x = (n - center) / meter->factor;
+        double sinc = x == 0.0 ? 1.0 : sin(M_PI * x) / (M_PI * x);
+        double window = 0.5 - 0.5 * cos(2.0 * M_PI * (n + 0.5) / length);
+        meter->peak_filter[n % meter->factor][n / meter->factor] = (float)(sinc * window);
+    }
+}
+
+static inline double bridge_biquad_run(const bridge_biquad* f, double* z, double x) {
+    // Transposed direct form II
+    double y = f->b0 * x + z[0];
+    z[0] = f->b1 * x - f->a1 * y + z[1];
+    z[1] = f->b2 * x - f->a2 * y;
+    return y;
+}
+
+// MARK: - Lifecycle
+
+openmpt_bridge_loudness_meter* openmpt_bridge_loudness_meter_create(int32_t sample_rate) {
+    if (sample_rate <= 0) return NULL;
+    openmpt_bridge_loudness_meter* meter = calloc(1, sizeof(*meter));
+    if (!meter) return NULL;
+    meter->sample_rate = sample_rate;
+    meter->step_frames = (size_t)lround(sample_rate * 0.1);
+    if (meter->step_frames == 0) meter->step_frames = 1;
+    bridge_loudness_design(meter);
+    return meter;
+}
+
+void openmpt_bridge_loudness_meter_destroy(openmpt_bridge_loudness_meter* meter) {
+    if (!meter) return;
+    free(meter->momentary.values);
+    free(meter->short_term.values);
+    free(meter);
+}
+
+void openmpt_bridge_loudness_meter_reset(openmpt_bridge_loudness_meter* meter) {
+    if (!meter) return;
+    memset(meter->state, 0, sizeof(meter->state));
+    meter->step_energy = 0.0;
+    meter->step_filled = 0;
+    memset(meter->recent, 0, sizeof(meter->recent));
+    meter->recent_next = 0;
+    meter->steps = 0;
+    meter->momentary.count = 0;
+    meter->short_term.count = 0;
+    memset(meter->history, 0, sizeof(meter->history));
+    meter->history_next = 0;
+    meter->true_peak = 0.0f;
+    meter->sample_peak = 0.0f;
+    meter->frames = 0;
+}
+
+// MARK: - Measurement
+
+static int bridge_energy_append(bridge_energy_list* list, double value) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 1024;
+        double* values = realloc(list->values, capacity * sizeof(*values));
+        if (!values) return 0;
+        list->values = values;
+        list->capacity = capacity;
+    }
+    list->values[list->count++] = value;
+    return 1;
+}
+
+// Mean square of the newest steps, over as many as exist
+static double bridge_loudness_window(const openmpt_bridge_loudness_meter* meter, size_t steps) {
+    size_t available = meter->steps < steps ? (size_t)meter->steps : steps;
+    if (available == 0) return 0.0;
+    double sum = 0.0;
+    for (size_t i = 1; i <= available; i++) {
+        sum += meter->recent[(meter->recent_next + BRIDGE_LOUDNESS_SHORT_TERM_STEPS - i) % BRIDGE_LOUDNESS_SHORT_TERM_STEPS];
+    }
+    return sum / (double)(available * meter->step_frames);
+}
+
+static int bridge_loudness_close_step(openmpt_bridge_loudness_meter* meter) {
+    meter->recent[meter->recent_next] = meter->step_energy;
+    meter->recent_next = (meter->recent_next + 1) % BRIDGE_LOUDNESS_SHORT_TERM_STEPS;
+    meter->steps++;
+    meter->step_energy = 0.0;
+    meter->step_filled = 0;
+
+    // Blocks overlap by 75 % (momentary) and start every step (short-term)
+    int ok = 1;
+    if (meter->steps >= BRIDGE_LOUDNESS_MOMENTARY_STEPS) {
+        ok = bridge_energy_append(&meter->momentary, bridge_loudness_window(meter, BRIDGE_LOUDNESS_MOMENTARY_STEPS));
+    }
+    if (ok && meter->steps >= BRIDGE_LOUDNESS_SHORT_TERM_STEPS) {
+        ok = bridge_energy_append(&meter->short_term, bridge_loudness_window(meter, BRIDGE_LOUDNESS_SHORT_TERM_STEPS));
+    }
+    return ok;
+}
+
+static void bridge_loudness_peaks(openmpt_bridge_loudness_meter* meter, float left, float right) {
+    const size_t taps = BRIDGE_LOUDNESS_PEAK_TAPS;
+    size_t slot = meter->history_next;
+    meter->history[0][slot] = meter->history[0][slot + taps] = left;
+    meter->history[1][slot] = meter->history[1][slot + taps] = right;
+    meter->history_next = (slot + 1) % taps;
+
+    float peak = meter->true_peak;
+    for (int channel = 0; channel < 2; channel++) {
+        // Oldest sample first, matching the filter's tap order reversed
+        const float* window = meter->history[channel] + meter->history_next;
+        for (int phase = 0; phase < meter->factor; phase++) {
+            const float* coeffs = meter->peak_filter[phase];
+            float sum = 0.0f;
+            for (size_t k = 0; k < taps; k++) sum += window[k] * coeffs[taps - 1 - k];
+            float magnitude = fabsf(sum);
+            if (magnitude > peak) peak = magnitude;
+        }
+    }
+    meter->true_peak = peak;
+}
+
+int openmpt_bridge_loudness_meter_add(openmpt_bridge_loudness_meter* meter, const float* interleaved_stereo, size_t frames) {
+    if (!meter || (!interleaved_stereo && frames)) return 0;
+    for (size_t i = 0; i < frames; i++) {
+        float left = interleaved_stereo[i * 2];
+        float right = interleaved_stereo[i * 2 + 1];
+        float magnitude = fmaxf(fabsf(left), fabsf(right));
+        if (magnitude > meter->sample_peak) meter->sample_peak = magnitude;
+        bridge_loudness_peaks(meter, left, right);
+
+        double l = bridge_biquad_run(&meter->shelf, &meter->state[0][0], left);
+        l = bridge_biquad_run(&meter->highpass, &meter->state[0][2], l);
+        double r = bridge_biquad_run(&meter->shelf, &meter->state[1][0], right);
+        r = bridge_biquad_run(&meter->highpass, &meter->state[1][2], r);
+        // Left and right both have channel weight 1
+        meter->step_energy += l * l + r * r;
+        if (++meter->step_filled == meter->step_frames && !bridge_loudness_close_step(meter)) return 0;
+    }
+    meter->frames += frames;
+    return 1;
+}
+
+static double bridge_lufs(double mean_square) {
+    return mean_square > 0.0 ? -0.691 + 10.0 * log10(mean_square) : -INFINITY;
+}
+
+static double bridge_mean_square(double lufs) {
+    return pow(10.0, (lufs + 0.691) / 10.0);
+}
+
+// Mean of the values above threshold, or 0 if there are none
+static double bridge_gated_mean(const bridge_energy_list* list, double threshold) {
+    double sum = 0.0;
+    size_t count = 0;
+    for (size_t i = 0; i < list->count; i++) {
+        if (list->values[i] <= threshold) continue;
+        sum += list->values[i];
+        count++;
+    }
+    return count ? sum / (double)count : 0.0;
+}
+
+static double bridge_list_max(const bridge_energy_list* list) {
+    double max = 0.0;
+    for (size_t i = 0; i < list->count; i++) {
+        if (list->values[i] > max) max = list->values[i];
+    }
+    return max;
+}
+
+static int bridge_double_compare(const void* a, const void* b) {
+    double lhs = *(const double*)a;
+    double rhs = *(const double*)b;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+// EBU Tech 3342: spread between the 10th and 95th percentile of gated short-term loudness
+static double bridge_loudness_range(const bridge_energy_list* list) {
+    double absolute = bridge_mean_square(BRIDGE_LOUDNESS_ABSOLUTE_GATE);
+    double mean = bridge_gated_mean(list, absolute);
+    if (mean <= 0.0) return 0.0;
+    double relative = bridge_mean_square(bridge_lufs(mean) + BRIDGE_LOUDNESS_RANGE_GATE);
+    double threshold = relative > absolute ? relative : absolute;
+
+    double* gated = malloc((list->count ? list->count : 1) * sizeof(*gated));
+    if (!gated) return 0.0;
+    size_t count = 0;
+    for (size_t i = 0; i < list->count; i++) {
+        if (list->values[i] > threshold) gated[count++] = list->values[i];
+    }
+    double range = 0.0;
+    if (count > 0) {
+        qsort(gated, count, sizeof(*gated), bridge_double_compare);
+        double low = gated[(size_t)floor(0.10 * (double)(count - 1) + 0.5)];
+        double high = gated[(size_t)floor(0.95 * (double)(count - 1) + 0.5)];
+        range = bridge_lufs(high) - bridge_lufs(low);
+    }
+    free(gated);
+    return range;
+}
+
+int openmpt_bridge_loudness_meter_get(const openmpt_bridge_loudness_meter* meter, openmpt_bridge_loudness* loudness) {
+    if (!meter || !loudness) return 0;
+    memset(loudness, 0, sizeof(*loudness));
+
+    double absolute = bridge_mean_square(BRIDGE_LOUDNESS_ABSOLUTE_GATE);
+    double mean = bridge_gated_mean(&meter->momentary, absolute);
+    double relative = mean > 0.0 ? bridge_mean_square(bridge_lufs(mean) + BRIDGE_LOUDNESS_RELATIVE_GATE) : absolute;
+    loudness->integrated_lufs = bridge_lufs(bridge_gated_mean(&meter->momentary, relative > absolute ? relative : absolute));
+
+    loudness->momentary_lufs = bridge_lufs(bridge_loudness_window(meter, BRIDGE_LOUDNESS_MOMENTARY_STEPS));
+    loudness->short_term_lufs = bridge_lufs(bridge_loudness_window(meter, BRIDGE_LOUDNESS_SHORT_TERM_STEPS));
+    loudness->max_momentary_lufs = bridge_lufs(bridge_list_max(&meter->momentary));
+    loudness->max_short_term_lufs = bridge_lufs(bridge_list_max(&meter->short_term));
+    loudness->loudness_range_lu = bridge_loudness_range(&meter->short_term);
+    // The interpolator cannot reconstruct less than the samples themselves
+    float true_peak = meter->true_peak > meter->sample_peak ? meter->true_peak : meter->sample_peak;
+    loudness->true_peak_dbtp = true_peak > 0.0f ? 20.0 * log10(true_peak) : -INFINITY;
+    loudness->sample_peak_dbfs = meter->sample_peak > 0.0f ? 20.0 * log10(meter->sample_peak) : -INFINITY;
+    loudness->replaygain_db = isfinite(loudness->integrated_lufs)
+        ? OPENMPT_BRIDGE_LOUDNESS_REPLAYGAIN_REFERENCE - loudness->integrated_lufs : 0.0;
+    loudness->frames = meter->frames;
+    return 1;
+}
+
+// MARK: - Batch
+
+int bridge_loudness_render(openmpt_module* mod, openmpt_bridge_loudness* loudness) {
+    openmpt_bridge_loudness_meter* meter = openmpt_bridge_loudness_meter_create(BRIDGE_LOUDNESS_MEASURE_RATE);
+    float* block = malloc(BRIDGE_LOUDNESS_MEASURE_BLOCK * 2 * sizeof(float));
+    int ok = meter && block;
+    openmpt_module_set_repeat_count(mod, 0);
+
+    while (ok) {
+        size_t rendered = openmpt_module_read_interleaved_float_stereo(mod, BRIDGE_LOUDNESS_MEASURE_RATE,
+                                                                       BRIDGE_LOUDNESS_MEASURE_BLOCK, block);
+        ok = openmpt_bridge_loudness_meter_add(meter, block, rendered);
+        if (rendered < BRIDGE_LOUDNESS_MEASURE_BLOCK) break; // end of song
+    }
+    if (ok) ok = openmpt_bridge_loudness_meter_get(meter, loudness);
+
+    free(block);
+    openmpt_bridge_loudness_meter_destroy(meter);
+    return ok;
+}
+
+int openmpt_bridge_loudness_measure(const void* data, size_t size, int32_t subsong, openmpt_bridge_loudness* loudness) {
+    if (!data || !size || !loudness) return 0;
+    int error = 0;
+    openmpt_module* mod = openmpt_module_create_from_memory2(data, size, (void*)openmpt_log_func_silent, NULL,
+                                                             NULL, NULL, &error, NULL, NULL);
+    if (!mod) return 0;
+    int ok = (subsong < 0 || openmpt_module_select_subsong(mod, subsong)) && bridge_loudness_render(mod, loudness);
+    openmpt_module_destroy(mod);
+    return ok;
+}
+
+int32_t openmpt_bridge_loudness_gain_millibel(double integrated_lufs, double true_peak_dbtp, double target_lufs, double peak_ceiling_dbtp) {
+    if (!isfinite(integrated_lufs)) return 0;
+    double gain = target_lufs - integrated_lufs;
+    if (gain > 0.0 && isfinite(true_peak_dbtp)) {
+        double headroom = peak_ceiling_dbtp - true_peak_dbtp;
+        if (headroom < 0.0) headroom = 0.0;
+        if (gain > headroom) gain = headroom;
+    }
+    return (int32_t)lround(gain * 100.0);
+}
@@ -0,0 +1,256 @@
+// openmpt_bridge_module.c
+// Module handle that counts and times loads, renders and seeks
+
+#include "openmpt_bridge_module.h"
+#include "bridge_internal.h"
+#include "bridge_module_internal.h"
+
+#include <stdlib.h>
+
+// MARK: - Counters
+
+static inline void bridge_count(atomic_uint_fast64_t* counter, uint64_t amount) {
+    atomic_fetch_add_explicit(counter, amount, memory_order_relaxed);
+}
+
+static void bridge_count_render(openmpt_bridge_module* handle, int32_t samplerate, size_t requested, size_t rendered,
+                                uint64_t start, uint64_t end) {
+    bridge_counters* counters = &handle->counters;
+    uint64_t elapsed = end - start;
+    uint64_t block_index = atomic_fetch_add_explicit(&counters->render_calls, 1, memory_order_relaxed);
+    bridge_count(&counters->frames_rendered, rendered);
+    bridge_count(&counters->render_ns, elapsed);
+    if (rendered < requested) bridge_count(&counters->underruns, 1);
+
+    // Only the render thread raises the maximum; a reset may race harmlessly
+    uint64_t max = atomic_load_explicit(&counters->max_block_ns, memory_order_relaxed);
+    if (elapsed > max) atomic_store_explicit(&counters->max_block_ns, elapsed, memory_order_relaxed);
+
+    uint64_t ppm = bridge_deadline_record(&handle->deadline, requested, samplerate, end, elapsed, block_index);
+    bridge_quality_update(handle, ppm);
+}
+
+int openmpt_bridge_get_stats(const openmpt_bridge_module* handle, openmpt_bridge_stats* stats) {
+    if (!handle || !stats) return 0;
+    const bridge_counters* counters = &handle->counters;
+    stats->frames_rendered = bridge_atomic_load_u64(&counters->frames_rendered, memory_order_relaxed);
+    stats->render_calls = bridge_atomic_load_u64(&counters->render_calls, memory_order_relaxed);
+    stats->render_ns = bridge_atomic_load_u64(&counters->render_ns, memory_order_relaxed);
+    stats->max_block_ns = bridge_atomic_load_u64(&counters->max_block_ns, memory_order_relaxed);
+    stats->underruns = bridge_atomic_load_u64(&counters->underruns, memory_order_relaxed);
+    stats->seeks = bridge_atomic_load_u64(&counters->seeks, memory_order_relaxed);
+    stats->loads = bridge_atomic_load_u64(&counters->loads, memory_order_relaxed);
+    stats->load_ns = bridge_atomic_load_u64(&counters->load_ns, memory_order_relaxed);
+    return 1;
+}
+
+void openmpt_bridge_reset_stats(openmpt_bridge_module* handle) {
+    if (!handle) return;
+    bridge_counters* counters = &handle->counters;
+    atomic_store_explicit(&counters->frames_rendered, 0, memory_order_relaxed);
+    atomic_store_explicit(&counters->render_calls, 0, memory_order_relaxed);
+    atomic_store_explicit(&counters->render_ns, 0, memory_order_relaxed);
+    atomic_store_explicit(&counters->max_block_ns, 0, memory_order_relaxed);
+    atomic_store_explicit(&counters->underruns, 0, memory_order_relaxed);
+    atomic_store_explicit(&counters->seeks, 0, memory_order_relaxed);
+    atomic_store_explicit(&counters->loads, 0, memory_order_relaxed);
+    atomic_store_explicit(&counters->load_ns, 0, memory_order_relaxed);
+}
+
+// MARK: - Lifecycle
+
+openmpt_bridge_module* openmpt_bridge_module_create(void) {
+    openmpt_bridge_module* handle = calloc(1, sizeof(*handle));
+    if (!handle) return NULL;
+    if (pthread_mutex_init(&handle->snapshot_lock, NULL) != 0) {
+        free(handle);
+        return NULL;
+    }
+    openmpt_bridge_reset_stats(handle);
+    bridge_deadline_init(&handle->deadline);
+    bridge_quality_init(&handle->quality);
+    bridge_commands_init(&handle->commands);
+    bridge_position_init(&handle->position);
+    bridge_taps_init(&handle->taps);
+    bridge_interactive_init(&handle->interactive);
+    return handle;
+}
+
+static void bridge_set_snapshot(openmpt_bridge_module* handle, bridge_snapshot* snapshot) {
+    pthread_mutex_lock(&handle->snapshot_lock);
+    bridge_snapshot* previous = handle->snapshot;
+    handle->snapshot = snapshot;
+    pthread_mutex_unlock(&handle->snapshot_lock);
+    // Readers holding a reference keep the old snapshot alive
+    bridge_snapshot_release(previous);
+}
+
+static void bridge_release_module(openmpt_bridge_module* handle) {
+    if (!handle->mod) return;
+    bridge_set_snapshot(handle, NULL);
+    openmpt_module_ext_destroy(handle->mod_ext);
+    handle->mod_ext = NULL;
+    handle->mod = NULL;
+    bridge_interactive_reset(handle);
+    bridge_position_publish(handle);
+}
+
+void openmpt_bridge_module_destroy(openmpt_bridge_module* handle) {
+    if (!handle) return;
+    // No render thread may be running by now, whatever the mode
+    bridge_release_module(handle);
+    bridge_taps_destroy(&handle->taps);
+    pthread_mutex_destroy(&handle->snapshot_lock);
+    free(handle);
+}
+
+int openmpt_bridge_module_unload(openmpt_bridge_module* handle) {
+    if (!handle) return 0;
+    // The render thread owns the module in real-time mode
+    if (openmpt_bridge_module_is_realtime(handle)) return 0;
+    bridge_release_module(handle);
+    return 1;
+}
+
+int openmpt_bridge_module_load(openmpt_bridge_module* handle, const void* data, size_t size, const openmpt_module_initial_ctl* ctls, int* error) {
+    if (!handle || !data) return 0;
+    // The render thread owns the module in real-time mode
+    if (openmpt_bridge_module_is_realtime(handle)) return 0;
+    bridge_release_module(handle);
+
+    uint64_t start = bridge_now_ns();
+    // Loaded through ext so the interactive interfaces are available
+    openmpt_module_ext* mod_ext = openmpt_module_ext_create_from_memory(data, size, NULL, NULL, NULL, NULL, error, NULL, ctls);
+    if (!mod_ext) return 0;
+    openmpt_module* mod = openmpt_module_ext_get_module(mod_ext);
+    uint64_t elapsed = bridge_now_ns() - start;
+
+    bridge_snapshot* snapshot = mod ? bridge_snapshot_create(mod, data, size) : NULL;
+    if (!snapshot) {
+        openmpt_module_ext_destroy(mod_ext);
+        return 0;
+    }
+    handle->mod_ext = mod_ext;
+    handle->mod = mod;
+    handle->at_end = 0;
+    bridge_set_snapshot(handle, snapshot);
+
+    bridge_count(&handle->counters.load_ns, elapsed);
+    bridge_count(&handle->counters.loads, 1);
+    bridge_quality_reset(handle);
+    bridge_commands_reset(handle);
+    bridge_interactive_reset(handle);
+    bridge_position_publish(handle);
+    return 1;
+}
+
+openmpt_module* openmpt_bridge_module_get_module(const openmpt_bridge_module* handle) {
+    return handle ? handle->mod : NULL;
+}
+
+// MARK: - Rendering
+
+// Apply queued changes, then render, in short sub-blocks while a smoothed
+// parameter is ramping, and hand the block to any taps. Exactly one of
+// interleaved or left/right is set.
+static size_t bridge_render(openmpt_bridge_module* handle, int32_t samplerate, size_t count,
+                            float* interleaved, float* left, float* right) {
+    uint64_t start = bridge_now_ns();
+    bridge_commands_drain(handle, samplerate);
+    size_t rendered = 0;
+    while (rendered < count) {
+        size_t chunk = bridge_commands_smooth(handle, count - rendered);
+        size_t got = interleaved
+            ? openmpt_module_read_interleaved_float_stereo(handle->mod, samplerate, chunk, interleaved + rendered * 2)
+            : openmpt_module_read_float_stereo(handle->mod, samplerate, chunk, left + rendered, right + rendered);
+        rendered += got;
+        if (got < chunk) break;
+    }
+    // A short block means libopenmpt reached the end of the song and, with
+    // a finite repeat count, will keep returning 0 frames
+    handle->at_end = rendered < count;
+    bridge_taps_feed(handle, samplerate, interleaved, left, right, rendered);
+    bridge_position_publish(handle);
+    bridge_count_render(handle, samplerate, count, rendered, start, bridge_now_ns());
+    return rendered;
+}
+
+size_t openmpt_bridge_module_read_interleaved_float_stereo(openmpt_bridge_module* handle, int32_t samplerate, size_t count, float* interleaved_stereo) {
+    if (!handle || !handle->mod || !interleaved_stereo) return 0;
+    return bridge_render(handle, samplerate, count, interleaved_stereo, NULL, NULL);
+}
+
+size_t openmpt_bridge_module_read_float_stereo(openmpt_bridge_module* handle, int32_t samplerate, size_t count, float* left, float* right) {
+    if (!handle || !handle->mod || !left || !right) return 0;
+    return bridge_render(handle, samplerate, count, NULL, left, right);
+}
+
+// MARK: - Seeking
+
+// Where a queued seek will land, as far as the snapshot can tell
+static double bridge_expected_seconds(openmpt_bridge_module* handle, int32_t order, double seconds) {
+    const openmpt_bridge_snapshot* snapshot = openmpt_bridge_module_acquire_snapshot(handle);
+    if (!snapshot) return 0.0;
+    if (order >= 0) {
+        seconds = openmpt_bridge_snapshot_get_order_time(snapshot, order);
+        if (seconds < 0.0) seconds = 0.0;
+    } else {
+        if (seconds > snapshot->duration) seconds = snapshot->duration;
+        if (seconds < 0.0) seconds = 0.0;
+    }
+    openmpt_bridge_snapshot_release(snapshot);
+    return seconds;
+}
+
+double openmpt_bridge_module_set_position_seconds(openmpt_bridge_module* handle, double seconds) {
+    if (!handle || !handle->mod) return 0.0;
+    bridge_count(&handle->counters.seeks, 1);
+    if (openmpt_bridge_module_is_realtime(handle)) {
+        bridge_command command = { .kind = BRIDGE_COMMAND_SEEK_SECONDS, .seconds = seconds };
+        if (!bridge_commands_submit(handle, &command)) return 0.0;
+        return bridge_expected_seconds(handle, -1, seconds);
+    }
+    double position = openmpt_module_set_position_seconds(handle->mod, seconds);
+    handle->at_end = 0;
+    bridge_position_publish(handle);
+    return position;
+}
+
+double openmpt_bridge_module_set_position_order_row(openmpt_bridge_module* handle, int32_t order, int32_t row) {
+    if (!handle || !handle->mod) return 0.0;
+    bridge_count(&handle->counters.seeks, 1);
+    if (openmpt_bridge_module_is_realtime(handle)) {
+        bridge_command command = { .kind = BRIDGE_COMMAND_SEEK_ORDER_ROW, .param = order, .value = row };
+        if (!bridge_commands_submit(handle, &command)) return 0.0;
+        return bridge_expected_seconds(handle, order < 0 ? 0 : order, 0.0);
+    }
+    double position = openmpt_module_set_position_order_row(handle->mod, order, row);
+    handle->at_end = 0;
+    bridge_position_publish(handle);
+    return position;
+}
+
+int openmpt_bridge_module_select_subsong(openmpt_bridge_module* handle, int32_t subsong) {
+    if (!handle || !handle->mod) return 0;
+    if (openmpt_bridge_module_is_realtime(handle)) {
+        const openmpt_bridge_snapshot* snapshot = openmpt_bridge_module_acquire_snapshot(handle);
+        int valid = snapshot && subsong >= -1 && subsong < snapshot->num_subsongs;
+        openmpt_bridge_snapshot_release(snapshot);
+        if (!valid) return 0;
+        bridge_command command = { .kind = BRIDGE_COMMAND_SELECT_SUBSONG, .value = subsong };
+        return bridge_commands_submit(handle, &command);
+    }
+    int result = openmpt_module_select_subsong(handle->mod, subsong);
+    handle->at_end = 0;
+    bridge_position_publish(handle);
+    return result;
+}
+
+int openmpt_bridge_module_set_repeat_count(openmpt_bridge_module* handle, int32_t repeat_count) {
+    if (!handle || !handle->mod) return 0;
+    if (openmpt_bridge_module_is_realtime(handle)) {
+        bridge_command command = { .kind = BRIDGE_COMMAND_REPEAT_COUNT, .value = repeat_count };
+        return bridge_commands_submit(handle, &command);
+    }
+    return openmpt_module_set_repeat_count(handle->mod, repeat_count);
+}
@@ -0,0 +1,317 @@
+// openmpt_bridge_preview.c
+// Probe-based preview start selection and batched clip rendering
+
+#include "openmpt_bridge_preview.h"
+#include "bridge_internal.h"
+#include "bridge_pcm.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BRIDGE_PREVIEW_DEFAULT_CLIP 20.0
+#define BRIDGE_PREVIEW_DEFAULT_FADE_IN 0.01
+#define BRIDGE_PREVIEW_DEFAULT_FADE_OUT 1.5
+#define BRIDGE_PREVIEW_DEFAULT_PROBE 1.0
+#define BRIDGE_PREVIEW_DEFAULT_SCAN_RATE 8000
+#define BRIDGE_PREVIEW_BLOCK 4096
+
+// Both instances seek mid-song, so samples must be restored on seek
+static const openmpt_module_initial_ctl preview_load_ctls[] = {
+    { "seek.sync_samples", "1" },
+    { NULL, NULL }
+};
+
+typedef struct preview_order {
+    int32_t order;
+    double start;
+    double end;
+    double energy;
+} preview_order;
+
+void openmpt_bridge_preview_options_init(openmpt_bridge_preview_options* preview) {
+    if (!preview) return;
+    memset(preview, 0, sizeof(*preview));
+    preview->clip_seconds = BRIDGE_PREVIEW_DEFAULT_CLIP;
+    preview->fade_in_seconds = BRIDGE_PREVIEW_DEFAULT_FADE_IN;
+    preview->fade_out_seconds = BRIDGE_PREVIEW_DEFAULT_FADE_OUT;
+    preview->probe_seconds = BRIDGE_PREVIEW_DEFAULT_PROBE;
+    preview->scan_sample_rate = BRIDGE_PREVIEW_DEFAULT_SCAN_RATE;
+    preview->subsong = -1;
+}
+
+static void preview_settings(const openmpt_bridge_preview_options* preview, openmpt_bridge_preview_options* settings) {
+    openmpt_bridge_preview_options_init(settings);
+    if (preview) *settings = *preview;
+    if (settings->clip_seconds <= 0.0) settings->clip_seconds = BRIDGE_PREVIEW_DEFAULT_CLIP;
+    if (settings->fade_in_seconds < 0.0) settings->fade_in_seconds = 0.0;
+    if (settings->fade_out_seconds < 0.0) settings->fade_out_seconds = 0.0;
+    if (settings->probe_seconds <= 0.0) settings->probe_seconds = BRIDGE_PREVIEW_DEFAULT_PROBE;
+    if (settings->scan_sample_rate <= 0) settings->scan_sample_rate = BRIDGE_PREVIEW_DEFAULT_SCAN_RATE;
+}
+
+static openmpt_module* preview_instance(const void* data, size_t size, int32_t subsong) {
+    int error = 0;
+    openmpt_module* mod = openmpt_module_create_from_memory2(data, size, (void*)openmpt_log_func_silent, NULL,
+                                                             NULL, NULL, &error, NULL, preview_load_ctls);
+    if (!mod) return NULL;
+    if (subsong >= 0 && !openmpt_module_select_subsong(mod, subsong)) {
+        openmpt_module_destroy(mod);
+        return NULL;
+    }
+    openmpt_module_set_repeat_count(mod, 0);
+    return mod;
+}
+
+// MARK: - Start selection
+
+static int preview_order_compare(const void* a, const void* b) {
+    double lhs = ((const preview_order*)a)->start;
+    double rhs = ((const preview_order*)b)->start;
+    return (lhs > rhs) - (lhs < rhs);
+}
+
+// Orders that are played, sorted by start time, each spanning up to the next
+static preview_order* preview_orders(openmpt_module* mod, double duration, size_t* count) {
+    int32_t orders = openmpt_module_get_num_orders(mod);
+    *count = 0;
+    if (orders <= 0) return NULL;
+    preview_order* list = malloc((size_t)orders * sizeof(*list));
+    if (!list) return NULL;
+    for (int32_t order = 0; order < orders; order++) {
+        double start = openmpt_module_get_time_at_position(mod, order, 0);
+        if (start < 0.0 || start >= duration) continue;
+        list[*count].order = order;
+        list[*count].start = start;
+        list[*count].energy = 0.0;
+        (*count)++;
+    }
+    qsort(list, *count, sizeof(*list), preview_order_compare);
+
+    // Orders played at the same time (e.g. empty patterns) collapse into the first
+    size_t unique = 0;
+    for (size_t i = 0; i < *count; i++) {
+        if (unique && list[i].start <= list[unique - 1].start) continue;
+        list[unique++] = list[i];
+    }
+    *count = unique;
+    for (size_t i = 0; i < unique; i++) {
+        list[i].end = i + 1 < unique ? list[i + 1].start : duration;
+    }
+    return list;
+}
+
+// Mean square of a short low-quality render from the start of each order
+static int preview_probe(openmpt_module* mod, preview_order* orders, size_t count,
+                         const openmpt_bridge_preview_options* settings) {
+    openmpt_module_set_render_param(mod, OPENMPT_MODULE_RENDER_INTERPOLATIONFILTER_LENGTH, 1);
+    openmpt_module_set_render_param(mod, OPENMPT_MODULE_RENDER_VOLUMERAMPING_STRENGTH, 0);
+    float* block = malloc(BRIDGE_PREVIEW_BLOCK * 2 * sizeof(float));
+    if (!block) return 0;
+
+    const uint64_t probe_frames = (uint64_t)(settings->probe_seconds * settings->scan_sample_rate) + 1;
+    for (size_t i = 0; i < count; i++) {
+        openmpt_module_set_position_order_row(mod, orders[i].order, 0);
+        double sum = 0.0;
+        uint64_t frames = 0;
+        while (frames < probe_frames) {
+            size_t wanted = probe_frames - frames < BRIDGE_PREVIEW_BLOCK ? (size_t)(probe_frames - frames) : BRIDGE_PREVIEW_BLOCK;
+            size_t rendered = openmpt_module_read_interleaved_float_stereo(mod, settings->scan_sample_rate, wanted, block);
+            for (size_t k = 0; k < rendered * 2; k++) sum += (double)block[k] * block[k];
+            frames += rendered;
+            if (rendered < wanted) break; // end of song
+        }
+        orders[i].energy = frames ? sum / (double)(frames * 2) : 0.0;
+    }
+    free(block);
+    return 1;
+}
+
+// Order start whose clip-length window holds the most probed energy
+static const preview_order* preview_pick(const preview_order* orders, size_t count, double clip, double duration) {
+    const preview_order* best = NULL;
+    double best_score = -1.0;
+    for (size_t i = 0; i < count; i++) {
+        double window_end = orders[i].start + clip;
+        // Only windows that fit the song, so previews run their full length
+        if (window_end > duration + 1e-6) break;
+        double score = 0.0;
+        for (size_t j = i; j < count && orders[j].start < window_end; j++) {
+            double overlap = (orders[j].end < window_end ? orders[j].end : window_end) - orders[j].start;
+            score += orders[j].energy * overlap;
+        }
+        if (score > best_score) {
+            best = &orders[i];
+            best_score = score;
+        }
+    }
+    return best;
+}
+
+static int preview_find_start(const void* data, size_t size, const openmpt_bridge_preview_options* settings,
+                              int32_t* order, double* start_seconds) {
+    openmpt_module* mod = preview_instance(data, size, settings->subsong);
+    if (!mod) return 0;
+    *order = -1;
+    *start_seconds = 0.0;
+
+    double duration = openmpt_module_get_duration_seconds(mod);
+    int ok = 1;
+    if (duration > settings->clip_seconds) {
+        size_t count = 0;
+        preview_order* orders = preview_orders(mod, duration, &count);
+        if (count > 1 && (ok = preview_probe(mod, orders, count, settings))) {
+            const preview_order* best = preview_pick(orders, count, settings->clip_seconds, duration);
+            if (best) {
+                *order = best->order;
+                *start_seconds = best->start;
+            }
+        }
+        free(orders);
+    }
+    openmpt_module_destroy(mod);
+    return ok;
+}
+
+int openmpt_bridge_preview_find_start(const void* data, size_t size, const openmpt_bridge_preview_options* preview, int32_t* order, double* start_seconds) {
+    if (!data || !size || !order || !start_seconds) return 0;
+    openmpt_bridge_preview_options settings;
+    preview_settings(preview, &settings);
+    return preview_find_start(data, size, &settings, order, start_seconds);
+}
+
+// MARK: - Clip rendering
+
+// Raised-cosine gain from 0 at position 0 to 1 at position length
+static inline float preview_ramp(size_t position, size_t length) {
+    return (float)(0.5 - 0.5 * cos(M_PI * (double)position / (double)length));
+}
+
+static void preview_fade(float* clip, size_t frames, size_t fade_in, size_t fade_out) {
+    if (fade_in > frames) fade_in = frames;
+    if (fade_out > frames) fade_out = frames;
+    for (size_t i = 0; i < fade_in; i++) {
+        float gain = preview_ramp(i, fade_in);
+        clip[i * 2] *= gain;
+        clip[i * 2 + 1] *= gain;
+    }
+    for (size_t i = 0; i < fade_out; i++) {
+        float gain = preview_ramp(i, fade_out);
+        float* frame = clip + (frames - 1 - i) * 2;
+        frame[0] *= gain;
+        frame[1] *= gain;
+    }
+}
+
+static int preview_write(const char* path, const float* clip, size_t frames, const openmpt_bridge_export_options* output) {
+    size_t frame_bytes = bridge_sample_bytes(output->format) * 2;
+    uint8_t header[BRIDGE_WAV_HEADER_MAX];
+    size_t header_size = 0;
+    if (output->container == OPENMPT_BRIDGE_CONTAINER_WAV) {
+        header_size = bridge_wav_header(header, output->format, output->sample_rate, 2, (uint64_t)frames * frame_bytes);
+    }
+    uint8_t* file = malloc(header_size + frames * frame_bytes + 1);
+    if (!file) return 0;
+    memcpy(file, header, header_size);
+    bridge_convert_samples(clip, file + header_size, frames * 2, output->format);
+    int ok = bridge_write_file_atomic(path, file, header_size + frames * frame_bytes);
+    free(file);
+    return ok;
+}
+
+int openmpt_bridge_preview_render(const void* data, size_t size, const char* output_path, const openmpt_bridge_export_options* options, const openmpt_bridge_preview_options* preview, openmpt_bridge_preview_result* result) {
+    openmpt_bridge_preview_result summary;
+    memset(&summary, 0, sizeof(summary));
+    summary.order = -1;
+    if (result) *result = summary;
+    if (!data || !size || !output_path) return 0;
+
+    openmpt_bridge_export_options output;
+    openmpt_bridge_export_options_init(&output);
+    if (options) output = *options;
+    if (output.sample_rate <= 0) output.sample_rate = 48000;
+    if (!bridge_sample_bytes(output.format)) return 0;
+    if (output.container != OPENMPT_BRIDGE_CONTAINER_WAV && output.container != OPENMPT_BRIDGE_CONTAINER_RAW) return 0;
+    openmpt_bridge_preview_options settings;
+    preview_settings(preview, &settings);
+
+    uint64_t start = bridge_now_ns();
+    if (!preview_find_start(data, size, &settings, &summary.order, &summary.start_seconds)) return 0;
+    uint64_t scanned = bridge_now_ns();
+    summary.scan_seconds = (double)(scanned - start) * 1e-9;
+
+    openmpt_module* mod = preview_instance(data, size, settings.subsong);
+    const size_t clip_frames = (size_t)(settings.clip_seconds * output.sample_rate);
+    float* clip = malloc((clip_frames ? clip_frames : 1) * 2 * sizeof(float));
+    int ok = 0;
+    if (mod && clip) {
+        if (summary.order >= 0) openmpt_module_set_position_order_row(mod, summary.order, 0);
+        size_t frames = 0;
+        while (frames < clip_frames) {
+            size_t wanted = clip_frames - frames < BRIDGE_PREVIEW_BLOCK ? clip_frames - frames : BRIDGE_PREVIEW_BLOCK;
+            size_t rendered = openmpt_module_read_interleaved_float_stereo(mod, output.sample_rate, wanted, clip + frames * 2);
+            frames += rendered;
+            if (rendered < wanted) break; // end of song
+        }
+        // A song that ends inside the clip has its own ending; one cut short fades out
+        size_t fade_in = summary.order >= 0 ? (size_t)(settings.fade_in_seconds * output.sample_rate) : 0;
+        size_t fade_out = frames == clip_frames ? (size_t)(settings.fade_out_seconds * output.sample_rate) : 0;
+        preview_fade(clip, frames, fade_in, fade_out);
+        ok = frames > 0 && preview_write(output_path, clip, frames, &output);
+        summary.frames = frames;
+    }
+    summary.render_seconds = (double)(bridge_now_ns() - scanned) * 1e-9;
+    summary.ok = ok;
+
+    free(clip);
+    if (mod) openmpt_module_destroy(mod);
+    if (result) *result = summary;
+    return ok;
+}
+
+// MARK: - Batch
+
+typedef struct preview_batch {
+    const char* const* module_paths;
+    const char* const* output_paths;
+    const openmpt_bridge_export_options* options;
+    const openmpt_bridge_preview_options* preview;
+    openmpt_bridge_preview_result* results;
+} preview_batch;
+
+static void preview_batch_job(void* ctx, size_t index, int worker) {
+    (void)worker;
+    preview_batch* batch = (preview_batch*)ctx;
+    openmpt_bridge_preview_result* result = &batch->results[index];
+    void* data = NULL;
+    size_t size = 0;
+    if (!bridge_read_file(batch->module_paths[index], &data, &size)) {
+        memset(result, 0, sizeof(*result));
+        result->order = -1;
+        return;
+    }
+    openmpt_bridge_preview_render(data, size, batch->output_paths[index], batch->options, batch->preview, result);
+    free(data);
+}
+
+size_t openmpt_bridge_preview_batch(const char* const* module_paths, const char* const* output_paths, size_t count, const openmpt_bridge_export_options* options, const openmpt_bridge_preview_options* preview, openmpt_bridge_preview_result* results) {
+    if (!module_paths || !output_paths || !count) return 0;
+    openmpt_bridge_preview_result* owned = NULL;
+    if (!results) {
+        owned = calloc(count, sizeof(*owned));
+        if (!owned) return 0;
+        results = owned;
+    }
+
+    preview_batch batch = { module_paths, output_paths, options, preview, results };
+    bridge_parallel_for(count, preview ? preview->thread_count : 0, preview_batch_job, &batch);
+
+    size_t written = 0;
+    for (size_t i = 0; i < count; i++) written += results[i].ok ? 1 : 0;
+    free(owned);
+    return written;
+}
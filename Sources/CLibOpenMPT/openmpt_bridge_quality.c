@@ -0,0 +1,193 @@
+// openmpt_bridge_quality.c
+// Steps interpolation and volume ramping down under sustained overruns and back up with headroom
+
+#include "openmpt_bridge_quality.h"
+#include "bridge_internal.h"
+#include "bridge_module_internal.h"
+
+// libopenmpt defaults, used when the module cannot report its own values
+#define BRIDGE_QUALITY_DEFAULT_INTERPOLATION 8
+#define BRIDGE_QUALITY_DEFAULT_RAMPING -1
+
+void openmpt_bridge_quality_options_init(openmpt_bridge_quality_options* options) {
+    if (!options) return;
+    options->restore_utilization = 0.4;
+    options->degrade_blocks = 4;
+    options->restore_blocks = 256;
+    options->max_level = OPENMPT_BRIDGE_QUALITY_MAX_LEVEL;
+}
+
+static void bridge_quality_store_options(bridge_quality* quality, const openmpt_bridge_quality_options* options) {
+    int32_t max_level = options->max_level;
+    if (max_level < 1) max_level = 1;
+    if (max_level > OPENMPT_BRIDGE_QUALITY_MAX_LEVEL) max_level = OPENMPT_BRIDGE_QUALITY_MAX_LEVEL;
+    double restore = options->restore_utilization > 0.0 ? options->restore_utilization : 0.0;
+    atomic_store_explicit(&quality->max_level, max_level, memory_order_relaxed);
+    atomic_store_explicit(&quality->degrade_blocks, options->degrade_blocks ? options->degrade_blocks : 1, memory_order_relaxed);
+    atomic_store_explicit(&quality->restore_blocks, options->restore_blocks ? options->restore_blocks : 1, memory_order_relaxed);
+    atomic_store_explicit(&quality->restore_ppm, (uint_fast64_t)(restore * 1e6), memory_order_relaxed);
+}
+
+void bridge_quality_init(bridge_quality* quality) {
+    openmpt_bridge_quality_options defaults;
+    openmpt_bridge_quality_options_init(&defaults);
+    atomic_init(&quality->enabled, 0);
+    atomic_init(&quality->max_level, 0);
+    atomic_init(&quality->degrade_blocks, 0);
+    atomic_init(&quality->restore_blocks, 0);
+    atomic_init(&quality->restore_ppm, 0);
+    atomic_init(&quality->requested_interpolation, BRIDGE_QUALITY_DEFAULT_INTERPOLATION);
+    atomic_init(&quality->requested_ramping, BRIDGE_QUALITY_DEFAULT_RAMPING);
+    atomic_init(&quality->level, 0);
+    atomic_init(&quality->applied_interpolation, BRIDGE_QUALITY_DEFAULT_INTERPOLATION);
+    atomic_init(&quality->applied_ramping, BRIDGE_QUALITY_DEFAULT_RAMPING);
+    atomic_init(&quality->degrades, 0);
+    atomic_init(&quality->restores, 0);
+    quality->pressure = 0;
+    quality->calm = 0;
+    bridge_quality_store_options(quality, &defaults);
+}
+
+void bridge_quality_reset(openmpt_bridge_module* handle) {
+    bridge_quality* quality = &handle->quality;
+    int32_t interpolation = BRIDGE_QUALITY_DEFAULT_INTERPOLATION;
+    int32_t ramping = BRIDGE_QUALITY_DEFAULT_RAMPING;
+    if (handle->mod) {
+        openmpt_module_get_render_param(handle->mod, OPENMPT_MODULE_RENDER_INTERPOLATIONFILTER_LENGTH, &interpolation);
+        openmpt_module_get_render_param(handle->mod, OPENMPT_MODULE_RENDER_VOLUMERAMPING_STRENGTH, &ramping);
+    }
+    atomic_store_explicit(&quality->requested_interpolation, interpolation, memory_order_relaxed);
+    atomic_store_explicit(&quality->requested_ramping, ramping, memory_order_relaxed);
+    atomic_store_explicit(&quality->applied_interpolation, interpolation, memory_order_relaxed);
+    atomic_store_explicit(&quality->applied_ramping, ramping, memory_order_relaxed);
+    atomic_store_explicit(&quality->level, 0, memory_order_relaxed);
+    atomic_store_explicit(&quality->degrades, 0, memory_order_relaxed);
+    atomic_store_explicit(&quality->restores, 0, memory_order_relaxed);
+    quality->pressure = 0;
+    quality->calm = 0;
+}
+
+// MARK: - Render Thread
+
+// Interpolation taps allowed at a level: 8, 4, 2, 1
+static int32_t bridge_quality_interpolation(int32_t requested, int level) {
+    if (level == 0) return requested;
+    int32_t cap = BRIDGE_QUALITY_DEFAULT_INTERPOLATION >> level;
+    if (requested <= 0) return cap;     // 0 selects libopenmpt's default, 8 taps
+    return requested < cap ? requested : cap;
+}
+
+static void bridge_quality_set(openmpt_bridge_module* handle, atomic_int* applied, int param, int32_t value) {
+    if (atomic_load_explicit(applied, memory_order_relaxed) == value) return;
+    if (openmpt_module_set_render_param(handle->mod, param, value) == 1) {
+        atomic_store_explicit(applied, value, memory_order_relaxed);
+    }
+}
+
+// Bring the module's render params in line with the level. At level 0
+// bridge_quality_set_render_param writes them, so they are only written
+// here on a restore.
+static void bridge_quality_apply(openmpt_bridge_module* handle, int level, int changed) {
+    bridge_quality* quality = &handle->quality;
+    if (level == 0 && !changed) return;
+    int32_t interpolation = atomic_load_explicit(&quality->requested_interpolation, memory_order_relaxed);
+    int32_t ramping = atomic_load_explicit(&quality->requested_ramping, memory_order_relaxed);
+    bridge_quality_set(handle, &quality->applied_interpolation, OPENMPT_MODULE_RENDER_INTERPOLATIONFILTER_LENGTH,
+                       bridge_quality_interpolation(interpolation, level));
+    bridge_quality_set(handle, &quality->applied_ramping, OPENMPT_MODULE_RENDER_VOLUMERAMPING_STRENGTH,
+                       level == 0 ? ramping : 0);
+}
+
+void bridge_quality_update(openmpt_bridge_module* handle, uint64_t utilization_ppm) {
+    bridge_quality* quality = &handle->quality;
+    if (!handle->mod) return;
+    int level = atomic_load_explicit(&quality->level, memory_order_relaxed);
+    int target = level;
+
+    if (!atomic_load_explicit(&quality->enabled, memory_order_relaxed)) {
+        if (level == 0) return;
+        target = 0;
+    } else if (utilization_ppm > 0) {
+        // Overruns build pressure and good blocks bleed it off, so isolated
+        // spikes never degrade; restoring needs a long run of real headroom
+        uint64_t budget = atomic_load_explicit(&handle->deadline.budget_ppm, memory_order_relaxed);
+        if (utilization_ppm > budget) {
+            quality->pressure++;
+            quality->calm = 0;
+        } else {
+            if (quality->pressure > 0) quality->pressure--;
+            uint64_t restore = atomic_load_explicit(&quality->restore_ppm, memory_order_relaxed);
+            quality->calm = utilization_ppm < restore ? quality->calm + 1 : 0;
+        }
+
+        int max_level = atomic_load_explicit(&quality->max_level, memory_order_relaxed);
+        if (level > max_level) {
+            target = max_level;
+        } else if (level < max_level && quality->pressure >= atomic_load_explicit(&quality->degrade_blocks, memory_order_relaxed)) {
+            target = level + 1;
+        } else if (level > 0 && quality->calm >= atomic_load_explicit(&quality->restore_blocks, memory_order_relaxed)) {
+            target = level - 1;
+        }
+    }
+
+    if (target != level) {
+        atomic_fetch_add_explicit(target > level ? &quality->degrades : &quality->restores, 1, memory_order_relaxed);
+        atomic_store_explicit(&quality->level, target, memory_order_relaxed);
+        quality->pressure = 0;
+        quality->calm = 0;
+    }
+    bridge_quality_apply(handle, target, target != level);
+}
+
+// MARK: - Control
+
+int openmpt_bridge_quality_enable(openmpt_bridge_module* handle, const openmpt_bridge_quality_options* options) {
+    if (!handle) return 0;
+    openmpt_bridge_quality_options defaults;
+    if (!options) {
+        openmpt_bridge_quality_options_init(&defaults);
+        options = &defaults;
+    }
+    bridge_quality_store_options(&handle->quality, options);
+    atomic_store_explicit(&handle->quality.enabled, 1, memory_order_relaxed);
+    return 1;
+}
+
+void openmpt_bridge_quality_disable(openmpt_bridge_module* handle) {
+    if (!handle) return;
+    atomic_store_explicit(&handle->quality.enabled, 0, memory_order_relaxed);
+}
+
+int openmpt_bridge_quality_get_state(const openmpt_bridge_module* handle, openmpt_bridge_quality_state* state) {
+    if (!handle || !state) return 0;
+    const bridge_quality* quality = &handle->quality;
+    state->enabled = bridge_atomic_load_int(&quality->enabled, memory_order_relaxed);
+    state->level = bridge_atomic_load_int(&quality->level, memory_order_relaxed);
+    state->interpolation_filter_length = bridge_atomic_load_int(&quality->applied_interpolation, memory_order_relaxed);
+    state->volume_ramping_strength = bridge_atomic_load_int(&quality->applied_ramping, memory_order_relaxed);
+    state->degrades = bridge_atomic_load_u64(&quality->degrades, memory_order_relaxed);
+    state->restores = bridge_atomic_load_u64(&quality->restores, memory_order_relaxed);
+    return 1;
+}
+
+int bridge_quality_set_render_param(openmpt_bridge_module* handle, int param, int32_t value) {
+    bridge_quality* quality = &handle->quality;
+    atomic_int* requested = NULL;
+    atomic_int* applied = NULL;
+    if (param == OPENMPT_MODULE_RENDER_INTERPOLATIONFILTER_LENGTH) {
+        requested = &quality->requested_interpolation;
+        applied = &quality->applied_interpolation;
+    } else if (param == OPENMPT_MODULE_RENDER_VOLUMERAMPING_STRENGTH) {
+        requested = &quality->requested_ramping;
+        applied = &quality->applied_ramping;
+    }
+    if (!requested) return openmpt_module_set_render_param(handle->mod, param, value);
+
+    // While degraded, bridge_quality_apply derives the applied value from
+    // the request at the next block
+    atomic_store_explicit(requested, value, memory_order_relaxed);
+    if (atomic_load_explicit(&quality->level, memory_order_relaxed) != 0) return 1;
+    if (openmpt_module_set_render_param(handle->mod, param, value) != 1) return 0;
+    atomic_store_explicit(applied, value, memory_order_relaxed);
+    return 1;
+}
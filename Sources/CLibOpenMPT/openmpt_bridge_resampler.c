@@ -0,0 +1,264 @@
+// openmpt_bridge_resampler.c
+// Polyphase Kaiser-windowed sinc resampler for converting one render to several output rates
+
+#include "openmpt_bridge_resampler.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Input frames buffered per channel between filter passes, on top of the taps
+#define BRIDGE_RESAMPLER_CHUNK 1024
+// Longest filter, reached when downsampling stretches the base tap count
+#define BRIDGE_RESAMPLER_MAX_TAPS 256
+#define BRIDGE_RESAMPLER_MAX_DECIMATION 16
+
+typedef struct bridge_resampler_preset {
+    int taps;
+    double beta;        // Kaiser window shape; higher trades transition width for stopband
+    double rolloff;     // Passband edge as a fraction of the lower Nyquist frequency
+} bridge_resampler_preset;
+
+static const bridge_resampler_preset bridge_resampler_presets[] = {
+    { 16, 6.0, 0.90 },
+    { 32, 8.0, 0.94 },
+    { 64, 10.0, 0.96 },
+};
+
+struct openmpt_bridge_resampler {
+    int channels;
+    int taps;
+    int64_t up;         // L: output rate / gcd
+    int64_t down;       // M: input rate / gcd
+    int phases;
+    float* coeffs;      // phases * taps, each phase 16-byte aligned
+    float* buffer[OPENMPT_BRIDGE_RESAMPLER_MAX_CHANNELS];
+    size_t capacity;    // frames per channel buffer
+    size_t filled;      // frames held in each channel buffer
+    size_t pos;         // first tap of the next output frame, may run past filled
+    int64_t phase;      // numerator of the fractional position, in [0, up)
+    float* silence;     // latency frames of zeros for flush
+};
+
+// MARK: - Filter Design
+
+static int64_t bridge_gcd(int64_t a, int64_t b) {
+    while (b) {
+        int64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Zeroth-order modified Bessel function of the first kind
+static double bridge_bessel_i0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    double half = x * 0.5;
+    for (int k = 1; k < 64; k++) {
+        term *= (half / k) * (half / k);
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+// One phase of the filter bank. Tap k sits under input frame pos + k and
+// the output is taken at pos + taps/2 - 1 + fraction.
+static void bridge_resampler_design_phase(float* coeffs, int taps, double fraction, double cutoff, double beta) {
+    double half = taps * 0.5;
+    double norm = bridge_bessel_i0(beta);
+    double sum = 0.0;
+    double h[BRIDGE_RESAMPLER_MAX_TAPS];
+    for (int k = 0; k < taps; k++) {
+        double t = (double)k - (half - 1.0) - fraction;
+        double x = t / half;
+        double window = fabs(x) < 1.0 ? bridge_bessel_i0(beta * sqrt(1.0 - x * x)) / norm : 0.0;
+        double arg = M_PI * cutoff * t;
+        double sinc = fabs(arg) < 1e-9 ? 1.0 : sin(arg) / arg;
+        h[k] = cutoff * sinc * window;
+        sum += h[k];
+    }
+    // Normalize each phase to unity gain at DC so phases cannot ripple against each other
+    for (int k = 0; k < taps; k++) coeffs[k] = (float)(sum != 0.0 ? h[k] / sum : 0.0);
+}
+
+// MARK: - Dot Product
+
+#if defined(__GNUC__) || defined(__clang__)
+
+// Compiler vector extensions lower to SSE on x86 and NEON on ARM
+typedef float bridge_v4f __attribute__((vector_size(16)));
+
+static inline float bridge_resampler_dot(const float* restrict samples, const float* restrict coeffs, int taps) {
+    bridge_v4f acc0 = { 0.0f, 0.0f, 0.0f, 0.0f };
+    bridge_v4f acc1 = acc0;
+    for (int k = 0; k < taps; k += 8) {
+        bridge_v4f x0, x1;
+        memcpy(&x0, samples + k, sizeof(x0));
+        memcpy(&x1, samples + k + 4, sizeof(x1));
+        acc0 += x0 * *(const bridge_v4f*)(coeffs + k);
+        acc1 += x1 * *(const bridge_v4f*)(coeffs + k + 4);
+    }
+    acc0 += acc1;
+    return acc0[0] + acc0[1] + acc0[2] + acc0[3];
+}
+
+#else
+
+static inline float bridge_resampler_dot(const float* samples, const float* coeffs, int taps) {
+    float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (int k = 0; k < taps; k += 4) {
+        acc[0] += samples[k] * coeffs[k];
+        acc[1] += samples[k + 1] * coeffs[k + 1];
+        acc[2] += samples[k + 2] * coeffs[k + 2];
+        acc[3] += samples[k + 3] * coeffs[k + 3];
+    }
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+#endif
+
+// MARK: - Lifecycle
+
+openmpt_bridge_resampler* openmpt_bridge_resampler_create(int32_t input_rate, int32_t output_rate, int channels, int quality) {
+    if (input_rate <= 0 || output_rate <= 0) return NULL;
+    if ((int64_t)input_rate > (int64_t)output_rate * BRIDGE_RESAMPLER_MAX_DECIMATION) return NULL;
+    if (channels < 1 || channels > OPENMPT_BRIDGE_RESAMPLER_MAX_CHANNELS) return NULL;
+    if (quality < OPENMPT_BRIDGE_RESAMPLER_FAST || quality > OPENMPT_BRIDGE_RESAMPLER_BEST) return NULL;
+
+    const bridge_resampler_preset* preset = &bridge_resampler_presets[quality];
+    int64_t divisor = bridge_gcd(input_rate, output_rate);
+    double ratio = (double)output_rate / (double)input_rate;
+    double cutoff = (ratio < 1.0 ? ratio : 1.0) * preset->rolloff;
+
+    // Downsampling narrows the passband in input samples, so the filter
+    // widens to keep the same transition band at the output rate
+    int taps = preset->taps;
+    if (ratio < 1.0) taps = (int)ceil(preset->taps / ratio);
+    taps = (taps + 7) & ~7;
+    if (taps > BRIDGE_RESAMPLER_MAX_TAPS) taps = BRIDGE_RESAMPLER_MAX_TAPS;
+
+    openmpt_bridge_resampler* resampler = calloc(1, sizeof(*resampler));
+    if (!resampler) return NULL;
+    resampler->channels = channels;
+    resampler->taps = taps;
+    resampler->up = output_rate / divisor;
+    resampler->down = input_rate / divisor;
+    resampler->phases = resampler->up <= OPENMPT_BRIDGE_RESAMPLER_MAX_PHASES ? (int)resampler->up : OPENMPT_BRIDGE_RESAMPLER_MAX_PHASES;
+    resampler->capacity = (size_t)taps + BRIDGE_RESAMPLER_CHUNK;
+
+    resampler->coeffs = aligned_alloc(16, (size_t)resampler->phases * (size_t)taps * sizeof(float));
+    resampler->silence = calloc((size_t)taps * (size_t)channels, sizeof(float));
+    int ok = resampler->coeffs && resampler->silence;
+    for (int c = 0; c < channels && ok; c++) {
+        resampler->buffer[c] = calloc(resampler->capacity, sizeof(float));
+        ok = resampler->buffer[c] != NULL;
+    }
+    if (!ok) {
+        openmpt_bridge_resampler_destroy(resampler);
+        return NULL;
+    }
+
+    for (int p = 0; p < resampler->phases; p++) {
+        bridge_resampler_design_phase(resampler->coeffs + (size_t)p * (size_t)taps, taps,
+                                      (double)p / resampler->phases, cutoff, preset->beta);
+    }
+    openmpt_bridge_resampler_reset(resampler);
+    return resampler;
+}
+
+void openmpt_bridge_resampler_destroy(openmpt_bridge_resampler* resampler) {
+    if (!resampler) return;
+    for (int c = 0; c < OPENMPT_BRIDGE_RESAMPLER_MAX_CHANNELS; c++) free(resampler->buffer[c]);
+    free(resampler->coeffs);
+    free(resampler->silence);
+    free(resampler);
+}
+
+void openmpt_bridge_resampler_reset(openmpt_bridge_resampler* resampler) {
+    if (!resampler) return;
+    // Leading zeros put the first output frame at input time 0
+    size_t lead = (size_t)resampler->taps / 2 - 1;
+    for (int c = 0; c < resampler->channels; c++) memset(resampler->buffer[c], 0, lead * sizeof(float));
+    resampler->filled = lead;
+    resampler->pos = 0;
+    resampler->phase = 0;
+}
+
+// MARK: - Processing
+
+size_t openmpt_bridge_resampler_process(openmpt_bridge_resampler* resampler, const float* input, size_t* input_frames, float* output, size_t output_frames) {
+    if (!resampler || !input_frames) return 0;
+    size_t available = input ? *input_frames : 0;
+    size_t consumed = 0;
+    size_t produced = 0;
+    int channels = resampler->channels;
+    int taps = resampler->taps;
+
+    for (;;) {
+        while (produced < output_frames && resampler->pos + (size_t)taps <= resampler->filled) {
+            int phase = resampler->phases == resampler->up
+                ? (int)resampler->phase
+                : (int)(resampler->phase * resampler->phases / resampler->up);
+            const float* coeffs = resampler->coeffs + (size_t)phase * (size_t)taps;
+            float* frame = output + produced * (size_t)channels;
+            for (int c = 0; c < channels; c++) {
+                frame[c] = bridge_resampler_dot(resampler->buffer[c] + resampler->pos, coeffs, taps);
+            }
+            produced++;
+            resampler->phase += resampler->down;
+            resampler->pos += (size_t)(resampler->phase / resampler->up);
+            resampler->phase %= resampler->up;
+        }
+        if (produced == output_frames || consumed == available) break;
+
+        // Drop frames no later output can reach, then top the buffers up
+        size_t keep = resampler->pos < resampler->filled ? resampler->filled - resampler->pos : 0;
+        if (resampler->pos > 0) {
+            for (int c = 0; c < channels && keep > 0; c++) {
+                memmove(resampler->buffer[c], resampler->buffer[c] + resampler->pos, keep * sizeof(float));
+            }
+            resampler->pos -= resampler->filled - keep;
+            resampler->filled = keep;
+        }
+        size_t count = resampler->capacity - resampler->filled;
+        if (count > available - consumed) count = available - consumed;
+        const float* source = input + consumed * (size_t)channels;
+        for (int c = 0; c < channels; c++) {
+            float* destination = resampler->buffer[c] + resampler->filled;
+            for (size_t i = 0; i < count; i++) destination[i] = source[i * (size_t)channels + (size_t)c];
+        }
+        resampler->filled += count;
+        consumed += count;
+    }
+
+    *input_frames = consumed;
+    return produced;
+}
+
+size_t openmpt_bridge_resampler_flush(openmpt_bridge_resampler* resampler, float* output, size_t output_frames) {
+    if (!resampler) return 0;
+    size_t frames = (size_t)openmpt_bridge_resampler_get_latency(resampler);
+    return openmpt_bridge_resampler_process(resampler, resampler->silence, &frames, output, output_frames);
+}
+
+size_t openmpt_bridge_resampler_max_output(const openmpt_bridge_resampler* resampler, size_t input_frames) {
+    if (!resampler) return 0;
+    // Frames already buffered can contribute up to a full filter's worth of output
+    size_t frames = input_frames + (size_t)resampler->taps;
+    return (size_t)(((uint64_t)frames * (uint64_t)resampler->up) / (uint64_t)resampler->down) + 1;
+}
+
+int openmpt_bridge_resampler_get_latency(const openmpt_bridge_resampler* resampler) {
+    return resampler ? resampler->taps / 2 : 0;
+}
+
+int openmpt_bridge_resampler_get_taps(const openmpt_bridge_resampler* resampler) {
+    return resampler ? resampler->taps : 0;
+}
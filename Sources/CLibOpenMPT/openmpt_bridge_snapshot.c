@@ -0,0 +1,276 @@
+// openmpt_bridge_snapshot.c
+// Immutable per-load snapshots and the seqlock-published playback position
+
+#include "openmpt_bridge_snapshot.h"
+#include "bridge_internal.h"
+#include "bridge_module_internal.h"
+#include "bridge_pattern_store.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// MARK: - Snapshot
+
+struct bridge_snapshot {
+    openmpt_bridge_snapshot snapshot;   // first, so the public pointer converts back
+    atomic_int references;
+    bridge_pattern_store* cells;
+};
+
+static char* bridge_snapshot_copy_string(const char* value, const char* fallback) {
+    char* copy = strdup(value ? value : fallback);
+    if (value) openmpt_free_string(value);
+    return copy;
+}
+
+static void bridge_snapshot_free_strings(char** strings, int32_t count) {
+    if (!strings) return;
+    for (int32_t i = 0; i < count; i++) free(strings[i]);
+    free(strings);
+}
+
+static void bridge_snapshot_destroy(bridge_snapshot* owner) {
+    openmpt_bridge_snapshot* snapshot = &owner->snapshot;
+    free((char*)snapshot->title);
+    free((char*)snapshot->artist);
+    free((char*)snapshot->type);
+    free((char*)snapshot->type_long);
+    free((char*)snapshot->tracker);
+    free((char*)snapshot->message);
+    free((int32_t*)snapshot->orders);
+    if (snapshot->patterns) {
+        for (int32_t i = 0; i < snapshot->num_patterns; i++) free((char*)snapshot->patterns[i].name);
+        free((openmpt_bridge_snapshot_pattern*)snapshot->patterns);
+    }
+    bridge_snapshot_free_strings((char**)snapshot->instrument_names, snapshot->num_instruments);
+    bridge_snapshot_free_strings((char**)snapshot->sample_names, snapshot->num_samples);
+    bridge_pattern_store_destroy(owner->cells);
+    free(owner);
+}
+
+// Layout only; cells are decoded by the pattern store on first access
+static int bridge_snapshot_read_pattern(openmpt_module* mod, int32_t index, openmpt_bridge_snapshot_pattern* pattern) {
+    pattern->rows = openmpt_module_get_pattern_num_rows(mod, index);
+    pattern->rows_per_beat = openmpt_module_get_pattern_rows_per_beat(mod, index);
+    pattern->rows_per_measure = openmpt_module_get_pattern_rows_per_measure(mod, index);
+    pattern->name = bridge_snapshot_copy_string(openmpt_module_get_pattern_name(mod, index), "");
+    return pattern->name != NULL;
+}
+
+// Names are 1-based in libopenmpt's C API
+typedef const char* (*bridge_name_func)(openmpt_module* mod, int32_t index);
+
+static char** bridge_snapshot_read_names(openmpt_module* mod, int32_t count, bridge_name_func name) {
+    char** names = calloc(count > 0 ? (size_t)count : 1, sizeof(*names));
+    if (!names) return NULL;
+    for (int32_t i = 0; i < count; i++) {
+        names[i] = bridge_snapshot_copy_string(name(mod, i + 1), "");
+        if (!names[i]) {
+            bridge_snapshot_free_strings(names, i);
+            return NULL;
+        }
+    }
+    return names;
+}
+
+bridge_snapshot* bridge_snapshot_create(openmpt_module* mod, const void* data, size_t size) {
+    bridge_snapshot* owner = calloc(1, sizeof(*owner));
+    if (!owner) return NULL;
+    atomic_init(&owner->references, 1);
+    openmpt_bridge_snapshot* snapshot = &owner->snapshot;
+
+    snapshot->title = bridge_copy_metadata(mod, "title");
+    snapshot->artist = bridge_copy_metadata(mod, "artist");
+    snapshot->type = bridge_copy_metadata(mod, "type");
+    snapshot->type_long = bridge_copy_metadata(mod, "type_long");
+    snapshot->tracker = bridge_copy_metadata(mod, "tracker");
+    snapshot->message = bridge_copy_metadata(mod, "message");
+    snapshot->duration = openmpt_module_get_duration_seconds(mod);
+    if (!snapshot->title || !snapshot->artist || !snapshot->type || !snapshot->type_long ||
+        !snapshot->tracker || !snapshot->message) goto fail;
+
+    int32_t channels = openmpt_module_get_num_channels(mod);
+    snapshot->num_channels = channels > 0 ? channels : 0;
+    snapshot->num_subsongs = openmpt_module_get_num_subsongs(mod);
+
+    // Counts are set as each table is filled so a failure frees only what exists
+    int32_t orders = openmpt_module_get_num_orders(mod);
+    int32_t* order_patterns = calloc(orders > 0 ? (size_t)orders : 1, sizeof(*order_patterns));
+    snapshot->orders = order_patterns;
+    if (!order_patterns) goto fail;
+    // Order start times each cost a scan of the song, so the store works
+    // them out on request instead
+    for (int32_t i = 0; i < orders; i++) order_patterns[i] = openmpt_module_get_order_pattern(mod, i);
+    snapshot->num_orders = orders > 0 ? orders : 0;
+
+    int32_t patterns = openmpt_module_get_num_patterns(mod);
+    openmpt_bridge_snapshot_pattern* pattern_table = calloc(patterns > 0 ? (size_t)patterns : 1, sizeof(*pattern_table));
+    snapshot->patterns = pattern_table;
+    if (!pattern_table) goto fail;
+    int32_t* pattern_rows = calloc(patterns > 0 ? (size_t)patterns : 1, sizeof(*pattern_rows));
+    if (!pattern_rows) goto fail;
+    for (int32_t i = 0; i < patterns; i++) {
+        snapshot->num_patterns = i + 1;
+        if (!bridge_snapshot_read_pattern(mod, i, &pattern_table[i])) {
+            free(pattern_rows);
+            goto fail;
+        }
+        pattern_rows[i] = pattern_table[i].rows;
+    }
+    owner->cells = bridge_pattern_store_create(data, size, snapshot->num_channels, snapshot->num_orders,
+                                               snapshot->num_patterns, pattern_rows, OPENMPT_BRIDGE_PATTERN_CACHE_BYTES);
+    free(pattern_rows);
+    if (!owner->cells) goto fail;
+
+    int32_t instruments = openmpt_module_get_num_instruments(mod);
+    snapshot->instrument_names = (const char* const*)bridge_snapshot_read_names(mod, instruments, openmpt_module_get_instrument_name);
+    if (!snapshot->instrument_names) goto fail;
+    snapshot->num_instruments = instruments > 0 ? instruments : 0;
+
+    int32_t samples = openmpt_module_get_num_samples(mod);
+    snapshot->sample_names = (const char* const*)bridge_snapshot_read_names(mod, samples, openmpt_module_get_sample_name);
+    if (!snapshot->sample_names) goto fail;
+    snapshot->num_samples = samples > 0 ? samples : 0;
+    return owner;
+
+fail:
+    bridge_snapshot_destroy(owner);
+    return NULL;
+}
+
+void bridge_snapshot_retain(bridge_snapshot* owner) {
+    atomic_fetch_add_explicit(&owner->references, 1, memory_order_relaxed);
+}
+
+void bridge_snapshot_release(bridge_snapshot* owner) {
+    if (!owner) return;
+    if (atomic_fetch_sub_explicit(&owner->references, 1, memory_order_acq_rel) == 1) bridge_snapshot_destroy(owner);
+}
+
+const openmpt_bridge_snapshot* openmpt_bridge_module_acquire_snapshot(openmpt_bridge_module* handle) {
+    if (!handle) return NULL;
+    // Only control threads take this lock; the render thread never reads snapshots
+    pthread_mutex_lock(&handle->snapshot_lock);
+    bridge_snapshot* owner = handle->snapshot;
+    if (owner) bridge_snapshot_retain(owner);
+    pthread_mutex_unlock(&handle->snapshot_lock);
+    return owner ? &owner->snapshot : NULL;
+}
+
+void openmpt_bridge_snapshot_release(const openmpt_bridge_snapshot* snapshot) {
+    bridge_snapshot_release((bridge_snapshot*)snapshot);
+}
+
+// The pattern store is the one mutable part of a snapshot and locks itself
+static bridge_pattern_store* bridge_snapshot_cells(const openmpt_bridge_snapshot* snapshot) {
+    return snapshot ? ((const bridge_snapshot*)snapshot)->cells : NULL;
+}
+
+int openmpt_bridge_snapshot_get_cell(const openmpt_bridge_snapshot* snapshot, int32_t pattern, int32_t channel, int32_t row, openmpt_pattern_cell* cell) {
+    if (!snapshot || !cell) return 0;
+    return bridge_pattern_store_get_cell(bridge_snapshot_cells(snapshot), pattern, row, channel, cell);
+}
+
+int openmpt_bridge_snapshot_get_row(const openmpt_bridge_snapshot* snapshot, int32_t pattern, int32_t row, openmpt_pattern_cell* cells) {
+    if (!snapshot || !cells) return 0;
+    return bridge_pattern_store_get_row(bridge_snapshot_cells(snapshot), pattern, row, cells);
+}
+
+void openmpt_bridge_snapshot_prefetch(const openmpt_bridge_snapshot* snapshot, int32_t order, int32_t count) {
+    if (!snapshot || order < 0 || count <= 0) return;
+    bridge_pattern_store* cells = bridge_snapshot_cells(snapshot);
+    int32_t end = count > snapshot->num_orders - order ? snapshot->num_orders : order + count;
+    for (int32_t i = order; i < end; i++) {
+        // Markers such as "+++" and "---" are outside the pattern range
+        bridge_pattern_store_prefetch(cells, snapshot->orders[i]);
+    }
+}
+
+double openmpt_bridge_snapshot_get_order_time(const openmpt_bridge_snapshot* snapshot, int32_t order) {
+    return bridge_pattern_store_get_order_time(bridge_snapshot_cells(snapshot), order);
+}
+
+int openmpt_bridge_snapshot_get_cache_stats(const openmpt_bridge_snapshot* snapshot, openmpt_bridge_pattern_cache_stats* stats) {
+    if (!snapshot || !stats) return 0;
+    bridge_pattern_store_get_stats(bridge_snapshot_cells(snapshot), stats);
+    return 1;
+}
+
+int openmpt_bridge_snapshot_set_cache_budget(const openmpt_bridge_snapshot* snapshot, size_t bytes) {
+    if (!snapshot) return 0;
+    bridge_pattern_store_set_budget(bridge_snapshot_cells(snapshot), bytes);
+    return 1;
+}
+
+void openmpt_bridge_module_prefetch_patterns(openmpt_bridge_module* handle, int32_t count) {
+    openmpt_bridge_position position;
+    if (count < 0 || !openmpt_bridge_module_get_position(handle, &position) || position.order < 0) return;
+    const openmpt_bridge_snapshot* snapshot = openmpt_bridge_module_acquire_snapshot(handle);
+    if (!snapshot) return;
+    openmpt_bridge_snapshot_prefetch(snapshot, position.order, count + 1);
+    openmpt_bridge_snapshot_release(snapshot);
+}
+
+// MARK: - Position
+
+void bridge_position_init(bridge_position* position) {
+    atomic_init(&position->sequence, 0);
+    atomic_init(&position->valid, 0);
+    atomic_init(&position->seconds, 0);
+    atomic_init(&position->tempo, 0);
+    atomic_init(&position->order, 0);
+    atomic_init(&position->pattern, 0);
+    atomic_init(&position->row, 0);
+    atomic_init(&position->speed, 0);
+    atomic_init(&position->subsong, 0);
+    atomic_init(&position->playing_channels, 0);
+}
+
+// Single writer at a time: the render thread in real-time mode, otherwise
+// the thread that owns the handle
+void bridge_position_publish(openmpt_bridge_module* handle) {
+    bridge_position* position = &handle->position;
+    openmpt_module* mod = handle->mod;
+    unsigned sequence = atomic_load_explicit(&position->sequence, memory_order_relaxed);
+    atomic_store_explicit(&position->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    atomic_store_explicit(&position->valid, mod != NULL, memory_order_relaxed);
+    if (mod) {
+        atomic_store_explicit(&position->seconds, bridge_double_bits(openmpt_module_get_position_seconds(mod)), memory_order_relaxed);
+        atomic_store_explicit(&position->tempo, bridge_double_bits(openmpt_module_get_current_tempo2(mod)), memory_order_relaxed);
+        atomic_store_explicit(&position->order, openmpt_module_get_current_order(mod), memory_order_relaxed);
+        atomic_store_explicit(&position->pattern, openmpt_module_get_current_pattern(mod), memory_order_relaxed);
+        atomic_store_explicit(&position->row, openmpt_module_get_current_row(mod), memory_order_relaxed);
+        atomic_store_explicit(&position->speed, openmpt_module_get_current_speed(mod), memory_order_relaxed);
+        atomic_store_explicit(&position->subsong, openmpt_module_get_selected_subsong(mod), memory_order_relaxed);
+        atomic_store_explicit(&position->playing_channels, openmpt_module_get_current_playing_channels(mod), memory_order_relaxed);
+    }
+    atomic_store_explicit(&position->at_end, mod != NULL && handle->at_end, memory_order_relaxed);
+
+    atomic_store_explicit(&position->sequence, sequence + 2, memory_order_release);
+}
+
+int openmpt_bridge_module_get_position(const openmpt_bridge_module* handle, openmpt_bridge_position* out) {
+    if (!handle || !out) return 0;
+    const bridge_position* position = &handle->position;
+    int valid;
+    unsigned before, after;
+    do {
+        before = bridge_atomic_load_uint(&position->sequence, memory_order_acquire);
+        if (before & 1) continue;   // a write is in progress
+        valid = bridge_atomic_load_int(&position->valid, memory_order_relaxed);
+        out->seconds = bridge_bits_double(bridge_atomic_load_u64(&position->seconds, memory_order_relaxed));
+        out->tempo = bridge_bits_double(bridge_atomic_load_u64(&position->tempo, memory_order_relaxed));
+        out->order = bridge_atomic_load_int(&position->order, memory_order_relaxed);
+        out->pattern = bridge_atomic_load_int(&position->pattern, memory_order_relaxed);
+        out->row = bridge_atomic_load_int(&position->row, memory_order_relaxed);
+        out->speed = bridge_atomic_load_int(&position->speed, memory_order_relaxed);
+        out->subsong = bridge_atomic_load_int(&position->subsong, memory_order_relaxed);
+        out->playing_channels = bridge_atomic_load_int(&position->playing_channels, memory_order_relaxed);
+        out->at_end = bridge_atomic_load_int(&position->at_end, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        after = bridge_atomic_load_uint(&position->sequence, memory_order_relaxed);
+    } while ((before & 1) || before != after);
+    return valid;
+}
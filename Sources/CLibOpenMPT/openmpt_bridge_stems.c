@@ -0,0 +1,369 @@
+// openmpt_bridge_stems.c
+// One muted-down instance per channel on the thread pool, feeding a shared writer thread
+
+#include "openmpt_bridge_stems.h"
+#include "bridge_internal.h"
+#include "bridge_pcm.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BRIDGE_STEMS_DEFAULT_RATE 48000
+#define BRIDGE_STEMS_DEFAULT_BLOCK 32768
+// Converted blocks in flight per worker before workers wait for the writer
+#define BRIDGE_STEMS_BLOCKS_PER_WORKER 2
+
+void openmpt_bridge_stem_options_init(openmpt_bridge_stem_options* stems) {
+    if (!stems) return;
+    memset(stems, 0, sizeof(*stems));
+    stems->subsong = -1;
+    stems->skip_empty_channels = 1;
+}
+
+int openmpt_bridge_stem_path(char* buffer, size_t size, const char* output_prefix, int32_t channel, int32_t container) {
+    return snprintf(buffer, size, "%s_ch%02d.%s", output_prefix, channel + 1,
+                    container == OPENMPT_BRIDGE_CONTAINER_RAW ? "raw" : "wav");
+}
+
+// MARK: - Shared writer
+//
+// Workers convert their own blocks, which keeps the single writer thread
+// down to positional writes into whichever stem file a block belongs to.
+
+typedef struct bridge_stem_block {
+    struct bridge_stem_block* next;
+    int fd;
+    uint64_t offset;
+    size_t bytes;
+    uint8_t data[];
+} bridge_stem_block;
+
+typedef struct bridge_stem_writer {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t queued;      // the writer waits for blocks
+    pthread_cond_t freed;       // workers wait for free blocks
+    bridge_stem_block* free_blocks;
+    bridge_stem_block* head;
+    bridge_stem_block* tail;
+    bridge_stem_block** all;
+    size_t block_count;
+    int closing;
+    int failed;
+    uint64_t wait_ns;
+} bridge_stem_writer;
+
+static void* bridge_stem_writer_main(void* arg) {
+    bridge_stem_writer* writer = (bridge_stem_writer*)arg;
+    pthread_mutex_lock(&writer->lock);
+    for (;;) {
+        while (!writer->head && !writer->closing) pthread_cond_wait(&writer->queued, &writer->lock);
+        bridge_stem_block* block = writer->head;
+        if (!block) break; // closing and drained
+        writer->head = block->next;
+        if (!writer->head) writer->tail = NULL;
+        pthread_mutex_unlock(&writer->lock);
+
+        int ok = bridge_pwrite_all(block->fd, block->data, block->bytes, block->offset);
+
+        pthread_mutex_lock(&writer->lock);
+        if (!ok) writer->failed = 1;
+        block->next = writer->free_blocks;
+        writer->free_blocks = block;
+        pthread_cond_signal(&writer->freed);
+    }
+    pthread_mutex_unlock(&writer->lock);
+    return NULL;
+}
+
+static void bridge_stem_writer_free_blocks(bridge_stem_writer* writer) {
+    for (size_t i = 0; i < writer->block_count; i++) free(writer->all[i]);
+    free(writer->all);
+}
+
+static int bridge_stem_writer_open(bridge_stem_writer* writer, size_t block_count, size_t block_bytes) {
+    memset(writer, 0, sizeof(*writer));
+    writer->all = calloc(block_count, sizeof(*writer->all));
+    if (!writer->all) return 0;
+    for (size_t i = 0; i < block_count; i++) {
+        bridge_stem_block* block = malloc(sizeof(*block) + block_bytes);
+        if (!block) {
+            bridge_stem_writer_free_blocks(writer);
+            return 0;
+        }
+        block->next = writer->free_blocks;
+        writer->free_blocks = block;
+        writer->all[writer->block_count++] = block;
+    }
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->queued, NULL);
+    pthread_cond_init(&writer->freed, NULL);
+    if (pthread_create(&writer->thread, NULL, bridge_stem_writer_main, writer) != 0) {
+        pthread_mutex_destroy(&writer->lock);
+        pthread_cond_destroy(&writer->queued);
+        pthread_cond_destroy(&writer->freed);
+        bridge_stem_writer_free_blocks(writer);
+        return 0;
+    }
+    return 1;
+}
+
+static bridge_stem_block* bridge_stem_writer_acquire(bridge_stem_writer* writer) {
+    pthread_mutex_lock(&writer->lock);
+    if (!writer->free_blocks) {
+        uint64_t start = bridge_now_ns();
+        while (!writer->free_blocks) pthread_cond_wait(&writer->freed, &writer->lock);
+        writer->wait_ns += bridge_now_ns() - start;
+    }
+    bridge_stem_block* block = writer->free_blocks;
+    writer->free_blocks = block->next;
+    pthread_mutex_unlock(&writer->lock);
+    return block;
+}
+
+// Returns 0 once any write has failed, so workers can stop early
+static int bridge_stem_writer_submit(bridge_stem_writer* writer, bridge_stem_block* block) {
+    pthread_mutex_lock(&writer->lock);
+    block->next = NULL;
+    if (writer->tail) writer->tail->next = block;
+    else writer->head = block;
+    writer->tail = block;
+    int ok = !writer->failed;
+    pthread_cond_signal(&writer->queued);
+    pthread_mutex_unlock(&writer->lock);
+    return ok;
+}
+
+static int bridge_stem_writer_close(bridge_stem_writer* writer) {
+    pthread_mutex_lock(&writer->lock);
+    writer->closing = 1;
+    pthread_cond_signal(&writer->queued);
+    pthread_mutex_unlock(&writer->lock);
+    pthread_join(writer->thread, NULL);
+
+    int ok = !writer->failed;
+    pthread_mutex_destroy(&writer->lock);
+    pthread_cond_destroy(&writer->queued);
+    pthread_cond_destroy(&writer->freed);
+    bridge_stem_writer_free_blocks(writer);
+    return ok;
+}
+
+// MARK: - Workers
+
+typedef struct bridge_stem {
+    int32_t channel;
+    int fd;
+    uint64_t frames;
+    uint64_t render_ns;
+    int ok;
+} bridge_stem;
+
+typedef struct bridge_stem_export {
+    const void* data;
+    size_t size;
+    openmpt_bridge_export_options settings;
+    int32_t subsong;
+    int32_t channels;
+    size_t frame_bytes;
+    size_t header_size;
+    uint64_t frame_limit;
+    bridge_stem* stems;
+    bridge_stem_writer writer;
+} bridge_stem_export;
+
+// A channel is empty when no played pattern row triggers a note or instrument on it
+static int bridge_stem_channel_empty(openmpt_module* mod, int32_t channel) {
+    int32_t orders = openmpt_module_get_num_orders(mod);
+    for (int32_t order = 0; order < orders; order++) {
+        int32_t pattern = openmpt_module_get_order_pattern(mod, order);
+        int32_t rows = openmpt_module_get_pattern_num_rows(mod, pattern);
+        for (int32_t row = 0; row < rows; row++) {
+            if (openmpt_module_get_pattern_row_channel_command(mod, pattern, row, channel, OPENMPT_MODULE_COMMAND_NOTE) ||
+                openmpt_module_get_pattern_row_channel_command(mod, pattern, row, channel, OPENMPT_MODULE_COMMAND_INSTRUMENT)) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static openmpt_module_ext* bridge_stem_instance(const bridge_stem_export* job, int32_t solo) {
+    int error = 0;
+    openmpt_module_ext* mod_ext = openmpt_module_ext_create_from_memory(job->data, job->size, (void*)openmpt_log_func_silent,
+                                                                        NULL, NULL, NULL, &error, NULL, NULL);
+    if (!mod_ext) return NULL;
+    openmpt_module* mod = openmpt_module_ext_get_module(mod_ext);
+    openmpt_module_ext_interface_interactive interactive;
+    int ok = openmpt_module_ext_get_interface(mod_ext, LIBOPENMPT_EXT_C_INTERFACE_INTERACTIVE,
+                                              &interactive, sizeof(interactive));
+    if (ok && job->subsong >= 0) ok = openmpt_module_select_subsong(mod, job->subsong);
+    for (int32_t channel = 0; ok && channel < job->channels; channel++) {
+        if (channel != solo) ok = interactive.set_channel_mute_status(mod_ext, channel, 1);
+    }
+    if (!ok) {
+        openmpt_module_ext_destroy(mod_ext);
+        return NULL;
+    }
+    openmpt_module_set_repeat_count(mod, 0);
+    return mod_ext;
+}
+
+static void bridge_stem_render(void* ctx, size_t index, int worker) {
+    (void)worker;
+    bridge_stem_export* job = (bridge_stem_export*)ctx;
+    bridge_stem* stem = &job->stems[index];
+    const size_t block_frames = (size_t)job->settings.block_frames;
+
+    openmpt_module_ext* mod_ext = bridge_stem_instance(job, stem->channel);
+    float* block = malloc(block_frames * 2 * sizeof(float));
+    if (!mod_ext || !block) goto done;
+    openmpt_module* mod = openmpt_module_ext_get_module(mod_ext);
+
+    int ok = 1;
+    uint64_t render_ns = 0;
+    while (ok && stem->frames < job->frame_limit) {
+        size_t wanted = job->frame_limit - stem->frames < block_frames ? (size_t)(job->frame_limit - stem->frames) : block_frames;
+        uint64_t start = bridge_now_ns();
+        size_t rendered = openmpt_module_read_interleaved_float_stereo(mod, job->settings.sample_rate, wanted, block);
+        render_ns += bridge_now_ns() - start;
+        if (rendered) {
+            bridge_stem_block* out = bridge_stem_writer_acquire(&job->writer);
+            bridge_convert_samples(block, out->data, rendered * 2, job->settings.format);
+            out->fd = stem->fd;
+            out->offset = job->header_size + stem->frames * job->frame_bytes;
+            out->bytes = rendered * job->frame_bytes;
+            ok = bridge_stem_writer_submit(&job->writer, out);
+        }
+        stem->frames += rendered;
+        if (rendered < wanted) break; // end of song
+    }
+    stem->render_ns = render_ns;
+    stem->ok = ok;
+
+done:
+    free(block);
+    if (mod_ext) openmpt_module_ext_destroy(mod_ext);
+}
+
+// MARK: - Export
+
+int openmpt_bridge_export_stems(const void* data, size_t size, const char* output_prefix, const openmpt_bridge_export_options* options, const openmpt_bridge_stem_options* stems, openmpt_bridge_stem_result* result) {
+    if (!data || !size || !output_prefix) return 0;
+
+    bridge_stem_export job;
+    memset(&job, 0, sizeof(job));
+    job.data = data;
+    job.size = size;
+    openmpt_bridge_export_options_init(&job.settings);
+    if (options) job.settings = *options;
+    if (job.settings.sample_rate <= 0) job.settings.sample_rate = BRIDGE_STEMS_DEFAULT_RATE;
+    if (job.settings.block_frames <= 0) job.settings.block_frames = BRIDGE_STEMS_DEFAULT_BLOCK;
+    job.frame_bytes = bridge_sample_bytes(job.settings.format) * 2;
+    if (!job.frame_bytes) return 0;
+    if (job.settings.container != OPENMPT_BRIDGE_CONTAINER_WAV && job.settings.container != OPENMPT_BRIDGE_CONTAINER_RAW) return 0;
+    job.frame_limit = job.settings.max_seconds > 0.0 ? (uint64_t)(job.settings.max_seconds * job.settings.sample_rate) : UINT64_MAX;
+
+    openmpt_bridge_stem_options split;
+    openmpt_bridge_stem_options_init(&split);
+    if (stems) split = *stems;
+    job.subsong = split.subsong;
+
+    openmpt_bridge_stem_result summary;
+    memset(&summary, 0, sizeof(summary));
+    uint64_t start = bridge_now_ns();
+
+    // Count channels and find empty ones on a throwaway instance
+    int error = 0;
+    openmpt_module* planner = openmpt_module_create_from_memory2(data, size, (void*)openmpt_log_func_silent, NULL,
+                                                                 NULL, NULL, &error, NULL, NULL);
+    if (!planner) return 0;
+    job.channels = openmpt_module_get_num_channels(planner);
+    summary.channels = job.channels;
+    job.stems = job.channels > 0 ? calloc((size_t)job.channels, sizeof(*job.stems)) : NULL;
+    size_t stem_count = 0;
+    for (int32_t channel = 0; job.stems && channel < job.channels; channel++) {
+        if (split.skip_empty_channels && bridge_stem_channel_empty(planner, channel)) {
+            summary.empty_channels++;
+            continue;
+        }
+        job.stems[stem_count].channel = channel;
+        job.stems[stem_count].fd = -1;
+        stem_count++;
+    }
+    openmpt_module_destroy(planner);
+    if (!job.stems) return 0;
+
+    int ok = 1;
+    char path[4096];
+    uint8_t header[BRIDGE_WAV_HEADER_MAX];
+    if (job.settings.container == OPENMPT_BRIDGE_CONTAINER_WAV) {
+        job.header_size = bridge_wav_header(header, job.settings.format, job.settings.sample_rate, 2, 0);
+    }
+    for (size_t k = 0; ok && k < stem_count; k++) {
+        openmpt_bridge_stem_path(path, sizeof(path), output_prefix, job.stems[k].channel, job.settings.container);
+        job.stems[k].fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        ok = job.stems[k].fd >= 0;
+    }
+
+    int threads = bridge_resolve_thread_count(split.thread_count, stem_count);
+    size_t block_count = (size_t)threads * BRIDGE_STEMS_BLOCKS_PER_WORKER;
+    if (ok && stem_count) {
+        ok = bridge_stem_writer_open(&job.writer, block_count, (size_t)job.settings.block_frames * job.frame_bytes);
+        if (ok) {
+            bridge_parallel_for(stem_count, threads, bridge_stem_render, &job);
+            ok = bridge_stem_writer_close(&job.writer);
+        }
+    }
+
+    uint64_t render_ns = 0;
+    uint64_t frames = 0;
+    for (size_t k = 0; k < stem_count; k++) {
+        bridge_stem* stem = &job.stems[k];
+        ok = ok && stem->ok;
+        render_ns += stem->render_ns;
+        if (stem->frames > frames) frames = stem->frames;
+        if (ok && job.header_size) {
+            bridge_wav_header(header, job.settings.format, job.settings.sample_rate, 2, stem->frames * job.frame_bytes);
+            ok = bridge_pwrite_all(stem->fd, header, job.header_size, 0);
+        }
+    }
+    for (size_t k = 0; k < stem_count; k++) {
+        if (job.stems[k].fd >= 0 && close(job.stems[k].fd) != 0) ok = 0;
+    }
+    if (!ok) {
+        for (size_t k = 0; k < stem_count; k++) {
+            if (job.stems[k].fd < 0) continue;
+            openmpt_bridge_stem_path(path, sizeof(path), output_prefix, job.stems[k].channel, job.settings.container);
+            unlink(path);
+        }
+    }
+    free(job.stems);
+
+    if (result) {
+        summary.stems_written = ok ? (int32_t)stem_count : 0;
+        summary.totals.frames = frames;
+        summary.totals.audio_seconds = (double)frames / job.settings.sample_rate;
+        summary.totals.render_seconds = (double)render_ns * 1e-9;
+        summary.totals.write_wait_seconds = (double)job.writer.wait_ns * 1e-9;
+        summary.totals.wall_seconds = (double)(bridge_now_ns() - start) * 1e-9;
+        summary.totals.realtime_factor = summary.totals.wall_seconds > 0.0
+            ? summary.totals.audio_seconds * (double)summary.stems_written / summary.totals.wall_seconds : 0.0;
+        *result = summary;
+    }
+    return ok;
+}
+
+int openmpt_bridge_export_stems_file(const char* module_path, const char* output_prefix, const openmpt_bridge_export_options* options, const openmpt_bridge_stem_options* stems, openmpt_bridge_stem_result* result) {
+    void* data = NULL;
+    size_t size = 0;
+    if (!bridge_read_file(module_path, &data, &size)) return 0;
+
+    int ok = openmpt_bridge_export_stems(data, size, output_prefix, options, stems, result);
+    free(data);
+    return ok;
+}
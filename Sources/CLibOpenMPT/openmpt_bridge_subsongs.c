@@ -0,0 +1,68 @@
+// openmpt_bridge_subsongs.c
+// All-subsong durations, restart positions and names in one pass
+
+#include "openmpt_bridge_subsongs.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+openmpt_bridge_subsong_table* openmpt_bridge_subsongs_create(openmpt_module* mod) {
+    if (!mod) return NULL;
+
+    int32_t count = openmpt_module_get_num_subsongs(mod);
+    if (count < 0) return NULL;
+
+    // Names are fetched first so the table can be one allocation:
+    // header, entries, then the packed name strings
+    const char** names = calloc((size_t)(count ? count : 1), sizeof(*names));
+    if (!names) return NULL;
+    size_t names_size = 0;
+    for (int32_t i = 0; i < count; i++) {
+        names[i] = openmpt_module_get_subsong_name(mod, i);
+        names_size += strlen(names[i] ? names[i] : "") + 1;
+    }
+
+    size_t header_size = sizeof(openmpt_bridge_subsong_table);
+    size_t entries_size = (size_t)count * sizeof(openmpt_bridge_subsong);
+    openmpt_bridge_subsong_table* table = malloc(header_size + entries_size + names_size);
+    if (!table) {
+        for (int32_t i = 0; i < count; i++) {
+            if (names[i]) openmpt_free_string(names[i]);
+        }
+        free(names);
+        return NULL;
+    }
+    table->count = count;
+    table->subsongs = (openmpt_bridge_subsong*)((unsigned char*)table + header_size);
+    char* pool = (char*)table->subsongs + entries_size;
+
+    int32_t selected = openmpt_module_get_selected_subsong(mod);
+    double position = openmpt_module_get_position_seconds(mod);
+
+    for (int32_t i = 0; i < count; i++) {
+        openmpt_bridge_subsong* subsong = &table->subsongs[i];
+        // Selecting a subsong only moves the play position; the duration
+        // comes from the song-length scan libopenmpt did at load time
+        subsong->duration = openmpt_module_select_subsong(mod, i) ? openmpt_module_get_duration_seconds(mod) : 0.0;
+        subsong->restart_order = openmpt_module_get_restart_order(mod, i);
+        subsong->restart_row = openmpt_module_get_restart_row(mod, i);
+
+        const char* name = names[i] ? names[i] : "";
+        size_t length = strlen(name) + 1;
+        memcpy(pool, name, length);
+        subsong->name = pool;
+        pool += length;
+        if (names[i]) openmpt_free_string(names[i]);
+    }
+    free(names);
+
+    if (count > 0) {
+        openmpt_module_select_subsong(mod, selected);
+        openmpt_module_set_position_seconds(mod, position);
+    }
+    return table;
+}
+
+void openmpt_bridge_subsongs_destroy(openmpt_bridge_subsong_table* table) {
+    free(table);
+}
@@ -0,0 +1,241 @@
+// openmpt_bridge_taps.c
+// Fan-out of rendered blocks to per-consumer lock-free rings with their own rate, channels and format
+
+#include "openmpt_bridge_taps.h"
+#include "openmpt_bridge_resampler.h"
+#include "bridge_internal.h"
+#include "bridge_module_internal.h"
+#include "bridge_pcm.h"
+
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct openmpt_bridge_tap {
+    openmpt_bridge_tap_options options;
+    size_t frame_bytes;
+    uint8_t* ring;              // options.capacity_frames frames in the output format
+
+    // Single-producer (render thread), single-consumer (reader) frame counters
+    atomic_size_t head;
+    atomic_size_t tail;
+
+    atomic_uint_fast64_t written;
+    atomic_uint_fast64_t dropped;
+    atomic_uint_fast64_t skipped;
+
+    // Render thread only
+    openmpt_bridge_resampler* resampler;
+    float* converted;           // one chunk after resampling, stereo
+    size_t converted_frames;
+};
+
+// MARK: - Lifecycle
+
+void openmpt_bridge_tap_options_init(openmpt_bridge_tap_options* options) {
+    if (!options) return;
+    options->sample_rate = 0;
+    options->source_rate = 0;
+    options->channels = 2;
+    options->format = OPENMPT_BRIDGE_SAMPLE_FORMAT_F32;
+    options->quality = OPENMPT_BRIDGE_RESAMPLER_BALANCED;
+    options->capacity_frames = 16384;
+}
+
+static void bridge_tap_free(openmpt_bridge_tap* tap) {
+    if (!tap) return;
+    openmpt_bridge_resampler_destroy(tap->resampler);
+    free(tap->converted);
+    free(tap->ring);
+    free(tap);
+}
+
+static openmpt_bridge_tap* bridge_tap_create(const openmpt_bridge_tap_options* options) {
+    if (options->channels != 1 && options->channels != 2) return NULL;
+    if (bridge_sample_bytes(options->format) == 0 || options->capacity_frames == 0) return NULL;
+    if (options->sample_rate < 0 || (options->sample_rate > 0 && options->source_rate <= 0)) return NULL;
+
+    openmpt_bridge_tap* tap = calloc(1, sizeof(*tap));
+    if (!tap) return NULL;
+    tap->options = *options;
+    tap->frame_bytes = bridge_sample_bytes(options->format) * (size_t)options->channels;
+    atomic_init(&tap->head, 0);
+    atomic_init(&tap->tail, 0);
+    atomic_init(&tap->written, 0);
+    atomic_init(&tap->dropped, 0);
+    atomic_init(&tap->skipped, 0);
+
+    tap->ring = malloc(options->capacity_frames * tap->frame_bytes);
+    int ok = tap->ring != NULL;
+    if (ok && options->sample_rate > 0 && options->sample_rate != options->source_rate) {
+        tap->resampler = openmpt_bridge_resampler_create(options->source_rate, options->sample_rate, 2, options->quality);
+        tap->converted_frames = openmpt_bridge_resampler_max_output(tap->resampler, BRIDGE_TAP_CHUNK);
+        tap->converted = tap->resampler ? malloc(tap->converted_frames * 2 * sizeof(float)) : NULL;
+        ok = tap->converted != NULL;
+    } else if (ok && options->channels == 1) {
+        tap->converted_frames = BRIDGE_TAP_CHUNK;
+        tap->converted = malloc(tap->converted_frames * sizeof(float));
+        ok = tap->converted != NULL;
+    }
+    if (!ok) {
+        bridge_tap_free(tap);
+        return NULL;
+    }
+    return tap;
+}
+
+void bridge_taps_init(bridge_taps* taps) {
+    for (int i = 0; i < OPENMPT_BRIDGE_MAX_TAPS; i++) atomic_init(&taps->slots[i], NULL);
+    atomic_init(&taps->attached, 0);
+    atomic_init(&taps->epoch, 0);
+}
+
+void bridge_taps_destroy(bridge_taps* taps) {
+    for (int i = 0; i < OPENMPT_BRIDGE_MAX_TAPS; i++) {
+        bridge_tap_free(atomic_exchange(&taps->slots[i], NULL));
+    }
+    atomic_store(&taps->attached, 0);
+}
+
+openmpt_bridge_tap* openmpt_bridge_tap_attach(openmpt_bridge_module* handle, const openmpt_bridge_tap_options* options) {
+    if (!handle) return NULL;
+    openmpt_bridge_tap_options defaults;
+    if (!options) {
+        openmpt_bridge_tap_options_init(&defaults);
+        options = &defaults;
+    }
+    openmpt_bridge_tap* tap = bridge_tap_create(options);
+    if (!tap) return NULL;
+
+    bridge_taps* taps = &handle->taps;
+    for (int i = 0; i < OPENMPT_BRIDGE_MAX_TAPS; i++) {
+        openmpt_bridge_tap* expected = NULL;
+        if (atomic_compare_exchange_strong(&taps->slots[i], &expected, tap)) {
+            atomic_fetch_add(&taps->attached, 1);
+            return tap;
+        }
+    }
+    bridge_tap_free(tap);
+    return NULL;
+}
+
+void openmpt_bridge_tap_detach(openmpt_bridge_module* handle, openmpt_bridge_tap* tap) {
+    if (!handle || !tap) return;
+    bridge_taps* taps = &handle->taps;
+    int found = 0;
+    for (int i = 0; i < OPENMPT_BRIDGE_MAX_TAPS && !found; i++) {
+        openmpt_bridge_tap* expected = tap;
+        found = atomic_compare_exchange_strong(&taps->slots[i], &expected, NULL);
+    }
+    if (!found) return;
+    atomic_fetch_sub(&taps->attached, 1);
+
+    // The epoch is odd while the render thread walks the slots. Once it
+    // has moved on, no block can still hold the pointer cleared above.
+    unsigned epoch = atomic_load(&taps->epoch);
+    if (epoch & 1) {
+        while (atomic_load(&taps->epoch) == epoch) sched_yield();
+    }
+    bridge_tap_free(tap);
+}
+
+// MARK: - Render Thread
+
+// Append frames in the tap's format, dropping whatever does not fit
+static void bridge_tap_write(openmpt_bridge_tap* tap, const float* samples, size_t frames) {
+    size_t capacity = tap->options.capacity_frames;
+    size_t head = atomic_load_explicit(&tap->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&tap->tail, memory_order_acquire);
+    size_t space = capacity - (head - tail);
+    size_t count = frames < space ? frames : space;
+    size_t channels = (size_t)tap->options.channels;
+
+    size_t offset = head % capacity;
+    size_t first = count < capacity - offset ? count : capacity - offset;
+    bridge_convert_samples(samples, tap->ring + offset * tap->frame_bytes, first * channels, tap->options.format);
+    bridge_convert_samples(samples + first * channels, tap->ring, (count - first) * channels, tap->options.format);
+
+    atomic_store_explicit(&tap->head, head + count, memory_order_release);
+    atomic_fetch_add_explicit(&tap->written, count, memory_order_relaxed);
+    if (count < frames) atomic_fetch_add_explicit(&tap->dropped, frames - count, memory_order_relaxed);
+}
+
+static void bridge_tap_feed(openmpt_bridge_tap* tap, int32_t samplerate, const float* stereo, size_t frames) {
+    if (tap->options.sample_rate > 0 && samplerate != tap->options.source_rate) {
+        atomic_fetch_add_explicit(&tap->skipped, 1, memory_order_relaxed);
+        return;
+    }
+    const float* samples = stereo;
+    if (tap->resampler) {
+        size_t consumed = frames;
+        frames = openmpt_bridge_resampler_process(tap->resampler, stereo, &consumed, tap->converted, tap->converted_frames);
+        samples = tap->converted;
+    }
+    if (tap->options.channels == 1) {
+        // In place is safe: mono sample i only reads stereo samples 2i and 2i + 1
+        for (size_t i = 0; i < frames; i++) tap->converted[i] = 0.5f * (samples[i * 2] + samples[i * 2 + 1]);
+        samples = tap->converted;
+    }
+    bridge_tap_write(tap, samples, frames);
+}
+
+void bridge_taps_feed(openmpt_bridge_module* handle, int32_t samplerate, const float* interleaved,
+                      const float* left, const float* right, size_t frames) {
+    bridge_taps* taps = &handle->taps;
+    if (frames == 0 || atomic_load_explicit(&taps->attached, memory_order_relaxed) == 0) return;
+
+    atomic_fetch_add(&taps->epoch, 1);
+    for (size_t done = 0; done < frames; done += BRIDGE_TAP_CHUNK) {
+        size_t count = frames - done < BRIDGE_TAP_CHUNK ? frames - done : BRIDGE_TAP_CHUNK;
+        const float* stereo = interleaved ? interleaved + done * 2 : taps->scratch;
+        if (!interleaved) {
+            for (size_t i = 0; i < count; i++) {
+                taps->scratch[i * 2] = left[done + i];
+                taps->scratch[i * 2 + 1] = right[done + i];
+            }
+        }
+        for (int i = 0; i < OPENMPT_BRIDGE_MAX_TAPS; i++) {
+            openmpt_bridge_tap* tap = atomic_load(&taps->slots[i]);
+            if (tap) bridge_tap_feed(tap, samplerate, stereo, count);
+        }
+    }
+    atomic_fetch_add(&taps->epoch, 1);
+}
+
+// MARK: - Reader
+
+size_t openmpt_bridge_tap_read(openmpt_bridge_tap* tap, void* output, size_t frames) {
+    if (!tap || !output) return 0;
+    size_t capacity = tap->options.capacity_frames;
+    size_t tail = atomic_load_explicit(&tap->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&tap->head, memory_order_acquire);
+    size_t count = head - tail < frames ? head - tail : frames;
+
+    size_t offset = tail % capacity;
+    size_t first = count < capacity - offset ? count : capacity - offset;
+    memcpy(output, tap->ring + offset * tap->frame_bytes, first * tap->frame_bytes);
+    memcpy((uint8_t*)output + first * tap->frame_bytes, tap->ring, (count - first) * tap->frame_bytes);
+
+    atomic_store_explicit(&tap->tail, tail + count, memory_order_release);
+    return count;
+}
+
+size_t openmpt_bridge_tap_available(const openmpt_bridge_tap* tap) {
+    if (!tap) return 0;
+    size_t tail = bridge_atomic_load_size(&tap->tail, memory_order_relaxed);
+    size_t head = bridge_atomic_load_size(&tap->head, memory_order_acquire);
+    return head - tail;
+}
+
+size_t openmpt_bridge_tap_frame_bytes(const openmpt_bridge_tap* tap) {
+    return tap ? tap->frame_bytes : 0;
+}
+
+int openmpt_bridge_tap_get_stats(const openmpt_bridge_tap* tap, openmpt_bridge_tap_stats* stats) {
+    if (!tap || !stats) return 0;
+    stats->frames_written = bridge_atomic_load_u64(&tap->written, memory_order_relaxed);
+    stats->frames_read = bridge_atomic_load_size(&tap->tail, memory_order_relaxed);
+    stats->frames_dropped = bridge_atomic_load_u64(&tap->dropped, memory_order_relaxed);
+    stats->blocks_skipped = bridge_atomic_load_u64(&tap->skipped, memory_order_relaxed);
+    return 1;
+}
@@ -0,0 +1,317 @@
+// openmpt_bridge_waveform.c
+// Low-quality fast render into min/max/RMS pyramids, written once and mapped for reading
+
+#include "openmpt_bridge_waveform.h"
+#include "bridge_internal.h"
+#include "libopenmpt.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BRIDGE_WAVEFORM_BLOCK 4096
+
+static const char openmpt_bridge_waveform_magic[8] = { 'O', 'M', 'P', 'T', 'W', 'A', 'V', 0 };
+
+static size_t waveform_align8(size_t value) {
+    return (value + 7) & ~(size_t)7;
+}
+
+void openmpt_bridge_waveform_options_init(openmpt_bridge_waveform_options* options) {
+    if (!options) return;
+    memset(options, 0, sizeof(*options));
+    options->sample_rate = 11025;
+    options->frames_per_point = 128;
+    options->subsong = -1;
+    options->interpolation_filter = 1;
+}
+
+// MARK: - Builder
+
+// Exact statistics of one span; quantized only when the file is written
+typedef struct waveform_span {
+    float min;
+    float max;
+    double sum_squares;
+    uint64_t frames;
+} waveform_span;
+
+typedef struct waveform_levels {
+    waveform_span* spans[OPENMPT_BRIDGE_WAVEFORM_MAX_LEVELS];
+    size_t counts[OPENMPT_BRIDGE_WAVEFORM_MAX_LEVELS];
+    size_t capacity;                // of level 0
+    uint32_t level_count;
+} waveform_levels;
+
+static void waveform_levels_free(waveform_levels* levels) {
+    for (int i = 0; i < OPENMPT_BRIDGE_WAVEFORM_MAX_LEVELS; i++) free(levels->spans[i]);
+}
+
+// Level 0 span for the next point, growing the array as needed
+static waveform_span* waveform_next_span(waveform_levels* levels) {
+    if (levels->counts[0] == levels->capacity) {
+        size_t capacity = levels->capacity ? levels->capacity * 2 : 4096;
+        waveform_span* spans = realloc(levels->spans[0], capacity * sizeof(*spans));
+        if (!spans) return NULL;
+        levels->spans[0] = spans;
+        levels->capacity = capacity;
+    }
+    waveform_span* span = &levels->spans[0][levels->counts[0]++];
+    span->min = 0.0f;
+    span->max = 0.0f;
+    span->sum_squares = 0.0;
+    span->frames = 0;
+    return span;
+}
+
+static int waveform_render(openmpt_module* mod, const openmpt_bridge_waveform_options* options,
+                           waveform_levels* levels, uint64_t* total_frames) {
+    float* block = malloc(BRIDGE_WAVEFORM_BLOCK * 2 * sizeof(float));
+    if (!block) return 0;
+    const uint64_t per_point = (uint64_t)options->frames_per_point;
+    const uint64_t limit = options->max_seconds > 0.0 ? (uint64_t)(options->max_seconds * options->sample_rate) : UINT64_MAX;
+    waveform_span* span = NULL;
+    uint64_t frames = 0;
+    int ok = 1;
+
+    while (ok && frames < limit) {
+        size_t wanted = limit - frames < BRIDGE_WAVEFORM_BLOCK ? (size_t)(limit - frames) : BRIDGE_WAVEFORM_BLOCK;
+        size_t rendered = openmpt_module_read_interleaved_float_stereo(mod, options->sample_rate, wanted, block);
+        for (size_t i = 0; i < rendered; ) {
+            if (!span || span->frames == per_point) {
+                span = waveform_next_span(levels);
+                if (!span) {
+                    ok = 0;
+                    break;
+                }
+                span->min = block[i * 2];
+                span->max = block[i * 2];
+            }
+            // Fill the current point from as much of the block as it takes
+            size_t run = rendered - i < per_point - span->frames ? rendered - i : (size_t)(per_point - span->frames);
+            const float* samples = block + i * 2;
+            float low = span->min, high = span->max;
+            double squares = 0.0;
+            for (size_t k = 0; k < run * 2; k++) {
+                float value = samples[k];
+                low = value < low ? value : low;
+                high = value > high ? value : high;
+                squares += (double)value * value;
+            }
+            span->min = low;
+            span->max = high;
+            span->sum_squares += squares;
+            span->frames += run;
+            i += run;
+        }
+        frames += rendered;
+        if (rendered < wanted) break; // end of song
+    }
+    free(block);
+    *total_frames = frames;
+    return ok;
+}
+
+// Each level merges pairs of points of the one below until one point is left
+static int waveform_reduce(waveform_levels* levels) {
+    levels->level_count = 1;
+    while (levels->level_count < OPENMPT_BRIDGE_WAVEFORM_MAX_LEVELS && levels->counts[levels->level_count - 1] > 1) {
+        uint32_t level = levels->level_count;
+        const waveform_span* below = levels->spans[level - 1];
+        size_t below_count = levels->counts[level - 1];
+        size_t count = (below_count + 1) / 2;
+        waveform_span* spans = malloc(count * sizeof(*spans));
+        if (!spans) return 0;
+        for (size_t i = 0; i < count; i++) {
+            spans[i] = below[i * 2];
+            if (i * 2 + 1 == below_count) continue;
+            const waveform_span* next = &below[i * 2 + 1];
+            if (next->min < spans[i].min) spans[i].min = next->min;
+            if (next->max > spans[i].max) spans[i].max = next->max;
+            spans[i].sum_squares += next->sum_squares;
+            spans[i].frames += next->frames;
+        }
+        levels->spans[level] = spans;
+        levels->counts[level] = count;
+        levels->level_count++;
+    }
+    return 1;
+}
+
+static int16_t waveform_quantize(float value) {
+    long scaled = lrintf(value * 32767.0f);
+    if (scaled > 32767) scaled = 32767;
+    if (scaled < -32767) scaled = -32767;
+    return (int16_t)scaled;
+}
+
+static int waveform_write(const waveform_levels* levels, const openmpt_bridge_waveform_options* options,
+                          uint64_t content_hash, uint64_t total_frames, const char* path) {
+    openmpt_bridge_waveform_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, openmpt_bridge_waveform_magic, sizeof(header.magic));
+    header.version = OPENMPT_BRIDGE_WAVEFORM_VERSION;
+    header.point_size = sizeof(openmpt_bridge_waveform_point);
+    header.content_hash = content_hash;
+    header.sample_rate = options->sample_rate;
+    header.frames_per_point = options->frames_per_point;
+    header.subsong = options->subsong;
+    header.interpolation_filter = options->interpolation_filter;
+    header.max_seconds = options->max_seconds;
+    header.total_frames = total_frames;
+    header.level_count = levels->level_count;
+
+    size_t total = waveform_align8(sizeof(header));
+    uint64_t per_point = (uint64_t)options->frames_per_point;
+    for (uint32_t level = 0; level < levels->level_count; level++) {
+        header.levels[level].offset = total;
+        header.levels[level].count = levels->counts[level];
+        header.levels[level].frames_per_point = per_point << level;
+        total = waveform_align8(total + levels->counts[level] * sizeof(openmpt_bridge_waveform_point));
+    }
+
+    unsigned char* buffer = calloc(1, total);
+    if (!buffer) return 0;
+    memcpy(buffer, &header, sizeof(header));
+    for (uint32_t level = 0; level < levels->level_count; level++) {
+        openmpt_bridge_waveform_point* points = (openmpt_bridge_waveform_point*)(buffer + header.levels[level].offset);
+        const waveform_span* spans = levels->spans[level];
+        for (size_t i = 0; i < levels->counts[level]; i++) {
+            double mean = spans[i].frames ? spans[i].sum_squares / (double)(spans[i].frames * 2) : 0.0;
+            points[i].min = waveform_quantize(spans[i].min);
+            points[i].max = waveform_quantize(spans[i].max);
+            points[i].rms = (uint16_t)waveform_quantize((float)sqrt(mean));
+        }
+    }
+    int ok = bridge_write_file_atomic(path, buffer, total);
+    free(buffer);
+    return ok;
+}
+
+static int waveform_options_valid(const openmpt_bridge_waveform_options* options) {
+    return options->sample_rate > 0 && options->frames_per_point > 0 && options->max_seconds >= 0.0;
+}
+
+static int waveform_build(const void* data, size_t size, const openmpt_bridge_waveform_options* options,
+                          uint64_t content_hash, const char* path) {
+    int error = 0;
+    openmpt_module* mod = openmpt_module_create_from_memory2(data, size, (void*)openmpt_log_func_silent, NULL,
+                                                             NULL, NULL, &error, NULL, NULL);
+    if (!mod) return 0;
+    int ok = options->subsong < 0 || openmpt_module_select_subsong(mod, options->subsong);
+    if (ok) {
+        openmpt_module_set_repeat_count(mod, 0);
+        if (options->interpolation_filter > 0) {
+            openmpt_module_set_render_param(mod, OPENMPT_MODULE_RENDER_INTERPOLATIONFILTER_LENGTH, options->interpolation_filter);
+        }
+    }
+
+    waveform_levels levels;
+    memset(&levels, 0, sizeof(levels));
+    uint64_t total_frames = 0;
+    ok = ok && waveform_render(mod, options, &levels, &total_frames)
+            && waveform_reduce(&levels)
+            && waveform_write(&levels, options, content_hash, total_frames, path);
+    waveform_levels_free(&levels);
+    openmpt_module_destroy(mod);
+    return ok;
+}
+
+int openmpt_bridge_waveform_build(const void* data, size_t size, const openmpt_bridge_waveform_options* options, const char* path) {
+    if (!data || !size || !path) return 0;
+    openmpt_bridge_waveform_options settings;
+    openmpt_bridge_waveform_options_init(&settings);
+    if (options) settings = *options;
+    if (!waveform_options_valid(&settings)) return 0;
+    return waveform_build(data, size, &settings, bridge_hash64(data, size, 0), path);
+}
+
+// MARK: - Reader
+
+struct openmpt_bridge_waveform {
+    const unsigned char* mapping;
+    size_t mapping_size;
+    const openmpt_bridge_waveform_header* header;
+};
+
+openmpt_bridge_waveform* openmpt_bridge_waveform_open(const char* path) {
+    const void* data = NULL;
+    size_t size = 0;
+    if (!path || !bridge_map_file(path, &data, &size)) return NULL;
+
+    openmpt_bridge_waveform* waveform = calloc(1, sizeof(*waveform));
+    if (!waveform) {
+        bridge_unmap_file(data, size);
+        return NULL;
+    }
+    waveform->mapping = (const unsigned char*)data;
+    waveform->mapping_size = size;
+
+    const openmpt_bridge_waveform_header* header = (const openmpt_bridge_waveform_header*)data;
+    if (size < sizeof(*header)) goto invalid;
+    if (memcmp(header->magic, openmpt_bridge_waveform_magic, sizeof(header->magic)) != 0) goto invalid;
+    if (header->version != OPENMPT_BRIDGE_WAVEFORM_VERSION) goto invalid;
+    if (header->point_size != sizeof(openmpt_bridge_waveform_point)) goto invalid;
+    if (header->level_count < 1 || header->level_count > OPENMPT_BRIDGE_WAVEFORM_MAX_LEVELS) goto invalid;
+    for (uint32_t level = 0; level < header->level_count; level++) {
+        const openmpt_bridge_waveform_level* entry = &header->levels[level];
+        if ((entry->offset & 7) != 0 || entry->offset > size) goto invalid;
+        if (entry->count > (size - entry->offset) / sizeof(openmpt_bridge_waveform_point)) goto invalid;
+    }
+    waveform->header = header;
+    return waveform;
+
+invalid:
+    openmpt_bridge_waveform_close(waveform);
+    return NULL;
+}
+
+void openmpt_bridge_waveform_close(openmpt_bridge_waveform* waveform) {
+    if (!waveform) return;
+    bridge_unmap_file(waveform->mapping, waveform->mapping_size);
+    free(waveform);
+}
+
+openmpt_bridge_waveform* openmpt_bridge_waveform_load(const void* data, size_t size, const openmpt_bridge_waveform_options* options, const char* path) {
+    if (!data || !size || !path) return NULL;
+    openmpt_bridge_waveform_options settings;
+    openmpt_bridge_waveform_options_init(&settings);
+    if (options) settings = *options;
+    if (!waveform_options_valid(&settings)) return NULL;
+    uint64_t content_hash = bridge_hash64(data, size, 0);
+
+    openmpt_bridge_waveform* cached = openmpt_bridge_waveform_open(path);
+    if (cached) {
+        const openmpt_bridge_waveform_header* header = cached->header;
+        if (header->content_hash == content_hash && header->sample_rate == settings.sample_rate &&
+            header->frames_per_point == settings.frames_per_point && header->subsong == settings.subsong &&
+            header->interpolation_filter == settings.interpolation_filter && header->max_seconds == settings.max_seconds) {
+            return cached;
+        }
+        openmpt_bridge_waveform_close(cached);
+    }
+    if (!waveform_build(data, size, &settings, content_hash, path)) return NULL;
+    return openmpt_bridge_waveform_open(path);
+}
+
+const openmpt_bridge_waveform_header* openmpt_bridge_waveform_get_header(const openmpt_bridge_waveform* waveform) {
+    return waveform ? waveform->header : NULL;
+}
+
+const openmpt_bridge_waveform_point* openmpt_bridge_waveform_get_level(const openmpt_bridge_waveform* waveform, uint32_t level, uint64_t* count) {
+    if (count) *count = 0;
+    if (!waveform || level >= waveform->header->level_count) return NULL;
+    const openmpt_bridge_waveform_level* entry = &waveform->header->levels[level];
+    if (count) *count = entry->count;
+    return (const openmpt_bridge_waveform_point*)(waveform->mapping + entry->offset);
+}
+
+uint32_t openmpt_bridge_waveform_find_level(const openmpt_bridge_waveform* waveform, double frames_per_point) {
+    if (!waveform) return 0;
+    uint32_t best = 0;
+    for (uint32_t level = 1; level < waveform->header->level_count; level++) {
+        if ((double)waveform->header->levels[level].frames_per_point > frames_per_point) break;
+        best = level;
+    }
+    return best;
+}
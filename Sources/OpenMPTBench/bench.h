@@ -0,0 +1,115 @@
+// bench.h
+// Shared helpers for openmpt-bench: corpus loading, latency histograms,
+// resource usage and JSON output
+
+#ifndef OPENMPT_BENCH_H
+#define OPENMPT_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "libopenmpt.h"
+
+// MARK: - Corpus
+
+typedef struct bench_module {
+    char* path;         // relative to the corpus root
+    void* data;
+    size_t size;
+    char* type;         // libopenmpt "type" metadata, e.g. "it"
+} bench_module;
+
+typedef struct bench_corpus {
+    bench_module* modules;
+    size_t count;
+    uint64_t bytes;
+    size_t skipped;     // files that are not modules
+} bench_corpus;
+
+// Read every module below root into memory. Returns 1 on success.
+int bench_corpus_load(const char* root, bench_corpus* corpus);
+void bench_corpus_free(bench_corpus* corpus);
+
+// Load a module from memory with logging silenced
+openmpt_module* bench_module_create(const bench_module* module, const openmpt_module_initial_ctl* ctls);
+
+// MARK: - Timing
+
+uint64_t bench_now_ns(void);
+
+// Log-linear histogram of nanosecond durations, within ~3% per bucket
+#define BENCH_HISTOGRAM_BUCKETS 2048
+
+typedef struct bench_histogram {
+    uint64_t counts[BENCH_HISTOGRAM_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+    uint64_t sum;
+} bench_histogram;
+
+void bench_histogram_reset(bench_histogram* histogram);
+void bench_histogram_add(bench_histogram* histogram, uint64_t ns);
+// Value at quantile q in [0, 1], in nanoseconds
+uint64_t bench_histogram_quantile(const bench_histogram* histogram, double q);
+
+// Peak resident set size of this process in KiB
+uint64_t bench_peak_rss_kb(void);
+
+// MARK: - Allocation counting
+
+typedef struct bench_alloc_stats {
+    uint64_t allocations;
+    uint64_t frees;
+    uint64_t bytes;             // usable bytes handed out
+    uint64_t peak_live_bytes;   // high-water mark of bytes allocated and not yet freed
+} bench_alloc_stats;
+
+// 1 if the malloc hooks are active in this build (glibc only)
+int bench_alloc_available(void);
+// Count allocations made by any thread between begin and end
+void bench_alloc_begin(void);
+void bench_alloc_end(bench_alloc_stats* stats);
+
+// MARK: - JSON
+
+void bench_json_string(FILE* out, const char* value);
+// "key": {"p50": ..., "p90": ..., "p99": ..., "p999": ..., "max": ..., "mean": ...} in microseconds
+void bench_json_latency(FILE* out, const char* key, const bench_histogram* histogram);
+// Fields shared by every report: benchmark name, library versions and corpus summary
+void bench_json_header(FILE* out, const char* benchmark, const char* root, const bench_corpus* corpus);
+
+// MARK: - Benchmarks
+
+typedef struct bench_render_options {
+    const int32_t* sample_rates;
+    size_t sample_rate_count;
+    const int32_t* interpolations;
+    size_t interpolation_count;
+    double seconds;         // audio rendered per module and configuration
+    size_t block_frames;
+    int per_module;         // include a realtime factor for every module
+} bench_render_options;
+
+int bench_render(FILE* out, const char* root, const bench_corpus* corpus, const bench_render_options* options);
+
+typedef struct bench_load_options {
+    int iterations;         // loads per module and load path
+} bench_load_options;
+
+int bench_load(FILE* out, const char* root, const bench_corpus* corpus, const bench_load_options* options);
+
+// Most output rates one resample run compares
+#define BENCH_MAX_RATES 16
+
+typedef struct bench_resample_options {
+    int32_t base_rate;      // the single render every output rate is converted from
+    const int32_t* sample_rates;
+    size_t sample_rate_count;
+    double seconds;         // audio rendered per module at each rate
+    size_t block_frames;
+} bench_resample_options;
+
+int bench_resample(FILE* out, const char* root, const bench_corpus* corpus, const bench_resample_options* options);
+
+#endif /* OPENMPT_BENCH_H */
@@ -0,0 +1,134 @@
+// bench_alloc.c
+// Interposed malloc family that counts allocations while a measurement is
+// active.
+//
+// Defining malloc and friends in the executable overrides the C library for
+// the whole process, including libopenmpt's operator new, which allocates
+// through malloc. The real allocator is reached through glibc's __libc_*
+// entry points, so counting is only available on glibc; elsewhere the
+// report marks allocation counts as unavailable.
+
+#include "bench.h"
+
+#include <string.h>
+
+#if defined(__GLIBC__)
+
+#include <errno.h>
+#include <malloc.h>
+#include <stdatomic.h>
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void* ptr);
+
+static atomic_int bench_alloc_active;
+static atomic_uint_fast64_t bench_alloc_count;
+static atomic_uint_fast64_t bench_alloc_frees;
+static atomic_uint_fast64_t bench_alloc_bytes;
+static atomic_int_fast64_t bench_alloc_live;
+static atomic_int_fast64_t bench_alloc_peak;
+
+static int bench_alloc_counting(void) {
+    return atomic_load_explicit(&bench_alloc_active, memory_order_relaxed);
+}
+
+static void bench_alloc_record(void* ptr) {
+    if (!ptr || !bench_alloc_counting()) return;
+    size_t size = malloc_usable_size(ptr);
+    atomic_fetch_add_explicit(&bench_alloc_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&bench_alloc_bytes, size, memory_order_relaxed);
+    int_fast64_t live = atomic_fetch_add_explicit(&bench_alloc_live, (int_fast64_t)size, memory_order_relaxed) + (int_fast64_t)size;
+    int_fast64_t peak = atomic_load_explicit(&bench_alloc_peak, memory_order_relaxed);
+    while (live > peak && !atomic_compare_exchange_weak_explicit(&bench_alloc_peak, &peak, live,
+                                                                 memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+static void bench_alloc_release(size_t size) {
+    atomic_fetch_add_explicit(&bench_alloc_frees, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&bench_alloc_live, (int_fast64_t)size, memory_order_relaxed);
+}
+
+void* malloc(size_t size) {
+    void* ptr = __libc_malloc(size);
+    bench_alloc_record(ptr);
+    return ptr;
+}
+
+void* calloc(size_t count, size_t size) {
+    void* ptr = __libc_calloc(count, size);
+    bench_alloc_record(ptr);
+    return ptr;
+}
+
+void* realloc(void* ptr, size_t size) {
+    int counting = ptr && bench_alloc_counting();
+    size_t old_size = counting ? malloc_usable_size(ptr) : 0;
+    void* moved = __libc_realloc(ptr, size);
+    // A failed realloc leaves the original block allocated
+    if (counting && (moved || !size)) bench_alloc_release(old_size);
+    bench_alloc_record(moved);
+    return moved;
+}
+
+void free(void* ptr) {
+    if (ptr && bench_alloc_counting()) bench_alloc_release(malloc_usable_size(ptr));
+    __libc_free(ptr);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    void* ptr = __libc_memalign(alignment, size);
+    bench_alloc_record(ptr);
+    return ptr;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1))) return EINVAL;
+    void* ptr = memalign(alignment, size);
+    if (!ptr) return ENOMEM;
+    *out = ptr;
+    return 0;
+}
+
+int bench_alloc_available(void) {
+    return 1;
+}
+
+void bench_alloc_begin(void) {
+    atomic_store(&bench_alloc_count, 0);
+    atomic_store(&bench_alloc_frees, 0);
+    atomic_store(&bench_alloc_bytes, 0);
+    atomic_store(&bench_alloc_live, 0);
+    atomic_store(&bench_alloc_peak, 0);
+    atomic_store(&bench_alloc_active, 1);
+}
+
+void bench_alloc_end(bench_alloc_stats* stats) {
+    atomic_store(&bench_alloc_active, 0);
+    stats->allocations = atomic_load(&bench_alloc_count);
+    stats->frees = atomic_load(&bench_alloc_frees);
+    stats->bytes = atomic_load(&bench_alloc_bytes);
+    stats->peak_live_bytes = (uint64_t)atomic_load(&bench_alloc_peak);
+}
+
+#else
+
+int bench_alloc_available(void) {
+    return 0;
+}
+
+void bench_alloc_begin(void) {
+}
+
+void bench_alloc_end(bench_alloc_stats* stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+#endif
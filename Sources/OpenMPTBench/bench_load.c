@@ -0,0 +1,219 @@
+// bench_load.c
+// Load-path timing and allocation counts, broken down by module type
+
+#include "bench.h"
+#include "openmpt_bridge_module.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum bench_load_path {
+    BENCH_LOAD_MEMORY = 0,      // openmpt_module_create_from_memory2
+    BENCH_LOAD_STREAM,          // openmpt_module_create2 over an in-memory stream
+    BENCH_LOAD_METADATA,        // create_from_memory2 skipping samples and plugins
+    BENCH_LOAD_BRIDGE,          // openmpt_bridge_module_load, snapshot included
+    BENCH_LOAD_PATH_COUNT
+} bench_load_path;
+
+static const char* const bench_load_path_names[BENCH_LOAD_PATH_COUNT] = { "memory", "stream", "metadata", "bridge" };
+
+// Same ctls the indexer uses for metadata-only loads
+static const openmpt_module_initial_ctl bench_load_metadata_ctls[] = {
+    { "load.skip_samples", "1" },
+    { "load.skip_plugins", "1" },
+    { NULL, NULL }
+};
+
+typedef struct bench_load_totals {
+    bench_histogram latency;
+    uint64_t loads;
+    uint64_t failures;
+    uint64_t bytes_loaded;      // module file bytes successfully loaded
+    uint64_t allocations;
+    uint64_t allocated_bytes;
+    uint64_t peak_live_bytes;   // largest single-load high-water mark
+} bench_load_totals;
+
+typedef struct bench_load_group {
+    const char* type;
+    size_t modules;
+    uint64_t bytes;
+    bench_load_totals paths[BENCH_LOAD_PATH_COUNT];
+} bench_load_group;
+
+// MARK: - Stream callbacks
+
+typedef struct bench_memory_stream {
+    const unsigned char* data;
+    size_t size;
+    size_t position;
+} bench_memory_stream;
+
+static size_t bench_stream_read(void* stream, void* dst, size_t bytes) {
+    bench_memory_stream* s = (bench_memory_stream*)stream;
+    size_t available = s->size - s->position;
+    if (bytes > available) bytes = available;
+    memcpy(dst, s->data + s->position, bytes);
+    s->position += bytes;
+    return bytes;
+}
+
+static int bench_stream_seek(void* stream, int64_t offset, int whence) {
+    bench_memory_stream* s = (bench_memory_stream*)stream;
+    int64_t base = whence == OPENMPT_STREAM_SEEK_SET ? 0
+                 : whence == OPENMPT_STREAM_SEEK_CUR ? (int64_t)s->position
+                 : (int64_t)s->size;
+    int64_t target = base + offset;
+    if (target < 0 || target > (int64_t)s->size) return -1;
+    s->position = (size_t)target;
+    return 0;
+}
+
+static int64_t bench_stream_tell(void* stream) {
+    return (int64_t)((bench_memory_stream*)stream)->position;
+}
+
+// MARK: - Measurement
+
+// bridge is the handle the bridge path loads into; the module it returns
+// belongs to that handle
+static openmpt_module* bench_load_once(const bench_module* module, bench_load_path path, openmpt_bridge_module* bridge) {
+    int error = 0;
+    switch (path) {
+    case BENCH_LOAD_MEMORY:
+        return bench_module_create(module, NULL);
+    case BENCH_LOAD_STREAM: {
+        bench_memory_stream stream = { (const unsigned char*)module->data, module->size, 0 };
+        openmpt_stream_callbacks callbacks = { bench_stream_read, bench_stream_seek, bench_stream_tell };
+        return openmpt_module_create2(callbacks, &stream, (void*)openmpt_log_func_silent, NULL,
+                                      NULL, NULL, &error, NULL, NULL);
+    }
+    case BENCH_LOAD_METADATA:
+        return bench_module_create(module, bench_load_metadata_ctls);
+    case BENCH_LOAD_BRIDGE:
+        if (!bridge || !openmpt_bridge_module_load(bridge, module->data, module->size, NULL, &error)) return NULL;
+        return openmpt_bridge_module_get_module(bridge);
+    default:
+        return NULL;
+    }
+}
+
+static void bench_load_measure(const bench_module* module, bench_load_path path,
+                               bench_load_totals* group, bench_load_totals* all) {
+    openmpt_bridge_module* bridge = path == BENCH_LOAD_BRIDGE ? openmpt_bridge_module_create() : NULL;
+    bench_alloc_stats allocs;
+    bench_alloc_begin();
+    uint64_t start = bench_now_ns();
+    openmpt_module* mod = bench_load_once(module, path, bridge);
+    uint64_t elapsed = bench_now_ns() - start;
+    bench_alloc_end(&allocs);
+
+    bench_load_totals* targets[2] = { group, all };
+    for (int t = 0; t < 2; t++) {
+        bench_load_totals* totals = targets[t];
+        if (!mod) {
+            totals->failures++;
+            continue;
+        }
+        bench_histogram_add(&totals->latency, elapsed);
+        totals->loads++;
+        totals->bytes_loaded += module->size;
+        totals->allocations += allocs.allocations;
+        totals->allocated_bytes += allocs.bytes;
+        if (allocs.peak_live_bytes > totals->peak_live_bytes) totals->peak_live_bytes = allocs.peak_live_bytes;
+    }
+    if (bridge) openmpt_bridge_module_destroy(bridge);
+    else if (mod) openmpt_module_destroy(mod);
+}
+
+typedef struct bench_load_groups {
+    bench_load_group** items;   // stable pointers; each group holds large histograms
+    size_t count;
+} bench_load_groups;
+
+static bench_load_group* bench_load_find_group(bench_load_groups* groups, const char* type) {
+    for (size_t i = 0; i < groups->count; i++) {
+        if (strcmp(groups->items[i]->type, type) == 0) return groups->items[i];
+    }
+    bench_load_group** items = realloc(groups->items, (groups->count + 1) * sizeof(*items));
+    if (!items) return NULL;
+    groups->items = items;
+    bench_load_group* group = calloc(1, sizeof(*group));
+    if (!group) return NULL;
+    group->type = type;
+    groups->items[groups->count++] = group;
+    return group;
+}
+
+// MARK: - Report
+
+static void bench_load_report_group(FILE* out, const bench_load_group* group, int counting) {
+    fprintf(out, "{\"type\": ");
+    bench_json_string(out, group->type);
+    fprintf(out, ", \"modules\": %zu, \"bytes\": %llu", group->modules, (unsigned long long)group->bytes);
+    for (int p = 0; p < BENCH_LOAD_PATH_COUNT; p++) {
+        const bench_load_totals* totals = &group->paths[p];
+        double seconds = (double)totals->latency.sum * 1e-9;
+        fprintf(out, ",\n     \"%s\": {\"loads\": %llu, \"failures\": %llu, \"mb_per_second\": %.2f, ",
+                bench_load_path_names[p], (unsigned long long)totals->loads, (unsigned long long)totals->failures,
+                seconds > 0.0 ? (double)totals->bytes_loaded / seconds / 1e6 : 0.0);
+        bench_json_latency(out, "load_us", &totals->latency);
+        if (counting && totals->loads) {
+            fprintf(out, ", \"allocations_per_load\": %.1f, \"allocated_bytes_per_load\": %.0f, \"peak_live_bytes\": %llu}",
+                    (double)totals->allocations / (double)totals->loads,
+                    (double)totals->allocated_bytes / (double)totals->loads,
+                    (unsigned long long)totals->peak_live_bytes);
+        } else {
+            fprintf(out, ", \"allocations_per_load\": null, \"allocated_bytes_per_load\": null, \"peak_live_bytes\": null}");
+        }
+    }
+    fprintf(out, "}");
+}
+
+int bench_load(FILE* out, const char* root, const bench_corpus* corpus, const bench_load_options* options) {
+    bench_load_groups groups = { NULL, 0 };
+    bench_load_group* all = calloc(1, sizeof(*all));
+    if (!all) return 0;
+    all->type = "all";
+
+    int ok = 1;
+    for (size_t i = 0; ok && i < corpus->count; i++) {
+        const bench_module* module = &corpus->modules[i];
+        bench_load_group* group = bench_load_find_group(&groups, module->type);
+        if (!group) {
+            ok = 0;
+            break;
+        }
+        group->modules++;
+        group->bytes += module->size;
+        all->modules++;
+        all->bytes += module->size;
+
+        // Interleave the paths so cache warmth affects them equally
+        for (int iteration = 0; iteration < options->iterations; iteration++) {
+            for (int p = 0; p < BENCH_LOAD_PATH_COUNT; p++) {
+                bench_load_measure(module, (bench_load_path)p, &group->paths[p], &all->paths[p]);
+            }
+        }
+    }
+
+    if (ok) {
+        int counting = bench_alloc_available();
+        fprintf(out, "{\n");
+        bench_json_header(out, "load", root, corpus);
+        fprintf(out, "  \"iterations\": %d,\n  \"allocation_counting\": %s,\n  \"all\": ",
+                options->iterations, counting ? "true" : "false");
+        bench_load_report_group(out, all, counting);
+        fprintf(out, ",\n  \"types\": [");
+        for (size_t i = 0; i < groups.count; i++) {
+            fprintf(out, "%s\n    ", i ? "," : "");
+            bench_load_report_group(out, groups.items[i], counting);
+        }
+        fprintf(out, "\n  ],\n  \"peak_rss_kb\": %llu\n}\n", (unsigned long long)bench_peak_rss_kb());
+    }
+
+    for (size_t i = 0; i < groups.count; i++) free(groups.items[i]);
+    free(groups.items);
+    free(all);
+    return ok;
+}
@@ -0,0 +1,129 @@
+// bench_render.c
+// Render throughput and per-block latency across sample rates and
+// interpolation filter lengths
+
+#include "bench.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct bench_render_config {
+    int32_t sample_rate;
+    int32_t interpolation;
+    bench_histogram blocks;
+    uint64_t frames;
+    uint64_t render_ns;
+    size_t failed;          // modules that could not be loaded
+    size_t slowest;         // index of the module with the lowest realtime factor
+    double slowest_factor;
+    double* factors;        // per module, when requested
+} bench_render_config;
+
+// Render seconds of audio from one module, timing every block
+static int bench_render_module(const bench_module* module, const bench_render_options* options,
+                               bench_render_config* config, float* buffer, double* factor) {
+    openmpt_module* mod = bench_module_create(module, NULL);
+    if (!mod) return 0;
+    // Loop forever so every module renders the same amount of audio
+    openmpt_module_set_repeat_count(mod, -1);
+    openmpt_module_set_render_param(mod, OPENMPT_MODULE_RENDER_INTERPOLATIONFILTER_LENGTH, config->interpolation);
+
+    uint64_t target = (uint64_t)(options->seconds * config->sample_rate);
+    uint64_t frames = 0;
+    uint64_t render_ns = 0;
+    while (frames < target) {
+        size_t wanted = target - frames < options->block_frames ? (size_t)(target - frames) : options->block_frames;
+        uint64_t start = bench_now_ns();
+        size_t rendered = openmpt_module_read_interleaved_float_stereo(mod, config->sample_rate, wanted, buffer);
+        uint64_t elapsed = bench_now_ns() - start;
+        if (rendered == 0) break;
+        bench_histogram_add(&config->blocks, elapsed);
+        render_ns += elapsed;
+        frames += rendered;
+    }
+    openmpt_module_destroy(mod);
+
+    config->frames += frames;
+    config->render_ns += render_ns;
+    *factor = render_ns ? ((double)frames / config->sample_rate) / ((double)render_ns * 1e-9) : 0.0;
+    return 1;
+}
+
+static void bench_render_report(FILE* out, const bench_corpus* corpus, const bench_render_options* options,
+                                const bench_render_config* config, int last) {
+    double audio = (double)config->frames / config->sample_rate;
+    double render = (double)config->render_ns * 1e-9;
+    fprintf(out, "    {\"sample_rate\": %d, \"interpolation\": %d, \"audio_seconds\": %.3f, \"render_seconds\": %.6f, "
+                 "\"realtime_factor\": %.2f, \"failed\": %zu, \"block_budget_us\": %.3f,\n     ",
+            config->sample_rate, config->interpolation, audio, render,
+            render > 0.0 ? audio / render : 0.0, config->failed,
+            (double)options->block_frames / config->sample_rate * 1e6);
+    bench_json_latency(out, "block_latency_us", &config->blocks);
+    if (corpus->count) {
+        fprintf(out, ",\n     \"slowest\": {\"path\": ");
+        bench_json_string(out, corpus->modules[config->slowest].path);
+        fprintf(out, ", \"realtime_factor\": %.2f}", config->slowest_factor);
+    }
+    if (config->factors) {
+        fprintf(out, ",\n     \"modules\": [");
+        for (size_t i = 0; i < corpus->count; i++) {
+            fprintf(out, "%s\n       {\"path\": ", i ? "," : "");
+            bench_json_string(out, corpus->modules[i].path);
+            fprintf(out, ", \"type\": ");
+            bench_json_string(out, corpus->modules[i].type);
+            fprintf(out, ", \"realtime_factor\": %.2f}", config->factors[i]);
+        }
+        fprintf(out, "\n     ]");
+    }
+    fprintf(out, "}%s\n", last ? "" : ",");
+}
+
+int bench_render(FILE* out, const char* root, const bench_corpus* corpus, const bench_render_options* options) {
+    float* buffer = malloc(options->block_frames * 2 * sizeof(float));
+    bench_render_config* config = malloc(sizeof(*config));
+    if (!buffer || !config) {
+        free(buffer);
+        free(config);
+        return 0;
+    }
+
+    fprintf(out, "{\n");
+    bench_json_header(out, "render", root, corpus);
+    fprintf(out, "  \"seconds_per_module\": %.3f,\n  \"block_frames\": %zu,\n  \"configurations\": [\n",
+            options->seconds, options->block_frames);
+
+    int ok = 1;
+    size_t total = options->sample_rate_count * options->interpolation_count;
+    for (size_t r = 0; ok && r < options->sample_rate_count; r++) {
+        for (size_t k = 0; ok && k < options->interpolation_count; k++) {
+            memset(config, 0, sizeof(*config));
+            config->sample_rate = options->sample_rates[r];
+            config->interpolation = options->interpolations[k];
+            config->slowest_factor = -1.0;
+            if (options->per_module && corpus->count && !(config->factors = calloc(corpus->count, sizeof(double)))) {
+                ok = 0;
+                break;
+            }
+
+            for (size_t i = 0; i < corpus->count; i++) {
+                double factor = 0.0;
+                if (!bench_render_module(&corpus->modules[i], options, config, buffer, &factor)) {
+                    config->failed++;
+                    continue;
+                }
+                if (config->factors) config->factors[i] = factor;
+                if (config->slowest_factor < 0.0 || factor < config->slowest_factor) {
+                    config->slowest_factor = factor;
+                    config->slowest = i;
+                }
+            }
+            bench_render_report(out, corpus, options, config, r * options->interpolation_count + k + 1 == total);
+            free(config->factors);
+        }
+    }
+
+    fprintf(out, "  ],\n  \"peak_rss_kb\": %llu\n}\n", (unsigned long long)bench_peak_rss_kb());
+    free(config);
+    free(buffer);
+    return ok;
+}
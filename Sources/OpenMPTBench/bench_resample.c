@@ -0,0 +1,210 @@
+// bench_resample.c
+// Rendering once at a base rate and resampling to every output rate,
+// against rendering each output rate separately
+
+#include "bench.h"
+#include "openmpt_bridge_resampler.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BENCH_RESAMPLE_QUALITIES 3
+
+static const char* const bench_resample_quality_names[BENCH_RESAMPLE_QUALITIES] = { "fast", "balanced", "best" };
+
+// Frequency of the test tone used to measure conversion accuracy
+#define BENCH_RESAMPLE_TONE_HZ 1000.0
+
+typedef struct bench_resample_target {
+    int32_t sample_rate;
+    uint64_t direct_ns;
+    uint64_t resample_ns[BENCH_RESAMPLE_QUALITIES];
+    int taps[BENCH_RESAMPLE_QUALITIES];
+    double snr_db[BENCH_RESAMPLE_QUALITIES];
+} bench_resample_target;
+
+// Render up to frames from a fresh module at rate. Returns frames rendered
+// and adds the render time to *ns.
+static size_t bench_resample_render(const bench_module* module, int32_t rate, size_t frames, size_t block_frames,
+                                    float* output, uint64_t* ns) {
+    openmpt_module* mod = bench_module_create(module, NULL);
+    if (!mod) return 0;
+    openmpt_module_set_repeat_count(mod, -1);
+    size_t done = 0;
+    uint64_t start = bench_now_ns();
+    while (done < frames) {
+        size_t wanted = frames - done < block_frames ? frames - done : block_frames;
+        size_t rendered = openmpt_module_read_interleaved_float_stereo(mod, rate, wanted, output + done * 2);
+        if (rendered == 0) break;
+        done += rendered;
+    }
+    *ns += bench_now_ns() - start;
+    openmpt_module_destroy(mod);
+    return done;
+}
+
+// Convert a stereo buffer block by block, as a mixer feeding an output would
+static size_t bench_resample_convert(openmpt_bridge_resampler* resampler, const float* input, size_t frames,
+                                     size_t block_frames, float* output, size_t capacity) {
+    size_t consumed = 0;
+    size_t produced = 0;
+    while (consumed < frames) {
+        size_t block = frames - consumed < block_frames ? frames - consumed : block_frames;
+        produced += openmpt_bridge_resampler_process(resampler, input + consumed * 2, &block,
+                                                     output + produced * 2, capacity - produced);
+        if (block == 0) break;
+        consumed += block;
+    }
+    produced += openmpt_bridge_resampler_flush(resampler, output + produced * 2, capacity - produced);
+    return produced;
+}
+
+// Signal-to-error ratio of a converted sine against the ideal sine at the
+// output rate, skipping the filter's start-up and tail
+static double bench_resample_snr(int32_t base_rate, int32_t rate, int quality, size_t block_frames) {
+    size_t frames = (size_t)base_rate;
+    openmpt_bridge_resampler* resampler = openmpt_bridge_resampler_create(base_rate, rate, 2, quality);
+    if (!resampler) return 0.0;
+    size_t capacity = openmpt_bridge_resampler_max_output(resampler, frames) + openmpt_bridge_resampler_max_output(resampler, 0);
+    float* input = malloc(frames * 2 * sizeof(float));
+    float* output = malloc(capacity * 2 * sizeof(float));
+    double snr = 0.0;
+    if (input && output) {
+        for (size_t i = 0; i < frames; i++) {
+            input[i * 2] = input[i * 2 + 1] = (float)(0.5 * sin(2.0 * M_PI * BENCH_RESAMPLE_TONE_HZ * (double)i / base_rate));
+        }
+        size_t produced = bench_resample_convert(resampler, input, frames, block_frames, output, capacity);
+        size_t margin = (size_t)openmpt_bridge_resampler_get_taps(resampler);
+        double signal = 0.0;
+        double error = 0.0;
+        for (size_t i = margin; i + margin < produced; i++) {
+            double ideal = 0.5 * sin(2.0 * M_PI * BENCH_RESAMPLE_TONE_HZ * (double)i / rate);
+            double difference = output[i * 2] - ideal;
+            signal += ideal * ideal;
+            error += difference * difference;
+        }
+        snr = error > 0.0 ? 10.0 * log10(signal / error) : 200.0;
+    }
+    free(input);
+    free(output);
+    openmpt_bridge_resampler_destroy(resampler);
+    return snr;
+}
+
+static void bench_resample_report(FILE* out, const bench_resample_options* options, const bench_resample_target* targets,
+                                  uint64_t shared_ns, uint64_t direct_ns, size_t failed) {
+    fprintf(out, "  \"failed\": %zu,\n  \"direct\": {\"render_seconds\": %.6f, \"rates\": [", failed, (double)direct_ns * 1e-9);
+    for (size_t t = 0; t < options->sample_rate_count; t++) {
+        fprintf(out, "%s{\"sample_rate\": %d, \"render_seconds\": %.6f}", t ? ", " : "",
+                targets[t].sample_rate, (double)targets[t].direct_ns * 1e-9);
+    }
+    fprintf(out, "]},\n  \"shared_render_seconds\": %.6f,\n  \"qualities\": [\n", (double)shared_ns * 1e-9);
+
+    for (int q = 0; q < BENCH_RESAMPLE_QUALITIES; q++) {
+        uint64_t resample_ns = 0;
+        for (size_t t = 0; t < options->sample_rate_count; t++) resample_ns += targets[t].resample_ns[q];
+        double total = (double)(shared_ns + resample_ns) * 1e-9;
+        fprintf(out, "    {\"quality\": \"%s\", \"resample_seconds\": %.6f, \"total_seconds\": %.6f, \"speedup\": %.2f,\n"
+                     "     \"rates\": [",
+                bench_resample_quality_names[q], (double)resample_ns * 1e-9, total,
+                total > 0.0 ? (double)direct_ns * 1e-9 / total : 0.0);
+        for (size_t t = 0; t < options->sample_rate_count; t++) {
+            const bench_resample_target* target = &targets[t];
+            fprintf(out, "%s\n       {\"sample_rate\": %d, ", t ? "," : "", target->sample_rate);
+            if (target->sample_rate == options->base_rate) {
+                fprintf(out, "\"passthrough\": true}");
+            } else {
+                fprintf(out, "\"taps\": %d, \"resample_seconds\": %.6f, \"snr_db\": %.1f}",
+                        target->taps[q], (double)target->resample_ns[q] * 1e-9, target->snr_db[q]);
+            }
+        }
+        fprintf(out, "\n     ]}%s\n", q + 1 == BENCH_RESAMPLE_QUALITIES ? "" : ",");
+    }
+    fprintf(out, "  ],\n");
+}
+
+int bench_resample(FILE* out, const char* root, const bench_corpus* corpus, const bench_resample_options* options) {
+    size_t base_frames = (size_t)(options->seconds * options->base_rate);
+    size_t largest = base_frames;
+    bench_resample_target* targets = calloc(options->sample_rate_count, sizeof(*targets));
+    if (!targets) return 0;
+    for (size_t t = 0; t < options->sample_rate_count; t++) {
+        targets[t].sample_rate = options->sample_rates[t];
+        size_t frames = (size_t)(options->seconds * targets[t].sample_rate);
+        if (frames > largest) largest = frames;
+    }
+    // Room for the longest direct render and for any conversion with its flushed tail
+    size_t capacity = largest + 1024;
+    float* base = malloc(base_frames * 2 * sizeof(float));
+    float* scratch = malloc(capacity * 2 * sizeof(float));
+    openmpt_bridge_resampler* resamplers[BENCH_RESAMPLE_QUALITIES][BENCH_MAX_RATES] = { { NULL } };
+    int ok = base && scratch && options->sample_rate_count <= BENCH_MAX_RATES;
+
+    for (int q = 0; ok && q < BENCH_RESAMPLE_QUALITIES; q++) {
+        for (size_t t = 0; ok && t < options->sample_rate_count; t++) {
+            if (targets[t].sample_rate == options->base_rate) continue;
+            resamplers[q][t] = openmpt_bridge_resampler_create(options->base_rate, targets[t].sample_rate, 2, q);
+            if (!resamplers[q][t]) {
+                fprintf(stderr, "cannot resample %d Hz to %d Hz\n", options->base_rate, targets[t].sample_rate);
+                ok = 0;
+                break;
+            }
+            targets[t].taps[q] = openmpt_bridge_resampler_get_taps(resamplers[q][t]);
+            targets[t].snr_db[q] = bench_resample_snr(options->base_rate, targets[t].sample_rate, q, options->block_frames);
+        }
+    }
+
+    uint64_t shared_ns = 0;
+    uint64_t direct_ns = 0;
+    size_t failed = 0;
+    for (size_t i = 0; ok && i < corpus->count; i++) {
+        const bench_module* module = &corpus->modules[i];
+        uint64_t module_ns = 0;
+        size_t frames = bench_resample_render(module, options->base_rate, base_frames, options->block_frames, base, &module_ns);
+        if (frames == 0) {
+            failed++;
+            continue;
+        }
+        shared_ns += module_ns;
+
+        for (size_t t = 0; t < options->sample_rate_count; t++) {
+            bench_resample_target* target = &targets[t];
+            size_t wanted = (size_t)(options->seconds * target->sample_rate);
+            uint64_t ns = 0;
+            bench_resample_render(module, target->sample_rate, wanted, options->block_frames, scratch, &ns);
+            target->direct_ns += ns;
+            direct_ns += ns;
+
+            for (int q = 0; q < BENCH_RESAMPLE_QUALITIES; q++) {
+                openmpt_bridge_resampler* resampler = resamplers[q][t];
+                if (!resampler) continue;
+                openmpt_bridge_resampler_reset(resampler);
+                uint64_t start = bench_now_ns();
+                bench_resample_convert(resampler, base, frames, options->block_frames, scratch, capacity);
+                target->resample_ns[q] += bench_now_ns() - start;
+            }
+        }
+    }
+
+    if (ok) {
+        fprintf(out, "{\n");
+        bench_json_header(out, "resample", root, corpus);
+        fprintf(out, "  \"seconds_per_module\": %.3f,\n  \"base_rate\": %d,\n  \"block_frames\": %zu,\n",
+                options->seconds, options->base_rate, options->block_frames);
+        bench_resample_report(out, options, targets, shared_ns, direct_ns, failed);
+        fprintf(out, "  \"peak_rss_kb\": %llu\n}\n", (unsigned long long)bench_peak_rss_kb());
+    }
+
+    for (int q = 0; q < BENCH_RESAMPLE_QUALITIES; q++) {
+        for (size_t t = 0; t < BENCH_MAX_RATES; t++) openmpt_bridge_resampler_destroy(resamplers[q][t]);
+    }
+    free(scratch);
+    free(base);
+    free(targets);
+    return ok;
+}
@@ -0,0 +1,259 @@
+// bench_util.c
+// Corpus loading, histograms, resource usage and JSON helpers
+
+#include "bench.h"
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+
+// MARK: - Corpus
+
+static const openmpt_module_initial_ctl bench_metadata_ctls[] = {
+    { "load.skip_samples", "1" },
+    { "load.skip_plugins", "1" },
+    { NULL, NULL }
+};
+
+static char* bench_join_path(const char* a, const char* b) {
+    size_t la = strlen(a);
+    size_t lb = strlen(b);
+    char* joined = malloc(la + lb + 2);
+    if (!joined) return NULL;
+    memcpy(joined, a, la);
+    size_t pos = la;
+    if (la && a[la - 1] != '/') joined[pos++] = '/';
+    memcpy(joined + pos, b, lb + 1);
+    return joined;
+}
+
+static int bench_read_file(const char* path, size_t size, void** data) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return 0;
+    *data = malloc(size ? size : 1);
+    int ok = *data && fread(*data, 1, size, file) == size;
+    fclose(file);
+    if (!ok) {
+        free(*data);
+        *data = NULL;
+    }
+    return ok;
+}
+
+static int bench_corpus_append(bench_corpus* corpus, size_t* capacity, char* path, void* data, size_t size) {
+    int error = 0;
+    int probe = openmpt_probe_file_header(OPENMPT_PROBE_FILE_HEADER_FLAGS_DEFAULT, data, size, size,
+                                          (void*)openmpt_log_func_silent, NULL, NULL, NULL, &error, NULL);
+    bench_module module = { path, data, size, NULL };
+    openmpt_module* mod = probe == OPENMPT_PROBE_FILE_HEADER_RESULT_SUCCESS ? bench_module_create(&module, bench_metadata_ctls) : NULL;
+    if (!mod) {
+        corpus->skipped++;
+        return 0;
+    }
+    const char* type = openmpt_module_get_metadata(mod, "type");
+    module.type = strdup(type ? type : "");
+    if (type) openmpt_free_string(type);
+    openmpt_module_destroy(mod);
+
+    if (corpus->count == *capacity) {
+        size_t grown = *capacity ? *capacity * 2 : 64;
+        bench_module* modules = realloc(corpus->modules, grown * sizeof(*modules));
+        if (!modules) {
+            free(module.type);
+            return 0;
+        }
+        corpus->modules = modules;
+        *capacity = grown;
+    }
+    corpus->modules[corpus->count++] = module;
+    corpus->bytes += size;
+    return 1;
+}
+
+static int bench_walk(const char* root, const char* relative, bench_corpus* corpus, size_t* capacity) {
+    char* directory = relative[0] ? bench_join_path(root, relative) : strdup(root);
+    if (!directory) return 0;
+    DIR* dir = opendir(directory);
+    free(directory);
+    if (!dir) return relative[0] != 0;
+
+    int ok = 1;
+    struct dirent* entry;
+    while (ok && (entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        char* child_relative = relative[0] ? bench_join_path(relative, entry->d_name) : strdup(entry->d_name);
+        char* child_full = child_relative ? bench_join_path(root, child_relative) : NULL;
+        struct stat st;
+        if (!child_relative || !child_full) {
+            ok = 0;
+        } else if (stat(child_full, &st) == 0) {
+            void* data = NULL;
+            if (S_ISDIR(st.st_mode)) {
+                ok = bench_walk(root, child_relative, corpus, capacity);
+            } else if (S_ISREG(st.st_mode) && bench_read_file(child_full, (size_t)st.st_size, &data)) {
+                if (bench_corpus_append(corpus, capacity, child_relative, data, (size_t)st.st_size)) {
+                    child_relative = NULL;
+                } else {
+                    free(data);
+                }
+            }
+        }
+        free(child_relative);
+        free(child_full);
+    }
+    closedir(dir);
+    return ok;
+}
+
+static int bench_module_compare(const void* a, const void* b) {
+    return strcmp(((const bench_module*)a)->path, ((const bench_module*)b)->path);
+}
+
+int bench_corpus_load(const char* root, bench_corpus* corpus) {
+    memset(corpus, 0, sizeof(*corpus));
+    size_t capacity = 0;
+    struct stat st;
+    if (stat(root, &st) != 0) return 0;
+
+    int ok;
+    if (S_ISDIR(st.st_mode)) {
+        ok = bench_walk(root, "", corpus, &capacity);
+    } else {
+        // A single file is a corpus of one
+        void* data = NULL;
+        char* path = strdup(root);
+        ok = path && bench_read_file(root, (size_t)st.st_size, &data);
+        if (ok && !bench_corpus_append(corpus, &capacity, path, data, (size_t)st.st_size)) {
+            free(path);
+            free(data);
+        } else if (!ok) {
+            free(path);
+        }
+    }
+    if (!ok) {
+        bench_corpus_free(corpus);
+        return 0;
+    }
+    // Stable order keeps reports comparable between runs
+    if (corpus->count) qsort(corpus->modules, corpus->count, sizeof(*corpus->modules), bench_module_compare);
+    return 1;
+}
+
+void bench_corpus_free(bench_corpus* corpus) {
+    for (size_t i = 0; i < corpus->count; i++) {
+        free(corpus->modules[i].path);
+        free(corpus->modules[i].data);
+        free(corpus->modules[i].type);
+    }
+    free(corpus->modules);
+    memset(corpus, 0, sizeof(*corpus));
+}
+
+openmpt_module* bench_module_create(const bench_module* module, const openmpt_module_initial_ctl* ctls) {
+    int error = 0;
+    return openmpt_module_create_from_memory2(module->data, module->size, (void*)openmpt_log_func_silent, NULL,
+                                              NULL, NULL, &error, NULL, ctls);
+}
+
+// MARK: - Timing
+
+uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Values below 64 ns get their own bucket; above that each power of two is
+// split into 32 linear sub-buckets
+static size_t bench_histogram_index(uint64_t ns) {
+    if (ns < 64) return (size_t)ns;
+    int shift = 63 - __builtin_clzll(ns) - 5;
+    size_t index = 64 + (size_t)(shift - 1) * 32 + (size_t)((ns >> shift) - 32);
+    return index < BENCH_HISTOGRAM_BUCKETS ? index : BENCH_HISTOGRAM_BUCKETS - 1;
+}
+
+static uint64_t bench_histogram_value(size_t index) {
+    if (index < 64) return index;
+    int shift = (int)((index - 64) / 32) + 1;
+    uint64_t base = (uint64_t)(32 + (index - 64) % 32) << shift;
+    return base + ((1ull << shift) >> 1); // bucket midpoint
+}
+
+void bench_histogram_reset(bench_histogram* histogram) {
+    memset(histogram, 0, sizeof(*histogram));
+}
+
+void bench_histogram_add(bench_histogram* histogram, uint64_t ns) {
+    histogram->counts[bench_histogram_index(ns)]++;
+    histogram->total++;
+    histogram->sum += ns;
+    if (ns > histogram->max) histogram->max = ns;
+}
+
+uint64_t bench_histogram_quantile(const bench_histogram* histogram, double q) {
+    if (!histogram->total) return 0;
+    uint64_t rank = (uint64_t)(q * (double)(histogram->total - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BENCH_HISTOGRAM_BUCKETS; i++) {
+        seen += histogram->counts[i];
+        if (seen >= rank) {
+            uint64_t value = bench_histogram_value(i);
+            return value < histogram->max ? value : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+uint64_t bench_peak_rss_kb(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+    return (uint64_t)usage.ru_maxrss / 1024; // bytes on Darwin
+#else
+    return (uint64_t)usage.ru_maxrss;
+#endif
+}
+
+// MARK: - JSON
+
+void bench_json_string(FILE* out, const char* value) {
+    fputc('"', out);
+    for (const unsigned char* p = (const unsigned char*)(value ? value : ""); *p; p++) {
+        if (*p == '"' || *p == '\\') fprintf(out, "\\%c", *p);
+        else if (*p < 0x20) fprintf(out, "\\u%04x", *p);
+        else fputc(*p, out);
+    }
+    fputc('"', out);
+}
+
+void bench_json_latency(FILE* out, const char* key, const bench_histogram* histogram) {
+    double mean = histogram->total ? (double)histogram->sum / (double)histogram->total : 0.0;
+    fprintf(out, "\"%s\": {\"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"p999\": %.3f, \"max\": %.3f, \"mean\": %.3f}",
+            key,
+            bench_histogram_quantile(histogram, 0.50) * 1e-3,
+            bench_histogram_quantile(histogram, 0.90) * 1e-3,
+            bench_histogram_quantile(histogram, 0.99) * 1e-3,
+            bench_histogram_quantile(histogram, 0.999) * 1e-3,
+            histogram->max * 1e-3,
+            mean * 1e-3);
+}
+
+void bench_json_header(FILE* out, const char* benchmark, const char* root, const bench_corpus* corpus) {
+    const char* library = openmpt_get_string("library_version");
+    const char* core = openmpt_get_string("core_version");
+    fprintf(out, "  \"benchmark\": ");
+    bench_json_string(out, benchmark);
+    fprintf(out, ",\n  \"library_version\": ");
+    bench_json_string(out, library);
+    fprintf(out, ",\n  \"core_version\": ");
+    bench_json_string(out, core);
+    fprintf(out, ",\n  \"corpus\": {\"root\": ");
+    bench_json_string(out, root);
+    fprintf(out, ", \"modules\": %zu, \"bytes\": %llu, \"skipped\": %zu},\n",
+            corpus->count, (unsigned long long)corpus->bytes, corpus->skipped);
+    if (library) openmpt_free_string(library);
+    if (core) openmpt_free_string(core);
+}
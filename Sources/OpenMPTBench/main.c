@@ -0,0 +1,138 @@
+// main.c
+// openmpt-bench: corpus-driven libopenmpt benchmarks with JSON reports
+//
+// Usage:
+//   openmpt-bench render [-t seconds] [-r rates] [-i lengths] [-b frames] [--per-module] [-o report.json] <corpus>
+//   openmpt-bench load [-n iterations] [-o report.json] <corpus>
+//   openmpt-bench resample [-t seconds] [-s base] [-r rates] [-b frames] [-o report.json] <corpus>
+//
+// Rates and interpolation filter lengths are comma-separated lists, e.g.
+// "-r 44100,48000 -i 1,8". The report goes to stdout unless -o is given.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+
+#define BENCH_MAX_LIST BENCH_MAX_RATES
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: openmpt-bench render [-t seconds] [-r rates] [-i lengths] [-b frames] [--per-module] [-o report.json] <corpus>\n"
+            "       openmpt-bench load [-n iterations] [-o report.json] <corpus>\n"
+            "       openmpt-bench resample [-t seconds] [-s base] [-r rates] [-b frames] [-o report.json] <corpus>\n");
+}
+
+static size_t parse_list(const char* text, int32_t* values) {
+    size_t count = 0;
+    while (*text && count < BENCH_MAX_LIST) {
+        char* end = NULL;
+        long value = strtol(text, &end, 10);
+        if (end == text || value <= 0) return 0;
+        values[count++] = (int32_t)value;
+        if (*end == ',') end++;
+        else if (*end) return 0;
+        text = end;
+    }
+    return count;
+}
+
+int main(int argc, char** argv) {
+    int render = argc >= 2 && strcmp(argv[1], "render") == 0;
+    int load = argc >= 2 && strcmp(argv[1], "load") == 0;
+    int resample = argc >= 2 && strcmp(argv[1], "resample") == 0;
+    if (!render && !load && !resample) {
+        usage();
+        return 2;
+    }
+
+    int32_t rates[BENCH_MAX_LIST] = { 44100, 48000, 96000 };
+    int32_t resample_rates[BENCH_MAX_LIST] = { 48000, 44100, 22050 };
+    int32_t interpolations[BENCH_MAX_LIST] = { 1, 2, 4, 8 };
+    bench_render_options options = {
+        .sample_rates = rates,
+        .sample_rate_count = 3,
+        .interpolations = interpolations,
+        .interpolation_count = 4,
+        .seconds = 10.0,
+        .block_frames = 1024,
+        .per_module = 0,
+    };
+    bench_load_options load_options = { .iterations = 5 };
+    bench_resample_options resample_options = {
+        .base_rate = 48000,
+        .sample_rates = resample_rates,
+        .sample_rate_count = 3,
+        .seconds = 10.0,
+        .block_frames = 1024,
+    };
+    const char* output_path = NULL;
+    const char* root = NULL;
+
+    for (int i = 2; i < argc; i++) {
+        if (load && strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            load_options.iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (resample && strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            resample_options.seconds = atof(argv[++i]);
+        } else if (resample && strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            resample_options.base_rate = (int32_t)atol(argv[++i]);
+        } else if (resample && strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            resample_options.sample_rate_count = parse_list(argv[++i], resample_rates);
+        } else if (resample && strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            resample_options.block_frames = (size_t)atol(argv[++i]);
+        } else if (!render && argv[i][0] == '-') {
+            usage();
+            return 2;
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            options.seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            options.sample_rate_count = parse_list(argv[++i], rates);
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            options.interpolation_count = parse_list(argv[++i], interpolations);
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            options.block_frames = (size_t)atol(argv[++i]);
+        } else if (strcmp(argv[i], "--per-module") == 0) {
+            options.per_module = 1;
+        } else if (argv[i][0] == '-' || root) {
+            usage();
+            return 2;
+        } else {
+            root = argv[i];
+        }
+    }
+    if (!root || !options.sample_rate_count || !options.interpolation_count ||
+        options.seconds <= 0.0 || options.block_frames == 0 || load_options.iterations <= 0 ||
+        !resample_options.sample_rate_count || resample_options.base_rate <= 0 ||
+        resample_options.seconds <= 0.0 || resample_options.block_frames == 0) {
+        usage();
+        return 2;
+    }
+
+    bench_corpus corpus;
+    if (!bench_corpus_load(root, &corpus)) {
+        fprintf(stderr, "cannot read corpus: %s\n", root);
+        return 1;
+    }
+    fprintf(stderr, "loaded %zu modules (%zu other files skipped)\n", corpus.count, corpus.skipped);
+
+    FILE* out = output_path ? fopen(output_path, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "cannot write report: %s\n", output_path);
+        bench_corpus_free(&corpus);
+        return 1;
+    }
+
+    int ok = render ? bench_render(out, root, &corpus, &options)
+           : load ? bench_load(out, root, &corpus, &load_options)
+                  : bench_resample(out, root, &corpus, &resample_options);
+    if (out != stdout && fclose(out) != 0) ok = 0;
+    bench_corpus_free(&corpus);
+    if (!ok) {
+        fprintf(stderr, "benchmark failed\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,185 @@
+// main.c
+// openmpt-export: render a module to WAV or raw PCM faster than realtime
+//
+// Usage:
+//   openmpt-export [-r rate] [-f s16|s24|f32] [--raw] [-t seconds] [--trim] [--max-silence seconds] [-j threads] [--stems] <module> <output>
+//   openmpt-export --preview [-r rate] [-f s16|s24|f32] [--raw] [-t seconds] [-j threads] <output-dir> <module>...
+//
+// With -j the song is split into segments rendered on separate threads.
+// With --stems every channel goes to its own file, <output>_ch01.wav and so
+// on, with channels rendered in parallel (-j sets the thread count).
+// --trim stops exactly at the song end and cuts the silent tail;
+// --max-silence ends the render after that many seconds of silence.
+// --preview writes a short clip of each module, starting at its most
+// energetic order, to <output-dir>/<name>.wav; -t sets the clip length and
+// -j the number of modules rendered at once.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "openmpt_bridge_export.h"
+#include "openmpt_bridge_preview.h"
+#include "openmpt_bridge_stems.h"
+
+static void usage(void) {
+    fprintf(stderr, "usage: openmpt-export [-r rate] [-f s16|s24|f32] [--raw] [-t seconds] [--trim] [--max-silence seconds] [-j threads] [--stems] <module> <output>\n");
+    fprintf(stderr, "       openmpt-export --preview [-r rate] [-f s16|s24|f32] [--raw] [-t seconds] [-j threads] <output-dir> <module>...\n");
+}
+
+static int parse_format(const char* name, int32_t* format) {
+    if (strcmp(name, "s16") == 0) *format = OPENMPT_BRIDGE_SAMPLE_FORMAT_S16;
+    else if (strcmp(name, "s24") == 0) *format = OPENMPT_BRIDGE_SAMPLE_FORMAT_S24;
+    else if (strcmp(name, "f32") == 0) *format = OPENMPT_BRIDGE_SAMPLE_FORMAT_F32;
+    else return 0;
+    return 1;
+}
+
+// <directory>/<module file name without extension>.<extension>
+static char* preview_output_path(const char* directory, const char* module_path, const char* extension) {
+    const char* name = strrchr(module_path, '/');
+    name = name ? name + 1 : module_path;
+    const char* dot = strrchr(name, '.');
+    int stem = dot && dot != name ? (int)(dot - name) : (int)strlen(name);
+    size_t length = strlen(directory) + (size_t)stem + strlen(extension) + 3;
+    char* path = malloc(length);
+    if (path) snprintf(path, length, "%s/%.*s.%s", directory, stem, name, extension);
+    return path;
+}
+
+static int export_previews(const char* directory, const char* const* module_paths, size_t count,
+                           const openmpt_bridge_export_options* options, double clip_seconds, int threads) {
+    openmpt_bridge_preview_options preview;
+    openmpt_bridge_preview_options_init(&preview);
+    if (clip_seconds > 0.0) preview.clip_seconds = clip_seconds;
+    if (threads > 0) preview.thread_count = threads;
+
+    const char* extension = options->container == OPENMPT_BRIDGE_CONTAINER_RAW ? "raw" : "wav";
+    char** output_paths = calloc(count, sizeof(*output_paths));
+    openmpt_bridge_preview_result* results = calloc(count, sizeof(*results));
+    int ok = output_paths && results;
+    for (size_t i = 0; ok && i < count; i++) {
+        output_paths[i] = preview_output_path(directory, module_paths[i], extension);
+        ok = output_paths[i] != NULL;
+    }
+    if (ok) {
+        size_t written = openmpt_bridge_preview_batch(module_paths, (const char* const*)output_paths, count,
+                                                      options, &preview, results);
+        for (size_t i = 0; i < count; i++) {
+            if (!results[i].ok) {
+                fprintf(stderr, "preview failed: %s\n", module_paths[i]);
+                continue;
+            }
+            printf("%s: order %d at %.2f s, %.2f s clip (scan %.3f s, render %.3f s)\n", output_paths[i],
+                   results[i].order, results[i].start_seconds, (double)results[i].frames / options->sample_rate,
+                   results[i].scan_seconds, results[i].render_seconds);
+        }
+        printf("%zu of %zu previews written\n", written, count);
+        ok = written == count;
+    }
+    for (size_t i = 0; output_paths && i < count; i++) free(output_paths[i]);
+    free(output_paths);
+    free(results);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    openmpt_bridge_export_options options;
+    openmpt_bridge_export_options_init(&options);
+    openmpt_bridge_parallel_export_options parallel;
+    openmpt_bridge_parallel_export_options_init(&parallel);
+    int threads = -1;
+    int stems = 0;
+    int preview = 0;
+    const char** positional = calloc((size_t)argc, sizeof(*positional));
+    int positional_count = 0;
+    if (!positional) return 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            options.sample_rate = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            if (!parse_format(argv[++i], &options.format)) {
+                usage();
+                return 2;
+            }
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            options.max_seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--max-silence") == 0 && i + 1 < argc) {
+            options.max_silence_seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--trim") == 0) {
+            options.trim_silence = 1;
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--raw") == 0) {
+            options.container = OPENMPT_BRIDGE_CONTAINER_RAW;
+        } else if (strcmp(argv[i], "--stems") == 0) {
+            stems = 1;
+        } else if (strcmp(argv[i], "--preview") == 0) {
+            preview = 1;
+        } else if (argv[i][0] == '-' || (positional_count == 2 && !preview)) {
+            usage();
+            return 2;
+        } else {
+            positional[positional_count++] = argv[i];
+        }
+    }
+    if (preview && positional_count >= 2) {
+        double clip_seconds = options.max_seconds;
+        options.max_seconds = 0.0;
+        return export_previews(positional[0], positional + 1, (size_t)positional_count - 1,
+                               &options, clip_seconds, threads) ? 0 : 1;
+    }
+    if (positional_count != 2 || preview) {
+        usage();
+        return 2;
+    }
+
+    if (stems) {
+        openmpt_bridge_stem_options split;
+        openmpt_bridge_stem_options_init(&split);
+        if (threads > 0) split.thread_count = threads;
+        openmpt_bridge_stem_result result;
+        if (!openmpt_bridge_export_stems_file(positional[0], positional[1], &options, &split, &result)) {
+            fprintf(stderr, "export failed: %s\n", positional[0]);
+            return 1;
+        }
+        printf("%d stems of %.2f s (%d of %d channels empty) in %.3f s (render %.3f s total, writer wait %.3f s): %.1fx realtime\n",
+               result.stems_written, result.totals.audio_seconds, result.empty_channels, result.channels,
+               result.totals.wall_seconds, result.totals.render_seconds, result.totals.write_wait_seconds,
+               result.totals.realtime_factor);
+        return 0;
+    }
+
+    if (threads >= 0) {
+        parallel.thread_count = threads;
+        openmpt_bridge_parallel_export_result result;
+        if (!openmpt_bridge_export_parallel_file(positional[0], positional[1], &options, &parallel, &result)) {
+            fprintf(stderr, "export failed: %s\n", positional[0]);
+            return 1;
+        }
+        printf("%.2f s of audio in %.3f s (%d segments, render %.3f s total): %.1fx realtime\n",
+               result.totals.audio_seconds, result.totals.wall_seconds, result.segments,
+               result.totals.render_seconds, result.totals.realtime_factor);
+        if (result.totals.trimmed_frames) {
+            printf("trimmed %.2f s of trailing silence\n", (double)result.totals.trimmed_frames / options.sample_rate);
+        }
+        printf("seams: %d exact, %d crossfaded, max difference %g\n",
+               result.exact_seams, result.crossfaded_seams, result.max_seam_error);
+        return 0;
+    }
+
+    openmpt_bridge_export_result result;
+    if (!openmpt_bridge_export_file(positional[0], positional[1], &options, &result)) {
+        fprintf(stderr, "export failed: %s\n", positional[0]);
+        return 1;
+    }
+
+    printf("%.2f s of audio in %.3f s (render %.3f s, writer wait %.3f s): %.1fx realtime\n",
+           result.audio_seconds, result.wall_seconds, result.render_seconds,
+           result.write_wait_seconds, result.realtime_factor);
+    if (result.trimmed_frames) {
+        printf("trimmed %.2f s of trailing silence\n", (double)result.trimmed_frames / options.sample_rate);
+    }
+    return 0;
+}
@@ -0,0 +1,159 @@
+// main.c
+// openmpt-indexer: build or inspect a columnar module metadata database
+//
+// Usage:
+//   openmpt-indexer [-j threads] [--full] [--loudness] [--fingerprint] [--quiet] <root> <database>
+//   openmpt-indexer --dump <database>
+//   openmpt-indexer --catalog <database> <catalog>
+//   openmpt-indexer --duplicates <database> [min-similarity]
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "openmpt_bridge_catalog.h"
+#include "openmpt_bridge_fingerprint.h"
+#include "openmpt_bridge_index.h"
+
+static void usage(void) {
+    fprintf(stderr,
+            "usage: openmpt-indexer [-j threads] [--full] [--loudness] [--fingerprint] [--quiet] <root> <database>\n"
+            "       openmpt-indexer --dump <database>\n"
+            "       openmpt-indexer --catalog <database> <catalog>\n"
+            "       openmpt-indexer --duplicates <database> [min-similarity]\n");
+}
+
+static void print_progress(void* user, uint64_t done, uint64_t total) {
+    (void)user;
+    // Workers report concurrently; a coarse cadence keeps stderr readable
+    if (done == total || done % 1000 == 0) {
+        fprintf(stderr, "\rindexed %" PRIu64 "/%" PRIu64, done, total);
+        if (done == total) fputc('\n', stderr);
+    }
+}
+
+static int dump(const char* database_path) {
+    openmpt_bridge_index* index = openmpt_bridge_index_open(database_path);
+    if (!index) {
+        fprintf(stderr, "cannot open database: %s\n", database_path);
+        return 1;
+    }
+
+    for (int32_t column = 0; column < OPENMPT_BRIDGE_INDEX_COLUMN_COUNT; column++) {
+        printf("%s%s", column ? "\t" : "", openmpt_bridge_index_column_name(column));
+    }
+    printf("\n");
+
+    uint64_t rows = openmpt_bridge_index_get_row_count(index);
+    for (uint64_t row = 0; row < rows; row++) {
+        size_t fingerprint_size = 0;
+        openmpt_bridge_index_get_blob(index, OPENMPT_BRIDGE_INDEX_COLUMN_FINGERPRINT, row, &fingerprint_size);
+        printf("%s\t%" PRIu64 "\t%" PRId64 "\t%" PRIu64 "\t%016" PRIx64 "\t%s\t%s\t%s\t%s\t%.3f\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\t%.2f\t%.2f\t%.2f\t%zu\t%" PRIu64 "\n",
+               openmpt_bridge_index_get_string(index, OPENMPT_BRIDGE_INDEX_COLUMN_PATH, row),
+               openmpt_bridge_index_get_uint(index, OPENMPT_BRIDGE_INDEX_COLUMN_SIZE, row),
+               (int64_t)openmpt_bridge_index_get_uint(index, OPENMPT_BRIDGE_INDEX_COLUMN_MTIME, row),
+               openmpt_bridge_index_get_uint(index, OPENMPT_BRIDGE_INDEX_COLUMN_STATUS, row),
+               openmpt_bridge_index_get_uint(index, OPENMPT_BRIDGE_INDEX_COLUMN_CONTENT_HASH, row),
+               openmpt_bridge_index_get_string(index, OPENMPT_BRIDGE_INDEX_COLUMN_TITLE, row),
+               openmpt_bridge_index_get_string(index, OPENMPT_BRIDGE_INDEX_COLUMN_ARTIST, row),
+               openmpt_bridge_index_get_string(index, OPENMPT_BRIDGE_INDEX_COLUMN_TYPE, row),
+               openmpt_bridge_index_get_string(index, OPENMPT_BRIDGE_INDEX_COLUMN_TRACKER, row),
+               openmpt_bridge_index_get_double(index, OPENMPT_BRIDGE_INDEX_COLUMN_DURATION, row),
+               openmpt_bridge_index_get_uint(index, OPENMPT_BRIDGE_INDEX_COLUMN_CHANNELS, row),
+               openmpt_bridge_index_get_uint(index, OPENMPT_BRIDGE_INDEX_COLUMN_PATTERNS, row),
+               openmpt_bridge_index_get_uint(index, OPENMPT_BRIDGE_INDEX_COLUMN_INSTRUMENTS, row),
+               openmpt_bridge_index_get_uint(index, OPENMPT_BRIDGE_INDEX_COLUMN_SAMPLES, row),
+               openmpt_bridge_index_get_uint(index, OPENMPT_BRIDGE_INDEX_COLUMN_LOUDNESS_MEASURED, row),
+               openmpt_bridge_index_get_double(index, OPENMPT_BRIDGE_INDEX_COLUMN_LOUDNESS, row),
+               openmpt_bridge_index_get_double(index, OPENMPT_BRIDGE_INDEX_COLUMN_LOUDNESS_RANGE, row),
+               openmpt_bridge_index_get_double(index, OPENMPT_BRIDGE_INDEX_COLUMN_TRUE_PEAK, row),
+               fingerprint_size / sizeof(uint32_t),
+               openmpt_bridge_index_get_uint(index, OPENMPT_BRIDGE_INDEX_COLUMN_ANALYSIS_FAILED, row));
+    }
+    openmpt_bridge_index_close(index);
+    return 0;
+}
+
+// Print every pair of fingerprinted modules that sound alike, once
+static int duplicates(const char* database_path, double min_similarity) {
+    openmpt_bridge_index* index = openmpt_bridge_index_open(database_path);
+    openmpt_bridge_fingerprint_index* fingerprints = openmpt_bridge_fingerprint_index_open_database(database_path);
+    if (!index || !fingerprints) {
+        fprintf(stderr, "cannot open database: %s\n", database_path);
+        openmpt_bridge_index_close(index);
+        openmpt_bridge_fingerprint_index_destroy(fingerprints);
+        return 1;
+    }
+
+    openmpt_bridge_fingerprint_match matches[64];
+    uint64_t pairs = 0;
+    uint64_t rows = openmpt_bridge_index_get_row_count(index);
+    for (uint64_t row = 0; row < rows; row++) {
+        size_t count = openmpt_bridge_fingerprint_index_query_id(fingerprints, row, min_similarity, matches, 64);
+        for (size_t i = 0; i < count; i++) {
+            if (matches[i].id <= row) continue;
+            printf("%.3f\t%s\t%s\n", matches[i].similarity,
+                   openmpt_bridge_index_get_string(index, OPENMPT_BRIDGE_INDEX_COLUMN_PATH, row),
+                   openmpt_bridge_index_get_string(index, OPENMPT_BRIDGE_INDEX_COLUMN_PATH, matches[i].id));
+            pairs++;
+        }
+    }
+    fprintf(stderr, "%" PRIu64 " duplicate pairs among %" PRIu64 " modules\n", pairs, rows);
+    openmpt_bridge_fingerprint_index_destroy(fingerprints);
+    openmpt_bridge_index_close(index);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    openmpt_bridge_index_options options = { 0 };
+    options.progress = print_progress;
+    const char* positional[2] = { NULL, NULL };
+    int positional_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc) {
+            return dump(argv[i + 1]);
+        } else if (strcmp(argv[i], "--catalog") == 0 && i + 2 < argc) {
+            if (!openmpt_bridge_catalog_write_from_index(argv[i + 1], argv[i + 2])) {
+                fprintf(stderr, "cannot write catalog: %s\n", argv[i + 2]);
+                return 1;
+            }
+            return 0;
+        } else if (strcmp(argv[i], "--duplicates") == 0 && i + 1 < argc) {
+            return duplicates(argv[i + 1], i + 2 < argc ? atof(argv[i + 2]) : OPENMPT_BRIDGE_FINGERPRINT_DUPLICATE);
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            options.thread_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--full") == 0) {
+            options.full_rebuild = 1;
+        } else if (strcmp(argv[i], "--loudness") == 0) {
+            options.measure_loudness = 1;
+        } else if (strcmp(argv[i], "--fingerprint") == 0) {
+            options.fingerprint = 1;
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            options.progress = NULL;
+        } else if (argv[i][0] == '-' || positional_count == 2) {
+            usage();
+            return 2;
+        } else {
+            positional[positional_count++] = argv[i];
+        }
+    }
+    if (positional_count != 2) {
+        usage();
+        return 2;
+    }
+
+    openmpt_bridge_index_summary summary;
+    if (!openmpt_bridge_index_build(positional[0], positional[1], &options, &summary)) {
+        fprintf(stderr, "indexing failed\n");
+        return 1;
+    }
+
+    uint64_t processed = summary.files_indexed + summary.files_rejected + summary.files_failed;
+    printf("scanned %" PRIu64 " files: %" PRIu64 " indexed, %" PRIu64 " reused, %" PRIu64 " rejected, %" PRIu64 " failed in %.2f s (%.0f files/s)\n",
+           summary.files_scanned, summary.files_indexed, summary.files_reused,
+           summary.files_rejected, summary.files_failed, summary.seconds,
+           summary.seconds > 0 ? (double)processed / summary.seconds : 0.0);
+    return 0;
+}
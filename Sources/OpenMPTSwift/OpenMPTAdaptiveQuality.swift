@@ -0,0 +1,76 @@
+//
+//  OpenMPTAdaptiveQuality.swift
+//  OpenMPTSwift
+//
+//  Automatic render quality reduction under CPU pressure
+//
+
+import Foundation
+import CLibOpenMPT
+
+/// Tuning for adaptive quality
+///
+/// Overruns are blocks above the module's `renderBudget`. Each overrun adds
+/// pressure and each block within budget removes some, so only sustained
+/// overruns lower quality. Quality is raised again one level at a time after
+/// a run of blocks well below the budget.
+public struct OpenMPTAdaptiveQualityOptions: Sendable {
+    /// Utilization every block must stay below before quality is raised
+    public var restoreUtilization: Double = 0.4
+    /// Net overrun blocks before quality is lowered one level
+    public var degradeBlocks: Int = 4
+    /// Consecutive blocks below `restoreUtilization` before quality is raised one level
+    public var restoreBlocks: Int = 256
+    /// Lowest level allowed, 1...3
+    public var maxLevel: Int = Int(OPENMPT_BRIDGE_QUALITY_MAX_LEVEL)
+
+    public init() {}
+}
+
+/// Current adaptive quality level and the render parameters it applied
+public struct OpenMPTQualityState: Sendable {
+    public let isEnabled: Bool
+    /// 0 is the requested quality; 1 disables volume ramping and caps interpolation at 4 taps, 2 at 2 taps, 3 at 1 tap
+    public let level: Int
+    public let interpolationFilterLength: Int
+    public let volumeRampingStrength: Int
+    /// Times quality was lowered since the module was loaded
+    public let degrades: UInt64
+    /// Times quality was raised since the module was loaded
+    public let restores: UInt64
+}
+
+extension OpenMPTModule {
+
+    /// Lower interpolation and disable volume ramping while rendering overruns its budget
+    ///
+    /// Changes happen on the render thread between blocks. Interpolation and
+    /// ramping set through `setRenderParam` are kept as the requested quality
+    /// and restored when headroom returns.
+    public func enableAdaptiveQuality(_ options: OpenMPTAdaptiveQualityOptions = OpenMPTAdaptiveQualityOptions()) {
+        var cOptions = openmpt_bridge_quality_options()
+        cOptions.restore_utilization = options.restoreUtilization
+        cOptions.degrade_blocks = UInt32(clamping: options.degradeBlocks)
+        cOptions.restore_blocks = UInt32(clamping: options.restoreBlocks)
+        cOptions.max_level = Int32(clamping: options.maxLevel)
+        _ = openmpt_bridge_quality_enable(handle, &cOptions)
+    }
+
+    /// Stop adapting; the requested quality is restored before the next block
+    public func disableAdaptiveQuality() {
+        openmpt_bridge_quality_disable(handle)
+    }
+
+    public var qualityState: OpenMPTQualityState {
+        var state = openmpt_bridge_quality_state()
+        _ = openmpt_bridge_quality_get_state(handle, &state)
+        return OpenMPTQualityState(
+            isEnabled: state.enabled != 0,
+            level: Int(state.level),
+            interpolationFilterLength: Int(state.interpolation_filter_length),
+            volumeRampingStrength: Int(state.volume_ramping_strength),
+            degrades: state.degrades,
+            restores: state.restores
+        )
+    }
+}
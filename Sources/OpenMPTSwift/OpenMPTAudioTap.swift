@@ -0,0 +1,118 @@
+//
+//  OpenMPTAudioTap.swift
+//  OpenMPTSwift
+//
+//  Fan-out of one render to several consumers
+//
+
+import Foundation
+import CLibOpenMPT
+
+/// Output format of an `OpenMPTAudioTap`
+public struct OpenMPTAudioTapOptions: Sendable {
+    /// Output rate, or nil to keep the render rate
+    public var sampleRate: Int?
+    /// Rate the module is rendered at; required when `sampleRate` is set
+    public var sourceRate: Int = 48000
+    /// 1 (downmixed) or 2
+    public var channels: Int = 2
+    public var format: OpenMPTExportFormat = .float32
+    public var resamplerQuality: OpenMPTResamplerQuality = .balanced
+    /// Frames buffered before the render thread starts dropping
+    public var capacityFrames: Int = 16384
+
+    public init() {}
+}
+
+/// Counters for one tap
+public struct OpenMPTAudioTapStats: Sendable {
+    public let framesWritten: UInt64
+    public let framesRead: UInt64
+    /// Frames lost because the reader fell behind
+    public let framesDropped: UInt64
+    /// Blocks skipped because they were rendered at a rate other than `sourceRate`
+    public let blocksSkipped: UInt64
+}
+
+/// A copy of everything a module renders, in the tap's own format
+///
+/// Every block rendered through the module, for example by `OpenMPTPlayer`,
+/// is converted and appended to the tap's ring on the render thread, which
+/// never waits for readers. Read from a single thread at a time. The tap
+/// keeps its module alive and detaches itself when released.
+public final class OpenMPTAudioTap {
+    private let module: OpenMPTModule
+    private let tap: OpaquePointer
+    public let options: OpenMPTAudioTapOptions
+
+    fileprivate init?(module: OpenMPTModule, options: OpenMPTAudioTapOptions) {
+        var cOptions = openmpt_bridge_tap_options()
+        openmpt_bridge_tap_options_init(&cOptions)
+        cOptions.sample_rate = Int32(clamping: options.sampleRate ?? 0)
+        cOptions.source_rate = Int32(clamping: options.sourceRate)
+        cOptions.channels = Int32(clamping: options.channels)
+        cOptions.format = options.format.rawValue
+        cOptions.quality = options.resamplerQuality.rawValue
+        cOptions.capacity_frames = max(options.capacityFrames, 0)
+        guard let tap = openmpt_bridge_tap_attach(module.handle, &cOptions) else { return nil }
+        self.module = module
+        self.tap = tap
+        self.options = options
+    }
+
+    deinit {
+        openmpt_bridge_tap_detach(module.handle, tap)
+    }
+
+    /// Frames waiting to be read
+    public var availableFrames: Int {
+        openmpt_bridge_tap_available(tap)
+    }
+
+    /// Bytes per frame in the tap's format
+    public var frameBytes: Int {
+        openmpt_bridge_tap_frame_bytes(tap)
+    }
+
+    public var stats: OpenMPTAudioTapStats {
+        var stats = openmpt_bridge_tap_stats()
+        _ = openmpt_bridge_tap_get_stats(tap, &stats)
+        return OpenMPTAudioTapStats(
+            framesWritten: stats.frames_written,
+            framesRead: stats.frames_read,
+            framesDropped: stats.frames_dropped,
+            blocksSkipped: stats.blocks_skipped
+        )
+    }
+
+    /// Copy up to `frames` interleaved frames in the tap's format. Never allocates.
+    ///
+    /// - Returns: Frames copied
+    public func read(into buffer: UnsafeMutableRawPointer, frames: Int) -> Int {
+        openmpt_bridge_tap_read(tap, buffer, frames)
+    }
+
+    /// Read buffered float samples, interleaved. Returns an empty array for integer formats.
+    public func readSamples(maxFrames: Int = Int.max) -> [Float] {
+        guard options.format == .float32 else { return [] }
+        let frames = min(maxFrames, availableFrames)
+        guard frames > 0 else { return [] }
+        var samples = [Float](repeating: 0, count: frames * options.channels)
+        let read = samples.withUnsafeMutableBytes { buffer in
+            openmpt_bridge_tap_read(tap, buffer.baseAddress!, frames)
+        }
+        samples.removeSubrange((read * options.channels)...)
+        return samples
+    }
+}
+
+extension OpenMPTModule {
+
+    /// Attach a tap that receives every block rendered from now on
+    ///
+    /// - Returns: nil if the options are invalid or
+    ///   `OPENMPT_BRIDGE_MAX_TAPS` taps are already attached
+    public func addTap(_ options: OpenMPTAudioTapOptions = OpenMPTAudioTapOptions()) -> OpenMPTAudioTap? {
+        OpenMPTAudioTap(module: self, options: options)
+    }
+}
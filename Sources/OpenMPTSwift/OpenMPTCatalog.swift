@@ -0,0 +1,237 @@
+//
+//  OpenMPTCatalog.swift
+//  OpenMPTSwift
+//
+//  Zero-copy reader for memory-mapped module catalogs
+//
+
+import Foundation
+import CLibOpenMPT
+
+/// Sort orders stored in a catalog
+public enum OpenMPTCatalogOrder: Int32, Sendable {
+    case path = 0
+    case title = 1
+    case artist = 2
+}
+
+/// View of one catalog record
+///
+/// Numeric fields are read straight from the mapped file; strings are
+/// decoded only when accessed. Views stay valid while the catalog is alive.
+public struct OpenMPTCatalogEntry {
+    private let catalog: OpenMPTCatalog
+    private let record: UnsafePointer<openmpt_bridge_catalog_record>
+
+    /// Position of the record in file order
+    public let index: Int
+
+    internal init(catalog: OpenMPTCatalog, record: UnsafePointer<openmpt_bridge_catalog_record>, index: Int) {
+        self.catalog = catalog
+        self.record = record
+        self.index = index
+    }
+
+    public var path: String { catalog.string(at: record.pointee.path) }
+    public var title: String { catalog.string(at: record.pointee.title) }
+    public var artist: String { catalog.string(at: record.pointee.artist) }
+    public var type: String { catalog.string(at: record.pointee.type) }
+    public var tracker: String { catalog.string(at: record.pointee.tracker) }
+    public var duration: TimeInterval { record.pointee.duration }
+    public var channelCount: Int { Int(record.pointee.channels) }
+    public var patternCount: Int { Int(record.pointee.patterns) }
+    public var instrumentCount: Int { Int(record.pointee.instruments) }
+    public var sampleCount: Int { Int(record.pointee.samples) }
+    public var fileSize: UInt64 { record.pointee.file_size }
+    public var contentHash: UInt64 { record.pointee.content_hash }
+
+    /// Loudness stored by `openmpt-indexer --loudness`, nil if not measured
+    public var loudness: OpenMPTLoudness? {
+        guard record.pointee.flags & OPENMPT_BRIDGE_CATALOG_FLAG_LOUDNESS != 0 else { return nil }
+        return OpenMPTLoudness(integratedLoudness: Double(record.pointee.loudness),
+                               truePeak: Double(record.pointee.true_peak), duration: duration)
+    }
+
+    /// Module information in the same shape `OpenMPTModule.moduleInfo` returns
+    public var moduleInfo: ModuleInfo {
+        return ModuleInfo(
+            title: title.isEmpty ? "Unknown" : title,
+            artist: artist.isEmpty ? "Unknown" : artist,
+            type: type.isEmpty ? "Unknown" : type,
+            duration: duration,
+            instrumentCount: instrumentCount,
+            sampleCount: sampleCount,
+            patternCount: patternCount,
+            channelCount: channelCount
+        )
+    }
+}
+
+/// Read-only module catalog backed by a memory-mapped file
+///
+/// Opening a catalog maps the file and checks its header; no records are
+/// parsed or copied, so startup cost does not grow with library size.
+public final class OpenMPTCatalog: RandomAccessCollection {
+    private let handle: OpaquePointer
+
+    /// Map a catalog written by `OpenMPTCatalog.Builder` or the indexer
+    /// - Parameter url: Location of the catalog file
+    /// - Throws: OpenMPTError if the file is missing or malformed
+    public init(contentsOf url: URL) throws {
+        guard let handle = openmpt_bridge_catalog_open(url.path) else {
+            throw OpenMPTError.loadFailed("Invalid catalog at \(url.path)")
+        }
+        self.handle = handle
+    }
+
+    deinit {
+        openmpt_bridge_catalog_close(handle)
+    }
+
+    public var startIndex: Int { 0 }
+
+    public var endIndex: Int { Int(openmpt_bridge_catalog_get_count(handle)) }
+
+    public subscript(position: Int) -> OpenMPTCatalogEntry {
+        precondition(position >= 0 && position < endIndex, "Catalog index out of range")
+        let record = openmpt_bridge_catalog_get_record(handle, UInt64(position))!
+        return OpenMPTCatalogEntry(catalog: self, record: record, index: position)
+    }
+
+    /// Entries in one of the stored sort orders
+    /// - Parameter order: Sort order
+    /// - Returns: Lazy view over the catalog in that order
+    public func sorted(by order: OpenMPTCatalogOrder) -> LazyMapSequence<Range<Int>, OpenMPTCatalogEntry> {
+        return (0..<endIndex).lazy.map { position in
+            self[Int(openmpt_bridge_catalog_get_ordered(self.handle, order.rawValue, UInt64(position)))]
+        }
+    }
+
+    /// Find an entry by its exact path
+    /// - Parameter path: Path as stored in the catalog
+    /// - Returns: Entry, or nil if not present
+    public func entry(forPath path: String) -> OpenMPTCatalogEntry? {
+        let index = openmpt_bridge_catalog_find_path(handle, path)
+        return index >= 0 ? self[Int(index)] : nil
+    }
+
+    internal func string(at offset: UInt32) -> String {
+        return String(cString: openmpt_bridge_catalog_get_string(handle, offset))
+    }
+
+    /// Convert an indexer database into a catalog
+    /// - Parameters:
+    ///   - databaseURL: Database written by `openmpt-indexer`
+    ///   - catalogURL: Destination catalog file
+    /// - Throws: OpenMPTError if the conversion fails
+    public static func build(fromIndex databaseURL: URL, to catalogURL: URL) throws {
+        guard openmpt_bridge_catalog_write_from_index(databaseURL.path, catalogURL.path) == 1 else {
+            throw OpenMPTError.loadFailed("Failed to convert index at \(databaseURL.path)")
+        }
+    }
+}
+
+extension OpenMPTCatalog {
+    /// Collects entries and writes a catalog file
+    public final class Builder {
+        private let handle: OpaquePointer
+
+        public init() {
+            handle = openmpt_bridge_catalog_builder_create()!
+        }
+
+        deinit {
+            openmpt_bridge_catalog_builder_destroy(handle)
+        }
+
+        /// Add a loaded module
+        /// - Parameters:
+        ///   - path: Path to store for the module
+        ///   - module: Loaded module to read metadata from
+        ///   - fileSize: Size of the module file in bytes
+        /// - Throws: OpenMPTError if the module is not loaded
+        public func add(path: String, module: OpenMPTModule, fileSize: UInt64 = 0) throws {
+            // Read the snapshot taken at load time; the libopenmpt handle
+            // belongs to whichever thread is rendering
+            guard let snapshot = module.snapshot else {
+                throw OpenMPTError.notLoaded
+            }
+            let result = withExtendedLifetime(snapshot) { () -> Int32 in
+                let contents = snapshot.contents
+                return path.withCString { cPath in
+                    var entry = openmpt_bridge_catalog_entry(
+                        path: cPath,
+                        title: contents.title,
+                        artist: contents.artist,
+                        type: contents.type,
+                        tracker: contents.tracker,
+                        duration: contents.duration,
+                        channels: UInt32(clamping: contents.num_channels),
+                        patterns: UInt32(clamping: contents.num_patterns),
+                        instruments: UInt32(clamping: contents.num_instruments),
+                        samples: UInt32(clamping: contents.num_samples),
+                        file_size: fileSize,
+                        content_hash: 0,
+                        loudness_measured: 0,
+                        loudness: 0,
+                        true_peak: 0
+                    )
+                    return openmpt_bridge_catalog_builder_add(handle, &entry)
+                }
+            }
+            guard result == 1 else {
+                throw OpenMPTError.invalidData
+            }
+        }
+
+        /// Add an entry from previously extracted module information
+        /// - Parameters:
+        ///   - path: Path to store for the module
+        ///   - info: Module information
+        ///   - tracker: Tracker name, if known
+        ///   - loudness: Measured loudness, if known
+        /// - Throws: OpenMPTError if the entry cannot be stored
+        public func add(path: String, info: ModuleInfo, tracker: String = "", loudness: OpenMPTLoudness? = nil) throws {
+            let result = path.withCString { cPath in
+                info.title.withCString { cTitle in
+                    info.artist.withCString { cArtist in
+                        info.type.withCString { cType in
+                            tracker.withCString { cTracker in
+                                var entry = openmpt_bridge_catalog_entry(
+                                    path: cPath,
+                                    title: cTitle,
+                                    artist: cArtist,
+                                    type: cType,
+                                    tracker: cTracker,
+                                    duration: info.duration,
+                                    channels: UInt32(clamping: info.channelCount),
+                                    patterns: UInt32(clamping: info.patternCount),
+                                    instruments: UInt32(clamping: info.instrumentCount),
+                                    samples: UInt32(clamping: info.sampleCount),
+                                    file_size: 0,
+                                    content_hash: 0,
+                                    loudness_measured: loudness == nil ? 0 : 1,
+                                    loudness: loudness?.integratedLoudness ?? 0,
+                                    true_peak: loudness?.truePeak ?? 0
+                                )
+                                return openmpt_bridge_catalog_builder_add(handle, &entry)
+                            }
+                        }
+                    }
+                }
+            }
+            guard result == 1 else {
+                throw OpenMPTError.invalidData
+            }
+        }
+
+        /// Write the catalog atomically
+        /// - Parameter url: Destination file
+        /// - Throws: OpenMPTError if writing fails
+        public func write(to url: URL) throws {
+            guard openmpt_bridge_catalog_builder_write(handle, url.path) == 1 else {
+                throw OpenMPTError.loadFailed("Failed to write catalog to \(url.path)")
+            }
+        }
+    }
+}
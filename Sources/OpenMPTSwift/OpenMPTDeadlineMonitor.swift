@@ -0,0 +1,126 @@
+//
+//  OpenMPTDeadlineMonitor.swift
+//  OpenMPTSwift
+//
+//  Render deadline monitoring for real-time playback
+//
+
+import Foundation
+import CLibOpenMPT
+
+/// A render block that used more of its deadline than the budget allows
+public struct OpenMPTOverrunEvent: Sendable {
+    /// Monotonic clock time when the block finished, in nanoseconds
+    public let timestamp: UInt64
+    public let elapsed: TimeInterval
+    /// Audio duration of the block (frameCount / sampleRate)
+    public let deadline: TimeInterval
+    /// Render call number since the monitor was reset
+    public let blockIndex: UInt64
+    public let frameCount: Int
+    public let sampleRate: Int
+
+    /// Fraction of the deadline the block used
+    public var utilization: Double {
+        return deadline > 0 ? elapsed / deadline : 0
+    }
+}
+
+/// Distribution of render time relative to each block's deadline
+public struct OpenMPTDeadlineReport: Sendable {
+    /// Block counts per utilization bucket; the last bucket holds everything above its lower edge
+    public let buckets: [UInt64]
+    /// Width of each bucket as a fraction of the deadline
+    public let bucketWidth: Double
+    public let blocks: UInt64
+    /// Blocks above the render budget
+    public let overruns: UInt64
+    /// Blocks that took longer than their deadline
+    public let missedDeadlines: UInt64
+    /// Overrun events lost because nobody drained the queue
+    public let droppedEvents: UInt64
+    public let peakUtilization: Double
+
+    /// Upper edge of the bucket containing the given fraction of blocks
+    /// - Parameter fraction: Quantile in 0...1, e.g. 0.99
+    /// - Returns: Utilization below which that fraction of blocks finished
+    public func utilization(atQuantile fraction: Double) -> Double {
+        guard blocks > 0 else { return 0 }
+        let rank = UInt64((fraction * Double(blocks - 1)).rounded(.down)) + 1
+        var seen: UInt64 = 0
+        for (index, count) in buckets.enumerated() {
+            seen += count
+            if seen >= rank {
+                return index == buckets.count - 1 ? peakUtilization : Double(index + 1) * bucketWidth
+            }
+        }
+        return peakUtilization
+    }
+}
+
+extension OpenMPTModule {
+
+    /// Fraction of each block's deadline rendering may use before an overrun is reported
+    ///
+    /// Defaults to 0.75. Setting a value of zero or less restores the default.
+    public var renderBudget: Double {
+        get { openmpt_bridge_deadline_get_budget(handle) }
+        set { openmpt_bridge_deadline_set_budget(handle, newValue) }
+    }
+
+    /// Utilization histogram of all blocks rendered since the last reset
+    public var deadlineReport: OpenMPTDeadlineReport {
+        var histogram = openmpt_bridge_deadline_histogram()
+        _ = openmpt_bridge_deadline_get_histogram(handle, &histogram)
+        let buckets = withUnsafeBytes(of: histogram.buckets) { Array($0.bindMemory(to: UInt64.self)) }
+        return OpenMPTDeadlineReport(
+            buckets: buckets,
+            bucketWidth: OPENMPT_BRIDGE_DEADLINE_BUCKET_WIDTH,
+            blocks: histogram.blocks,
+            overruns: histogram.overruns,
+            missedDeadlines: histogram.missed,
+            droppedEvents: histogram.dropped_events,
+            peakUtilization: histogram.peak_utilization
+        )
+    }
+
+    /// Remove and return queued overrun events, oldest first
+    ///
+    /// Call from one thread at a time; the render thread never waits on it.
+    public func drainOverrunEvents() -> [OpenMPTOverrunEvent] {
+        var events: [OpenMPTOverrunEvent] = []
+        var event = openmpt_bridge_overrun_event()
+        while openmpt_bridge_deadline_pop_event(handle, &event) == 1 {
+            events.append(OpenMPTOverrunEvent(
+                timestamp: event.timestamp_ns,
+                elapsed: TimeInterval(event.elapsed_ns) / 1_000_000_000,
+                deadline: TimeInterval(event.deadline_ns) / 1_000_000_000,
+                blockIndex: event.block_index,
+                frameCount: Int(event.frames),
+                sampleRate: Int(event.sample_rate)
+            ))
+        }
+        return events
+    }
+
+    /// Clear the utilization histogram
+    public func resetDeadlineMonitor() {
+        openmpt_bridge_deadline_reset(handle)
+    }
+
+    /// Route parameter changes through the command queue while a render thread runs
+    ///
+    /// Leaving real-time mode applies queued changes on the calling thread.
+    internal func setRealtime(_ realtime: Bool) {
+        openmpt_bridge_module_set_realtime(handle, realtime ? 1 : 0)
+    }
+
+    /// Render planar stereo straight into caller-owned buffers
+    ///
+    /// Used by the audio callback: no allocation, timed by the deadline monitor.
+    /// - Returns: Frames rendered; 0 if no module is loaded
+    internal func render(left: UnsafeMutablePointer<Float>, right: UnsafeMutablePointer<Float>,
+                         frameCount: Int, sampleRate: Int32) -> Int {
+        return Int(openmpt_bridge_module_read_float_stereo(handle, sampleRate, frameCount, left, right))
+    }
+}
@@ -0,0 +1,421 @@
+//
+//  OpenMPTExport.swift
+//  OpenMPTSwift
+//
+//  Faster-than-realtime export of modules to audio files
+//
+
+import Foundation
+import CLibOpenMPT
+
+/// Sample formats supported by the exporter
+public enum OpenMPTExportFormat: Int32, Sendable {
+    /// 16-bit signed integer PCM
+    case int16 = 0
+    
+    /// 24-bit signed integer PCM
+    case int24 = 1
+    
+    /// 32-bit floating point
+    case float32 = 2
+}
+
+/// File containers supported by the exporter
+public enum OpenMPTExportContainer: Int32, Sendable {
+    /// RIFF WAVE file
+    case wav = 0
+    
+    /// Headerless interleaved little-endian PCM
+    case raw = 1
+}
+
+/// Export settings
+public struct OpenMPTExportOptions: Sendable {
+    public var sampleRate: Int32
+    public var format: OpenMPTExportFormat
+    public var container: OpenMPTExportContainer
+    /// Stop after this much audio; nil renders to the end of the song
+    public var maxDuration: TimeInterval?
+    /// Stop exactly at the song end instead of fading out, and cut the
+    /// silent tail from the file. Ignored by stem exports, which keep every
+    /// stem the same length.
+    public var trimSilence: Bool = false
+    /// Peak level in dBFS at or below which audio counts as silence
+    public var silenceThreshold: Double = -90
+    /// End the render once this much continuous silence has been rendered
+    public var maxSilence: TimeInterval?
+    
+    public init(sampleRate: Int32 = 48000, format: OpenMPTExportFormat = .int16,
+                container: OpenMPTExportContainer = .wav, maxDuration: TimeInterval? = nil) {
+        self.sampleRate = sampleRate
+        self.format = format
+        self.container = container
+        self.maxDuration = maxDuration
+    }
+    
+    fileprivate var bridgeOptions: openmpt_bridge_export_options {
+        var settings = openmpt_bridge_export_options()
+        openmpt_bridge_export_options_init(&settings)
+        settings.sample_rate = sampleRate
+        settings.format = format.rawValue
+        settings.container = container.rawValue
+        settings.max_seconds = maxDuration ?? 0
+        settings.trim_silence = trimSilence ? 1 : 0
+        settings.silence_threshold_db = Swift.min(silenceThreshold, -0.01)
+        settings.max_silence_seconds = maxSilence ?? 0
+        return settings
+    }
+}
+
+/// Timing of a finished export
+public struct OpenMPTExportResult: Sendable {
+    public let frameCount: Int
+    public let audioDuration: TimeInterval
+    public let wallTime: TimeInterval
+    public let renderTime: TimeInterval
+    public let writerWaitTime: TimeInterval
+    /// Seconds of audio produced per second of wall time
+    public let realtimeFactor: Double
+    /// Silent frames rendered past the last audible one and cut from the file
+    public var trimmedFrameCount: Int = 0
+    /// Number of segments rendered in parallel (1 for a sequential export)
+    public var segmentCount: Int = 1
+    /// Segment overlaps that matched exactly
+    public var exactSeams: Int = 0
+    /// Segment overlaps that differed and were crossfaded
+    public var crossfadedSeams: Int = 0
+}
+
+/// Settings for splitting one song across several threads
+public struct OpenMPTParallelExportOptions: Sendable {
+    /// Worker threads, 0 for one per CPU
+    public var threadCount: Int
+    /// Audio rendered and discarded before each segment to rebuild channel state
+    public var preroll: TimeInterval
+    /// Frames rendered by both neighbours at every seam
+    public var overlapFrames: Int
+    /// Subsong to export, nil for the default
+    public var subsong: Int?
+    
+    public init(threadCount: Int = 0, preroll: TimeInterval = 2.0, overlapFrames: Int = 256, subsong: Int? = nil) {
+        self.threadCount = threadCount
+        self.preroll = preroll
+        self.overlapFrames = overlapFrames
+        self.subsong = subsong
+    }
+}
+
+/// Settings for exporting one file per channel
+public struct OpenMPTStemExportOptions: Sendable {
+    /// Worker threads, 0 for one per CPU
+    public var threadCount: Int
+    /// Subsong to export, nil for the default
+    public var subsong: Int?
+    /// Write no file for channels that never play a note
+    public var skipEmptyChannels: Bool
+    
+    public init(threadCount: Int = 0, subsong: Int? = nil, skipEmptyChannels: Bool = true) {
+        self.threadCount = threadCount
+        self.subsong = subsong
+        self.skipEmptyChannels = skipEmptyChannels
+    }
+}
+
+/// Timing of a finished stem export
+public struct OpenMPTStemExportResult: Sendable {
+    /// Per-stem length, summed render time and overall realtime factor
+    public let totals: OpenMPTExportResult
+    public let channelCount: Int
+    public let emptyChannelCount: Int
+    /// Files written, one per channel that was not skipped
+    public let stems: [URL]
+}
+
+/// Settings for catalog preview clips
+public struct OpenMPTPreviewOptions: Sendable {
+    /// Clip length
+    public var duration: TimeInterval
+    public var fadeIn: TimeInterval
+    public var fadeOut: TimeInterval
+    /// Audio rendered per order while looking for the most energetic start
+    public var probeDuration: TimeInterval
+    /// Sample rate of the probes
+    public var scanSampleRate: Int32
+    /// Subsong to preview, nil for the default
+    public var subsong: Int?
+    /// Modules rendered at once by batch previews, 0 for one per CPU
+    public var threadCount: Int
+    
+    public init(duration: TimeInterval = 20, fadeIn: TimeInterval = 0.01, fadeOut: TimeInterval = 1.5,
+                probeDuration: TimeInterval = 1, scanSampleRate: Int32 = 8000,
+                subsong: Int? = nil, threadCount: Int = 0) {
+        self.duration = duration
+        self.fadeIn = fadeIn
+        self.fadeOut = fadeOut
+        self.probeDuration = probeDuration
+        self.scanSampleRate = scanSampleRate
+        self.subsong = subsong
+        self.threadCount = threadCount
+    }
+    
+    fileprivate var bridgeOptions: openmpt_bridge_preview_options {
+        var settings = openmpt_bridge_preview_options()
+        openmpt_bridge_preview_options_init(&settings)
+        settings.clip_seconds = duration
+        settings.fade_in_seconds = fadeIn
+        settings.fade_out_seconds = fadeOut
+        settings.probe_seconds = probeDuration
+        settings.scan_sample_rate = scanSampleRate
+        settings.subsong = Int32(clamping: subsong ?? -1)
+        settings.thread_count = Int32(clamping: threadCount)
+        return settings
+    }
+}
+
+/// Where a preview clip starts and how it was made
+public struct OpenMPTPreviewResult: Sendable {
+    /// Order the clip starts at, nil if it starts at the beginning of the song
+    public let order: Int?
+    /// Song time the clip starts at
+    public let startTime: TimeInterval
+    /// Frames written; fewer than the clip length for short songs
+    public let frameCount: Int
+    /// Time spent choosing the start
+    public let scanTime: TimeInterval
+    /// Time spent rendering the clip
+    public let renderTime: TimeInterval
+    
+    fileprivate init(_ result: openmpt_bridge_preview_result) {
+        order = result.order >= 0 ? Int(result.order) : nil
+        startTime = result.start_seconds
+        frameCount = Int(result.frames)
+        scanTime = result.scan_seconds
+        renderTime = result.render_seconds
+    }
+}
+
+extension OpenMPTModule {
+    
+    /// Render the selected subsong once, from the start, to a file
+    ///
+    /// Rendering and disk I/O overlap on a writer thread. The module loops
+    /// again afterwards, but its playback position is left at the end.
+    /// Fails while a player is rendering the module.
+    /// - Parameters:
+    ///   - url: Destination file
+    ///   - options: Export settings
+    /// - Returns: Frame count and timing of the export
+    /// - Throws: OpenMPTError if no module is loaded or the export fails
+    @discardableResult
+    public func export(to url: URL, options: OpenMPTExportOptions = OpenMPTExportOptions()) throws -> OpenMPTExportResult {
+        guard let module = module else {
+            throw OpenMPTError.notLoaded
+        }
+        // Rendering here would race the audio thread
+        guard openmpt_bridge_module_is_realtime(handle) == 0 else {
+            throw OpenMPTError.renderFailed
+        }
+        
+        var settings = options.bridgeOptions
+        
+        var result = openmpt_bridge_export_result()
+        guard openmpt_bridge_export_module(module, url.path, &settings, &result) == 1 else {
+            throw OpenMPTError.renderFailed
+        }
+        
+        var exportResult = OpenMPTExportResult(
+            frameCount: Int(result.frames),
+            audioDuration: result.audio_seconds,
+            wallTime: result.wall_seconds,
+            renderTime: result.render_seconds,
+            writerWaitTime: result.write_wait_seconds,
+            realtimeFactor: result.realtime_factor
+        )
+        exportResult.trimmedFrameCount = Int(result.trimmed_frames)
+        return exportResult
+    }
+    
+    /// Render module data to a file on several cores
+    ///
+    /// The song is split at order boundaries and each segment is rendered by
+    /// its own module instance, which seeks ahead of the segment and pre-rolls.
+    /// Neighbouring segments overlap briefly and are crossfaded if they differ.
+    /// - Parameters:
+    ///   - data: Raw module file data
+    ///   - url: Destination file
+    ///   - options: Export settings
+    ///   - parallel: Splitting settings
+    /// - Returns: Frame count, timing and seam statistics
+    /// - Throws: OpenMPTError if the data cannot be loaded or the export fails
+    @discardableResult
+    public static func exportParallel(data: Data, to url: URL,
+                                      options: OpenMPTExportOptions = OpenMPTExportOptions(),
+                                      parallel: OpenMPTParallelExportOptions = OpenMPTParallelExportOptions()) throws -> OpenMPTExportResult {
+        guard !data.isEmpty else {
+            throw OpenMPTError.invalidData
+        }
+        
+        var settings = options.bridgeOptions
+        
+        var split = openmpt_bridge_parallel_export_options()
+        openmpt_bridge_parallel_export_options_init(&split)
+        split.thread_count = Int32(clamping: parallel.threadCount)
+        split.preroll_seconds = parallel.preroll
+        split.overlap_frames = Int32(clamping: parallel.overlapFrames)
+        split.subsong = Int32(clamping: parallel.subsong ?? -1)
+        
+        var result = openmpt_bridge_parallel_export_result()
+        let success = data.withUnsafeBytes { bytes in
+            openmpt_bridge_export_parallel(bytes.baseAddress, bytes.count, url.path, &settings, &split, &result)
+        }
+        guard success == 1 else {
+            throw OpenMPTError.renderFailed
+        }
+        
+        var exportResult = OpenMPTExportResult(
+            frameCount: Int(result.totals.frames),
+            audioDuration: result.totals.audio_seconds,
+            wallTime: result.totals.wall_seconds,
+            renderTime: result.totals.render_seconds,
+            writerWaitTime: result.totals.write_wait_seconds,
+            realtimeFactor: result.totals.realtime_factor
+        )
+        exportResult.trimmedFrameCount = Int(result.totals.trimmed_frames)
+        exportResult.segmentCount = Int(result.segments)
+        exportResult.exactSeams = Int(result.exact_seams)
+        exportResult.crossfadedSeams = Int(result.crossfaded_seams)
+        return exportResult
+    }
+    
+    /// Render every channel of module data to its own file, on several cores
+    ///
+    /// Each channel is rendered by its own module instance with all other
+    /// channels muted, and one writer thread serves every file. Files are
+    /// named after `prefix` with the channel number appended, for example
+    /// `song_ch01.wav`.
+    /// - Parameters:
+    ///   - data: Raw module file data
+    ///   - prefix: Destination path without the channel suffix and extension
+    ///   - options: Export settings, applied to every stem
+    ///   - stems: Threading and channel selection
+    /// - Returns: Timing and the files written
+    /// - Throws: OpenMPTError if the data cannot be loaded or the export fails
+    @discardableResult
+    public static func exportStems(data: Data, prefix: URL,
+                                   options: OpenMPTExportOptions = OpenMPTExportOptions(),
+                                   stems: OpenMPTStemExportOptions = OpenMPTStemExportOptions()) throws -> OpenMPTStemExportResult {
+        guard !data.isEmpty else {
+            throw OpenMPTError.invalidData
+        }
+        
+        var settings = options.bridgeOptions
+        
+        var split = openmpt_bridge_stem_options()
+        openmpt_bridge_stem_options_init(&split)
+        split.thread_count = Int32(clamping: stems.threadCount)
+        split.subsong = Int32(clamping: stems.subsong ?? -1)
+        split.skip_empty_channels = stems.skipEmptyChannels ? 1 : 0
+        
+        var result = openmpt_bridge_stem_result()
+        let success = data.withUnsafeBytes { bytes in
+            openmpt_bridge_export_stems(bytes.baseAddress, bytes.count, prefix.path, &settings, &split, &result)
+        }
+        guard success == 1 else {
+            throw OpenMPTError.renderFailed
+        }
+        
+        // Stems exist for every channel the exporter did not find empty
+        var urls: [URL] = []
+        for channel in 0..<Int32(result.channels) {
+            var path = [CChar](repeating: 0, count: Int(PATH_MAX))
+            openmpt_bridge_stem_path(&path, path.count, prefix.path, channel, settings.container)
+            let url = URL(fileURLWithPath: String(cString: path))
+            if FileManager.default.fileExists(atPath: url.path) {
+                urls.append(url)
+            }
+        }
+        
+        let totals = OpenMPTExportResult(
+            frameCount: Int(result.totals.frames),
+            audioDuration: result.totals.audio_seconds,
+            wallTime: result.totals.wall_seconds,
+            renderTime: result.totals.render_seconds,
+            writerWaitTime: result.totals.write_wait_seconds,
+            realtimeFactor: result.totals.realtime_factor
+        )
+        return OpenMPTStemExportResult(
+            totals: totals,
+            channelCount: Int(result.channels),
+            emptyChannelCount: Int(result.empty_channels),
+            stems: urls
+        )
+    }
+    
+    /// Write a short preview clip of module data
+    ///
+    /// The clip starts at the order with the most energy in the following
+    /// `preview.duration` seconds, found from short low-quality probes, so
+    /// the song is never rendered in full. The clip itself is rendered at
+    /// full quality and faded in and out.
+    /// - Parameters:
+    ///   - data: Raw module file data
+    ///   - url: Destination file
+    ///   - options: Sample rate, format and container; length and trimming are ignored
+    ///   - preview: Clip length, fades and scan settings
+    /// - Returns: Where the clip starts and how long it is
+    /// - Throws: OpenMPTError if the data cannot be loaded or the clip cannot be written
+    @discardableResult
+    public static func exportPreview(data: Data, to url: URL,
+                                     options: OpenMPTExportOptions = OpenMPTExportOptions(),
+                                     preview: OpenMPTPreviewOptions = OpenMPTPreviewOptions()) throws -> OpenMPTPreviewResult {
+        guard !data.isEmpty else {
+            throw OpenMPTError.invalidData
+        }
+        
+        var settings = options.bridgeOptions
+        var clip = preview.bridgeOptions
+        
+        var result = openmpt_bridge_preview_result()
+        let success = data.withUnsafeBytes { bytes in
+            openmpt_bridge_preview_render(bytes.baseAddress, bytes.count, url.path, &settings, &clip, &result)
+        }
+        guard success == 1 else {
+            throw OpenMPTError.renderFailed
+        }
+        return OpenMPTPreviewResult(result)
+    }
+    
+    /// Write preview clips for many module files, several at once
+    ///
+    /// Each module is one job on `preview.threadCount` threads. A module
+    /// that cannot be loaded or written gets nil and does not stop the rest.
+    /// - Parameters:
+    ///   - files: Module files
+    ///   - outputs: Destination for each module, in the same order
+    ///   - options: Sample rate, format and container; length and trimming are ignored
+    ///   - preview: Clip length, fades, scan settings and thread count
+    /// - Returns: One result per module, nil where no clip was written
+    public static func exportPreviews(files: [URL], to outputs: [URL],
+                                      options: OpenMPTExportOptions = OpenMPTExportOptions(),
+                                      preview: OpenMPTPreviewOptions = OpenMPTPreviewOptions()) -> [OpenMPTPreviewResult?] {
+        precondition(files.count == outputs.count, "one output per module file")
+        guard !files.isEmpty else {
+            return []
+        }
+        
+        var settings = options.bridgeOptions
+        var clip = preview.bridgeOptions
+        
+        let modulePaths = files.map { strdup($0.path) }
+        let outputPaths = outputs.map { strdup($0.path) }
+        defer {
+            modulePaths.forEach { free($0) }
+            outputPaths.forEach { free($0) }
+        }
+        var moduleArgs = modulePaths.map { UnsafePointer($0) }
+        var outputArgs = outputPaths.map { UnsafePointer($0) }
+        var results = [openmpt_bridge_preview_result](repeating: openmpt_bridge_preview_result(), count: files.count)
+        openmpt_bridge_preview_batch(&moduleArgs, &outputArgs, files.count, &settings, &clip, &results)
+        return results.map { $0.ok == 1 ? OpenMPTPreviewResult($0) : nil }
+    }
+}
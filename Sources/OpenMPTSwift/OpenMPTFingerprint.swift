@@ -0,0 +1,145 @@
+//
+//  OpenMPTFingerprint.swift
+//  OpenMPTSwift
+//
+//  Audio fingerprints and an inverted index for finding duplicate songs
+//
+
+import Foundation
+import CLibOpenMPT
+
+/// Compact description of how a song sounds, one 32-bit hash per 128 ms
+///
+/// Two files of the same song, such as a MOD and its XM conversion, give
+/// nearly identical fingerprints even though their bytes differ.
+public struct OpenMPTFingerprint: Sendable, Equatable {
+    /// Similarity above which two songs are treated as the same
+    public static let duplicateThreshold: Double = OPENMPT_BRIDGE_FINGERPRINT_DUPLICATE
+    /// Time between hashes
+    public static let hashInterval: TimeInterval =
+        Double(OPENMPT_BRIDGE_FINGERPRINT_HOP_FRAMES) / Double(OPENMPT_BRIDGE_FINGERPRINT_SAMPLE_RATE)
+
+    /// Hashes in song order; 0 marks silence
+    public let hashes: [UInt32]
+
+    public init(hashes: [UInt32]) {
+        self.hashes = hashes
+    }
+
+    /// Length of song the fingerprint covers
+    public var duration: TimeInterval {
+        Double(hashes.count) * Self.hashInterval
+    }
+
+    /// Render module data at low quality and fingerprint it
+    ///
+    /// Covers about the first two minutes of the song. Rendering runs far
+    /// faster than realtime; call this off the main actor. Libraries should
+    /// prefer the fingerprints stored by `openmpt-indexer --fingerprint`.
+    /// - Parameters:
+    ///   - data: Module file contents
+    ///   - subsong: Subsong to fingerprint, nil for the default
+    /// - Throws: OpenMPTError if the module cannot be rendered
+    public static func compute(data: Data, subsong: Int? = nil) throws -> OpenMPTFingerprint {
+        guard !data.isEmpty else {
+            throw OpenMPTError.invalidData
+        }
+        var hashes = [UInt32](repeating: 0, count: Int(OPENMPT_BRIDGE_FINGERPRINT_MAX_HASHES))
+        let count = data.withUnsafeBytes { bytes in
+            openmpt_bridge_fingerprint_compute(bytes.baseAddress, bytes.count, Int32(clamping: subsong ?? -1),
+                                               &hashes, hashes.count)
+        }
+        guard count > 0 else {
+            throw OpenMPTError.renderFailed
+        }
+        return OpenMPTFingerprint(hashes: Array(hashes.prefix(count)))
+    }
+
+    /// Fraction of equal bits at the best alignment within `maxOffset`
+    /// hashes, about 0.5 for unrelated songs and 0 if too little overlaps
+    public func similarity(to other: OpenMPTFingerprint, maxOffset: Int = 16) -> Double {
+        openmpt_bridge_fingerprint_similarity(hashes, hashes.count, other.hashes, other.hashes.count,
+                                              Int32(clamping: maxOffset), nil)
+    }
+}
+
+/// A song found by `OpenMPTFingerprintIndex`
+public struct OpenMPTFingerprintMatch: Sendable {
+    /// Identifier the song was added with, or its database row
+    public let id: UInt64
+    public let similarity: Double
+    /// Query hash `i` lines up with hash `i + offset` of the match
+    public let offset: Int
+}
+
+/// Inverted index from fingerprint hashes to songs
+///
+/// Lookups only compare songs that share hashes with the query, so they
+/// stay fast on large libraries. An index is not thread safe.
+public final class OpenMPTFingerprintIndex {
+    private let index: OpaquePointer
+
+    public init() {
+        guard let index = openmpt_bridge_fingerprint_index_create() else {
+            fatalError("out of memory")
+        }
+        self.index = index
+    }
+
+    /// Index of the fingerprints stored by `openmpt-indexer --fingerprint`,
+    /// with database rows as ids. Returns nil if the database cannot be read.
+    public init?(databasePath: String) {
+        guard let index = openmpt_bridge_fingerprint_index_open_database(databasePath) else {
+            return nil
+        }
+        self.index = index
+    }
+
+    deinit {
+        openmpt_bridge_fingerprint_index_destroy(index)
+    }
+
+    /// Number of songs added
+    public var count: Int {
+        openmpt_bridge_fingerprint_index_get_count(index)
+    }
+
+    /// Add a song under an identifier of the caller's choosing
+    @discardableResult
+    public func add(_ fingerprint: OpenMPTFingerprint, id: UInt64) -> Bool {
+        openmpt_bridge_fingerprint_index_add(index, id, fingerprint.hashes, fingerprint.hashes.count) == 1
+    }
+
+    /// Songs resembling a fingerprint, best first
+    public func matches(for fingerprint: OpenMPTFingerprint,
+                        minSimilarity: Double = OpenMPTFingerprint.duplicateThreshold,
+                        limit: Int = 16) -> [OpenMPTFingerprintMatch] {
+        query(limit) { matches, capacity in
+            openmpt_bridge_fingerprint_index_query(index, fingerprint.hashes, fingerprint.hashes.count,
+                                                   minSimilarity, matches, capacity)
+        }
+    }
+
+    /// Other songs in the index resembling the one added as `id`, best first
+    public func duplicates(of id: UInt64,
+                           minSimilarity: Double = OpenMPTFingerprint.duplicateThreshold,
+                           limit: Int = 16) -> [OpenMPTFingerprintMatch] {
+        query(limit) { matches, capacity in
+            openmpt_bridge_fingerprint_index_query_id(index, id, minSimilarity, matches, capacity)
+        }
+    }
+
+    private func query(_ limit: Int,
+                       _ body: (UnsafeMutablePointer<openmpt_bridge_fingerprint_match>, Int) -> Int) -> [OpenMPTFingerprintMatch] {
+        guard limit > 0 else {
+            return []
+        }
+        var matches = [openmpt_bridge_fingerprint_match](repeating: openmpt_bridge_fingerprint_match(), count: limit)
+        let count = matches.withUnsafeMutableBufferPointer { buffer in
+            body(buffer.baseAddress!, buffer.count)
+        }
+        return matches.prefix(count).map {
+            OpenMPTFingerprintMatch(id: $0.id, similarity: $0.similarity, offset: Int($0.offset))
+        }
+    }
+}
@@ -0,0 +1,152 @@
+//
+//  OpenMPTInteractive.swift
+//  OpenMPTSwift
+//
+//  Live control of a playing module through libopenmpt's interactive interface
+//
+
+import Foundation
+import CLibOpenMPT
+
+extension OpenMPTModule {
+
+    /// Preview notes that can sound at once; older ones are cut to make room
+    public static let previewVoices = Int(OPENMPT_BRIDGE_JAM_VOICES)
+
+    /// Whether notes can be previewed on this module
+    public var isInteractive: Bool {
+        openmpt_bridge_module_is_interactive(handle) != 0
+    }
+
+    /// Audition a note, for example while editing a pattern
+    ///
+    /// The note plays on a channel beyond the pattern channels, so it never
+    /// cuts the song. While a render thread is running it starts at the next
+    /// block; otherwise before the next render call.
+    /// - Parameters:
+    ///   - instrument: 0-based instrument, or sample for modules without instruments
+    ///   - note: Note to play; 0 for C-0 up to 119 for B-9, middle C is 60
+    ///   - volume: 0...1
+    ///   - panning: -1 (left) ... 1 (right)
+    /// - Returns: Voice to pass to `stopNote` or `releaseNote`, or nil if the note cannot be played
+    @discardableResult
+    public func playNote(instrument: Int, note: Int, volume: Double = 1.0, panning: Double = 0.0) -> Int? {
+        let voice = openmpt_bridge_module_play_note(handle, Int32(clamping: instrument), Int32(clamping: note),
+                                                    volume, panning)
+        return voice >= 0 ? Int(voice) : nil
+    }
+
+    /// Audition a pattern editor note; `.none`, `.noteOff` and `.noteCut` play nothing
+    @discardableResult
+    public func playNote(instrument: Int, note: OpenMPTNote, volume: Double = 1.0, panning: Double = 0.0) -> Int? {
+        switch note {
+        case .none, .noteOff, .noteCut:
+            return nil
+        default:
+            return playNote(instrument: instrument, note: Int(note.rawValue), volume: volume, panning: panning)
+        }
+    }
+
+    /// Cut a preview note at once
+    public func stopNote(_ voice: Int) {
+        _ = openmpt_bridge_module_stop_note(handle, Int32(clamping: voice))
+    }
+
+    /// Release a preview note like a key-up, letting its envelope fade out
+    public func releaseNote(_ voice: Int) {
+        _ = openmpt_bridge_module_note_off(handle, Int32(clamping: voice))
+    }
+
+    /// Cut every preview note
+    public func stopAllNotes() {
+        _ = openmpt_bridge_module_stop_note(handle, -1)
+    }
+
+    // MARK: - Channel mix
+
+    /// Mute or unmute a pattern channel, or every channel for nil
+    ///
+    /// Takes effect at the next block. Muted channels are skipped by the
+    /// mixer, so rendering or exporting with channels muted is cheaper.
+    /// - Returns: false if the channel does not exist
+    @discardableResult
+    public func setMuted(_ muted: Bool, channel: Int?) -> Bool {
+        openmpt_bridge_module_set_channel_mute(handle, Int32(clamping: channel ?? -1), muted ? 1 : 0) == 1
+    }
+
+    public func isMuted(channel: Int) -> Bool {
+        openmpt_bridge_module_get_channel_mute(handle, Int32(clamping: channel)) != 0
+    }
+
+    /// Solo or unsolo a pattern channel, or every channel for nil
+    ///
+    /// While any channel is soloed, only soloed channels that are not muted are heard.
+    @discardableResult
+    public func setSolo(_ solo: Bool, channel: Int?) -> Bool {
+        openmpt_bridge_module_set_channel_solo(handle, Int32(clamping: channel ?? -1), solo ? 1 : 0) == 1
+    }
+
+    public func isSoloed(channel: Int) -> Bool {
+        openmpt_bridge_module_get_channel_solo(handle, Int32(clamping: channel)) != 0
+    }
+
+    /// Set a channel's volume, 0 (silent) ... 1 (as written)
+    @discardableResult
+    public func setVolume(_ volume: Double, channel: Int) -> Bool {
+        openmpt_bridge_module_set_channel_volume(handle, Int32(clamping: channel), volume) == 1
+    }
+
+    public func volume(channel: Int) -> Double {
+        openmpt_bridge_module_get_channel_volume(handle, Int32(clamping: channel))
+    }
+
+    /// Set a channel's panning, -1 (left) ... 1 (right); pattern effects may move it again
+    @discardableResult
+    public func setPanning(_ panning: Double, channel: Int) -> Bool {
+        openmpt_bridge_module_set_channel_panning(handle, Int32(clamping: channel), panning) == 1
+    }
+
+    public func panning(channel: Int) -> Double {
+        openmpt_bridge_module_get_channel_panning(handle, Int32(clamping: channel))
+    }
+
+    // MARK: - Tempo and pitch
+
+    /// Playback speed relative to the song, in (0, 4]; 2 plays twice as
+    /// fast without changing pitch. Setting a value outside the range
+    /// leaves the factor unchanged; use `setTempoFactor(_:)` to find out.
+    ///
+    /// Applied at the next block. Positions and durations stay in song time.
+    public var tempoFactor: Double {
+        get { openmpt_bridge_module_get_tempo_factor(handle) }
+        set { setTempoFactor(newValue) }
+    }
+
+    /// Pitch relative to the song, in (0, 4]; 2 plays an octave higher
+    /// without changing tempo. Setting a value outside the range leaves the
+    /// factor unchanged; use `setPitchFactor(_:)` to find out.
+    public var pitchFactor: Double {
+        get { openmpt_bridge_module_get_pitch_factor(handle) }
+        set { setPitchFactor(newValue) }
+    }
+
+    /// Set the tempo factor
+    /// - Returns: false if the factor is outside (0, 4] and was not applied
+    @discardableResult
+    public func setTempoFactor(_ factor: Double) -> Bool {
+        openmpt_bridge_module_set_tempo_factor(handle, factor) == 1
+    }
+
+    /// Set the pitch factor
+    /// - Returns: false if the factor is outside (0, 4] and was not applied
+    @discardableResult
+    public func setPitchFactor(_ factor: Double) -> Bool {
+        openmpt_bridge_module_set_pitch_factor(handle, factor) == 1
+    }
+
+    /// Pitch change in semitones, a convenience over `pitchFactor`
+    public var pitchSemitones: Double {
+        get { 12.0 * log2(pitchFactor) }
+        set { pitchFactor = pow(2.0, newValue / 12.0) }
+    }
+}
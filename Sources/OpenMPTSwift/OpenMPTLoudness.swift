@@ -0,0 +1,112 @@
+//
+//  OpenMPTLoudness.swift
+//  OpenMPTSwift
+//
+//  EBU R128 loudness measurement and ReplayGain-style normalization
+//
+
+import Foundation
+import CLibOpenMPT
+
+/// Loudness of a rendered song, measured per ITU-R BS.1770-4 / EBU R128
+public struct OpenMPTLoudness: Sendable {
+    /// ReplayGain 2.0 reference level in LUFS
+    public static let replayGainReference: Double = OPENMPT_BRIDGE_LOUDNESS_REPLAYGAIN_REFERENCE
+
+    /// Gated integrated loudness in LUFS, -infinity for silence
+    public let integratedLoudness: Double
+    /// Highest 400 ms loudness in LUFS
+    public let maxMomentaryLoudness: Double
+    /// Highest 3 s loudness in LUFS
+    public let maxShortTermLoudness: Double
+    /// Loudness range in LU (EBU Tech 3342)
+    public let loudnessRange: Double
+    /// Oversampled peak in dBTP
+    public let truePeak: Double
+    /// Largest sample magnitude in dBFS
+    public let samplePeak: Double
+    /// Gain in dB that brings the song to `replayGainReference`
+    public let replayGain: Double
+    /// Length of the measured audio
+    public let duration: TimeInterval
+
+    public init(integratedLoudness: Double, maxMomentaryLoudness: Double = -.infinity,
+                maxShortTermLoudness: Double = -.infinity, loudnessRange: Double = 0,
+                truePeak: Double, samplePeak: Double = -.infinity, duration: TimeInterval = 0) {
+        self.integratedLoudness = integratedLoudness
+        self.maxMomentaryLoudness = maxMomentaryLoudness
+        self.maxShortTermLoudness = maxShortTermLoudness
+        self.loudnessRange = loudnessRange
+        self.truePeak = truePeak
+        self.samplePeak = samplePeak
+        self.replayGain = integratedLoudness.isFinite ? Self.replayGainReference - integratedLoudness : 0
+        self.duration = duration
+    }
+
+    fileprivate init(_ loudness: openmpt_bridge_loudness, sampleRate: Double) {
+        integratedLoudness = loudness.integrated_lufs
+        maxMomentaryLoudness = loudness.max_momentary_lufs
+        maxShortTermLoudness = loudness.max_short_term_lufs
+        loudnessRange = loudness.loudness_range_lu
+        truePeak = loudness.true_peak_dbtp
+        samplePeak = loudness.sample_peak_dbfs
+        replayGain = loudness.replaygain_db
+        duration = Double(loudness.frames) / sampleRate
+    }
+
+    /// Render module data once and measure it
+    ///
+    /// Rendering runs the whole song faster than realtime; call this off the
+    /// main actor. Libraries should prefer the values stored by
+    /// `openmpt-indexer --loudness` in the catalog.
+    /// - Parameters:
+    ///   - data: Module file contents
+    ///   - subsong: Subsong to measure, nil for the default
+    /// - Throws: OpenMPTError if the module cannot be rendered
+    public static func measure(data: Data, subsong: Int? = nil) throws -> OpenMPTLoudness {
+        guard !data.isEmpty else {
+            throw OpenMPTError.invalidData
+        }
+        var loudness = openmpt_bridge_loudness()
+        let result = data.withUnsafeBytes { bytes in
+            openmpt_bridge_loudness_measure(bytes.baseAddress, bytes.count, Int32(clamping: subsong ?? -1), &loudness)
+        }
+        guard result == 1 else {
+            throw OpenMPTError.renderFailed
+        }
+        return OpenMPTLoudness(loudness, sampleRate: 48000)
+    }
+
+    /// Master gain in dB that brings the song to `target` LUFS while keeping
+    /// its true peak at or below `peakCeiling` dBTP
+    public func normalizationGain(target: Double = OpenMPTLoudness.replayGainReference,
+                                  peakCeiling: Double = -1) -> Double {
+        Double(Self.gainMillibel(integratedLoudness, truePeak, target, peakCeiling)) / 100
+    }
+
+    fileprivate static func gainMillibel(_ integrated: Double, _ truePeak: Double,
+                                         _ target: Double, _ peakCeiling: Double) -> Int32 {
+        openmpt_bridge_loudness_gain_millibel(integrated, truePeak, target, peakCeiling)
+    }
+}
+
+extension OpenMPTModule {
+
+    /// Set the master gain so the module plays at `target` LUFS
+    ///
+    /// Applied like any other render parameter: immediately when idle, or at
+    /// the start of the next block while a player is rendering. A
+    /// measurement without audible content resets the gain to 0 dB.
+    /// - Parameters:
+    ///   - loudness: Stored or freshly measured loudness of this module
+    ///   - target: Playback level in LUFS, ReplayGain 2.0 by default
+    ///   - peakCeiling: Highest true peak in dBTP that positive gain may reach
+    /// - Returns: True if the gain was applied or queued
+    @discardableResult
+    public func applyLoudnessNormalization(_ loudness: OpenMPTLoudness,
+                                           target: Double = OpenMPTLoudness.replayGainReference,
+                                           peakCeiling: Double = -1) -> Bool {
+        let gain = OpenMPTLoudness.gainMillibel(loudness.integratedLoudness, loudness.truePeak, target, peakCeiling)
+        return setRenderParam(Int(OPENMPT_MODULE_RENDER_MASTERGAIN_MILLIBEL), value: Int(gain))
+    }
+}
@@ -41,6 +41,15 @@ public struct ModuleInfo {
     public let channelCount: Int
 }
 
+/// Information about a single subsong
+public struct SubsongInfo {
+    public let index: Int
+    public let name: String
+    public let duration: TimeInterval
+    public let restartOrder: Int
+    public let restartRow: Int
+}
+
 /// Information about the current playback position
 public struct PlaybackPosition {
     public let seconds: TimeInterval
@@ -51,93 +60,252 @@ public struct PlaybackPosition {
     public let tempo: Int
 }
 
+/// Snapshot of a module's render, seek and load counters
+public struct OpenMPTStats: Sendable {
+    public let framesRendered: UInt64
+    public let renderCalls: UInt64
+    /// Total time spent rendering
+    public let renderTime: TimeInterval
+    /// Slowest single render call
+    public let maxBlockTime: TimeInterval
+    /// Render calls that returned fewer frames than requested
+    public let underruns: UInt64
+    public let seeks: UInt64
+    public let loads: UInt64
+    /// Total time spent loading
+    public let loadTime: TimeInterval
+}
+
+/// Immutable metadata, order list and pattern data captured when a module loads
+///
+/// Reading it never touches the libopenmpt module, so it is safe while the
+/// audio thread renders. Pattern cells are decoded on first access into a
+/// bounded cache owned by the snapshot.
+internal final class ModuleSnapshot: @unchecked Sendable {
+    private let pointer: UnsafePointer<openmpt_bridge_snapshot>
+    
+    init?(handle: OpaquePointer) {
+        guard let pointer = openmpt_bridge_module_acquire_snapshot(handle) else { return nil }
+        self.pointer = pointer
+    }
+    
+    deinit {
+        openmpt_bridge_snapshot_release(pointer)
+    }
+    
+    var contents: openmpt_bridge_snapshot {
+        return pointer.pointee
+    }
+    
+    func pattern(_ index: Int) -> openmpt_bridge_snapshot_pattern? {
+        guard index >= 0 && index < Int(contents.num_patterns) else { return nil }
+        return contents.patterns[index]
+    }
+    
+    func cell(pattern: Int, channel: Int, row: Int) -> openmpt_pattern_cell? {
+        var cell = openmpt_pattern_cell()
+        guard openmpt_bridge_snapshot_get_cell(pointer, Int32(clamping: pattern), Int32(clamping: channel), Int32(clamping: row), &cell) == 1 else {
+            return nil
+        }
+        return cell
+    }
+    
+    func row(pattern: Int, row: Int) -> [openmpt_pattern_cell]? {
+        var cells = [openmpt_pattern_cell](repeating: openmpt_pattern_cell(), count: Int(contents.num_channels))
+        guard openmpt_bridge_snapshot_get_row(pointer, Int32(clamping: pattern), Int32(clamping: row), &cells) == 1 else {
+            return nil
+        }
+        return cells
+    }
+    
+    func prefetch(order: Int, count: Int) {
+        openmpt_bridge_snapshot_prefetch(pointer, Int32(clamping: order), Int32(clamping: count))
+    }
+    
+    var cacheStats: openmpt_bridge_pattern_cache_stats {
+        var stats = openmpt_bridge_pattern_cache_stats()
+        _ = openmpt_bridge_snapshot_get_cache_stats(pointer, &stats)
+        return stats
+    }
+    
+    func setCacheBudget(_ bytes: Int) {
+        _ = openmpt_bridge_snapshot_set_cache_budget(pointer, max(bytes, 0))
+    }
+    
+    func names(_ table: UnsafePointer<UnsafePointer<CChar>?>?, count: Int32) -> [String] {
+        guard let table = table else { return [] }
+        return (0..<Int(count)).map { table[$0].map { String(cString: $0) } ?? "" }
+    }
+}
+
 /// Swift wrapper for libopenmpt module playback
+///
+/// The bridge handle separates the audio thread from everything else:
+/// metadata and pattern queries read an immutable snapshot, the playback
+/// position is published by the renderer, and while a player is running,
+/// seeks and parameter changes are queued for the audio thread.
 public final class OpenMPTModule {
-    internal var module: OpaquePointer?
+    /// Bridge handle that owns the libopenmpt module and counts its activity
+    internal let handle: OpaquePointer
     private var _moduleInfo: ModuleInfo?
+    private var _subsongs: [SubsongInfo]?
+    internal private(set) var snapshot: ModuleSnapshot?
+    
+    internal var module: OpaquePointer? {
+        return openmpt_bridge_module_get_module(handle)
+    }
     
     public var isLoaded: Bool {
-        return module != nil
+        return snapshot != nil
     }
     
     public var moduleInfo: ModuleInfo? {
         return _moduleInfo
     }
     
-    public init() {}
+    /// Durations, restart positions and names of all subsongs
+    ///
+    /// Collected in a single bridge call the first time it is read, which
+    /// selects every subsong in turn, and cached until another module is
+    /// loaded. Empty while a render thread owns the module and nothing is
+    /// cached yet, so read it before starting playback.
+    public var subsongs: [SubsongInfo] {
+        if let cached = _subsongs {
+            return cached
+        }
+        // Collecting selects every subsong in turn, which the audio thread must not see
+        guard openmpt_bridge_module_is_realtime(handle) == 0,
+              let module = module,
+              let table = openmpt_bridge_subsongs_create(module) else {
+            return []
+        }
+        defer { openmpt_bridge_subsongs_destroy(table) }
+        
+        let entries = UnsafeBufferPointer(start: table.pointee.subsongs, count: Int(table.pointee.count))
+        let subsongs = entries.enumerated().map { index, entry in
+            SubsongInfo(
+                index: index,
+                name: String(cString: entry.name),
+                duration: entry.duration,
+                restartOrder: Int(entry.restart_order),
+                restartRow: Int(entry.restart_row)
+            )
+        }
+        _subsongs = subsongs
+        return subsongs
+    }
+    
+    /// Render, seek and load counters
+    ///
+    /// Safe to read from any thread, including while the audio thread renders.
+    public var stats: OpenMPTStats {
+        var stats = openmpt_bridge_stats()
+        _ = openmpt_bridge_get_stats(handle, &stats)
+        return OpenMPTStats(
+            framesRendered: stats.frames_rendered,
+            renderCalls: stats.render_calls,
+            renderTime: TimeInterval(stats.render_ns) / 1_000_000_000,
+            maxBlockTime: TimeInterval(stats.max_block_ns) / 1_000_000_000,
+            underruns: stats.underruns,
+            seeks: stats.seeks,
+            loads: stats.loads,
+            loadTime: TimeInterval(stats.load_ns) / 1_000_000_000
+        )
+    }
+    
+    public init() {
+        handle = openmpt_bridge_module_create()!
+    }
     
     deinit {
-        if let module = module {
-            openmpt_module_destroy(module)
-        }
+        openmpt_bridge_module_destroy(handle)
+    }
+    
+    /// Zero all counters reported by `stats`
+    public func resetStats() {
+        openmpt_bridge_reset_stats(handle)
     }
     
     /// Load a tracker module from data
     /// - Parameter data: Raw module file data
     /// - Throws: OpenMPTError if loading fails
     public func loadModule(from data: Data) throws {
-        // Clean up existing module
-        if let existingModule = module {
-            openmpt_module_destroy(existingModule)
-            module = nil
-            _moduleInfo = nil
+        // Clean up existing module; a render thread may still own it
+        guard openmpt_bridge_module_unload(handle) == 1 else {
+            throw OpenMPTError.loadFailed("module is in use by a render thread")
         }
+        snapshot = nil
+        _moduleInfo = nil
+        _subsongs = nil
         
-        let loadedModule = try data.withUnsafeBytes { bytes in
+        try data.withUnsafeBytes { bytes in
             guard let baseAddress = bytes.baseAddress else {
                 throw OpenMPTError.invalidData
             }
             
             var error: Int32 = 0
-            var errorMessage: UnsafePointer<Int8>? = nil
-            
-            let module = openmpt_module_create_from_memory2(
-                baseAddress,
-                bytes.count,
-                nil, // logfunc
-                nil, // loguser
-                nil, // errfunc
-                nil, // erruser
-                &error,
-                &errorMessage,
-                nil  // ctls
-            )
             
-            guard module != nil else {
+            guard openmpt_bridge_module_load(handle, baseAddress, bytes.count, nil, &error) == 1 else {
                 throw OpenMPTError.loadFailed("openmpt_module_create_from_memory2 returned null")
             }
-            
-            return module!
         }
         
-        self.module = loadedModule
+        self.snapshot = ModuleSnapshot(handle: handle)
         self._moduleInfo = extractModuleInfo()
         
         // Set up default playback settings
-        _ = openmpt_module_set_repeat_count(loadedModule, -1) // Loop infinitely
+        _ = openmpt_bridge_module_set_repeat_count(handle, -1) // Loop infinitely
     }
     
     /// Get current playback position
+    ///
+    /// Reads the position last published by the renderer; safe from any thread.
     /// - Returns: Current playback position information
     public func getCurrentPosition() -> PlaybackPosition? {
-        guard let module = module else { return nil }
+        var position = openmpt_bridge_position()
+        guard openmpt_bridge_module_get_position(handle, &position) == 1 else { return nil }
         
         return PlaybackPosition(
-            seconds: openmpt_module_get_position_seconds(module),
-            order: Int(openmpt_module_get_current_order(module)),
-            pattern: Int(openmpt_module_get_current_pattern(module)), 
-            row: Int(openmpt_module_get_current_row(module)),
-            speed: Int(openmpt_module_get_current_speed(module)),
-            tempo: Int(openmpt_module_get_current_tempo2(module))
+            seconds: position.seconds,
+            order: Int(position.order),
+            pattern: Int(position.pattern),
+            row: Int(position.row),
+            speed: Int(position.speed),
+            tempo: Int(position.tempo)
         )
     }
     
     /// Set playback position to specific time
+    ///
+    /// During playback the seek is queued for the audio thread and the
+    /// clamped target is returned.
     /// - Parameter seconds: Time in seconds to seek to
     /// - Returns: Actual position set (may differ due to quantization)
     public func setPosition(seconds: Double) -> Double {
-        guard let module = module else { return 0.0 }
-        return openmpt_module_set_position_seconds(module, seconds)
+        guard isLoaded else { return 0.0 }
+        return openmpt_bridge_module_set_position_seconds(handle, seconds)
+    }
+    
+    /// Set how often the song repeats: -1 loops forever (the default after
+    /// loading), 0 plays it once
+    ///
+    /// Queued for the audio thread during playback, like a seek.
+    /// - Parameter count: Number of repeats after the first play
+    /// - Returns: True if applied or queued
+    @discardableResult
+    public func setRepeatCount(_ count: Int) -> Bool {
+        guard isLoaded else { return false }
+        return openmpt_bridge_module_set_repeat_count(handle, Int32(clamping: count)) == 1
+    }
+    
+    /// Whether the last render stopped at the end of the song
+    ///
+    /// Only a finite repeat count lets the song end. Once it has, renders
+    /// return no frames until the module is seeked. Safe from any thread.
+    public var hasReachedEnd: Bool {
+        var position = openmpt_bridge_position()
+        guard openmpt_bridge_module_get_position(handle, &position) == 1 else { return false }
+        return position.at_end != 0
     }
     
     /// Render audio frames
@@ -147,15 +315,15 @@ public final class OpenMPTModule {
     /// - Returns: Array of interleaved stereo samples (left, right, left, right, ...)
     /// - Throws: OpenMPTError if rendering fails
     public func renderAudio(sampleRate: Int32, frameCount: Int) throws -> [Float] {
-        guard let module = module else {
+        guard isLoaded else {
             throw OpenMPTError.notLoaded
         }
         
         var interleavedSamples = Array<Float>(repeating: 0.0, count: frameCount * 2)
         
         let renderedFrames = interleavedSamples.withUnsafeMutableBufferPointer { buffer in
-            return openmpt_module_read_interleaved_float_stereo(
-                module,
+            return openmpt_bridge_module_read_interleaved_float_stereo(
+                handle,
                 sampleRate,
                 frameCount,
                 buffer.baseAddress!
@@ -170,65 +338,43 @@ public final class OpenMPTModule {
     /// Get instrument names
     /// - Returns: Array of instrument names
     public func getInstrumentNames() -> [String] {
-        guard let module = module, let info = _moduleInfo else { return [] }
-        
-        var names: [String] = []
-        for i in 1...info.instrumentCount { // OpenMPT uses 1-based indexing
-            if let cString = openmpt_module_get_instrument_name(module, Int32(i)),
-               let name = String(cString: cString, encoding: .utf8) {
-                names.append(name)
-            } else {
-                names.append("Instrument \(i)")
-            }
+        guard let snapshot = snapshot else { return [] }
+        let contents = snapshot.contents
+        return snapshot.names(contents.instrument_names, count: contents.num_instruments).enumerated().map { index, name in
+            name.isEmpty ? "Instrument \(index + 1)" : name
         }
-        return names
     }
     
     /// Get sample names  
     /// - Returns: Array of sample names
     public func getSampleNames() -> [String] {
-        guard let module = module, let info = _moduleInfo else { return [] }
-        
-        var names: [String] = []
-        for i in 1...info.sampleCount { // OpenMPT uses 1-based indexing
-            if let cString = openmpt_module_get_sample_name(module, Int32(i)),
-               let name = String(cString: cString, encoding: .utf8) {
-                names.append(name)
-            } else {
-                names.append("Sample \(i)")
-            }
+        guard let snapshot = snapshot else { return [] }
+        let contents = snapshot.contents
+        return snapshot.names(contents.sample_names, count: contents.num_samples).enumerated().map { index, name in
+            name.isEmpty ? "Sample \(index + 1)" : name
         }
-        return names
     }
     
     // MARK: - Private Methods
     
     private func extractModuleInfo() -> ModuleInfo? {
-        guard let module = module else { return nil }
+        guard let contents = snapshot?.contents else { return nil }
         
-        let title = getString("title") ?? "Unknown"
-        let artist = getString("artist") ?? "Unknown"
-        let type = getString("type") ?? "Unknown"
+        func string(_ value: UnsafePointer<CChar>?) -> String? {
+            guard let value = value else { return nil }
+            let string = String(cString: value)
+            return string.isEmpty ? nil : string
+        }
         
         return ModuleInfo(
-            title: title,
-            artist: artist,
-            type: type,
-            duration: openmpt_module_get_duration_seconds(module),
-            instrumentCount: Int(openmpt_module_get_num_instruments(module)),
-            sampleCount: Int(openmpt_module_get_num_samples(module)),
-            patternCount: Int(openmpt_module_get_num_patterns(module)),
-            channelCount: Int(openmpt_module_get_num_channels(module))
+            title: string(contents.title) ?? "Unknown",
+            artist: string(contents.artist) ?? "Unknown",
+            type: string(contents.type) ?? "Unknown",
+            duration: contents.duration,
+            instrumentCount: Int(contents.num_instruments),
+            sampleCount: Int(contents.num_samples),
+            patternCount: Int(contents.num_patterns),
+            channelCount: Int(contents.num_channels)
         )
     }
-    
-    private func getString(_ key: String) -> String? {
-        guard let module = module else { return nil }
-        
-        if let cString = openmpt_module_get_metadata(module, key),
-           let string = String(cString: cString, encoding: .utf8) {
-            return string.isEmpty ? nil : string
-        }
-        return nil
-    }
-}
\ No newline at end of file
+}
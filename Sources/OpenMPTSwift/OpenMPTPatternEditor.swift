@@ -80,6 +80,21 @@ public struct OpenMPTPatternCell: Sendable {
     }
 }
 
+/// Activity of the decoded pattern page cache
+public struct OpenMPTPatternCacheStats: Sendable {
+    /// Reads served from a cached page
+    public let hits: UInt64
+    /// Pages decoded for a read
+    public let misses: UInt64
+    /// Pages dropped to stay within budget
+    public let evictions: UInt64
+    /// Pages decoded ahead by `prefetchPatterns`
+    public let prefetched: UInt64
+    public let bytes: Int
+    public let budget: Int
+    public let pages: Int
+}
+
 /// Pattern editing errors
 public enum OpenMPTPatternError: Error, LocalizedError, Equatable, Sendable {
     case invalidPattern(Int)
@@ -116,37 +131,32 @@ extension OpenMPTModule {
     /// - Parameter pattern: Pattern number (0-based)
     /// - Returns: Number of rows, or -1 if pattern is invalid
     public func getPatternRows(pattern: Int) -> Int {
-        guard isLoaded, let module = module else { return -1 }
-        return Int(openmpt_module_get_pattern_rows(module, Int32(pattern)))
+        guard let entry = snapshot?.pattern(pattern) else { return -1 }
+        return Int(entry.rows)
     }
     
     /// Get pattern name
     /// - Parameter pattern: Pattern number (0-based)
     /// - Returns: Pattern name, or empty string if invalid
     public func getPatternName(pattern: Int) -> String {
-        guard isLoaded, let module = module else { return "" }
-        if let cString = openmpt_module_get_pattern_name(module, Int32(pattern)) {
-            let name = String(cString: cString)
-            openmpt_free_string(cString)
-            return name
-        }
-        return ""
+        guard let name = snapshot?.pattern(pattern)?.name else { return "" }
+        return String(cString: name)
     }
     
     /// Get rows per beat for a specific pattern
     /// - Parameter pattern: Pattern number (0-based)
     /// - Returns: Rows per beat, or -1 if pattern is invalid
     public func getPatternRowsPerBeat(pattern: Int) -> Int {
-        guard isLoaded, let module = module else { return -1 }
-        return Int(openmpt_module_get_pattern_rows_per_beat(module, Int32(pattern)))
+        guard let entry = snapshot?.pattern(pattern) else { return -1 }
+        return Int(entry.rows_per_beat)
     }
     
     /// Get rows per measure for a specific pattern
     /// - Parameter pattern: Pattern number (0-based)
     /// - Returns: Rows per measure, or -1 if pattern is invalid
     public func getPatternRowsPerMeasure(pattern: Int) -> Int {
-        guard isLoaded, let module = module else { return -1 }
-        return Int(openmpt_module_get_pattern_rows_per_measure(module, Int32(pattern)))
+        guard let entry = snapshot?.pattern(pattern) else { return -1 }
+        return Int(entry.rows_per_measure)
     }
     
     /// Get pattern cell data
@@ -156,12 +166,7 @@ extension OpenMPTModule {
     ///   - row: Row number (0-based)
     /// - Returns: Pattern cell data, or nil if invalid coordinates
     public func getPatternCell(pattern: Int, channel: Int, row: Int) -> OpenMPTPatternCell? {
-        guard isLoaded, let module = module else { return nil }
-        
-        var cellData = openmpt_pattern_cell()
-        let result = openmpt_module_get_pattern_cell(module, Int32(pattern), Int32(channel), Int32(row), &cellData)
-        
-        guard result == 1 else { return nil }
+        guard let cellData = snapshot?.cell(pattern: pattern, channel: channel, row: row) else { return nil }
         
         return OpenMPTPatternCell(
             note: OpenMPTNote(midiNote: cellData.note),
@@ -172,6 +177,67 @@ extension OpenMPTModule {
         )
     }
     
+    /// Get every channel's cell in a pattern row
+    /// - Parameters:
+    ///   - pattern: Pattern number (0-based)
+    ///   - row: Row number (0-based)
+    /// - Returns: One cell per channel, or nil if invalid coordinates
+    public func getPatternRow(pattern: Int, row: Int) -> [OpenMPTPatternCell]? {
+        guard let cells = snapshot?.row(pattern: pattern, row: row) else { return nil }
+        
+        return cells.map {
+            OpenMPTPatternCell(
+                note: OpenMPTNote(midiNote: $0.note),
+                instrument: $0.instrument,
+                volume: $0.volume,
+                effect: $0.effect,
+                effectParam: $0.effect_param
+            )
+        }
+    }
+    
+    /// Decode the patterns of upcoming orders ahead of drawing them
+    ///
+    /// Pattern cells are decoded on first access into a cache of at most
+    /// `OPENMPT_BRIDGE_PATTERN_CACHE_BYTES`, or `setPatternCacheBudget`. A view that follows playback
+    /// calls this from its position updates.
+    /// - Parameters:
+    ///   - orders: Orders after the first one to decode
+    ///   - order: First order, or nil for the current playback order
+    public func prefetchPatterns(orders: Int, from order: Int? = nil) {
+        if let order = order {
+            snapshot?.prefetch(order: order, count: orders + 1)
+        } else {
+            openmpt_bridge_module_prefetch_patterns(handle, Int32(clamping: orders))
+        }
+    }
+    
+    /// Pattern cache counters for the loaded module
+    public var patternCacheStats: OpenMPTPatternCacheStats? {
+        guard let stats = snapshot?.cacheStats else { return nil }
+        return OpenMPTPatternCacheStats(
+            hits: stats.hits,
+            misses: stats.misses,
+            evictions: stats.evictions,
+            prefetched: stats.prefetched,
+            bytes: Int(stats.bytes),
+            budget: Int(stats.budget),
+            pages: Int(stats.pages)
+        )
+    }
+    
+    /// Change the byte budget of the loaded module's pattern cache
+    ///
+    /// Least recently used pages are dropped at once if they no longer fit;
+    /// the most recently used page is always kept.
+    /// - Returns: false if no module is loaded
+    @discardableResult
+    public func setPatternCacheBudget(_ bytes: Int) -> Bool {
+        guard let snapshot = snapshot else { return false }
+        snapshot.setCacheBudget(bytes)
+        return true
+    }
+    
     // MARK: - Pattern Editing
     
     /// Set pattern cell data
@@ -182,13 +248,13 @@ extension OpenMPTModule {
     ///   - cell: New cell data
     /// - Throws: OpenMPTPatternError if coordinates are invalid
     public func setPatternCell(pattern: Int, channel: Int, row: Int, cell: OpenMPTPatternCell) throws {
-        guard isLoaded, let module = module else {
+        guard let contents = snapshot?.contents, let module = module else {
             throw OpenMPTPatternError.moduleNotLoaded
         }
         
         // Validate coordinates
-        let patternCount = Int(openmpt_module_get_num_patterns(module))
-        let channelCount = Int(openmpt_module_get_num_channels(module))
+        let patternCount = Int(contents.num_patterns)
+        let channelCount = Int(contents.num_channels)
         let rowCount = getPatternRows(pattern: pattern)
         
         guard pattern >= 0 && pattern < patternCount else {
@@ -278,11 +344,11 @@ extension OpenMPTModule {
     ///   - row: Row number (0-based)
     /// - Throws: OpenMPTPatternError if coordinates are invalid
     public func clearPatternRow(pattern: Int, row: Int) throws {
-        guard isLoaded, let module = module else {
+        guard let contents = snapshot?.contents else {
             throw OpenMPTPatternError.moduleNotLoaded
         }
         
-        let channelCount = Int(openmpt_module_get_num_channels(module))
+        let channelCount = Int(contents.num_channels)
         
         for channel in 0..<channelCount {
             try clearPatternCell(pattern: pattern, channel: channel, row: row)
@@ -330,26 +396,28 @@ extension OpenMPTModule {
     /// Get number of orders in the module
     /// - Returns: Number of orders, or -1 if module not loaded
     public func getNumOrders() -> Int {
-        guard isLoaded, let module = module else { return -1 }
-        return Int(openmpt_module_get_num_orders(module))
+        guard let contents = snapshot?.contents else { return -1 }
+        return Int(contents.num_orders)
     }
     
     /// Get pattern number for a specific order
     /// - Parameter order: Order position (0-based)
     /// - Returns: Pattern number, or -1 if invalid
     public func getOrderPattern(order: Int) -> Int {
-        guard isLoaded, let module = module else { return -1 }
-        return Int(openmpt_module_get_order_pattern(module, Int32(order)))
+        guard let contents = snapshot?.contents,
+              order >= 0 && order < Int(contents.num_orders) else { return -1 }
+        return Int(contents.orders[order])
     }
     
     /// Set playback position by order and row
     /// - Parameters:
     ///   - order: Order position (0-based)
     ///   - row: Row within pattern (0-based)
-    /// - Returns: Actual position set in seconds
+    /// - Returns: Actual position set in seconds; during playback the seek is
+    ///   queued for the audio thread and the start time of the order is returned
     public func setPosition(order: Int, row: Int) -> TimeInterval {
-        guard isLoaded, let module = module else { return 0.0 }
-        return openmpt_module_set_position_order_row(module, Int32(order), Int32(row))
+        guard isLoaded else { return 0.0 }
+        return openmpt_bridge_module_set_position_order_row(handle, Int32(order), Int32(row))
     }
     
     // MARK: - Subsong Support
@@ -357,23 +425,24 @@ extension OpenMPTModule {
     /// Get number of subsongs in the module
     /// - Returns: Number of subsongs, or -1 if module not loaded
     public func getNumSubsongs() -> Int {
-        guard isLoaded, let module = module else { return -1 }
-        return Int(openmpt_module_get_num_subsongs(module))
+        guard let contents = snapshot?.contents else { return -1 }
+        return Int(contents.num_subsongs)
     }
     
     /// Get currently selected subsong
     /// - Returns: Selected subsong index, or -1 if module not loaded
     public func getSelectedSubsong() -> Int {
-        guard isLoaded, let module = module else { return -1 }
-        return Int(openmpt_module_get_selected_subsong(module))
+        var position = openmpt_bridge_position()
+        guard openmpt_bridge_module_get_position(handle, &position) == 1 else { return -1 }
+        return Int(position.subsong)
     }
     
     /// Select a subsong for playback
     /// - Parameter subsong: Subsong index (0-based)
-    /// - Returns: True if successful, false otherwise
+    /// - Returns: True if successful (or queued during playback), false otherwise
     public func selectSubsong(_ subsong: Int) -> Bool {
-        guard isLoaded, let module = module else { return false }
-        return openmpt_module_select_subsong(module, Int32(subsong)) == 1
+        guard isLoaded else { return false }
+        return openmpt_bridge_module_select_subsong(handle, Int32(clamping: subsong)) == 1
     }
     
     // MARK: - Render Parameters and Control
@@ -383,17 +452,22 @@ extension OpenMPTModule {
     /// - Returns: Parameter value, or -1 if invalid
     public func getRenderParam(_ parameter: Int) -> Int {
         guard isLoaded, let module = module else { return -1 }
-        return Int(openmpt_module_get_render_param(module, Int32(parameter)))
+        var value: Int32 = 0
+        guard openmpt_module_get_render_param(module, Int32(parameter), &value) == 1 else { return -1 }
+        return Int(value)
     }
     
     /// Set render parameter value
+    ///
+    /// While a player is rendering the module, the change is queued and
+    /// applied by the audio thread at the start of its next block.
     /// - Parameters:
     ///   - parameter: Parameter identifier
     ///   - value: New parameter value
-    /// - Returns: True if successful, false otherwise
+    /// - Returns: True if applied or queued, false otherwise
     public func setRenderParam(_ parameter: Int, value: Int) -> Bool {
-        guard isLoaded, let module = module else { return false }
-        return openmpt_module_set_render_param(module, Int32(parameter), Int32(value)) == 1
+        guard isLoaded else { return false }
+        return openmpt_bridge_module_set_render_param(handle, Int32(parameter), Int32(value)) == 1
     }
     
     /// Get control value
@@ -410,13 +484,23 @@ extension OpenMPTModule {
     }
     
     /// Set control value
+    ///
+    /// While a player is rendering the module, the change is queued and
+    /// applied by the audio thread at the start of its next block.
     /// - Parameters:
     ///   - control: Control name
     ///   - value: Control value
-    /// - Returns: True if successful, false otherwise
+    /// - Returns: True if applied or queued, false otherwise
     public func setControl(_ control: String, value: String) -> Bool {
-        guard isLoaded, let module = module else { return false }
-        return openmpt_module_ctl_set(module, control, value) == 1
+        guard isLoaded else { return false }
+        return openmpt_bridge_module_ctl_set(handle, control, value) == 1
+    }
+    
+    /// Ramp time in seconds for master gain and stereo separation changes
+    /// made during playback; 0 applies them at the next audio block
+    public var parameterSmoothing: TimeInterval {
+        get { openmpt_bridge_module_get_smoothing(handle) }
+        set { openmpt_bridge_module_set_smoothing(handle, newValue) }
     }
     
     // MARK: - Convenience Functions
@@ -424,8 +508,8 @@ extension OpenMPTModule {
     /// Get all pattern names in the module
     /// - Returns: Array of pattern names
     public func getAllPatternNames() -> [String] {
-        guard isLoaded, let module = module else { return [] }
-        let patternCount = Int(openmpt_module_get_num_patterns(module))
+        guard let contents = snapshot?.contents else { return [] }
+        let patternCount = Int(contents.num_patterns)
         var names: [String] = []
         
         for i in 0..<patternCount {
@@ -438,12 +522,12 @@ extension OpenMPTModule {
     /// Get complete order sequence
     /// - Returns: Array of pattern numbers in order sequence
     public func getOrderSequence() -> [Int] {
-        guard isLoaded, let module = module else { return [] }
-        let orderCount = Int(openmpt_module_get_num_orders(module))
+        guard let contents = snapshot?.contents else { return [] }
+        let orderCount = Int(contents.num_orders)
         var sequence: [Int] = []
         
         for i in 0..<orderCount {
-            sequence.append(Int(openmpt_module_get_order_pattern(module, Int32(i))))
+            sequence.append(Int(contents.orders[i]))
         }
         
         return sequence
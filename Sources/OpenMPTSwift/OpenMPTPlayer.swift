@@ -15,6 +15,13 @@ public protocol OpenMPTPlayerDelegate: AnyObject {
     func playerDidStopPlaying(_ player: OpenMPTPlayer)
     func playerDidUpdatePosition(_ player: OpenMPTPlayer, position: PlaybackPosition)
     func playerDidEncounterError(_ player: OpenMPTPlayer, error: OpenMPTError)
+    func playerDidOverrunDeadline(_ player: OpenMPTPlayer, event: OpenMPTOverrunEvent)
+    func playerDidReachEnd(_ player: OpenMPTPlayer)
+}
+
+public extension OpenMPTPlayerDelegate {
+    func playerDidOverrunDeadline(_ player: OpenMPTPlayer, event: OpenMPTOverrunEvent) {}
+    func playerDidReachEnd(_ player: OpenMPTPlayer) {}
 }
 
 /// Wrapper to make non-Sendable types work across actor boundaries
@@ -31,6 +38,9 @@ struct UncheckedSendable<Value>: @unchecked Sendable {
 public final class OpenMPTPlayer {
     public weak var delegate: OpenMPTPlayerDelegate?
     
+    /// Shared with the audio thread, which only calls `render`. While the
+    /// engine runs, the bridge handle is in real-time mode: queries read
+    /// snapshots and the published position, and mutations are queued.
     private let moduleWrapper: UncheckedSendable<OpenMPTModule>
     private let audioEngineWrapper: UncheckedSendable<AVAudioEngine>
     private var sourceNode: AVAudioSourceNode?
@@ -58,6 +68,73 @@ public final class OpenMPTPlayer {
         return module.getCurrentPosition()
     }
     
+    /// Fraction of each audio callback's deadline rendering may use before
+    /// `playerDidOverrunDeadline` is reported
+    public var renderBudget: Double {
+        get { module.renderBudget }
+        set { module.renderBudget = newValue }
+    }
+    
+    /// Utilization of the audio callback relative to its deadline
+    public var deadlineReport: OpenMPTDeadlineReport {
+        return module.deadlineReport
+    }
+    
+    /// Lower render quality automatically while the audio callback overruns `renderBudget`
+    public var adaptiveQuality: Bool {
+        get { module.qualityState.isEnabled }
+        set { newValue ? module.enableAdaptiveQuality() : module.disableAdaptiveQuality() }
+    }
+    
+    public var qualityState: OpenMPTQualityState {
+        return module.qualityState
+    }
+    
+    /// Playback speed, in (0, 4], without changing pitch. Changes take
+    /// effect at the next audio block and persist across seeks; values
+    /// outside the range are refused, see `setTempoFactor(_:)`.
+    public var tempoFactor: Double {
+        get { module.tempoFactor }
+        set { module.tempoFactor = newValue }
+    }
+    
+    /// Pitch, in (0, 4], without changing playback speed; values outside
+    /// the range are refused, see `setPitchFactor(_:)`
+    public var pitchFactor: Double {
+        get { module.pitchFactor }
+        set { module.pitchFactor = newValue }
+    }
+    
+    /// Pitch change in semitones, a convenience over `pitchFactor`
+    public var pitchSemitones: Double {
+        get { module.pitchSemitones }
+        set { module.pitchSemitones = newValue }
+    }
+    
+    /// Set the tempo factor
+    /// - Returns: false if the factor is outside (0, 4] and was not applied
+    @discardableResult
+    public func setTempoFactor(_ factor: Double) -> Bool {
+        return module.setTempoFactor(factor)
+    }
+    
+    /// Set the pitch factor
+    /// - Returns: false if the factor is outside (0, 4] and was not applied
+    @discardableResult
+    public func setPitchFactor(_ factor: Double) -> Bool {
+        return module.setPitchFactor(factor)
+    }
+    
+    /// Orders after the current one whose patterns are decoded ahead of
+    /// playback on each position update, so pattern views never wait
+    public var patternPrefetchOrders = 2
+    
+    /// Loop the song forever (the default). When false the song plays
+    /// once; the player then stops and calls `playerDidReachEnd`.
+    public var loops = true {
+        didSet { module.setRepeatCount(loops ? -1 : 0) }
+    }
+    
     public init(sampleRate: Double = 48000) throws {
         guard let format = AVAudioFormat(standardFormatWithSampleRate: sampleRate, channels: 2) else {
             throw OpenMPTError.loadFailed("Failed to create audio format")
@@ -81,6 +158,9 @@ public final class OpenMPTPlayer {
     public func loadModule(from data: Data) throws {
         stop() // Stop any current playback
         try module.loadModule(from: data)
+        if !loops {
+            module.setRepeatCount(0)
+        }
     }
     
     /// Start playback
@@ -132,6 +212,49 @@ public final class OpenMPTPlayer {
         return module.getSampleNames()
     }
     
+    // MARK: - Channel Mix
+    
+    /// Mute or unmute a pattern channel, or every channel for nil.
+    /// Like the other channel controls, applied at the next audio block.
+    @discardableResult
+    public func setMuted(_ muted: Bool, channel: Int?) -> Bool {
+        return module.setMuted(muted, channel: channel)
+    }
+    
+    public func isMuted(channel: Int) -> Bool {
+        return module.isMuted(channel: channel)
+    }
+    
+    /// Solo or unsolo a pattern channel, or every channel for nil
+    @discardableResult
+    public func setSolo(_ solo: Bool, channel: Int?) -> Bool {
+        return module.setSolo(solo, channel: channel)
+    }
+    
+    public func isSoloed(channel: Int) -> Bool {
+        return module.isSoloed(channel: channel)
+    }
+    
+    /// Channel volume, 0 (silent) ... 1 (as written)
+    @discardableResult
+    public func setVolume(_ volume: Double, channel: Int) -> Bool {
+        return module.setVolume(volume, channel: channel)
+    }
+    
+    public func volume(channel: Int) -> Double {
+        return module.volume(channel: channel)
+    }
+    
+    /// Channel panning, -1 (left) ... 1 (right)
+    @discardableResult
+    public func setPanning(_ panning: Double, channel: Int) -> Bool {
+        return module.setPanning(panning, channel: channel)
+    }
+    
+    public func panning(channel: Int) -> Double {
+        return module.panning(channel: channel)
+    }
+    
     // MARK: - Private Methods
     
     private func setupAudioSession() throws {
@@ -165,57 +288,46 @@ public final class OpenMPTPlayer {
     
     private func startAudioEngine() throws {
         if !audioEngine.isRunning {
-            try audioEngine.start()
+            module.setRealtime(true)
+            do {
+                try audioEngine.start()
+            } catch {
+                module.setRealtime(false)
+                throw error
+            }
         }
     }
     
     private func stopAudioEngine() {
         audioEngine.stop()
-    }
-    
-    @MainActor
-    private func notifyError(_ error: OpenMPTError) {
-        delegate?.playerDidEncounterError(self, error: error)
+        // The render callback has finished; parameter changes apply directly again
+        module.setRealtime(false)
     }
     
     nonisolated private func renderAudio(frameCount: UInt32, audioBufferList: UnsafeMutablePointer<AudioBufferList>) -> OSStatus {
         let bufferList = UnsafeMutableAudioBufferListPointer(audioBufferList)
         
-        guard let buffer = bufferList[0].mData?.assumingMemoryBound(to: Float.self) else {
+        // The standard format is deinterleaved: one buffer per channel
+        guard bufferList.count >= 2,
+              let left = bufferList[0].mData?.assumingMemoryBound(to: Float.self),
+              let right = bufferList[1].mData?.assumingMemoryBound(to: Float.self) else {
             return kAudioUnitErr_InvalidParameter
         }
         
-        do {
-            let samples = try moduleWrapper.value.renderAudio(
-                sampleRate: Int32(audioFormatWrapper.value.sampleRate), 
-                frameCount: Int(frameCount)
-            )
-            
-            // Copy samples to output buffer
-            let sampleCount = min(samples.count, Int(frameCount) * 2)
-            for i in 0..<sampleCount {
-                buffer[i] = samples[i]
-            }
-            
-            // Fill remaining with silence if needed
-            if sampleCount < Int(frameCount) * 2 {
-                for i in sampleCount..<(Int(frameCount) * 2) {
-                    buffer[i] = 0.0
-                }
-            }
-            
-        } catch {
-            // Fill with silence on error
-            for i in 0..<(Int(frameCount) * 2) {
-                buffer[i] = 0.0
-            }
-            
-            // Report error to main actor
-            let errorToReport = error as? OpenMPTError ?? .renderFailed
-            Task { @MainActor [weak self] in
-                guard let self = self else { return }
-                self.notifyError(errorToReport)
-            }
+        // Render in place through the bridge, which times the block against
+        // its deadline; nothing here allocates or locks
+        let frames = Int(frameCount)
+        let rendered = moduleWrapper.value.render(
+            left: left,
+            right: right,
+            frameCount: frames,
+            sampleRate: Int32(audioFormatWrapper.value.sampleRate)
+        )
+        
+        // Fill remaining with silence if needed
+        if rendered < frames {
+            (left + rendered).update(repeating: 0, count: frames - rendered)
+            (right + rendered).update(repeating: 0, count: frames - rendered)
         }
         
         return noErr
@@ -224,7 +336,20 @@ public final class OpenMPTPlayer {
     private func startPositionUpdates() {
         positionTimer = Timer.scheduledTimer(withTimeInterval: 0.1, repeats: true) { [weak self] _ in
             Task { @MainActor [weak self] in
-                guard let self = self, let position = self.module.getCurrentPosition() else { return }
+                guard let self = self else { return }
+                for event in self.module.drainOverrunEvents() {
+                    self.delegate?.playerDidOverrunDeadline(self, event: event)
+                }
+                // The audio thread pads the final block with silence
+                if self.module.hasReachedEnd {
+                    self.stop()
+                    self.delegate?.playerDidReachEnd(self)
+                    return
+                }
+                guard let position = self.module.getCurrentPosition() else { return }
+                if self.patternPrefetchOrders > 0 {
+                    self.module.prefetchPatterns(orders: self.patternPrefetchOrders)
+                }
                 self.delegate?.playerDidUpdatePosition(self, position: position)
             }
         }
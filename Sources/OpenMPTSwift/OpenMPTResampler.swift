@@ -0,0 +1,109 @@
+//
+//  OpenMPTResampler.swift
+//  OpenMPTSwift
+//
+//  Polyphase sample-rate conversion of rendered audio
+//
+
+import Foundation
+import CLibOpenMPT
+
+/// Filter length and passband trade-off for `OpenMPTResampler`
+public enum OpenMPTResamplerQuality: Int32, Sendable, CaseIterable {
+    /// 16 taps, ~90% passband
+    case fast = 0
+    /// 32 taps, ~94% passband
+    case balanced = 1
+    /// 64 taps, ~96% passband
+    case best = 2
+}
+
+/// Converts interleaved float audio between two sample rates
+///
+/// Render a module once at a base rate and feed the result through one
+/// resampler per output instead of rendering it again at every rate.
+/// Downsampling lengthens the filter to keep the same transition band.
+/// A resampler is not thread safe; the pointer-based `process` never
+/// allocates, so it is safe to call from a render callback.
+public final class OpenMPTResampler {
+    private let resampler: OpaquePointer
+
+    public let inputRate: Int
+    public let outputRate: Int
+    public let channels: Int
+    public let quality: OpenMPTResamplerQuality
+
+    /// Returns nil for non-positive rates, downsampling by more than 16x, or
+    /// more than `OPENMPT_BRIDGE_RESAMPLER_MAX_CHANNELS` channels
+    public init?(inputRate: Int, outputRate: Int, channels: Int = 2, quality: OpenMPTResamplerQuality = .balanced) {
+        guard let resampler = openmpt_bridge_resampler_create(Int32(clamping: inputRate), Int32(clamping: outputRate),
+                                                              Int32(clamping: channels), quality.rawValue) else {
+            return nil
+        }
+        self.resampler = resampler
+        self.inputRate = inputRate
+        self.outputRate = outputRate
+        self.channels = channels
+        self.quality = quality
+    }
+
+    deinit {
+        openmpt_bridge_resampler_destroy(resampler)
+    }
+
+    /// Filter length in input frames
+    public var taps: Int {
+        Int(openmpt_bridge_resampler_get_taps(resampler))
+    }
+
+    /// Input frames held back until more input or `flush()` arrives
+    public var latency: Int {
+        Int(openmpt_bridge_resampler_get_latency(resampler))
+    }
+
+    /// Largest number of frames a call with this many input frames can produce
+    public func maxOutputFrames(for inputFrames: Int) -> Int {
+        openmpt_bridge_resampler_max_output(resampler, inputFrames)
+    }
+
+    /// Convert frames in place without allocating
+    ///
+    /// - Returns: Input frames consumed and output frames written. All input
+    ///   is consumed when `outputCapacity >= maxOutputFrames(for: frameCount)`.
+    public func process(_ input: UnsafePointer<Float>, frameCount: Int,
+                        into output: UnsafeMutablePointer<Float>, outputCapacity: Int) -> (consumed: Int, produced: Int) {
+        var consumed = frameCount
+        let produced = openmpt_bridge_resampler_process(resampler, input, &consumed, output, outputCapacity)
+        return (consumed, produced)
+    }
+
+    /// Convert interleaved samples
+    public func process(_ input: [Float]) -> [Float] {
+        let frames = input.count / channels
+        guard frames > 0 else { return [] }
+        var output = [Float](repeating: 0, count: maxOutputFrames(for: frames) * channels)
+        let produced = input.withUnsafeBufferPointer { source in
+            output.withUnsafeMutableBufferPointer { destination in
+                process(source.baseAddress!, frameCount: frames,
+                        into: destination.baseAddress!, outputCapacity: destination.count / channels).produced
+            }
+        }
+        output.removeSubrange((produced * channels)...)
+        return output
+    }
+
+    /// Emit the frames still held back, as if the input ended in silence
+    public func flush() -> [Float] {
+        var output = [Float](repeating: 0, count: maxOutputFrames(for: latency) * channels)
+        let produced = output.withUnsafeMutableBufferPointer { destination in
+            openmpt_bridge_resampler_flush(resampler, destination.baseAddress!, destination.count / channels)
+        }
+        output.removeSubrange((produced * channels)...)
+        return output
+    }
+
+    /// Forget buffered input, e.g. after seeking the source
+    public func reset() {
+        openmpt_bridge_resampler_reset(resampler)
+    }
+}
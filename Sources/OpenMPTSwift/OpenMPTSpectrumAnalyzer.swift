@@ -0,0 +1,109 @@
+//
+//  OpenMPTSpectrumAnalyzer.swift
+//  OpenMPTSwift
+//
+//  FFT spectra of the rendered audio for visualizers
+//
+
+import Foundation
+import CLibOpenMPT
+
+/// Analysis window applied before each FFT
+public enum OpenMPTAnalyzerWindow: Int32, Sendable {
+    case hann = 0
+    /// Lower side lobes, wider peaks
+    case blackmanHarris = 1
+}
+
+/// Settings of an `OpenMPTSpectrumAnalyzer`
+public struct OpenMPTSpectrumAnalyzerOptions: Sendable {
+    /// Rate the module is rendered at
+    public var sampleRate: Int = 48000
+    /// Power of two from 64 to 16384
+    public var fftSize: Int = 2048
+    /// Frames between spectra, nil for a quarter of `fftSize`
+    public var hopFrames: Int?
+    public var window: OpenMPTAnalyzerWindow = .hann
+    /// 0 for none; values towards 1 make peaks fall back more slowly
+    public var smoothing: Float = 0.5
+    /// Magnitudes are clamped to at least this, in dBFS
+    public var floorDecibels: Float = -120
+
+    public init() {}
+}
+
+/// One magnitude spectrum
+public struct OpenMPTSpectrum: Sendable {
+    /// Increases by one per spectrum computed
+    public let sequence: UInt64
+    /// Rendered frames the analyzer had seen when the window ended
+    public let frame: UInt64
+    /// dBFS per bin from DC to Nyquist; a full-scale sine peaks at about 0
+    public let magnitudes: [Float]
+    /// Width of one bin in Hz
+    public let binWidth: Double
+
+    /// Centre frequency of a bin in Hz
+    public func frequency(ofBin bin: Int) -> Double {
+        Double(bin) * binWidth
+    }
+}
+
+/// Spectra of everything a module renders, computed off the audio thread
+///
+/// The analyzer takes one of the module's taps, so the audio thread only
+/// copies each block. A worker thread computes the spectra and publishes
+/// the newest one; call `latestSpectrum()` from a single thread at a time,
+/// for example once per display frame. The analyzer keeps its module alive
+/// and stops when released.
+public final class OpenMPTSpectrumAnalyzer {
+    private let module: OpenMPTModule
+    private let analyzer: OpaquePointer
+    public let options: OpenMPTSpectrumAnalyzerOptions
+
+    fileprivate init?(module: OpenMPTModule, options: OpenMPTSpectrumAnalyzerOptions) {
+        var cOptions = openmpt_bridge_analyzer_options()
+        openmpt_bridge_analyzer_options_init(&cOptions)
+        cOptions.sample_rate = Int32(clamping: options.sampleRate)
+        cOptions.fft_size = Int32(clamping: options.fftSize)
+        cOptions.hop_frames = Int32(clamping: options.hopFrames ?? 0)
+        cOptions.window = options.window.rawValue
+        cOptions.smoothing = options.smoothing
+        cOptions.floor_db = options.floorDecibels
+        guard let analyzer = openmpt_bridge_analyzer_create(module.handle, &cOptions) else { return nil }
+        self.module = module
+        self.analyzer = analyzer
+        self.options = options
+    }
+
+    deinit {
+        openmpt_bridge_analyzer_destroy(module.handle, analyzer)
+    }
+
+    /// Bins per spectrum, DC to Nyquist
+    public var binCount: Int {
+        options.fftSize / 2 + 1
+    }
+
+    /// The newest spectrum, or nil before enough audio has been rendered
+    public func latestSpectrum() -> OpenMPTSpectrum? {
+        guard let frame = openmpt_bridge_analyzer_acquire(analyzer)?.pointee else { return nil }
+        let magnitudes = Array(UnsafeBufferPointer(start: frame.magnitudes, count: Int(frame.bins)))
+        return OpenMPTSpectrum(
+            sequence: frame.sequence,
+            frame: frame.frame,
+            magnitudes: magnitudes,
+            binWidth: openmpt_bridge_analyzer_bin_frequency(analyzer, 1)
+        )
+    }
+}
+
+extension OpenMPTModule {
+
+    /// Start a spectrum analyzer on everything rendered from now on
+    ///
+    /// - Returns: nil if the options are invalid or no tap is free
+    public func addSpectrumAnalyzer(_ options: OpenMPTSpectrumAnalyzerOptions = OpenMPTSpectrumAnalyzerOptions()) -> OpenMPTSpectrumAnalyzer? {
+        OpenMPTSpectrumAnalyzer(module: self, options: options)
+    }
+}
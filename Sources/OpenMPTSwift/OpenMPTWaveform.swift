@@ -0,0 +1,159 @@
+//
+//  OpenMPTWaveform.swift
+//  OpenMPTSwift
+//
+//  Cached min/max/RMS overviews of whole modules
+//
+
+import Foundation
+import CLibOpenMPT
+
+/// Settings for building a waveform overview
+public struct OpenMPTWaveformOptions: Sendable {
+    /// Render rate; lower is faster and still resolves the envelope
+    public var sampleRate: Int = 11025
+    /// Rendered frames per point at the finest level
+    public var framesPerPoint: Int = 128
+    /// Subsong to render, nil for the default
+    public var subsong: Int?
+    /// Interpolation filter taps; 1 is nearest neighbour, the fastest
+    public var interpolationFilter: Int = 1
+    /// Stop after this much audio; nil renders to the end of the song
+    public var maxDuration: TimeInterval?
+
+    public init() {}
+
+    fileprivate var bridgeOptions: openmpt_bridge_waveform_options {
+        var options = openmpt_bridge_waveform_options()
+        openmpt_bridge_waveform_options_init(&options)
+        options.sample_rate = Int32(clamping: sampleRate)
+        options.frames_per_point = Int32(clamping: framesPerPoint)
+        options.subsong = Int32(clamping: subsong ?? -1)
+        options.interpolation_filter = Int32(clamping: interpolationFilter)
+        options.max_seconds = maxDuration ?? 0
+        return options
+    }
+}
+
+/// Peaks and RMS of one span, with full scale at 1
+public struct OpenMPTWaveformPoint: Sendable {
+    public let min: Float
+    public let max: Float
+    public let rms: Float
+}
+
+/// One zoom level of an overview, read in place from the mapped file
+public struct OpenMPTWaveformLevel: RandomAccessCollection {
+    private let waveform: OpenMPTWaveform
+    private let points: UnsafePointer<openmpt_bridge_waveform_point>?
+
+    public let count: Int
+    /// Rendered frames covered by each point
+    public let framesPerPoint: Int
+
+    fileprivate init(waveform: OpenMPTWaveform, points: UnsafePointer<openmpt_bridge_waveform_point>?,
+                     count: Int, framesPerPoint: Int) {
+        self.waveform = waveform
+        self.points = points
+        self.count = count
+        self.framesPerPoint = framesPerPoint
+    }
+
+    public var startIndex: Int { 0 }
+
+    public var endIndex: Int { count }
+
+    public subscript(position: Int) -> OpenMPTWaveformPoint {
+        precondition(position >= 0 && position < count, "Waveform index out of range")
+        let point = points![position]
+        return OpenMPTWaveformPoint(
+            min: Float(point.min) / 32767,
+            max: Float(point.max) / 32767,
+            rms: Float(point.rms) / 32767
+        )
+    }
+}
+
+/// Multi-resolution waveform overview of a whole song
+///
+/// Overviews are rendered once at low quality and cached on disk; later
+/// loads map the cached file and check it against the module data, so
+/// showing an overview again costs no rendering. Level 0 is the finest and
+/// each following level halves the resolution.
+public final class OpenMPTWaveform: @unchecked Sendable {
+    private let handle: OpaquePointer
+
+    /// Load the overview cached at `cacheURL`, building it first if it is
+    /// missing or was built from other data or options
+    ///
+    /// Building renders the whole song, so call this off the main actor or
+    /// use `load(data:cacheURL:options:)`.
+    /// - Throws: OpenMPTError if the module cannot be rendered or the cache cannot be written
+    public init(data: Data, cacheURL: URL, options: OpenMPTWaveformOptions = OpenMPTWaveformOptions()) throws {
+        guard !data.isEmpty else {
+            throw OpenMPTError.invalidData
+        }
+        var settings = options.bridgeOptions
+        let handle = data.withUnsafeBytes { bytes in
+            openmpt_bridge_waveform_load(bytes.baseAddress, bytes.count, &settings, cacheURL.path)
+        }
+        guard let handle = handle else {
+            throw OpenMPTError.renderFailed
+        }
+        self.handle = handle
+    }
+
+    /// Map an existing overview file without checking what it was built from
+    /// - Throws: OpenMPTError if the file is missing or malformed
+    public init(contentsOf url: URL) throws {
+        guard let handle = openmpt_bridge_waveform_open(url.path) else {
+            throw OpenMPTError.loadFailed("Invalid waveform at \(url.path)")
+        }
+        self.handle = handle
+    }
+
+    deinit {
+        openmpt_bridge_waveform_close(handle)
+    }
+
+    /// Load or build an overview on a background thread
+    public static func load(data: Data, cacheURL: URL,
+                            options: OpenMPTWaveformOptions = OpenMPTWaveformOptions()) async throws -> OpenMPTWaveform {
+        try await Task.detached(priority: .utility) {
+            try OpenMPTWaveform(data: data, cacheURL: cacheURL, options: options)
+        }.value
+    }
+
+    private var header: openmpt_bridge_waveform_header {
+        openmpt_bridge_waveform_get_header(handle)!.pointee
+    }
+
+    /// Rate the overview was rendered at
+    public var sampleRate: Int { Int(header.sample_rate) }
+
+    /// Length of the rendered audio
+    public var duration: TimeInterval {
+        Double(header.total_frames) / Double(header.sample_rate)
+    }
+
+    public var levelCount: Int { Int(header.level_count) }
+
+    /// One zoom level, 0 being the finest
+    public func level(_ index: Int) -> OpenMPTWaveformLevel {
+        precondition(index >= 0 && index < levelCount, "Waveform level out of range")
+        var count: UInt64 = 0
+        let points = openmpt_bridge_waveform_get_level(handle, UInt32(index), &count)
+        let framesPerPoint = withUnsafeBytes(of: header.levels) { levels in
+            levels.bindMemory(to: openmpt_bridge_waveform_level.self)[index].frames_per_point
+        }
+        return OpenMPTWaveformLevel(waveform: self, points: points, count: Int(count),
+                                    framesPerPoint: Int(framesPerPoint))
+    }
+
+    /// The coarsest level that still has at least one point per pixel
+    /// - Parameter width: Width of the view in pixels
+    public func level(forWidth width: Int) -> OpenMPTWaveformLevel {
+        let framesPerPixel = Double(header.total_frames) / Double(Swift.max(width, 1))
+        return level(Int(openmpt_bridge_waveform_find_level(handle, framesPerPixel)))
+    }
+}
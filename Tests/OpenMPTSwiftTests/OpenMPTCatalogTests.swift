@@ -0,0 +1,180 @@
+import XCTest
+import CLibOpenMPT
+@testable import OpenMPTSwift
+
+final class OpenMPTCatalogTests: XCTestCase {
+    
+    private func temporaryURL() -> URL {
+        return FileManager.default.temporaryDirectory.appendingPathComponent("catalog-\(UUID().uuidString).omptcat")
+    }
+    
+    func testMissingCatalogThrows() {
+        XCTAssertThrowsError(try OpenMPTCatalog(contentsOf: temporaryURL())) { error in
+            XCTAssertTrue(error is OpenMPTError)
+        }
+    }
+    
+    func testCatalogRoundTrip() throws {
+        let url = temporaryURL()
+        defer { try? FileManager.default.removeItem(at: url) }
+        
+        let builder = OpenMPTCatalog.Builder()
+        try builder.add(path: "b.it", info: ModuleInfo(title: "beta", artist: "Zed", type: "it", duration: 90,
+                                                        instrumentCount: 4, sampleCount: 6, patternCount: 10, channelCount: 16))
+        try builder.add(path: "a.xm", info: ModuleInfo(title: "Alpha", artist: "amy", type: "xm", duration: 120,
+                                                        instrumentCount: 2, sampleCount: 3, patternCount: 5, channelCount: 8),
+                        tracker: "FastTracker 2")
+        try builder.write(to: url)
+        
+        let catalog = try OpenMPTCatalog(contentsOf: url)
+        XCTAssertEqual(catalog.count, 2)
+        XCTAssertEqual(catalog[0].path, "b.it")
+        XCTAssertEqual(catalog[0].channelCount, 16)
+        XCTAssertEqual(catalog[1].tracker, "FastTracker 2")
+        XCTAssertEqual(catalog[1].moduleInfo.duration, 120)
+        
+        XCTAssertEqual(catalog.sorted(by: .title).map { $0.title }, ["Alpha", "beta"])
+        XCTAssertEqual(catalog.sorted(by: .artist).map { $0.artist }, ["amy", "Zed"])
+        XCTAssertEqual(catalog.entry(forPath: "a.xm")?.index, 1)
+        XCTAssertNil(catalog.entry(forPath: "missing.mod"))
+    }
+    
+    func testCatalogEntryFromLoadedModule() throws {
+        let url = temporaryURL()
+        defer { try? FileManager.default.removeItem(at: url) }
+        let data = TestModule.make(patterns: [[.init(channel: 0, row: 0)], []], title: "loaded")
+        
+        let builder = OpenMPTCatalog.Builder()
+        let module = OpenMPTModule()
+        XCTAssertThrowsError(try builder.add(path: "empty.mod", module: module)) { error in
+            XCTAssertTrue(error is OpenMPTError)
+        }
+        try module.loadModule(from: data)
+        let info = try XCTUnwrap(module.moduleInfo)
+        // Metadata comes from the load-time snapshot, so playback may be running
+        _ = try module.renderAudio(sampleRate: 48000, frameCount: 4800)
+        try builder.add(path: "loaded.mod", module: module, fileSize: UInt64(data.count))
+        try builder.write(to: url)
+        
+        let catalog = try OpenMPTCatalog(contentsOf: url)
+        XCTAssertEqual(catalog.count, 1)
+        let entry = catalog[0]
+        XCTAssertEqual(entry.path, "loaded.mod")
+        XCTAssertEqual(entry.title, "loaded")
+        XCTAssertEqual(entry.type, info.type)
+        XCTAssertEqual(entry.duration, info.duration)
+        XCTAssertEqual(entry.channelCount, 4)
+        XCTAssertEqual(entry.patternCount, 2)
+        XCTAssertEqual(entry.sampleCount, info.sampleCount)
+        XCTAssertEqual(entry.fileSize, UInt64(data.count))
+        XCTAssertNil(entry.loudness)
+    }
+    
+    func testCatalogStoresLoudness() throws {
+        let url = temporaryURL()
+        defer { try? FileManager.default.removeItem(at: url) }
+        
+        let info = ModuleInfo(title: "Quiet", artist: "", type: "mod", duration: 60,
+                              instrumentCount: 0, sampleCount: 4, patternCount: 8, channelCount: 4)
+        let builder = OpenMPTCatalog.Builder()
+        try builder.add(path: "quiet.mod", info: info,
+                        loudness: OpenMPTLoudness(integratedLoudness: -23, truePeak: -4))
+        try builder.add(path: "unmeasured.mod", info: info)
+        try builder.write(to: url)
+        
+        let catalog = try OpenMPTCatalog(contentsOf: url)
+        let loudness = try XCTUnwrap(catalog[0].loudness)
+        XCTAssertEqual(loudness.integratedLoudness, -23)
+        XCTAssertEqual(loudness.replayGain, 5)
+        XCTAssertNil(catalog[1].loudness)
+        
+        // +5 dB would lift the -4 dBTP peak past the -1 dBTP ceiling
+        XCTAssertEqual(loudness.normalizationGain(), 3)
+        XCTAssertEqual(OpenMPTLoudness(integratedLoudness: -10, truePeak: 0).normalizationGain(), -8)
+        XCTAssertEqual(OpenMPTLoudness(integratedLoudness: -.infinity, truePeak: -.infinity).normalizationGain(), 0)
+    }
+    
+    /// Meter interleaved stereo with the same signal on both channels
+    private func meter(sampleRate: Int32, frames: Int, signal: (Int) -> Float) throws -> openmpt_bridge_loudness {
+        let meter = try XCTUnwrap(openmpt_bridge_loudness_meter_create(sampleRate))
+        defer { openmpt_bridge_loudness_meter_destroy(meter) }
+        let samples = (0..<frames).flatMap { frame -> [Float] in
+            let value = signal(frame)
+            return [value, value]
+        }
+        XCTAssertEqual(openmpt_bridge_loudness_meter_add(meter, samples, frames), 1)
+        var loudness = openmpt_bridge_loudness()
+        XCTAssertEqual(openmpt_bridge_loudness_meter_get(meter, &loudness), 1)
+        return loudness
+    }
+    
+    func testLoudnessMeterReadsSineAtItsLevel() throws {
+        // BS.1770 calibration: K-weighting is +0.69 dB at 1 kHz, cancelling
+        // the -0.691 offset, so a -20 dBFS sine on both channels is -20 LUFS
+        let rate = 48000
+        let loudness = try meter(sampleRate: Int32(rate), frames: rate * 10) {
+            Float(0.1 * sin(2 * Double.pi * 1000 * Double($0) / Double(rate)))
+        }
+        XCTAssertEqual(loudness.frames, UInt64(rate * 10))
+        XCTAssertEqual(loudness.integrated_lufs, -20, accuracy: 0.1)
+        XCTAssertEqual(loudness.short_term_lufs, -20, accuracy: 0.1)
+        XCTAssertEqual(loudness.loudness_range_lu, 0, accuracy: 0.1)
+        XCTAssertEqual(loudness.sample_peak_dbfs, -20, accuracy: 0.05)
+        XCTAssertEqual(loudness.replaygain_db, 2, accuracy: 0.1)
+    }
+    
+    func testLoudnessMeterFindsPeaksBetweenSamples() throws {
+        // An fs/4 sine sampled 45 degrees off its crests: every sample is at
+        // 0.707 of the 0.5 amplitude, 3 dB below the peak between them
+        let loudness = try meter(sampleRate: 48000, frames: 48000) {
+            Float(0.5 * sin(Double.pi / 2 * Double($0) + Double.pi / 4))
+        }
+        XCTAssertEqual(loudness.sample_peak_dbfs, 20 * log10(0.5 * 0.5.squareRoot()), accuracy: 0.05)
+        XCTAssertGreaterThan(loudness.true_peak_dbtp, loudness.sample_peak_dbfs + 2.5)
+        XCTAssertEqual(loudness.true_peak_dbtp, 20 * log10(0.5), accuracy: 0.5)
+    }
+    
+    func testIndexerKeepsEarlierAnalyses() throws {
+        let root = FileManager.default.temporaryDirectory.appendingPathComponent("index-\(UUID().uuidString)")
+        try FileManager.default.createDirectory(at: root, withIntermediateDirectories: true)
+        defer { try? FileManager.default.removeItem(at: root) }
+        let database = root.appendingPathComponent("index.db")
+        let songs = root.appendingPathComponent("songs")
+        try FileManager.default.createDirectory(at: songs, withIntermediateDirectories: true)
+        try TestModule.make(patterns: [[.init(channel: 0, row: 0)], [.init(channel: 1, row: 8, volume: 32)]])
+            .write(to: songs.appendingPathComponent("a.mod"))
+        try TestModule.make(patterns: [[.init(channel: 2, row: 0), .init(channel: 3, row: 32)]])
+            .write(to: songs.appendingPathComponent("b.mod"))
+        
+        func build(loudness: Bool, fingerprint: Bool) -> openmpt_bridge_index_summary {
+            var options = openmpt_bridge_index_options()
+            options.thread_count = 1
+            options.measure_loudness = loudness ? 1 : 0
+            options.fingerprint = fingerprint ? 1 : 0
+            var summary = openmpt_bridge_index_summary()
+            XCTAssertEqual(openmpt_bridge_index_build(songs.path, database.path, &options, &summary), 1)
+            return summary
+        }
+        func column(_ column: openmpt_bridge_index_column) -> Int32 {
+            Int32(column.rawValue)
+        }
+        
+        // Each pass loads the modules again for its own analysis only
+        XCTAssertEqual(build(loudness: true, fingerprint: false).files_indexed, 2)
+        XCTAssertEqual(build(loudness: false, fingerprint: true).files_indexed, 2)
+        let summary = build(loudness: true, fingerprint: true)
+        XCTAssertEqual(summary.files_reused, 2)
+        
+        let index = try XCTUnwrap(openmpt_bridge_index_open(database.path))
+        defer { openmpt_bridge_index_close(index) }
+        XCTAssertEqual(openmpt_bridge_index_get_row_count(index), 2)
+        for row in 0..<UInt64(2) {
+            XCTAssertEqual(openmpt_bridge_index_get_uint(index, column(OPENMPT_BRIDGE_INDEX_COLUMN_LOUDNESS_MEASURED), row), 1)
+            XCTAssertLessThan(openmpt_bridge_index_get_double(index, column(OPENMPT_BRIDGE_INDEX_COLUMN_LOUDNESS), row), 0)
+            var size = 0
+            XCTAssertNotNil(openmpt_bridge_index_get_blob(index, column(OPENMPT_BRIDGE_INDEX_COLUMN_FINGERPRINT), row, &size))
+            XCTAssertGreaterThan(size, 0)
+            XCTAssertEqual(openmpt_bridge_index_get_uint(index, column(OPENMPT_BRIDGE_INDEX_COLUMN_ANALYSIS_FAILED), row), 0)
+        }
+    }
+}
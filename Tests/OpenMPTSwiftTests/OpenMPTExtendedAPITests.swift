@@ -1,8 +1,19 @@
 import XCTest
+import CLibOpenMPT
 @testable import OpenMPTSwift
 
 final class OpenMPTExtendedAPITests: XCTestCase {
     
+    private func temporaryURL(_ name: String, _ pathExtension: String) -> URL {
+        return FileManager.default.temporaryDirectory.appendingPathComponent("\(name)-\(UUID().uuidString).\(pathExtension)")
+    }
+    
+    /// Interleaved samples of a raw 32-bit float export
+    private func readFloats(_ url: URL) throws -> [Float] {
+        let data = try Data(contentsOf: url)
+        return data.withUnsafeBytes { Array($0.bindMemory(to: Float.self)) }
+    }
+    
     func testRenderParameterConstants() {
         // Test that render parameter constants have expected values
         XCTAssertEqual(OpenMPTRenderParam.masterGain.rawValue, 0)
@@ -128,4 +139,349 @@ final class OpenMPTExtendedAPITests: XCTestCase {
         let success = module.setRenderParam(Int(OpenMPTRenderParam.stereoSeparation.rawValue), value: 2)
         XCTAssertFalse(success)
     }
-}
\ No newline at end of file
+    
+    func testParameterSmoothing() {
+        let module = OpenMPTModule()
+        XCTAssertEqual(module.parameterSmoothing, 0)
+        
+        module.parameterSmoothing = 0.02
+        XCTAssertEqual(module.parameterSmoothing, 0.02, accuracy: 1e-6)
+        
+        module.parameterSmoothing = -1
+        XCTAssertEqual(module.parameterSmoothing, 0)
+    }
+    
+    func testAudioTapAttachment() {
+        let module = OpenMPTModule()
+        
+        var invalid = OpenMPTAudioTapOptions()
+        invalid.channels = 3
+        XCTAssertNil(module.addTap(invalid))
+        
+        var mono = OpenMPTAudioTapOptions()
+        mono.sampleRate = 44100
+        mono.channels = 1
+        mono.format = .int16
+        let tap = module.addTap(mono)
+        XCTAssertNotNil(tap)
+        XCTAssertEqual(tap?.frameBytes, 2)
+        XCTAssertEqual(tap?.availableFrames, 0)
+        XCTAssertEqual(tap?.stats.framesWritten, 0)
+        XCTAssertTrue(tap?.readSamples().isEmpty ?? false)
+        
+        var taps = (1..<Int(OPENMPT_BRIDGE_MAX_TAPS)).compactMap { _ in module.addTap() }
+        XCTAssertEqual(taps.count, Int(OPENMPT_BRIDGE_MAX_TAPS) - 1)
+        XCTAssertNil(module.addTap())
+        
+        // Releasing a tap detaches it and frees its slot
+        taps.removeLast()
+        XCTAssertNotNil(module.addTap())
+    }
+    
+    func testSpectrumAnalyzerAttachment() {
+        let module = OpenMPTModule()
+        
+        var invalid = OpenMPTSpectrumAnalyzerOptions()
+        invalid.fftSize = 1000
+        XCTAssertNil(module.addSpectrumAnalyzer(invalid))
+        
+        var options = OpenMPTSpectrumAnalyzerOptions()
+        options.fftSize = 1024
+        let analyzer = module.addSpectrumAnalyzer(options)
+        XCTAssertNotNil(analyzer)
+        XCTAssertEqual(analyzer?.binCount, 513)
+        // Nothing has been rendered yet
+        XCTAssertNil(analyzer?.latestSpectrum())
+        
+        // The analyzer holds one of the module's taps
+        let taps = (1..<Int(OPENMPT_BRIDGE_MAX_TAPS)).compactMap { _ in module.addTap() }
+        XCTAssertEqual(taps.count, Int(OPENMPT_BRIDGE_MAX_TAPS) - 1)
+        XCTAssertNil(module.addSpectrumAnalyzer())
+    }
+    
+    func testSpectrumPeaksAtSquareWaveFundamental() throws {
+        let module = OpenMPTModule()
+        try module.loadModule(from: TestModule.make(patterns: [[.init(channel: 0, row: 0), .init(channel: 1, row: 0)]]))
+        var options = OpenMPTSpectrumAnalyzerOptions()
+        options.fftSize = 8192
+        options.smoothing = 0
+        let analyzer = try XCTUnwrap(module.addSpectrumAnalyzer(options))
+        
+        // Period 428 plays the sample at about 8363 Hz, one cycle per 64 bytes
+        let fundamental = 8363.0 / 64
+        var spectrum: OpenMPTSpectrum?
+        let deadline = Date().addingTimeInterval(5)
+        while Date() < deadline {
+            _ = try module.renderAudio(sampleRate: Int32(options.sampleRate), frameCount: 1024)
+            // Give the worker time to drain the tap; wait for a window well into the note
+            Thread.sleep(forTimeInterval: 0.002)
+            if let latest = analyzer.latestSpectrum(), latest.frame >= UInt64(2 * options.fftSize) {
+                spectrum = latest
+                break
+            }
+        }
+        let result = try XCTUnwrap(spectrum)
+        XCTAssertEqual(result.magnitudes.count, analyzer.binCount)
+        
+        let magnitudes = result.magnitudes
+        let peak = try XCTUnwrap(magnitudes.indices.max { magnitudes[$0] < magnitudes[$1] })
+        XCTAssertEqual(result.frequency(ofBin: peak), fundamental, accuracy: 1.5 * result.binWidth)
+        XCTAssertGreaterThan(magnitudes[peak], -40)
+        
+        // A square wave has only odd harmonics
+        func bin(_ frequency: Double) -> Int { Int((frequency / result.binWidth).rounded()) }
+        XCTAssertGreaterThan(magnitudes[bin(3 * fundamental)], magnitudes[bin(2 * fundamental)] + 10)
+    }
+    
+    func testWaveformRejectsInvalidData() {
+        let cacheURL = FileManager.default.temporaryDirectory.appendingPathComponent("waveform-\(UUID().uuidString).bin")
+        
+        XCTAssertThrowsError(try OpenMPTWaveform(data: Data([0x00, 0x01, 0x02, 0x03]), cacheURL: cacheURL))
+        XCTAssertFalse(FileManager.default.fileExists(atPath: cacheURL.path))
+        XCTAssertThrowsError(try OpenMPTWaveform(contentsOf: cacheURL))
+    }
+    
+    func testWaveformLevelsSummarizeRender() throws {
+        let data = TestModule.make(patterns: [[.init(channel: 0, row: 0), .init(channel: 1, row: 0, volume: 32),
+                                               .init(channel: 0, row: 32, volume: 0, trigger: false)]])
+        let cacheURL = temporaryURL("waveform", "bin")
+        defer { try? FileManager.default.removeItem(at: cacheURL) }
+        var options = OpenMPTWaveformOptions()
+        options.framesPerPoint = 128
+        let waveform = try OpenMPTWaveform(data: data, cacheURL: cacheURL, options: options)
+        
+        XCTAssertEqual(waveform.sampleRate, options.sampleRate)
+        XCTAssertEqual(waveform.duration, TestModule.secondsPerPattern, accuracy: 0.05)
+        let totalFrames = Int((waveform.duration * Double(waveform.sampleRate)).rounded())
+        var expectedCounts = [(totalFrames + options.framesPerPoint - 1) / options.framesPerPoint]
+        while expectedCounts.count < Int(OPENMPT_BRIDGE_WAVEFORM_MAX_LEVELS) && expectedCounts.last! > 1 {
+            expectedCounts.append((expectedCounts.last! + 1) / 2)
+        }
+        XCTAssertEqual(waveform.levelCount, expectedCounts.count)
+        XCTAssertEqual(waveform.level(waveform.levelCount - 1).count, 1)
+        
+        let step: Float = 1 / 32767
+        for index in 0..<waveform.levelCount {
+            let level = waveform.level(index)
+            XCTAssertEqual(level.count, expectedCounts[index])
+            XCTAssertEqual(level.framesPerPoint, options.framesPerPoint << index)
+            for point in level {
+                // RMS never exceeds the peak magnitude of its span
+                XCTAssertLessThanOrEqual(point.min, point.rms)
+                XCTAssertLessThanOrEqual(point.rms, max(point.max, -point.min) + step)
+                XCTAssertLessThanOrEqual(point.min, point.max)
+            }
+            guard index > 0 else { continue }
+            
+            // Each point merges the two below it
+            let below = waveform.level(index - 1)
+            for (offset, point) in level.enumerated() {
+                let pair = Array(below[(offset * 2)..<min(offset * 2 + 2, below.count)])
+                XCTAssertEqual(point.min, pair.map(\.min).min()!)
+                XCTAssertEqual(point.max, pair.map(\.max).max()!)
+                XCTAssertGreaterThanOrEqual(point.rms, pair.map(\.rms).min()! - step)
+                XCTAssertLessThanOrEqual(point.rms, pair.map(\.rms).max()! + step)
+            }
+        }
+        // The quiet half of the pattern shows in the coarse levels
+        let halves = waveform.level(waveform.levelCount - 2)
+        XCTAssertEqual(halves.count, 2)
+        XCTAssertGreaterThan(halves[0].rms, halves[1].rms)
+        
+        // Loading again maps the cached file; other options replace it
+        func fileNumber() throws -> Int {
+            try XCTUnwrap((FileManager.default.attributesOfItem(atPath: cacheURL.path)[.systemFileNumber] as? NSNumber)?.intValue)
+        }
+        let built = try fileNumber()
+        let cached = try OpenMPTWaveform(data: data, cacheURL: cacheURL, options: options)
+        XCTAssertEqual(try fileNumber(), built)
+        XCTAssertEqual(cached.levelCount, waveform.levelCount)
+        
+        options.framesPerPoint = 256
+        let rebuilt = try OpenMPTWaveform(data: data, cacheURL: cacheURL, options: options)
+        XCTAssertNotEqual(try fileNumber(), built)
+        XCTAssertEqual(rebuilt.level(0).framesPerPoint, 256)
+        XCTAssertEqual(rebuilt.levelCount, waveform.levelCount - 1)
+    }
+    
+    func testExportRequiresLoadedModule() {
+        let module = OpenMPTModule()
+        let url = FileManager.default.temporaryDirectory.appendingPathComponent("export-\(UUID().uuidString).wav")
+        
+        XCTAssertThrowsError(try module.export(to: url)) { error in
+            guard case OpenMPTError.notLoaded = error else {
+                return XCTFail("Unexpected error: \(error)")
+            }
+        }
+        XCTAssertFalse(FileManager.default.fileExists(atPath: url.path))
+    }
+    
+    func testExportFormatsMatchFloatRender() throws {
+        let module = OpenMPTModule()
+        try module.loadModule(from: TestModule.make(patterns: [(0..<4).map { TestModule.Event(channel: $0, row: 0) } +
+                                                               [.init(channel: 1, row: 32, volume: 16)]]))
+        func export(_ format: OpenMPTExportFormat, _ container: OpenMPTExportContainer) throws -> (OpenMPTExportResult, Data) {
+            let url = temporaryURL("export", container == .wav ? "wav" : "raw")
+            defer { try? FileManager.default.removeItem(at: url) }
+            let result = try module.export(to: url, options: OpenMPTExportOptions(format: format, container: container))
+            return (result, try Data(contentsOf: url))
+        }
+        func uint32(_ data: Data, _ offset: Int) -> Int {
+            (0..<4).reduce(0) { $0 | Int(data[data.startIndex + offset + $1]) << (8 * $1) }
+        }
+        func uint16(_ data: Data, _ offset: Int) -> Int {
+            Int(data[data.startIndex + offset]) | Int(data[data.startIndex + offset + 1]) << 8
+        }
+        
+        // The raw float export is the render every other format converts
+        let (raw, rawData) = try export(.float32, .raw)
+        let frames = raw.frameCount
+        XCTAssertGreaterThan(frames, 32768)   // several writer blocks
+        XCTAssertEqual(rawData.count, frames * 8)
+        let render = rawData.withUnsafeBytes { Array($0.bindMemory(to: Float.self)) }
+        
+        // (format, bytes per sample, header size, format tag)
+        let layouts: [(OpenMPTExportFormat, Int, Int, Int)] = [(.int16, 2, 44, 1), (.int24, 3, 44, 1), (.float32, 4, 58, 3)]
+        for (format, sampleBytes, header, tag) in layouts {
+            let (result, file) = try export(format, .wav)
+            XCTAssertEqual(result.frameCount, frames)
+            XCTAssertEqual(file.count, header + frames * 2 * sampleBytes)
+            XCTAssertEqual(String(decoding: file.prefix(4), as: UTF8.self), "RIFF")
+            XCTAssertEqual(uint32(file, 4), file.count - 8)
+            XCTAssertEqual(uint32(file, 16), header == 58 ? 18 : 16)
+            XCTAssertEqual(uint16(file, 20), tag)
+            XCTAssertEqual(uint16(file, 32), 2 * sampleBytes)
+            XCTAssertEqual(String(decoding: file[(header - 8)..<(header - 4)], as: UTF8.self), "data")
+            XCTAssertEqual(uint32(file, header - 4), frames * 2 * sampleBytes)
+            if header == 58 {
+                XCTAssertEqual(String(decoding: file[38..<42], as: UTF8.self), "fact")
+                XCTAssertEqual(uint32(file, 46), frames)
+            }
+            
+            // Every sample must equal a scalar round-to-nearest conversion of the render
+            let samples = file.dropFirst(header)
+            for (index, value) in render.enumerated() {
+                let offset = samples.startIndex + index * sampleBytes
+                switch format {
+                case .int16:
+                    let expected = Int16(max(-32768, min(32767, (value * 32768).rounded(.toNearestOrEven))))
+                    let actual = Int16(bitPattern: UInt16(samples[offset]) | UInt16(samples[offset + 1]) << 8)
+                    if actual != expected { return XCTFail("s16 sample \(index): \(actual) != \(expected)") }
+                case .int24:
+                    let expected = Int32(max(-8388608, min(8388607, (value * 8388608).rounded(.toNearestOrEven))))
+                    let word = UInt32(samples[offset]) | UInt32(samples[offset + 1]) << 8 | UInt32(samples[offset + 2]) << 16
+                    let actual = Int32(bitPattern: word << 8) >> 8
+                    if actual != expected { return XCTFail("s24 sample \(index): \(actual) != \(expected)") }
+                case .float32:
+                    let word = (0..<4).reduce(UInt32(0)) { $0 | UInt32(samples[offset + $1]) << (8 * UInt32($1)) }
+                    if Float(bitPattern: word) != value { return XCTFail("f32 sample \(index) differs") }
+                }
+            }
+        }
+    }
+    
+    func testParallelExportRejectsInvalidData() {
+        let url = FileManager.default.temporaryDirectory.appendingPathComponent("export-\(UUID().uuidString).wav")
+        
+        XCTAssertThrowsError(try OpenMPTModule.exportParallel(data: Data([0x00, 0x01, 0x02, 0x03]), to: url))
+        XCTAssertFalse(FileManager.default.fileExists(atPath: url.path))
+    }
+    
+    func testParallelExportMatchesSerialExport() throws {
+        // Every order retriggers its notes, so each boundary is a clean split point
+        let patterns = (0..<6).map { index in
+            (0..<4).map { TestModule.Event(channel: $0, row: 0, volume: 16 + 8 * ((index + $0) % 6)) }
+        }
+        let data = TestModule.make(patterns: patterns)
+        let serialURL = temporaryURL("serial", "raw")
+        let parallelURL = temporaryURL("parallel", "raw")
+        defer {
+            try? FileManager.default.removeItem(at: serialURL)
+            try? FileManager.default.removeItem(at: parallelURL)
+        }
+        
+        var settings = openmpt_bridge_export_options()
+        openmpt_bridge_export_options_init(&settings)
+        settings.format = OpenMPTExportFormat.float32.rawValue
+        settings.container = OpenMPTExportContainer.raw.rawValue
+        
+        let module = OpenMPTModule()
+        try module.loadModule(from: data)
+        var serial = openmpt_bridge_export_result()
+        XCTAssertEqual(openmpt_bridge_export_module(try XCTUnwrap(module.module), serialURL.path, &settings, &serial), 1)
+        
+        // Three segments start at orders 2 and 4 and pre-roll from the order before
+        var split = openmpt_bridge_parallel_export_options()
+        openmpt_bridge_parallel_export_options_init(&split)
+        split.thread_count = 2
+        split.segment_count = 3
+        split.min_segment_seconds = 5
+        split.preroll_seconds = 1
+        var parallel = openmpt_bridge_parallel_export_result()
+        let exported = data.withUnsafeBytes {
+            openmpt_bridge_export_parallel($0.baseAddress, $0.count, parallelURL.path, &settings, &split, &parallel)
+        }
+        XCTAssertEqual(exported, 1)
+        
+        XCTAssertEqual(parallel.segments, 3)
+        XCTAssertEqual(parallel.exact_seams + parallel.crossfaded_seams, parallel.segments - 1)
+        XCTAssertEqual(parallel.crossfaded_seams == 0, parallel.max_seam_error == 0)
+        XCTAssertEqual(parallel.totals.frames, serial.frames)
+        
+        let expected = try readFloats(serialURL)
+        let actual = try readFloats(parallelURL)
+        XCTAssertEqual(expected.count, Int(serial.frames) * 2)
+        XCTAssertEqual(actual.count, expected.count)
+        // Pre-rolled segments match the serial render; only a crossfaded
+        // seam may move a sample, and by no more than the seam differed
+        let error = zip(expected, actual).map { abs($0 - $1) }.max() ?? 0
+        XCTAssertLessThanOrEqual(error, parallel.max_seam_error + 1e-6)
+    }
+    
+    func testStemsAddUpToFullMix() throws {
+        // Notes on channels 0 and 2 only; 1 and 3 never play
+        let data = TestModule.make(patterns: [
+            [.init(channel: 0, row: 0), .init(channel: 2, row: 16, volume: 40)],
+            [.init(channel: 0, row: 8, volume: 20), .init(channel: 2, row: 0)],
+        ])
+        let prefix = FileManager.default.temporaryDirectory.appendingPathComponent("stems-\(UUID().uuidString)")
+        let mixURL = temporaryURL("mix", "raw")
+        let options = OpenMPTExportOptions(format: .float32, container: .raw)
+        
+        let module = OpenMPTModule()
+        try module.loadModule(from: data)
+        let mix = try module.export(to: mixURL, options: options)
+        let result = try OpenMPTModule.exportStems(data: data, prefix: prefix, options: options,
+                                                   stems: OpenMPTStemExportOptions(threadCount: 2))
+        defer {
+            try? FileManager.default.removeItem(at: mixURL)
+            result.stems.forEach { try? FileManager.default.removeItem(at: $0) }
+        }
+        
+        XCTAssertEqual(result.channelCount, 4)
+        XCTAssertEqual(result.emptyChannelCount, 2)
+        XCTAssertEqual(result.stems.map { $0.lastPathComponent }, [prefix.lastPathComponent + "_ch01.raw",
+                                                                   prefix.lastPathComponent + "_ch03.raw"])
+        XCTAssertEqual(result.totals.frameCount, mix.frameCount)
+        
+        // Each stem is its channel alone, so together they are the mix
+        let expected = try readFloats(mixURL)
+        let stems = try result.stems.map(readFloats)
+        guard stems.count == 2 else { return XCTFail("expected two stems, got \(stems.count)") }
+        XCTAssertEqual(expected.count, mix.frameCount * 2)
+        for stem in stems {
+            XCTAssertEqual(stem.count, expected.count)
+            XCTAssertGreaterThan(stem.map { abs($0) }.max() ?? 0, 0.01)
+        }
+        let error = expected.indices.map { abs(stems[0][$0] + stems[1][$0] - expected[$0]) }.max() ?? 0
+        XCTAssertLessThan(error, 1e-4)
+    }
+    
+    func testStemExportRejectsInvalidData() {
+        let prefix = FileManager.default.temporaryDirectory.appendingPathComponent("stems-\(UUID().uuidString)")
+        let firstStem = URL(fileURLWithPath: prefix.path + "_ch01.wav")
+        
+        XCTAssertThrowsError(try OpenMPTModule.exportStems(data: Data([0x00, 0x01, 0x02, 0x03]), prefix: prefix))
+        XCTAssertFalse(FileManager.default.fileExists(atPath: firstStem.path))
+    }
+}
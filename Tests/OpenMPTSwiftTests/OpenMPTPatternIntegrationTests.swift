@@ -1,4 +1,5 @@
 import XCTest
+import CLibOpenMPT
 @testable import OpenMPTSwift
 
 final class OpenMPTPatternIntegrationTests: XCTestCase {
@@ -63,4 +64,105 @@ final class OpenMPTPatternIntegrationTests: XCTestCase {
         XCTAssertNotNil(module.setPatternNote)
         XCTAssertNotNil(module.clearPatternCell)
     }
+    
+    func testPatternPagesStoreOnlyUsedCells() throws {
+        let full = (0..<TestModule.rowsPerPattern).flatMap { row in
+            (0..<4).map { TestModule.Event(channel: $0, row: row) }
+        }
+        let module = OpenMPTModule()
+        try module.loadModule(from: TestModule.make(patterns: [[], full]))
+        
+        XCTAssertTrue(try XCTUnwrap(module.getPatternCell(pattern: 0, channel: 0, row: 0)).isEmpty)
+        let emptyPage = try XCTUnwrap(module.patternCacheStats).bytes
+        XCTAssertFalse(try XCTUnwrap(module.getPatternCell(pattern: 1, channel: 0, row: 0)).isEmpty)
+        let bothPages = try XCTUnwrap(module.patternCacheStats).bytes
+        
+        // The pages share their layout; only the 16 rows of 4 filled cells differ
+        XCTAssertEqual(bothPages - 2 * emptyPage, 16 * 4 * MemoryLayout<openmpt_pattern_cell>.size)
+    }
+    
+    func testPatternRowsMatchCells() throws {
+        let events: [TestModule.Event] = [
+            .init(channel: 0, row: 0),
+            .init(channel: 3, row: 0, volume: 20),
+            .init(channel: 1, row: 17),
+            .init(channel: 2, row: 40, volume: 48, trigger: false),
+            .init(channel: 0, row: 63),
+        ]
+        let module = OpenMPTModule()
+        try module.loadModule(from: TestModule.make(patterns: [events]))
+        
+        for row in 0..<TestModule.rowsPerPattern {
+            let cells = try XCTUnwrap(module.getPatternRow(pattern: 0, row: row))
+            XCTAssertEqual(cells.count, 4)
+            for channel in 0..<4 {
+                let cell = try XCTUnwrap(module.getPatternCell(pattern: 0, channel: channel, row: row))
+                XCTAssertEqual(cells[channel].note, cell.note)
+                XCTAssertEqual(cells[channel].instrument, cell.instrument)
+                XCTAssertEqual(cells[channel].volume, cell.volume)
+                XCTAssertEqual(cells[channel].effect, cell.effect)
+                XCTAssertEqual(cells[channel].effectParam, cell.effectParam)
+                let used = events.contains { $0.channel == channel && $0.row == row }
+                XCTAssertEqual(cell.isEmpty, !used, "row \(row) channel \(channel)")
+            }
+        }
+        XCTAssertEqual(module.getPatternRow(pattern: 0, row: 17)?[1].instrument, 1)
+        XCTAssertEqual(module.getPatternRow(pattern: 0, row: 40)?[2].instrument, 0)
+        XCTAssertNil(module.getPatternRow(pattern: 0, row: TestModule.rowsPerPattern))
+        XCTAssertNil(module.getPatternRow(pattern: 1, row: 0))
+    }
+    
+    func testPatternCacheEvictsUnderSmallBudget() throws {
+        let patterns = (0..<8).map { [TestModule.Event(channel: $0 % 4, row: 0)] }
+        let module = OpenMPTModule()
+        try module.loadModule(from: TestModule.make(patterns: patterns))
+        
+        XCTAssertNotNil(module.getPatternCell(pattern: 0, channel: 0, row: 0))
+        let page = try XCTUnwrap(module.patternCacheStats).bytes
+        XCTAssertTrue(module.setPatternCacheBudget(page))
+        for pattern in 1..<8 {
+            XCTAssertNotNil(module.getPatternCell(pattern: pattern, channel: 0, row: 0))
+        }
+        var stats = try XCTUnwrap(module.patternCacheStats)
+        XCTAssertEqual(stats.budget, page)
+        XCTAssertEqual(stats.pages, 1)
+        XCTAssertEqual(stats.bytes, page)
+        XCTAssertEqual(stats.evictions, 7)
+        XCTAssertEqual(stats.misses, 8)
+        
+        // An evicted page is decoded again, pushing out the newest
+        XCTAssertNotNil(module.getPatternCell(pattern: 0, channel: 0, row: 0))
+        stats = try XCTUnwrap(module.patternCacheStats)
+        XCTAssertEqual(stats.misses, 9)
+        XCTAssertEqual(stats.evictions, 8)
+        XCTAssertEqual(stats.hits, 0)
+    }
+    
+    func testPatternCacheCountsHitsMissesAndPrefetches() throws {
+        let module = OpenMPTModule()
+        try module.loadModule(from: TestModule.make(patterns: [[.init(channel: 0, row: 0)], [.init(channel: 1, row: 63)]]))
+        XCTAssertEqual(module.patternCacheStats?.pages, 0)
+        
+        _ = module.getPatternCell(pattern: 0, channel: 0, row: 0)    // miss
+        _ = module.getPatternCell(pattern: 0, channel: 2, row: 5)    // same page
+        _ = module.getPatternRow(pattern: 0, row: 15)                // same page
+        _ = module.getPatternRow(pattern: 0, row: 16)                // next page
+        var stats = try XCTUnwrap(module.patternCacheStats)
+        XCTAssertEqual(stats.misses, 2)
+        XCTAssertEqual(stats.hits, 2)
+        XCTAssertEqual(stats.prefetched, 0)
+        
+        // Order 1 plays pattern 1: its four pages are decoded once
+        module.prefetchPatterns(orders: 0, from: 1)
+        module.prefetchPatterns(orders: 0, from: 1)
+        stats = try XCTUnwrap(module.patternCacheStats)
+        XCTAssertEqual(stats.prefetched, 4)
+        XCTAssertEqual(stats.pages, 6)
+        
+        XCTAssertEqual(module.getPatternCell(pattern: 1, channel: 1, row: 63)?.instrument, 1)
+        stats = try XCTUnwrap(module.patternCacheStats)
+        XCTAssertEqual(stats.hits, 3)
+        XCTAssertEqual(stats.misses, 2)
+        XCTAssertEqual(stats.evictions, 0)
+    }
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 //
 
 import XCTest
+import CLibOpenMPT
 @testable import OpenMPTSwift
 
 final class OpenMPTSwiftTests: XCTestCase {
@@ -14,6 +15,7 @@ final class OpenMPTSwiftTests: XCTestCase {
         let module = OpenMPTModule()
         XCTAssertFalse(module.isLoaded)
         XCTAssertNil(module.moduleInfo)
+        XCTAssertTrue(module.subsongs.isEmpty)
     }
     
     @MainActor
@@ -41,6 +43,331 @@ final class OpenMPTSwiftTests: XCTestCase {
         }
     }
     
+    func testStatsWithoutModule() {
+        let module = OpenMPTModule()
+        XCTAssertThrowsError(try module.loadModule(from: Data([0x00, 0x01, 0x02, 0x03])))
+        XCTAssertThrowsError(try module.renderAudio(sampleRate: 48000, frameCount: 512))
+        _ = module.setPosition(seconds: 1.0)
+        
+        let stats = module.stats
+        XCTAssertEqual(stats.loads, 0)
+        XCTAssertEqual(stats.renderCalls, 0)
+        XCTAssertEqual(stats.framesRendered, 0)
+        XCTAssertEqual(stats.seeks, 0)
+        XCTAssertEqual(stats.renderTime, 0)
+    }
+    
+    func testDeadlineMonitorDefaults() {
+        let module = OpenMPTModule()
+        XCTAssertEqual(module.renderBudget, 0.75, accuracy: 1e-6)
+        
+        module.renderBudget = 0.5
+        XCTAssertEqual(module.renderBudget, 0.5, accuracy: 1e-6)
+        module.renderBudget = 0
+        XCTAssertEqual(module.renderBudget, 0.75, accuracy: 1e-6)
+        
+        let report = module.deadlineReport
+        XCTAssertEqual(report.blocks, 0)
+        XCTAssertEqual(report.overruns, 0)
+        XCTAssertEqual(report.utilization(atQuantile: 0.99), 0)
+        XCTAssertTrue(module.drainOverrunEvents().isEmpty)
+    }
+    
+    func testUnloadedModuleHasNoSnapshotOrPosition() {
+        let module = OpenMPTModule()
+        XCTAssertNil(module.getCurrentPosition())
+        XCTAssertTrue(module.getInstrumentNames().isEmpty)
+        XCTAssertTrue(module.getSampleNames().isEmpty)
+        XCTAssertTrue(module.subsongs.isEmpty)
+        XCTAssertNil(module.getPatternCell(pattern: 0, channel: 0, row: 0))
+        XCTAssertNil(module.getPatternRow(pattern: 0, row: 0))
+        XCTAssertNil(module.patternCacheStats)
+        module.prefetchPatterns(orders: 2)
+    }
+    
+    func testSubsongsDescribeLoadedModule() throws {
+        let module = OpenMPTModule()
+        try module.loadModule(from: TestModule.make(patterns: [[.init(channel: 0, row: 0)], []]))
+        _ = try module.renderAudio(sampleRate: 8000, frameCount: 8000)
+        let before = try XCTUnwrap(module.getCurrentPosition()).seconds
+        
+        let subsongs = module.subsongs
+        XCTAssertEqual(subsongs.count, 1)
+        let song = try XCTUnwrap(subsongs.first)
+        XCTAssertEqual(song.index, 0)
+        XCTAssertEqual(song.name, "")
+        XCTAssertEqual(song.duration, 2 * TestModule.secondsPerPattern, accuracy: 0.01)
+        XCTAssertEqual(song.restartOrder, 0)
+        XCTAssertEqual(song.restartRow, 0)
+        // Walking the subsongs leaves playback where it was
+        XCTAssertEqual(try XCTUnwrap(module.getCurrentPosition()).seconds, before, accuracy: 0.01)
+        
+        // The cache belongs to the module that was loaded
+        try module.loadModule(from: TestModule.make(patterns: [[], [], []]))
+        XCTAssertEqual(module.subsongs.first?.duration ?? 0, 3 * TestModule.secondsPerPattern, accuracy: 0.01)
+    }
+    
+    func testSongEndsOnceWhenNotLooping() throws {
+        let module = OpenMPTModule()
+        XCTAssertFalse(module.setRepeatCount(0))
+        try module.loadModule(from: TestModule.make(patterns: [[.init(channel: 0, row: 0)]]))
+        
+        // Loaded modules loop until told otherwise
+        _ = try module.renderAudio(sampleRate: 8000, frameCount: Int(TestModule.secondsPerPattern * 8000) + 8000)
+        XCTAssertFalse(module.hasReachedEnd)
+        
+        XCTAssertTrue(module.setRepeatCount(0))
+        _ = module.setPosition(seconds: 0)
+        let song = try module.renderAudio(sampleRate: 8000, frameCount: Int(TestModule.secondsPerPattern * 8000) + 8000)
+        XCTAssertTrue(module.hasReachedEnd)
+        XCTAssertLessThan(song.count / 2, Int(TestModule.secondsPerPattern * 8000) + 8000)
+        XCTAssertTrue(try module.renderAudio(sampleRate: 8000, frameCount: 800).isEmpty)
+        
+        _ = module.setPosition(seconds: 0)
+        XCTAssertFalse(module.hasReachedEnd)
+    }
+    
+    func testTrimSilenceCutsSilentTail() throws {
+        // One audible pattern, then one where the note is turned down to nothing
+        let module = OpenMPTModule()
+        try module.loadModule(from: TestModule.make(patterns: [[.init(channel: 0, row: 0)],
+                                                               [.init(channel: 0, row: 0, volume: 0, trigger: false)]]))
+        let directory = FileManager.default.temporaryDirectory
+        let fullURL = directory.appendingPathComponent("full-\(UUID().uuidString).wav")
+        let trimmedURL = directory.appendingPathComponent("trimmed-\(UUID().uuidString).wav")
+        defer {
+            try? FileManager.default.removeItem(at: fullURL)
+            try? FileManager.default.removeItem(at: trimmedURL)
+        }
+        
+        let full = try module.export(to: fullURL)
+        var options = OpenMPTExportOptions()
+        options.trimSilence = true
+        let trimmed = try module.export(to: trimmedURL, options: options)
+        
+        XCTAssertEqual(full.trimmedFrameCount, 0)
+        XCTAssertGreaterThanOrEqual(full.audioDuration, 2 * TestModule.secondsPerPattern - 0.1)
+        XCTAssertEqual(trimmed.audioDuration, TestModule.secondsPerPattern, accuracy: 0.1)
+        XCTAssertGreaterThan(trimmed.trimmedFrameCount, 0)
+        
+        // 16-bit stereo: the files differ by exactly the frames cut
+        func size(_ url: URL) throws -> Int {
+            try XCTUnwrap(FileManager.default.attributesOfItem(atPath: url.path)[.size] as? Int)
+        }
+        XCTAssertEqual(try size(fullURL) - size(trimmedURL), (full.frameCount - trimmed.frameCount) * 4)
+    }
+    
+    func testAdaptiveQualityToggle() {
+        let module = OpenMPTModule()
+        XCTAssertFalse(module.qualityState.isEnabled)
+        XCTAssertEqual(module.qualityState.level, 0)
+        
+        var options = OpenMPTAdaptiveQualityOptions()
+        options.maxLevel = 2
+        module.enableAdaptiveQuality(options)
+        XCTAssertTrue(module.qualityState.isEnabled)
+        XCTAssertEqual(module.qualityState.level, 0)
+        
+        module.disableAdaptiveQuality()
+        XCTAssertFalse(module.qualityState.isEnabled)
+        XCTAssertEqual(module.qualityState.degrades, 0)
+    }
+    
+    func testResamplerPreservesDurationAndTone() throws {
+        XCTAssertNil(OpenMPTResampler(inputRate: 0, outputRate: 44100))
+        XCTAssertNil(OpenMPTResampler(inputRate: 48000, outputRate: 1000))
+        
+        let resampler = try XCTUnwrap(OpenMPTResampler(inputRate: 48000, outputRate: 44100, channels: 1, quality: .best))
+        let input = (0..<48000).map { Float(sin(2 * Double.pi * 1000 * Double($0) / 48000)) }
+        let output = resampler.process(input) + resampler.flush()
+        XCTAssertEqual(output.count, 44100)
+        
+        // Away from the filter's start-up, the tone matches an ideal 44.1 kHz sine
+        let margin = resampler.taps
+        for i in stride(from: margin, to: output.count - margin, by: 97) {
+            XCTAssertEqual(Double(output[i]), sin(2 * Double.pi * 1000 * Double(i) / 44100), accuracy: 1e-3)
+        }
+    }
+    
+    func testPreviewStartsAtLoudestOrder() throws {
+        // One channel quietly throughout; all four at full volume in order 2 only
+        let quiet = [TestModule.Event(channel: 0, row: 0, volume: 8)]
+        let loud = (0..<4).map { TestModule.Event(channel: $0, row: 0) }
+        let calm = [TestModule.Event(channel: 0, row: 0, volume: 8, trigger: false)] +
+            (1..<4).map { TestModule.Event(channel: $0, row: 0, volume: 0, trigger: false) }
+        let data = TestModule.make(patterns: [quiet, [], loud, calm])
+        
+        var preview = OpenMPTPreviewOptions(duration: 5, fadeOut: 0.5, threadCount: 1)
+        var order: Int32 = -1
+        var start = 0.0
+        var settings = openmpt_bridge_preview_options()
+        openmpt_bridge_preview_options_init(&settings)
+        settings.clip_seconds = preview.duration
+        XCTAssertEqual(data.withUnsafeBytes { openmpt_bridge_preview_find_start($0.baseAddress, $0.count, &settings, &order, &start) }, 1)
+        XCTAssertEqual(order, 2)
+        XCTAssertEqual(start, 2 * TestModule.secondsPerPattern, accuracy: 0.01)
+        
+        let output = FileManager.default.temporaryDirectory.appendingPathComponent("preview-\(UUID().uuidString).wav")
+        defer { try? FileManager.default.removeItem(at: output) }
+        let result = try OpenMPTModule.exportPreview(data: data, to: output, preview: preview)
+        XCTAssertEqual(result.order, 2)
+        XCTAssertEqual(result.startTime, start, accuracy: 0.01)
+        XCTAssertEqual(Double(result.frameCount), preview.duration * 48000, accuracy: 1)
+        XCTAssertTrue(FileManager.default.fileExists(atPath: output.path))
+        
+        // A clip longer than the song starts at the beginning
+        preview.duration = 60
+        XCTAssertNil(try OpenMPTModule.exportPreview(data: data, to: output, preview: preview).order)
+        
+        XCTAssertThrowsError(try OpenMPTModule.exportPreview(data: Data([0x00, 0x01, 0x02, 0x03]), to: output)) { error in
+            XCTAssertTrue(error is OpenMPTError)
+        }
+        let missing = URL(fileURLWithPath: "/nonexistent/song.mod")
+        XCTAssertEqual(OpenMPTModule.exportPreviews(files: [missing], to: [output], preview: preview).map { $0 == nil }, [true])
+    }
+    
+    func testFingerprintIndexFindsShiftedCopy() {
+        var state: UInt32 = 12345
+        func randomHashes(_ count: Int) -> [UInt32] {
+            (0..<count).map { _ in
+                state = state &* 1664525 &+ 1013904223
+                return state | 1
+            }
+        }
+        let song = OpenMPTFingerprint(hashes: randomHashes(200))
+        let other = OpenMPTFingerprint(hashes: randomHashes(200))
+        // The same song with its first 5 hashes missing, as if it started later
+        let copy = OpenMPTFingerprint(hashes: Array(song.hashes.dropFirst(5)))
+        XCTAssertEqual(copy.similarity(to: song), 1.0, accuracy: 1e-9)
+        XCTAssertLessThan(other.similarity(to: song), OpenMPTFingerprint.duplicateThreshold)
+        
+        let index = OpenMPTFingerprintIndex()
+        XCTAssertTrue(index.add(song, id: 7))
+        XCTAssertTrue(index.add(other, id: 9))
+        XCTAssertEqual(index.count, 2)
+        
+        let matches = index.matches(for: copy)
+        XCTAssertEqual(matches.count, 1)
+        XCTAssertEqual(matches.first?.id, 7)
+        XCTAssertEqual(matches.first?.offset, 5)
+        XCTAssertEqual(matches.first?.similarity ?? 0, 1.0, accuracy: 1e-9)
+        XCTAssertTrue(index.duplicates(of: 7).isEmpty)
+        XCTAssertThrowsError(try OpenMPTFingerprint.compute(data: Data()))
+    }
+    
+    func testNotePreviewPlaysOverSong() throws {
+        let module = OpenMPTModule()
+        XCTAssertNil(module.playNote(instrument: 0, note: .c4))
+        try module.loadModule(from: TestModule.make(patterns: [[]]))
+        XCTAssertTrue(module.isInteractive)
+        XCTAssertEqual(TestModule.levels(try module.renderAudio(sampleRate: 48000, frameCount: 4800)).left, 0, accuracy: 1e-6)
+        
+        XCTAssertNil(module.playNote(instrument: 0, note: .noteOff))
+        XCTAssertNil(module.playNote(instrument: 0, note: 120))
+        XCTAssertNil(module.playNote(instrument: -1, note: .c4))
+        let voice = try XCTUnwrap(module.playNote(instrument: 0, note: .c4, panning: -1))
+        let playing = TestModule.levels(try module.renderAudio(sampleRate: 48000, frameCount: 4800))
+        XCTAssertGreaterThan(playing.left, 0.01)
+        XCTAssertGreaterThan(playing.left, playing.right * 2)
+        
+        // Cut, then let the volume ramp finish
+        module.stopNote(voice)
+        _ = try module.renderAudio(sampleRate: 48000, frameCount: 2400)
+        XCTAssertEqual(TestModule.levels(try module.renderAudio(sampleRate: 48000, frameCount: 4800)).left, 0, accuracy: 1e-4)
+        
+        // Voices wrap around after previewVoices notes, each stealing its oldest
+        let voices = (0...OpenMPTModule.previewVoices).compactMap { _ in module.playNote(instrument: 0, note: .c4) }
+        XCTAssertEqual(voices.count, OpenMPTModule.previewVoices + 1)
+        XCTAssertEqual(voices.last, voices.first)
+        module.stopAllNotes()
+        _ = try module.renderAudio(sampleRate: 48000, frameCount: 2400)
+        XCTAssertEqual(TestModule.levels(try module.renderAudio(sampleRate: 48000, frameCount: 4800)).left, 0, accuracy: 1e-4)
+    }
+    
+    func testSoloYieldsToMute() throws {
+        let module = OpenMPTModule()
+        XCTAssertFalse(module.setMuted(true, channel: 0))
+        // Channel 0 plays on the left, channel 1 on the right
+        try module.loadModule(from: TestModule.make(patterns: [[.init(channel: 0, row: 0), .init(channel: 1, row: 0)]]))
+        
+        // Levels after a change, once the volume ramp has finished
+        func levels() throws -> (left: Double, right: Double) {
+            _ = try module.renderAudio(sampleRate: 48000, frameCount: 2400)
+            return TestModule.levels(try module.renderAudio(sampleRate: 48000, frameCount: 4800))
+        }
+        let both = try levels()
+        XCTAssertGreaterThan(both.left, 0.01)
+        XCTAssertGreaterThan(both.right, 0.01)
+        
+        XCTAssertTrue(module.setSolo(true, channel: 0))
+        var heard = try levels()
+        XCTAssertEqual(heard.left, both.left, accuracy: both.left * 0.1)
+        XCTAssertEqual(heard.right, 0, accuracy: 1e-4)
+        
+        // Muting the soloed channel silences it, and the solo still holds the other
+        XCTAssertTrue(module.setMuted(true, channel: 0))
+        XCTAssertTrue(module.isSoloed(channel: 0))
+        heard = try levels()
+        XCTAssertEqual(heard.left, 0, accuracy: 1e-4)
+        XCTAssertEqual(heard.right, 0, accuracy: 1e-4)
+        
+        XCTAssertTrue(module.setSolo(false, channel: nil))
+        heard = try levels()
+        XCTAssertEqual(heard.left, 0, accuracy: 1e-4)
+        XCTAssertEqual(heard.right, both.right, accuracy: both.right * 0.1)
+        
+        // A refused request changes nothing
+        XCTAssertFalse(module.setMuted(false, channel: 4))
+        XCTAssertFalse(module.setSolo(true, channel: -2))
+        XCTAssertTrue(module.isMuted(channel: 0))
+        XCTAssertFalse(module.isSoloed(channel: 1))
+        
+        XCTAssertTrue(module.setMuted(false, channel: nil))
+        XCTAssertTrue((0..<4).allSatisfy { !module.isMuted(channel: $0) })
+        heard = try levels()
+        XCTAssertEqual(heard.left, both.left, accuracy: both.left * 0.1)
+        XCTAssertEqual(heard.right, both.right, accuracy: both.right * 0.1)
+    }
+    
+    func testFactorsOutsideRangeAreRefused() throws {
+        let module = OpenMPTModule()
+        XCTAssertEqual(openmpt_bridge_module_set_tempo_factor(module.handle, 2), 0)
+        try module.loadModule(from: TestModule.make(patterns: [[.init(channel: 0, row: 0)]]))
+        
+        for factor in [0, -1, 4.001, Double.nan, Double.infinity] {
+            XCTAssertEqual(openmpt_bridge_module_set_tempo_factor(module.handle, factor), 0, "\(factor)")
+            XCTAssertEqual(openmpt_bridge_module_set_pitch_factor(module.handle, factor), 0, "\(factor)")
+        }
+        XCTAssertEqual(module.tempoFactor, 1)
+        XCTAssertEqual(module.pitchFactor, 1)
+        
+        // The setters report whether the factor was applied
+        XCTAssertTrue(module.setTempoFactor(OPENMPT_BRIDGE_MAX_FACTOR))
+        XCTAssertFalse(module.setTempoFactor(0))
+        XCTAssertEqual(module.tempoFactor, OPENMPT_BRIDGE_MAX_FACTOR)
+        XCTAssertTrue(module.setPitchFactor(2))
+        XCTAssertFalse(module.setPitchFactor(OPENMPT_BRIDGE_MAX_FACTOR * 2))
+        XCTAssertEqual(module.pitchFactor, 2)
+        
+        // The properties leave the factor unchanged the same way
+        module.tempoFactor = -1
+        XCTAssertEqual(module.tempoFactor, OPENMPT_BRIDGE_MAX_FACTOR)
+        module.pitchSemitones = 12
+        XCTAssertEqual(module.pitchFactor, 2, accuracy: 1e-12)
+        module.pitchSemitones = 36
+        XCTAssertEqual(module.pitchFactor, 2, accuracy: 1e-12)
+        
+        // Twice the tempo plays the 7.68 s pattern in half the time
+        module.tempoFactor = 2
+        XCTAssertTrue(module.setRepeatCount(0))
+        var frames = 0
+        while !module.hasReachedEnd && frames < 48000 * 10 {
+            frames += try module.renderAudio(sampleRate: 48000, frameCount: 4800).count / 2
+        }
+        XCTAssertTrue(module.hasReachedEnd)
+        XCTAssertEqual(Double(frames) / 48000, TestModule.secondsPerPattern / 2, accuracy: 0.3)
+    }
+    
     // TODO: Add tests with actual module files once libopenmpt binary is available
     // func testValidModuleLoading() { ... }
     // func testAudioRendering() { ... }
@@ -0,0 +1,91 @@
+//
+//  TestModules.swift
+//  OpenMPTSwift
+//
+//  ProTracker modules built in memory, for tests that need real audio
+//
+
+import Foundation
+
+/// 4-channel ProTracker ("M.K.") modules with one looping square-wave sample
+///
+/// Rows last 0.12 s (speed 6, 125 BPM), so a 64-row pattern plays for
+/// 7.68 s. Channels 0 and 3 are panned left, 1 and 2 right.
+enum TestModule {
+
+    static let rowsPerPattern = 64
+    static let secondsPerRow = 0.12
+    static var secondsPerPattern: Double { Double(rowsPerPattern) * secondsPerRow }
+
+    /// A note of sample 1 at `volume` (0...64), or with `trigger` false only
+    /// a volume change for the note already playing on the channel
+    struct Event {
+        var channel: Int
+        var row: Int
+        var volume: Int = 64
+        var trigger: Bool = true
+    }
+
+    /// - Parameters:
+    ///   - patterns: events of each pattern; an empty pattern is silent
+    ///   - orders: pattern of each order, every pattern once in turn by default
+    static func make(patterns: [[Event]], orders: [Int]? = nil, title: String = "test") -> Data {
+        let orders = orders ?? Array(patterns.indices)
+        let sample: [UInt8] = (0..<64).map { $0 < 32 ? 0x40 : 0xC0 }  // ±0.5 square wave
+
+        var data = Data()
+        data.append(contentsOf: fixedString(title, length: 20))
+        for index in 0..<31 {
+            data.append(contentsOf: fixedString(index == 0 ? "square" : "", length: 22))
+            let words = index == 0 ? sample.count / 2 : 0
+            data.append(contentsOf: bigEndian(words))
+            data.append(0)                                      // finetune
+            data.append(index == 0 ? 64 : 0)                    // volume
+            data.append(contentsOf: bigEndian(0))               // loop start
+            data.append(contentsOf: bigEndian(max(words, 1)))   // loop length, 1 = no loop
+        }
+        data.append(UInt8(orders.count))
+        data.append(0x7F)
+        data.append(contentsOf: orders.map { UInt8($0) } + [UInt8](repeating: 0, count: 128 - orders.count))
+        data.append(contentsOf: Array("M.K.".utf8))
+
+        for events in patterns {
+            var cells = [UInt8](repeating: 0, count: rowsPerPattern * 4 * 4)
+            for event in events {
+                let offset = (event.row * 4 + event.channel) * 4
+                if event.trigger {
+                    // Sample 1 at period 428 (C-2)
+                    cells[offset] = 0x01
+                    cells[offset + 1] = 0xAC
+                    cells[offset + 2] = 0x10
+                }
+                cells[offset + 2] |= 0x0C                           // Cxx: set volume
+                cells[offset + 3] = UInt8(event.volume)
+            }
+            data.append(contentsOf: cells)
+        }
+        data.append(contentsOf: sample)
+        return data
+    }
+
+    /// Root-mean-square level of the left and right channels of interleaved stereo
+    static func levels(_ samples: [Float]) -> (left: Double, right: Double) {
+        var left = 0.0
+        var right = 0.0
+        for frame in stride(from: 0, to: samples.count - 1, by: 2) {
+            left += Double(samples[frame] * samples[frame])
+            right += Double(samples[frame + 1] * samples[frame + 1])
+        }
+        let frames = Double(max(samples.count / 2, 1))
+        return ((left / frames).squareRoot(), (right / frames).squareRoot())
+    }
+
+    private static func fixedString(_ string: String, length: Int) -> [UInt8] {
+        let bytes = Array(string.utf8.prefix(length))
+        return bytes + [UInt8](repeating: 0, count: length - bytes.count)
+    }
+
+    private static func bigEndian(_ value: Int) -> [UInt8] {
+        [UInt8(value >> 8 & 0xFF), UInt8(value & 0xFF)]
+    }
+}